@@ -1,6 +1,7 @@
 ﻿// Copyright(c) 2022 Ryan Seghers
 // Distributed under the MIT License (http://opensource.org/licenses/MIT)
 #include <string>
+#include <cstring>
 #include <filesystem>
 
 #include "ArrowUtil.h"
@@ -14,6 +15,7 @@
 #include <arrow/status.h>
 #include <arrow/filesystem/localfs.h>
 #include <arrow/csv/writer.h>
+#include <arrow/ipc/reader.h>
 
 #include <parquet/api/reader.h>
 #include <parquet/arrow/reader.h>
@@ -34,23 +36,11 @@ namespace Wxiv
     namespace ArrowUtil
     {
         /**
-         * @brief Load a csv or parquet file into a Table.
-         * @param path Local file path. Can be utf-8 on both Windows and Linux.
-         * @return shared_ptr Table
+         * @brief Read a csv, parquet, or Arrow IPC stream (.arrows) table from this input.
+         * @param path For the format, by extension, and for error messages.
          */
-        std::shared_ptr<arrow::Table> loadFile(const std::string& path)
+        static std::shared_ptr<arrow::Table> readTable(std::shared_ptr<arrow::io::RandomAccessFile> input, const std::string& path)
         {
-            // open file
-            arrow::fs::LocalFileSystem file_system;
-            auto maybe_input = file_system.OpenInputFile(path);
-
-            if (!maybe_input.ok())
-            {
-                return nullptr;
-            }
-
-            std::shared_ptr<arrow::io::RandomAccessFile> input = *maybe_input;
-
             if (path.ends_with(".csv"))
             {
                 arrow::io::IOContext io_context = arrow::io::default_io_context();
@@ -80,8 +70,6 @@ namespace Wxiv
             }
             else if (path.ends_with("parquet"))
             {
-                std::shared_ptr<arrow::io::RandomAccessFile> input = file_system.OpenInputFile(path).ValueOrDie();
-
                 std::unique_ptr<parquet::arrow::FileReader> arrow_reader;
                 arrow::MemoryPool* pool = arrow::default_memory_pool();
                 auto st = parquet::arrow::OpenFile(input, pool, &arrow_reader);
@@ -102,12 +90,69 @@ namespace Wxiv
 
                 return table;
             }
+            else if (path.ends_with(".arrows"))
+            {
+                auto maybe_reader = arrow::ipc::RecordBatchStreamReader::Open(input);
+
+                if (!maybe_reader.ok())
+                {
+                    throw std::runtime_error(fmt::format("Arrow failed to open the IPC stream: {}", path).c_str());
+                }
+
+                auto maybe_table = (*maybe_reader)->ToTable();
+
+                if (!maybe_table.ok())
+                {
+                    throw std::runtime_error(fmt::format("Arrow failed to read the IPC stream: {}", path).c_str());
+                }
+
+                return *maybe_table;
+            }
             else
             {
                 throw std::runtime_error("Unhandled file format.");
             }
         }
 
+        /**
+         * @brief Load a csv or parquet file into a Table.
+         * @param path Local file path. Can be utf-8 on both Windows and Linux.
+         * @return shared_ptr Table
+         */
+        std::shared_ptr<arrow::Table> loadFile(const std::string& path)
+        {
+            // open file
+            arrow::fs::LocalFileSystem file_system;
+            auto maybe_input = file_system.OpenInputFile(path);
+
+            if (!maybe_input.ok())
+            {
+                return nullptr;
+            }
+
+            return readTable(*maybe_input, path);
+        }
+
+        /**
+         * @brief Load a csv, parquet, or Arrow IPC stream's contents from memory into a Table, e.g. a member of an archive.
+         * The bytes are copied, so the table doesn't refer to them.
+         * @param name File name, for the format by extension.
+         */
+        std::shared_ptr<arrow::Table> loadBuffer(const uint8_t* data, size_t size, const std::string& name)
+        {
+            auto maybe_buffer = arrow::AllocateBuffer((int64_t)size);
+
+            if (!maybe_buffer.ok())
+            {
+                throw std::runtime_error(fmt::format("Arrow failed to allocate a buffer for: {}", name).c_str());
+            }
+
+            std::shared_ptr<arrow::Buffer> buffer = std::move(*maybe_buffer);
+            memcpy(buffer->mutable_data(), data, size);
+
+            return readTable(std::make_shared<arrow::io::BufferReader>(buffer), name);
+        }
+
         /**
          * @brief Save a table to a parquet or csv file. Throws for any error.
          * @param path Output file path, must end with ".parquet" or ".csv". Can be utf-8 on both Windows and Linux.
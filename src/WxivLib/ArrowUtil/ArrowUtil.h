@@ -19,6 +19,7 @@ namespace Wxiv
     namespace ArrowUtil
     {
         std::shared_ptr<arrow::Table> loadFile(const std::string& path);
+        std::shared_ptr<arrow::Table> loadBuffer(const uint8_t* data, size_t size, const std::string& name);
         void saveFile(const std::string& path, std::shared_ptr<arrow::Table> ptable);
 
         std::shared_ptr<arrow::ChunkedArray> getColumn(std::shared_ptr<arrow::Table> ptable, std::string name);
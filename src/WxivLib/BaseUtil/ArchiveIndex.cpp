@@ -0,0 +1,480 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+
+#include "ArchiveIndex.h"
+#include "StringUtil.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    static const uint32_t ZipLocalHeaderSig = 0x04034b50;
+    static const uint32_t ZipCentralHeaderSig = 0x02014b50;
+    static const uint32_t ZipEndSig = 0x06054b50;
+    static const uint32_t Zip64EndSig = 0x06064b50;
+    static const uint32_t Zip64LocatorSig = 0x07064b50;
+    static const size_t ZipEndSize = 22;
+    static const size_t ZipMaxCommentSize = 0xffff;
+    static const size_t TarBlockSize = 512;
+
+    static uint16_t readU16(const uint8_t* p)
+    {
+        return (uint16_t)(p[0] | (p[1] << 8));
+    }
+
+    static uint32_t readU32(const uint8_t* p)
+    {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    static uint64_t readU64(const uint8_t* p)
+    {
+        return (uint64_t)readU32(p) | ((uint64_t)readU32(p + 4) << 32);
+    }
+
+    ArchiveIndex::ArchiveIndex(const std::filesystem::path& path)
+    {
+        this->file = std::make_shared<MappedFile>(path);
+        const uint8_t* p = this->file->getData();
+        size_t size = this->file->getSize();
+
+        // a zip starts with a member or, if empty, the end record
+        if ((size >= 4) && (p[0] == 'P') && (p[1] == 'K'))
+        {
+            indexZip();
+        }
+        else
+        {
+            indexTar();
+        }
+    }
+
+    bool ArchiveIndex::checkIsArchiveExtension(const std::string& inputExt)
+    {
+        string ext = getNormalizedExt(inputExt);
+        return (ext == "zip") || (ext == "tar");
+    }
+
+    uint32_t ArchiveIndex::computeCrc(const uint8_t* data, size_t size)
+    {
+        static const std::array<uint32_t, 256> table = []() {
+            std::array<uint32_t, 256> t;
+
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t c = i;
+
+                for (int k = 0; k < 8; k++)
+                {
+                    c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+                }
+
+                t[i] = c;
+            }
+
+            return t;
+        }();
+
+        uint32_t crc = 0xffffffff;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        }
+
+        return ~crc;
+    }
+
+    bool ArchiveIndex::checkCrc(const Entry& entry, const uint8_t* data)
+    {
+        return !entry.hasCrc || (computeCrc(data, (size_t)entry.size) == entry.crc);
+    }
+
+    void ArchiveIndex::addEntry(Entry entry)
+    {
+        // dirs, and the odd archive with an empty name
+        if (entry.name.empty() || (entry.name.back() == '/'))
+        {
+            return;
+        }
+
+        if (entry.name.starts_with("./"))
+        {
+            entry.name = entry.name.substr(2);
+        }
+
+        // a later member of the same name replaces the earlier one, like extracting would
+        auto iter = this->entryIndexByName.find(entry.name);
+
+        if (iter != this->entryIndexByName.end())
+        {
+            this->entries[iter->second] = entry;
+        }
+        else
+        {
+            this->entryIndexByName[entry.name] = (int)this->entries.size();
+            this->entries.push_back(entry);
+        }
+    }
+
+    /**
+     * @brief Read the central directory at the end, then each member's local header for where its data starts.
+     */
+    void ArchiveIndex::indexZip()
+    {
+        const uint8_t* p = this->file->getData();
+        size_t size = this->file->getSize();
+
+        if (size < ZipEndSize)
+        {
+            throw runtime_error("Zip file is truncated.");
+        }
+
+        // end record is last, after a comment of up to 64K
+        size_t endPos = string::npos;
+        size_t minPos = (size - ZipEndSize > ZipMaxCommentSize) ? size - ZipEndSize - ZipMaxCommentSize : 0;
+
+        for (size_t pos = size - ZipEndSize + 1; pos-- > minPos;)
+        {
+            if (readU32(p + pos) == ZipEndSig)
+            {
+                endPos = pos;
+                break;
+            }
+        }
+
+        if (endPos == string::npos)
+        {
+            throw runtime_error("Zip file has no end of central directory record.");
+        }
+
+        uint64_t entryCount = readU16(p + endPos + 10);
+        uint64_t dirOffset = readU32(p + endPos + 16);
+
+        // zip64 end record, found via the locator just before the end record
+        if ((entryCount == 0xffff) || (dirOffset == 0xffffffff))
+        {
+            if ((endPos < 20) || (readU32(p + endPos - 20) != Zip64LocatorSig))
+            {
+                throw runtime_error("Zip64 file has no end of central directory locator.");
+            }
+
+            uint64_t end64Pos = readU64(p + endPos - 20 + 8);
+
+            if ((end64Pos > size) || (size - end64Pos < 56) || (readU32(p + end64Pos) != Zip64EndSig))
+            {
+                throw runtime_error("Zip64 end of central directory record is not valid.");
+            }
+
+            entryCount = readU64(p + end64Pos + 32);
+            dirOffset = readU64(p + end64Pos + 48);
+        }
+
+        uint64_t pos = dirOffset;
+
+        for (uint64_t i = 0; i < entryCount; i++)
+        {
+            if ((pos > size) || (size - pos < 46) || (readU32(p + pos) != ZipCentralHeaderSig))
+            {
+                throw runtime_error("Zip central directory is not valid.");
+            }
+
+            const uint8_t* h = p + pos;
+            uint16_t flags = readU16(h + 8);
+            uint16_t method = readU16(h + 10);
+            uint32_t crc = readU32(h + 16);
+            uint64_t compressedSize = readU32(h + 20);
+            uint64_t uncompressedSize = readU32(h + 24);
+            uint16_t nameLen = readU16(h + 28);
+            uint16_t extraLen = readU16(h + 30);
+            uint16_t commentLen = readU16(h + 32);
+            uint64_t localOffset = readU32(h + 42);
+
+            if (size - pos - 46 < (uint64_t)nameLen + extraLen + commentLen)
+            {
+                throw runtime_error("Zip central directory is truncated.");
+            }
+
+            // zip64 extra field has just the values that didn't fit, in this order
+            const uint8_t* extra = h + 46 + nameLen;
+
+            for (size_t e = 0; e + 4 <= extraLen;)
+            {
+                uint16_t id = readU16(extra + e);
+                uint16_t len = readU16(extra + e + 2);
+                const uint8_t* v = extra + e + 4;
+                const uint8_t* vEnd = v + std::min<size_t>(len, extraLen - e - 4);
+
+                if (id == 0x0001)
+                {
+                    if ((uncompressedSize == 0xffffffff) && (v + 8 <= vEnd))
+                    {
+                        uncompressedSize = readU64(v);
+                        v += 8;
+                    }
+
+                    if ((compressedSize == 0xffffffff) && (v + 8 <= vEnd))
+                    {
+                        compressedSize = readU64(v);
+                        v += 8;
+                    }
+
+                    if ((localOffset == 0xffffffff) && (v + 8 <= vEnd))
+                    {
+                        localOffset = readU64(v);
+                    }
+                }
+
+                e += 4 + len;
+            }
+
+            Entry entry;
+            entry.name = string((const char*)h + 46, nameLen);
+            entry.compressedSize = compressedSize;
+            entry.size = uncompressedSize;
+            entry.hasCrc = true;
+            entry.crc = crc;
+
+            if (flags & 0x0001)
+            {
+                entry.compression = Compression::Unsupported; // encrypted
+            }
+            else if (method == 0)
+            {
+                // the data is read as size bytes, so they can't be more than what's there
+                if (compressedSize != uncompressedSize)
+                {
+                    throw runtime_error("Zip stored member sizes don't match.");
+                }
+
+                entry.compression = Compression::Stored;
+            }
+            else if (method == 8)
+            {
+                entry.compression = Compression::Deflated;
+            }
+            else
+            {
+                entry.compression = Compression::Unsupported;
+            }
+
+            // the local header's extra field can differ from the central one, so its length has to be read from there
+            if ((localOffset > size) || (size - localOffset < 30) || (readU32(p + localOffset) != ZipLocalHeaderSig))
+            {
+                throw runtime_error("Zip local header is not valid.");
+            }
+
+            entry.dataOffset = localOffset + 30 + readU16(p + localOffset + 26) + readU16(p + localOffset + 28);
+
+            if ((entry.dataOffset > size) || (entry.compressedSize > size - entry.dataOffset))
+            {
+                throw runtime_error("Zip member data is outside the file.");
+            }
+
+            addEntry(entry);
+            pos += 46 + nameLen + extraLen + commentLen;
+        }
+    }
+
+    static string readTarString(const uint8_t* p, size_t maxLen)
+    {
+        const uint8_t* end = (const uint8_t*)memchr(p, 0, maxLen);
+        return string((const char*)p, end ? end - p : maxLen);
+    }
+
+    /**
+     * @brief Octal, or base-256 (high bit of the first byte set) for values too big for the field.
+     */
+    static uint64_t readTarNumber(const uint8_t* p, size_t len)
+    {
+        uint64_t value = 0;
+
+        if (p[0] & 0x80)
+        {
+            value = p[0] & 0x7f;
+
+            for (size_t i = 1; i < len; i++)
+            {
+                value = (value << 8) | p[i];
+            }
+
+            return value;
+        }
+
+        for (size_t i = 0; i < len; i++)
+        {
+            if ((p[i] >= '0') && (p[i] <= '7'))
+            {
+                value = (value << 3) | (uint64_t)(p[i] - '0');
+            }
+            else if ((p[i] == 0) || ((p[i] == ' ') && (value > 0)))
+            {
+                break;
+            }
+        }
+
+        return value;
+    }
+
+    static bool checkTarHeaderChecksum(const uint8_t* h)
+    {
+        // checksum field counts as spaces
+        uint64_t sum = 0;
+
+        for (size_t i = 0; i < TarBlockSize; i++)
+        {
+            sum += ((i >= 148) && (i < 156)) ? ' ' : h[i];
+        }
+
+        return sum == readTarNumber(h + 148, 8);
+    }
+
+    /**
+     * @brief Get the path from pax extended header records, which are like "30 path=some/long/name.png\n".
+     */
+    static string readPaxPath(const uint8_t* p, size_t len)
+    {
+        string path;
+        size_t pos = 0;
+
+        while (pos < len)
+        {
+            size_t recordLen = 0;
+            size_t i = pos;
+
+            while ((i < len) && (p[i] >= '0') && (p[i] <= '9'))
+            {
+                recordLen = recordLen * 10 + (p[i] - '0');
+                i++;
+            }
+
+            if ((recordLen == 0) || (pos + recordLen > len) || (i >= len) || (p[i] != ' '))
+            {
+                break;
+            }
+
+            string record((const char*)p + i + 1, pos + recordLen - i - 1);
+
+            if (!record.empty() && (record.back() == '\n'))
+            {
+                record.pop_back();
+            }
+
+            if (record.starts_with("path="))
+            {
+                path = record.substr(5);
+            }
+
+            pos += recordLen;
+        }
+
+        return path;
+    }
+
+    void ArchiveIndex::indexTar()
+    {
+        const uint8_t* p = this->file->getData();
+        size_t size = this->file->getSize();
+        size_t pos = 0;
+        string longName; // from the header before, for the next member
+
+        while (pos + TarBlockSize <= size)
+        {
+            const uint8_t* h = p + pos;
+
+            // archive ends with zero blocks
+            if (std::all_of(h, h + TarBlockSize, [](uint8_t b) { return b == 0; }))
+            {
+                break;
+            }
+
+            if (!checkTarHeaderChecksum(h))
+            {
+                if (pos == 0)
+                {
+                    throw runtime_error("Not a zip or tar file.");
+                }
+
+                throw runtime_error("Tar header checksum is not valid.");
+            }
+
+            uint64_t memberSize = readTarNumber(h + 124, 12);
+            size_t dataOffset = pos + TarBlockSize;
+            char type = (char)h[156];
+
+            if ((dataOffset > size) || (memberSize > size - dataOffset))
+            {
+                throw runtime_error("Tar member data is outside the file.");
+            }
+
+            if (type == 'L')
+            {
+                // GNU long name
+                longName = readTarString(p + dataOffset, (size_t)memberSize);
+            }
+            else if (type == 'x')
+            {
+                longName = readPaxPath(p + dataOffset, (size_t)memberSize);
+            }
+            else
+            {
+                if ((type == '0') || (type == '\0') || (type == '7'))
+                {
+                    Entry entry;
+
+                    if (!longName.empty())
+                    {
+                        entry.name = longName;
+                    }
+                    else
+                    {
+                        entry.name = readTarString(h, 100);
+                        string prefix = (memcmp(h + 257, "ustar", 5) == 0) ? readTarString(h + 345, 155) : "";
+
+                        if (!prefix.empty())
+                        {
+                            entry.name = prefix + "/" + entry.name;
+                        }
+                    }
+
+                    entry.dataOffset = dataOffset;
+                    entry.compressedSize = memberSize;
+                    entry.size = memberSize;
+                    entry.compression = Compression::Stored;
+                    addEntry(entry);
+                }
+
+                // links, dirs, global pax headers etc. have no data we want, and use up any long name
+                longName.clear();
+            }
+
+            pos = dataOffset + (size_t)((memberSize + TarBlockSize - 1) / TarBlockSize * TarBlockSize);
+        }
+    }
+
+    const std::vector<ArchiveIndex::Entry>& ArchiveIndex::getEntries()
+    {
+        return this->entries;
+    }
+
+    int ArchiveIndex::findEntry(const std::string& name)
+    {
+        auto iter = this->entryIndexByName.find(name);
+        return (iter != this->entryIndexByName.end()) ? iter->second : -1;
+    }
+
+    std::shared_ptr<MappedFile> ArchiveIndex::getFile()
+    {
+        return this->file;
+    }
+
+    const uint8_t* ArchiveIndex::getEntryData(const Entry& entry)
+    {
+        return this->file->getData() + entry.dataOffset;
+    }
+}
@@ -0,0 +1,94 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <filesystem>
+
+#include "MappedFile.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief Random-access index of the members of a zip or tar file, built once from a memory mapping of the whole
+     * archive, so any member can be read without scanning or extracting the others.
+     *
+     * Zip members are found via the central directory (including zip64), tar members by walking the 512-byte headers
+     * (ustar, with GNU long names and pax paths). The data of a stored (uncompressed) member, which is every tar member,
+     * is just a range of the mapping. Deflated zip members have to be inflated by the caller. Compressed tar files
+     * (.tar.gz etc.) can't be read at random, so are not supported.
+     *
+     * The index is not modified after construction, so it can be read from any thread.
+     */
+    class ArchiveIndex
+    {
+      public:
+        enum class Compression
+        {
+            Stored,
+            Deflated,
+            Unsupported, // other zip methods, or encrypted
+        };
+
+        struct Entry
+        {
+            std::string name; // path within the archive, with / separators
+            uint64_t dataOffset = 0;
+            uint64_t compressedSize = 0;
+            uint64_t size = 0;
+            Compression compression = Compression::Stored;
+            bool hasCrc = false; // zip members have a CRC-32 of the uncompressed data, tar members don't
+            uint32_t crc = 0;
+        };
+
+      private:
+        std::shared_ptr<MappedFile> file;
+        std::vector<Entry> entries;
+        std::unordered_map<std::string, int> entryIndexByName;
+
+        void indexZip();
+        void indexTar();
+        void addEntry(Entry entry);
+
+      public:
+        /**
+         * @brief Map and index the archive. Throws runtime_error if it can't be mapped or isn't a zip or tar file.
+         */
+        ArchiveIndex(const std::filesystem::path& path);
+
+        ArchiveIndex(const ArchiveIndex&) = delete;
+        ArchiveIndex& operator=(const ArchiveIndex&) = delete;
+
+        static bool checkIsArchiveExtension(const std::string& ext);
+
+        /**
+         * @brief The zip (and gzip, png) CRC-32.
+         */
+        static uint32_t computeCrc(const uint8_t* data, size_t size);
+
+        /**
+         * @brief Whether the member's uncompressed data matches its CRC, or true if it has none.
+         */
+        static bool checkCrc(const Entry& entry, const uint8_t* data);
+
+        /**
+         * @brief Files only (no dirs), in archive order.
+         */
+        const std::vector<Entry>& getEntries();
+
+        /**
+         * @return Index into getEntries(), or -1 if there is no such member.
+         */
+        int findEntry(const std::string& name);
+
+        std::shared_ptr<MappedFile> getFile();
+
+        /**
+         * @brief The member's bytes in the mapping, which are the member's data only if it is stored.
+         */
+        const uint8_t* getEntryData(const Entry& entry);
+    };
+}
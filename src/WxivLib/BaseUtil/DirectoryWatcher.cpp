@@ -0,0 +1,128 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#include "DirectoryWatcher.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+#ifdef __linux__
+    DirectoryWatcher::DirectoryWatcher(const std::filesystem::path& dirPath) : dirPath(dirPath)
+    {
+        this->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        if (this->fd < 0)
+        {
+            throw runtime_error("Failed to init inotify.");
+        }
+
+        uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+        if (inotify_add_watch(this->fd, dirPath.c_str(), mask) < 0)
+        {
+            close();
+            throw runtime_error("Failed to watch directory (it may not exist, or the inotify watch limit was reached).");
+        }
+    }
+
+    void DirectoryWatcher::close()
+    {
+        if (this->fd >= 0)
+        {
+            ::close(this->fd);
+            this->fd = -1;
+        }
+    }
+
+    std::vector<DirectoryWatcher::Change> DirectoryWatcher::takeChanges()
+    {
+        vector<Change> changes;
+
+        if (this->fd < 0)
+        {
+            return changes;
+        }
+
+        alignas(struct inotify_event) char buf[16 * 1024];
+        bool isDirGone = false;
+
+        while (!isDirGone)
+        {
+            ssize_t len = read(this->fd, buf, sizeof(buf));
+
+            if (len <= 0)
+            {
+                // EAGAIN means nothing more queued
+                break;
+            }
+
+            for (char* p = buf; p < buf + len;)
+            {
+                const struct inotify_event* evt = (const struct inotify_event*)p;
+                p += sizeof(struct inotify_event) + evt->len;
+
+                if (evt->mask & IN_Q_OVERFLOW)
+                {
+                    this->isOverflowed = true;
+                }
+                else if (evt->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT | IN_IGNORED))
+                {
+                    // the watch is over (a move leaves it on the dir under its new name, but that's not what was opened)
+                    isDirGone = true;
+                }
+                else if ((evt->len > 0) && !(evt->mask & IN_ISDIR))
+                {
+                    ChangeType type = (evt->mask & (IN_DELETE | IN_MOVED_FROM)) ? ChangeType::Removed : ChangeType::Written;
+                    changes.push_back({type, this->dirPath / evt->name});
+                }
+            }
+        }
+
+        if (isDirGone)
+        {
+            close();
+        }
+
+        return changes;
+    }
+#else
+    DirectoryWatcher::DirectoryWatcher(const std::filesystem::path& dirPath) : dirPath(dirPath)
+    {
+    }
+
+    void DirectoryWatcher::close()
+    {
+    }
+
+    std::vector<DirectoryWatcher::Change> DirectoryWatcher::takeChanges()
+    {
+        return vector<Change>();
+    }
+#endif
+
+    DirectoryWatcher::~DirectoryWatcher()
+    {
+        close();
+    }
+
+    bool DirectoryWatcher::checkIsWatching()
+    {
+        return this->fd >= 0;
+    }
+
+    bool DirectoryWatcher::takeIsOverflowed()
+    {
+        bool b = this->isOverflowed;
+        this->isOverflowed = false;
+        return b;
+    }
+}
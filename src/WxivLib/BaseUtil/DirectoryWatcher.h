@@ -0,0 +1,70 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <vector>
+#include <filesystem>
+
+namespace Wxiv
+{
+    /**
+     * @brief Watches one directory (not recursive) for files being written, moved in, deleted, or moved out.
+     *
+     * This uses inotify on Linux and is a no-op elsewhere (checkIsWatching() is false). There is no thread; the caller
+     * polls takeChanges(), which only does a non-blocking read of whatever the kernel has queued since the last call.
+     *
+     * Files are reported when closed after writing (not on create), so a file that's still being written by another
+     * process is not reported until it's complete.
+     *
+     * If the dir itself is deleted, moved, or unmounted, the watch ends: takeChanges() returns what happened before
+     * that and then checkIsWatching() is false.
+     */
+    class DirectoryWatcher
+    {
+      public:
+        enum class ChangeType
+        {
+            Written, // new, or re-written, or moved into the dir
+            Removed, // deleted, or moved out of the dir
+        };
+
+        struct Change
+        {
+            ChangeType type;
+            std::filesystem::path path;
+        };
+
+      private:
+        std::filesystem::path dirPath;
+        int fd = -1;
+        bool isOverflowed = false;
+
+        void close();
+
+      public:
+        /**
+         * @brief Start watching. Throws runtime_error if the platform supports watching but it fails, e.g. the dir
+         * doesn't exist or the user's inotify watch limit is reached.
+         */
+        DirectoryWatcher(const std::filesystem::path& dirPath);
+        ~DirectoryWatcher();
+
+        DirectoryWatcher(const DirectoryWatcher&) = delete;
+        DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+        /**
+         * @brief False on platforms with no watching, and once the dir is gone.
+         */
+        bool checkIsWatching();
+
+        /**
+         * @brief Get the changes since the last call, in the order they happened.
+         */
+        std::vector<Change> takeChanges();
+
+        /**
+         * @brief Whether events were dropped (too many since the last takeChanges()), in which case the caller should
+         * re-list the dir. This is cleared by the call.
+         */
+        bool takeIsOverflowed();
+    };
+}
@@ -0,0 +1,217 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::filesystem::path& path, bool doCopy)
+    {
+        HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (hFile == INVALID_HANDLE_VALUE)
+        {
+            throw runtime_error("Failed to open file for mapping.");
+        }
+
+        this->fileHandle = hFile;
+        LARGE_INTEGER fileSize;
+
+        if (!GetFileSizeEx(hFile, &fileSize) || (fileSize.QuadPart == 0))
+        {
+            close();
+            throw runtime_error("Failed to get file size for mapping, or file is empty.");
+        }
+
+        this->size = (size_t)fileSize.QuadPart;
+
+        if (doCopy)
+        {
+            this->data = new uint8_t[this->size];
+            this->isCopy = true;
+            size_t readBytes = 0;
+
+            while (readBytes < this->size)
+            {
+                DWORD chunkBytes = (DWORD)std::min(this->size - readBytes, (size_t)1 << 30);
+                DWORD didRead = 0;
+
+                if (!ReadFile(hFile, this->data + readBytes, chunkBytes, &didRead, NULL) || (didRead == 0))
+                {
+                    close();
+                    throw runtime_error("Failed to read file, or it was truncated while reading.");
+                }
+
+                readBytes += didRead;
+            }
+
+            // nothing refers to the file after this
+            CloseHandle(hFile);
+            this->fileHandle = nullptr;
+            return;
+        }
+
+        HANDLE hMapping = CreateFileMappingW(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+
+        if (hMapping == NULL)
+        {
+            close();
+            throw runtime_error("Failed to create file mapping.");
+        }
+
+        this->mappingHandle = hMapping;
+        this->data = (uint8_t*)MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, 0);
+
+        if (this->data == nullptr)
+        {
+            close();
+            throw runtime_error("Failed to map view of file.");
+        }
+    }
+
+    void MappedFile::close()
+    {
+        if (this->data && this->isCopy)
+        {
+            delete[] this->data;
+            this->data = nullptr;
+        }
+        else if (this->data)
+        {
+            UnmapViewOfFile(this->data);
+            this->data = nullptr;
+        }
+
+        if (this->mappingHandle)
+        {
+            CloseHandle((HANDLE)this->mappingHandle);
+            this->mappingHandle = nullptr;
+        }
+
+        if (this->fileHandle)
+        {
+            CloseHandle((HANDLE)this->fileHandle);
+            this->fileHandle = nullptr;
+        }
+    }
+#else
+    MappedFile::MappedFile(const std::filesystem::path& path, bool doCopy)
+    {
+        this->fd = ::open(path.c_str(), O_RDONLY);
+
+        if (this->fd < 0)
+        {
+            throw runtime_error("Failed to open file for mapping.");
+        }
+
+        struct stat st;
+
+        if ((fstat(this->fd, &st) != 0) || (st.st_size == 0))
+        {
+            close();
+            throw runtime_error("Failed to get file size for mapping, or file is empty.");
+        }
+
+        this->size = (size_t)st.st_size;
+
+        if (doCopy)
+        {
+            this->data = new uint8_t[this->size];
+            this->isCopy = true;
+            size_t readBytes = 0;
+
+            while (readBytes < this->size)
+            {
+                ssize_t didRead = ::pread(this->fd, this->data + readBytes, this->size - readBytes, (off_t)readBytes);
+
+                if ((didRead < 0) && (errno == EINTR))
+                {
+                    continue;
+                }
+
+                if (didRead <= 0)
+                {
+                    close();
+                    throw runtime_error("Failed to read file, or it was truncated while reading.");
+                }
+
+                readBytes += (size_t)didRead;
+            }
+
+            // nothing refers to the file after this
+            ::close(this->fd);
+            this->fd = -1;
+            return;
+        }
+
+        void* p = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, this->fd, 0);
+
+        if (p == MAP_FAILED)
+        {
+            close();
+            throw runtime_error("Failed to map file.");
+        }
+
+        this->data = (uint8_t*)p;
+    }
+
+    void MappedFile::close()
+    {
+        if (this->data && this->isCopy)
+        {
+            delete[] this->data;
+            this->data = nullptr;
+        }
+        else if (this->data)
+        {
+            munmap(this->data, this->size);
+            this->data = nullptr;
+        }
+
+        if (this->fd >= 0)
+        {
+            ::close(this->fd);
+            this->fd = -1;
+        }
+    }
+#endif
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    uint8_t* MappedFile::getData()
+    {
+        return this->data;
+    }
+
+    size_t MappedFile::getSize()
+    {
+        return this->size;
+    }
+
+    bool MappedFile::checkIsCopy()
+    {
+        return this->isCopy;
+    }
+}
@@ -0,0 +1,50 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+
+namespace Wxiv
+{
+    /**
+     * @brief Read-only file memory mapping, closed on destruct.
+     *
+     * The mapping is copy-on-write (private), so the pages can be written to (e.g. by wrapping them in a cv::Mat that
+     * something modifies in place) without changing the file.
+     *
+     * A file that's truncated while mapped faults (SIGBUS) when the pages past its new end are read, so a file that may
+     * be rewritten while in use (e.g. in a watched dir) can instead be read into memory, with the same interface.
+     */
+    class MappedFile
+    {
+      private:
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        bool isCopy = false; // data is a heap copy, not a mapping
+
+#ifdef _WIN32
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#else
+        int fd = -1;
+#endif
+
+        void close();
+
+      public:
+        /**
+         * @brief Map the whole file. Throws runtime_error on failure, including for an empty file.
+         * @param doCopy Read the file into memory instead of mapping it.
+         */
+        MappedFile(const std::filesystem::path& path, bool doCopy = false);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        uint8_t* getData();
+        size_t getSize();
+        bool checkIsCopy();
+    };
+}
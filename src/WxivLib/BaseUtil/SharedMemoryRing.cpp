@@ -0,0 +1,196 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+
+#include "SharedMemoryRing.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+#ifdef _WIN32
+    SharedMemoryRing::SharedMemoryRing(const std::string& name)
+    {
+        throw runtime_error("Shared memory rings are not supported on this platform.");
+    }
+
+    void SharedMemoryRing::close()
+    {
+    }
+#else
+    SharedMemoryRing::SharedMemoryRing(const std::string& name)
+    {
+        this->shmName = name;
+
+        // read-write, to pin
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+
+        if (fd < 0)
+        {
+            throw runtime_error("Failed to open the shared memory: " + name);
+        }
+
+        struct stat st;
+
+        if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)sizeof(WxivShmRingHeader)))
+        {
+            ::close(fd);
+            throw runtime_error("Shared memory is too small for a ring: " + name);
+        }
+
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if (p == MAP_FAILED)
+        {
+            throw runtime_error("Failed to map the shared memory: " + name);
+        }
+
+        this->data = (uint8_t*)p;
+        this->size = (size_t)st.st_size;
+        this->header = (WxivShmRingHeader*)p;
+
+        if ((wxivShmLoad(&this->header->magic) != WXIV_SHM_RING_MAGIC) || (this->header->version != WXIV_SHM_RING_VERSION) ||
+            (this->header->headerSize < sizeof(WxivShmRingHeader)) || (this->header->slotCount < 2) ||
+            (this->header->slotSize < sizeof(WxivShmFrameHeader)) || (this->header->slotSize % 8 != 0) ||
+            (this->header->headerSize + (uint64_t)this->header->slotCount * this->header->slotSize > this->size))
+        {
+            close();
+            throw runtime_error("Shared memory is not a wxiv image ring: " + name);
+        }
+    }
+
+    void SharedMemoryRing::close()
+    {
+        if (this->data)
+        {
+            munmap(this->data, this->size);
+            this->data = nullptr;
+            this->header = nullptr;
+        }
+    }
+#endif
+
+    SharedMemoryRing::~SharedMemoryRing()
+    {
+        if (this->header)
+        {
+            unpin();
+        }
+
+        close();
+    }
+
+    const std::string& SharedMemoryRing::getName()
+    {
+        return this->shmName;
+    }
+
+    int SharedMemoryRing::getSlotCount()
+    {
+        return (int)this->header->slotCount;
+    }
+
+    uint64_t SharedMemoryRing::getLastSequence()
+    {
+        return wxivShmLoad(&this->header->lastSequence);
+    }
+
+    /**
+     * @brief Read the slot's frame header, like a seqlock: the sequence before and after must match, else the producer
+     * was writing it.
+     * @return False if empty, being written, or the header isn't valid.
+     */
+    bool SharedMemoryRing::readFrame(int slotIndex, Frame& frame)
+    {
+        WxivShmFrameHeader* slot = wxivShmRingSlot(this->header, (uint32_t)slotIndex);
+        uint64_t sequence = wxivShmLoad(&slot->sequence);
+
+        if (sequence == 0)
+        {
+            return false;
+        }
+
+        frame.sequence = sequence;
+        frame.slotIndex = slotIndex;
+        frame.width = (int)slot->width;
+        frame.height = (int)slot->height;
+        frame.channels = (int)slot->channels;
+        frame.depth = (int)slot->depth;
+        frame.rowStride = (size_t)slot->rowStride;
+        frame.timestampNs = slot->timestampNs;
+        frame.name = string(slot->name, strnlen(slot->name, sizeof(slot->name)));
+        frame.pixels = (uint8_t*)slot + sizeof(WxivShmFrameHeader);
+
+        if (wxivShmLoad(&slot->sequence) != sequence)
+        {
+            return false;
+        }
+
+        size_t rowBytes = (size_t)frame.width * frame.channels * wxivShmDepthBytes((uint32_t)frame.depth);
+
+        return (frame.width > 0) && (frame.height > 0) && (frame.channels >= 1) && (frame.channels <= 4) && (rowBytes > 0) &&
+            (frame.rowStride >= rowBytes) && (sizeof(WxivShmFrameHeader) + frame.rowStride * (frame.height - 1) + rowBytes <= this->header->slotSize);
+    }
+
+    std::vector<SharedMemoryRing::Frame> SharedMemoryRing::getFramesAfter(uint64_t sequence)
+    {
+        vector<Frame> frames;
+
+        for (int i = 0; i < (int)this->header->slotCount; i++)
+        {
+            Frame frame;
+
+            if (readFrame(i, frame) && (frame.sequence > sequence))
+            {
+                frames.push_back(frame);
+            }
+        }
+
+        std::sort(frames.begin(), frames.end(), [](const Frame& a, const Frame& b) { return a.sequence < b.sequence; });
+        return frames;
+    }
+
+    bool SharedMemoryRing::checkIsIntact(const Frame& frame)
+    {
+        WxivShmFrameHeader* slot = wxivShmRingSlot(this->header, (uint32_t)frame.slotIndex);
+        return wxivShmLoad(&slot->sequence) == frame.sequence;
+    }
+
+    /**
+     * @brief Pin, then check it's still there. The producer marks a slot as being written and then checks the pin, so
+     * one of us sees the other's write (both are sequentially consistent).
+     */
+    bool SharedMemoryRing::pin(const Frame& frame)
+    {
+        wxivShmStore(&this->header->pinnedSequence, frame.sequence);
+        this->pinnedSequence = frame.sequence;
+
+        if (!checkIsIntact(frame))
+        {
+            unpin();
+            return false;
+        }
+
+        return true;
+    }
+
+    void SharedMemoryRing::unpin()
+    {
+        if (this->pinnedSequence != 0)
+        {
+            wxivShmCompareExchange(&this->header->pinnedSequence, this->pinnedSequence, 0);
+            this->pinnedSequence = 0;
+        }
+    }
+
+    uint64_t SharedMemoryRing::getMonotonicNs()
+    {
+        // steady_clock is CLOCK_MONOTONIC on Linux, which the producer stamps frames with
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
@@ -0,0 +1,92 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "WxivShmRing.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief Viewer side of a shared-memory ring of images (see WxivShmRing.h for the layout and the producer side).
+     *
+     * Frames are read in place: a Frame points at the pixels in the shared memory, which stay valid until the producer
+     * writes another frame over the slot. So check checkIsIntact() after using them, or pin() the one being displayed,
+     * which the producer then skips. Only one frame can be pinned at a time.
+     *
+     * POSIX only; elsewhere the constructor throws.
+     */
+    class SharedMemoryRing
+    {
+      public:
+        struct Frame
+        {
+            uint64_t sequence = 0;
+            int slotIndex = -1;
+            int width = 0;
+            int height = 0;
+            int channels = 0;
+            int depth = 0; // OpenCV depth code
+            size_t rowStride = 0;
+            uint64_t timestampNs = 0; // CLOCK_MONOTONIC when the producer completed it
+            std::string name;
+            uint8_t* pixels = nullptr;
+        };
+
+      private:
+        std::string shmName;
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        WxivShmRingHeader* header = nullptr;
+
+        // what this pinned, 0 if none, since another instance (e.g. of the next source) may have pinned since
+        uint64_t pinnedSequence = 0;
+
+        void close();
+        bool readFrame(int slotIndex, Frame& frame);
+
+      public:
+        /**
+         * @brief Attach to an existing ring. Throws runtime_error if there is none or it isn't valid.
+         * @param name Shared memory object name, like "/wxiv".
+         */
+        SharedMemoryRing(const std::string& name);
+        ~SharedMemoryRing();
+
+        SharedMemoryRing(const SharedMemoryRing&) = delete;
+        SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+        const std::string& getName();
+        int getSlotCount();
+
+        /**
+         * @brief The newest complete frame's sequence number, 0 if none. This is just one atomic read, to poll.
+         */
+        uint64_t getLastSequence();
+
+        /**
+         * @brief The complete frames newer than this sequence number, oldest first.
+         */
+        std::vector<Frame> getFramesAfter(uint64_t sequence);
+
+        /**
+         * @brief Whether the frame's slot still holds it, i.e. the pixels haven't been (and aren't being) overwritten.
+         */
+        bool checkIsIntact(const Frame& frame);
+
+        /**
+         * @brief Keep the producer from overwriting this frame, replacing any prior pin.
+         * @return False if it was already overwritten (or is being), and then nothing is pinned.
+         */
+        bool pin(const Frame& frame);
+
+        /**
+         * @brief Clear the pin, if it is still the one this pinned.
+         */
+        void unpin();
+
+        static uint64_t getMonotonicNs();
+    };
+}
@@ -0,0 +1,385 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+#include "SocketFrameReceiver.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    // payload buffers start at this and then double as the bytes arrive
+    static const size_t ReadChunkBytes = 1024 * 1024;
+
+#ifdef _WIN32
+    SocketFrameReceiver::SocketFrameReceiver(const std::filesystem::path& socketPath, int maxQueuedFrames, uint64_t maxFrameBytes)
+        : socketPath(socketPath), maxQueuedFrames(maxQueuedFrames), maxFrameBytes(maxFrameBytes)
+    {
+        throw runtime_error("Unix domain socket streams are not supported on this platform.");
+    }
+
+    void SocketFrameReceiver::close()
+    {
+    }
+#else
+    SocketFrameReceiver::SocketFrameReceiver(const std::filesystem::path& socketPath, int maxQueuedFrames, uint64_t maxFrameBytes)
+        : socketPath(socketPath), maxQueuedFrames(std::max(maxQueuedFrames, 1)), maxFrameBytes(maxFrameBytes)
+    {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        string pathStr = socketPath.string();
+
+        if (pathStr.empty() || (pathStr.size() >= sizeof(addr.sun_path)))
+        {
+            throw runtime_error("Socket path is empty or too long: " + pathStr);
+        }
+
+        strcpy(addr.sun_path, pathStr.c_str());
+
+        // replace a socket left by a prior run, but nothing else
+        std::error_code ec;
+
+        if (std::filesystem::is_socket(socketPath, ec))
+        {
+            std::filesystem::remove(socketPath, ec);
+        }
+
+        this->listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (this->listenFd < 0)
+        {
+            throw runtime_error("Failed to create a socket.");
+        }
+
+        fcntl(this->listenFd, F_SETFD, FD_CLOEXEC);
+
+        if (bind(this->listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+        {
+            close();
+            throw runtime_error("Failed to bind the socket (the path may exist and not be a socket): " + pathStr);
+        }
+
+        // to only remove the socket file if it's still this one, e.g. not a re-listen's on the same path
+        struct stat st;
+
+        if (stat(pathStr.c_str(), &st) == 0)
+        {
+            this->boundDev = (uint64_t)st.st_dev;
+            this->boundIno = (uint64_t)st.st_ino;
+            this->isBound = true;
+        }
+
+        if (listen(this->listenFd, 4) != 0)
+        {
+            close();
+            throw runtime_error("Failed to listen on the socket: " + pathStr);
+        }
+
+        // to wake the thread out of poll when stopping
+        if (pipe(this->wakeFds) != 0)
+        {
+            close();
+            throw runtime_error("Failed to create a pipe.");
+        }
+
+        this->thread = std::thread(&SocketFrameReceiver::run, this);
+    }
+
+    void SocketFrameReceiver::close()
+    {
+        if (this->listenFd >= 0)
+        {
+            ::close(this->listenFd);
+            this->listenFd = -1;
+        }
+
+        struct stat st;
+
+        if (this->isBound && (stat(this->socketPath.c_str(), &st) == 0) && ((uint64_t)st.st_dev == this->boundDev) &&
+            ((uint64_t)st.st_ino == this->boundIno))
+        {
+            std::error_code ec;
+            std::filesystem::remove(this->socketPath, ec);
+        }
+
+        this->isBound = false;
+
+        for (int& fd : this->wakeFds)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+    }
+
+    /**
+     * @brief Accept one producer at a time and read its frames until it disconnects or sends a bad frame.
+     */
+    void SocketFrameReceiver::run()
+    {
+        while (waitReadable(this->listenFd))
+        {
+            int fd = accept(this->listenFd, nullptr, nullptr);
+
+            if (fd < 0)
+            {
+                continue;
+            }
+
+            this->isConnected = true;
+            std::shared_ptr<Frame> frame;
+
+            while ((frame = readFrame(fd)) && enqueue(frame))
+            {
+            }
+
+            ::close(fd);
+            this->isConnected = false;
+        }
+    }
+
+    /**
+     * @brief Wait for the fd to have data (or be closed).
+     * @return False if woken to stop.
+     */
+    bool SocketFrameReceiver::waitReadable(int fd)
+    {
+        struct pollfd fds[2] = {{fd, POLLIN, 0}, {this->wakeFds[0], POLLIN, 0}};
+
+        while (true)
+        {
+            int n = poll(fds, 2, -1);
+
+            if ((n < 0) && (errno != EINTR))
+            {
+                return false;
+            }
+
+            if (fds[1].revents != 0)
+            {
+                return false;
+            }
+
+            if (fds[0].revents != 0)
+            {
+                return true;
+            }
+        }
+    }
+
+    /**
+     * @return False if the connection closed or failed, or woken to stop.
+     */
+    bool SocketFrameReceiver::readFully(int fd, void* buf, size_t size)
+    {
+        uint8_t* p = (uint8_t*)buf;
+
+        while (size > 0)
+        {
+            if (!waitReadable(fd))
+            {
+                return false;
+            }
+
+            ssize_t n = read(fd, p, size);
+
+            if (n == 0)
+            {
+                return false;
+            }
+            else if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                return false;
+            }
+
+            p += n;
+            size -= (size_t)n;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Read size bytes into buf, growing it as they arrive rather than allocating it all before any are sent.
+     * @return False if the connection closed or failed, or woken to stop.
+     */
+    bool SocketFrameReceiver::readGrowing(int fd, std::vector<uint8_t>& buf, uint64_t size)
+    {
+        buf.clear();
+
+        while (buf.size() < size)
+        {
+            size_t oldSize = buf.size();
+            size_t chunk = (size_t)std::min<uint64_t>(size - oldSize, std::max(ReadChunkBytes, oldSize));
+            buf.resize(oldSize + chunk);
+
+            if (!readFully(fd, buf.data() + oldSize, chunk))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @return Null if the connection closed, or the frame was bad and it should be closed.
+     */
+    std::shared_ptr<SocketFrameReceiver::Frame> SocketFrameReceiver::readFrame(int fd)
+    {
+        auto frame = std::make_shared<Frame>();
+        WxivStreamFrameHeader& header = frame->header;
+
+        if (!readFully(fd, &header, sizeof(header)))
+        {
+            return nullptr;
+        }
+
+        frame->format = string(header.format, strnlen(header.format, sizeof(header.format)));
+        frame->name = string(header.name, strnlen(header.name, sizeof(header.name)));
+        uint64_t rawBytes = (uint64_t)header.width * header.height * header.channels * wxivStreamDepthBytes(header.depth);
+
+        bool isValid = (memcmp(header.magic, WXIV_STREAM_MAGIC, sizeof(WXIV_STREAM_MAGIC)) == 0) && (header.version == WXIV_STREAM_VERSION) &&
+            (header.headerSize >= sizeof(header)) && (header.headerSize <= 4096) && (header.imageBytes <= this->maxFrameBytes) &&
+            (header.shapesBytes <= this->maxFrameBytes - header.imageBytes) && !frame->format.empty() &&
+            ((frame->format != "raw") || ((header.channels >= 1) && (header.channels <= 4) && (rawBytes > 0) && (rawBytes == header.imageBytes)));
+
+        if (!isValid)
+        {
+            this->errorCount++;
+            return nullptr;
+        }
+
+        // a later version's header can be bigger
+        vector<uint8_t> headerRest(header.headerSize - sizeof(header));
+
+        if (!readFully(fd, headerRest.data(), headerRest.size()) || !readGrowing(fd, frame->image, header.imageBytes) ||
+            !readGrowing(fd, frame->shapes, header.shapesBytes))
+        {
+            return nullptr;
+        }
+
+        this->receivedCount++;
+        return frame;
+    }
+
+    /**
+     * @brief Wait for space in the queue, unless the frame may drop others.
+     * @return False if stopping.
+     */
+    bool SocketFrameReceiver::enqueue(std::shared_ptr<Frame> frame)
+    {
+        std::unique_lock<std::mutex> lock(this->queueMutex);
+
+        if (frame->header.flags & WXIV_STREAM_FLAG_MAY_DROP)
+        {
+            while (this->queue.size() >= this->maxQueuedFrames)
+            {
+                this->queue.pop_front();
+                this->droppedCount++;
+            }
+        }
+        else
+        {
+            // backpressure: the socket isn't read while waiting, so the producer blocks once its buffer fills
+            this->isWaitingForSpace = true;
+            this->queueSpaceCondition.wait(lock, [&]() { return this->isStopping || (this->queue.size() < this->maxQueuedFrames); });
+            this->isWaitingForSpace = false;
+        }
+
+        if (this->isStopping)
+        {
+            return false;
+        }
+
+        this->queue.push_back(frame);
+        return true;
+    }
+#endif
+
+    SocketFrameReceiver::~SocketFrameReceiver()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            this->isStopping = true;
+        }
+
+        this->queueSpaceCondition.notify_all();
+
+        if (this->thread.joinable())
+        {
+#ifndef _WIN32
+            char c = 0;
+
+            if (write(this->wakeFds[1], &c, 1) < 0)
+            {
+                // the pipe can't be full, the thread only reads it to stop
+            }
+#endif
+            this->thread.join();
+        }
+
+        close();
+    }
+
+    const std::filesystem::path& SocketFrameReceiver::getSocketPath()
+    {
+        return this->socketPath;
+    }
+
+    std::vector<std::shared_ptr<SocketFrameReceiver::Frame>> SocketFrameReceiver::takeFrames()
+    {
+        vector<std::shared_ptr<Frame>> frames;
+
+        {
+            std::lock_guard<std::mutex> lock(this->queueMutex);
+            frames.assign(this->queue.begin(), this->queue.end());
+            this->queue.clear();
+        }
+
+        this->queueSpaceCondition.notify_all();
+        return frames;
+    }
+
+    uint64_t SocketFrameReceiver::getReceivedCount()
+    {
+        return this->receivedCount;
+    }
+
+    uint64_t SocketFrameReceiver::getDroppedCount()
+    {
+        return this->droppedCount;
+    }
+
+    uint64_t SocketFrameReceiver::getErrorCount()
+    {
+        return this->errorCount;
+    }
+
+    bool SocketFrameReceiver::checkIsConnected()
+    {
+        return this->isConnected;
+    }
+
+    bool SocketFrameReceiver::checkIsWaitingForSpace()
+    {
+        return this->isWaitingForSpace;
+    }
+}
@@ -0,0 +1,107 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+
+#include "WxivStreamFrame.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief Viewer side of frames streamed over a Unix domain socket (see WxivStreamFrame.h for the protocol and the
+     * producer side).
+     *
+     * This listens on the socket and reads frames on a background thread into a small queue, which the caller polls with
+     * takeFrames(). When the queue is full the thread stops reading, so the producer blocks (backpressure), unless the
+     * new frame allows dropping, and then the oldest queued frame is dropped. One producer is read at a time, the next
+     * one is accepted when it disconnects.
+     *
+     * POSIX only; elsewhere the constructor throws.
+     */
+    class SocketFrameReceiver
+    {
+      public:
+        struct Frame
+        {
+            WxivStreamFrameHeader header;
+            std::string format;
+            std::string name;
+            std::vector<uint8_t> image;
+            std::vector<uint8_t> shapes;
+        };
+
+      private:
+        std::filesystem::path socketPath;
+        int maxQueuedFrames;
+        uint64_t maxFrameBytes;
+        int listenFd = -1;
+        bool isBound = false;
+        uint64_t boundDev = 0;
+        uint64_t boundIno = 0;
+        int wakeFds[2] = {-1, -1};
+
+        std::mutex queueMutex;
+        std::condition_variable queueSpaceCondition;
+        std::deque<std::shared_ptr<Frame>> queue;
+        bool isStopping = false;
+
+        std::atomic<uint64_t> receivedCount = 0;
+        std::atomic<uint64_t> droppedCount = 0;
+        std::atomic<uint64_t> errorCount = 0;
+        std::atomic<bool> isConnected = false;
+        std::atomic<bool> isWaitingForSpace = false;
+
+        std::thread thread;
+
+        void close();
+        void run();
+        bool waitReadable(int fd);
+        bool readFully(int fd, void* buf, size_t size);
+        bool readGrowing(int fd, std::vector<uint8_t>& buf, uint64_t size);
+        std::shared_ptr<Frame> readFrame(int fd);
+        bool enqueue(std::shared_ptr<Frame> frame);
+
+      public:
+        /**
+         * @brief Start listening. An existing socket file at the path is replaced. Throws runtime_error on failure.
+         * @param maxQueuedFrames Frames received but not taken yet, past which backpressure or dropping starts.
+         * @param maxFrameBytes A frame with more image and shapes bytes than this is a protocol error. Buffers grow as the
+         * bytes arrive, so a bad header can't make this allocate the claimed size up front.
+         */
+        SocketFrameReceiver(const std::filesystem::path& socketPath, int maxQueuedFrames = 8, uint64_t maxFrameBytes = 256ull << 20);
+        ~SocketFrameReceiver();
+
+        SocketFrameReceiver(const SocketFrameReceiver&) = delete;
+        SocketFrameReceiver& operator=(const SocketFrameReceiver&) = delete;
+
+        const std::filesystem::path& getSocketPath();
+
+        /**
+         * @brief Get the frames received since the last call, oldest first.
+         */
+        std::vector<std::shared_ptr<Frame>> takeFrames();
+
+        uint64_t getReceivedCount();
+        uint64_t getDroppedCount();
+
+        /**
+         * @brief Count of connections closed for a bad frame header or payload size.
+         */
+        uint64_t getErrorCount();
+        bool checkIsConnected();
+
+        /**
+         * @brief Whether the reader is holding a frame until takeFrames() makes room, so the producer is held back.
+         */
+        bool checkIsWaitingForSpace();
+    };
+}
@@ -0,0 +1,261 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <fstream>
+#include <unordered_set>
+#include <cstdint>
+#include <stdexcept>
+
+#include "TiffUtil.h"
+#include "StringUtil.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace Wxiv
+{
+    namespace TiffUtil
+    {
+        // guard against garbage or cyclic IFD chains
+        static const int MaxPageCount = 1000000;
+
+        /**
+         * @brief Read an unsigned int of the given byte count in the file's byte order.
+         */
+        static uint64_t readUInt(std::ifstream& f, int byteCount, bool isBigEndian)
+        {
+            uint8_t bytes[8];
+
+            if (!f.read((char*)bytes, byteCount))
+            {
+                throw runtime_error("Unexpected end of TIFF file.");
+            }
+
+            uint64_t value = 0;
+
+            for (int i = 0; i < byteCount; i++)
+            {
+                int shift = isBigEndian ? (byteCount - 1 - i) * 8 : i * 8;
+                value |= (uint64_t)bytes[i] << shift;
+            }
+
+            return value;
+        }
+
+        bool checkIsTiffExtension(const std::string& ext)
+        {
+            string s = getNormalizedExt(ext);
+            return (s == "tif") || (s == "tiff");
+        }
+
+        /**
+         * @brief An open TIFF file positioned at its first IFD, with the byte order and offset sizes from its header.
+         * Handles both classic TIFF and BigTIFF.
+         */
+        struct TiffFile
+        {
+            std::ifstream f;
+            bool isBigEndian = false;
+            bool isBigTiff = false;
+            int offsetBytes = 4;
+            int countBytes = 2;
+            int entryBytes = 12;
+            uint64_t firstIfdOffset = 0;
+
+            /**
+             * @brief Throws runtime_error if the file is not a TIFF.
+             */
+            TiffFile(const fs::path& path) : f(path, std::ios::binary)
+            {
+                if (!f)
+                {
+                    throw runtime_error("Failed to open TIFF file.");
+                }
+
+                char order[2];
+
+                if (!f.read(order, 2))
+                {
+                    throw runtime_error("Unexpected end of TIFF file.");
+                }
+
+                if ((order[0] == 'I') && (order[1] == 'I'))
+                {
+                    isBigEndian = false;
+                }
+                else if ((order[0] == 'M') && (order[1] == 'M'))
+                {
+                    isBigEndian = true;
+                }
+                else
+                {
+                    throw runtime_error("Not a TIFF file.");
+                }
+
+                uint64_t version = readUInt(2);
+
+                if (version == 42)
+                {
+                    isBigTiff = false;
+                }
+                else if (version == 43)
+                {
+                    isBigTiff = true;
+
+                    // offset byte size (always 8) and a zero
+                    if (readUInt(2) != 8)
+                    {
+                        throw runtime_error("Unsupported BigTIFF offset size.");
+                    }
+
+                    readUInt(2);
+                }
+                else
+                {
+                    throw runtime_error("Not a TIFF file.");
+                }
+
+                offsetBytes = isBigTiff ? 8 : 4;
+                countBytes = isBigTiff ? 8 : 2;
+                entryBytes = isBigTiff ? 20 : 12;
+                firstIfdOffset = readUInt(offsetBytes);
+            }
+
+            uint64_t readUInt(int byteCount)
+            {
+                return TiffUtil::readUInt(f, byteCount, isBigEndian);
+            }
+        };
+
+        /**
+         * @brief Count the top-level images (IFDs) by walking the IFD chain. This only reads the header and each IFD's
+         * entry count and next-offset, so it is fast even for stacks with hundreds of pages.
+         * Sub-IFDs (e.g. reduced-resolution levels) are not counted.
+         * Throws runtime_error if the file is not a TIFF.
+         */
+        int countPages(const fs::path& path)
+        {
+            TiffFile tf(path);
+            uint64_t ifdOffset = tf.firstIfdOffset;
+            std::unordered_set<uint64_t> visited;
+            int pageCount = 0;
+
+            while ((ifdOffset != 0) && (pageCount < MaxPageCount))
+            {
+                if (!visited.insert(ifdOffset).second)
+                {
+                    // cycle, count what we have
+                    break;
+                }
+
+                tf.f.seekg((std::streamoff)ifdOffset);
+                uint64_t entryCount = tf.readUInt(tf.countBytes);
+                tf.f.seekg((std::streamoff)(entryCount * tf.entryBytes), std::ios::cur);
+                pageCount++;
+
+                ifdOffset = tf.readUInt(tf.offsetBytes);
+            }
+
+            return pageCount;
+        }
+
+        /**
+         * @brief Bytes per value of the IFD entry types we read, or 0 for types we don't.
+         */
+        static int getTypeBytes(uint64_t type)
+        {
+            switch (type)
+            {
+            case 1: // BYTE
+                return 1;
+            case 3: // SHORT
+                return 2;
+            case 4: // LONG
+                return 4;
+            case 16: // LONG8
+                return 8;
+            default:
+                return 0;
+            }
+        }
+
+        /**
+         * @brief Read the dimensions and sample layout of one page from its IFD entries, without touching the pixels.
+         * Throws runtime_error if the file is not a TIFF or doesn't have that page.
+         */
+        TiffPageInfo readPageInfo(const fs::path& path, int page)
+        {
+            TiffFile tf(path);
+            uint64_t ifdOffset = tf.firstIfdOffset;
+
+            for (int i = 0; (i < page) && (ifdOffset != 0); i++)
+            {
+                tf.f.seekg((std::streamoff)ifdOffset);
+                uint64_t entryCount = tf.readUInt(tf.countBytes);
+                tf.f.seekg((std::streamoff)(entryCount * tf.entryBytes), std::ios::cur);
+                ifdOffset = tf.readUInt(tf.offsetBytes);
+            }
+
+            if (ifdOffset == 0)
+            {
+                throw runtime_error("TIFF file does not have that page.");
+            }
+
+            tf.f.seekg((std::streamoff)ifdOffset);
+            uint64_t entryCount = tf.readUInt(tf.countBytes);
+            uint64_t entriesOffset = ifdOffset + tf.countBytes;
+            TiffPageInfo info;
+
+            for (uint64_t i = 0; i < entryCount; i++)
+            {
+                tf.f.seekg((std::streamoff)(entriesOffset + i * tf.entryBytes));
+                uint64_t tag = tf.readUInt(2);
+                uint64_t type = tf.readUInt(2);
+                uint64_t count = tf.readUInt(tf.offsetBytes);
+                int typeBytes = getTypeBytes(type);
+
+                if ((typeBytes == 0) || (count == 0))
+                {
+                    continue;
+                }
+
+                if ((tag != 256) && (tag != 257) && (tag != 258) && (tag != 262) && (tag != 277) && (tag != 339))
+                {
+                    continue;
+                }
+
+                // values that don't fit in the entry are at an offset, and we only want the first one anyway
+                if (count * typeBytes > (uint64_t)tf.offsetBytes)
+                {
+                    tf.f.seekg((std::streamoff)tf.readUInt(tf.offsetBytes));
+                }
+
+                uint64_t value = tf.readUInt(typeBytes);
+
+                switch (tag)
+                {
+                case 256:
+                    info.width = value;
+                    break;
+                case 257:
+                    info.height = value;
+                    break;
+                case 258:
+                    info.bitsPerSample = (int)value;
+                    break;
+                case 262:
+                    info.photometric = (int)value;
+                    break;
+                case 277:
+                    info.samplesPerPixel = (int)value;
+                    break;
+                case 339:
+                    info.sampleFormat = (int)value;
+                    break;
+                }
+            }
+
+            return info;
+        }
+    }
+}
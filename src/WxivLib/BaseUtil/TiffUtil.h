@@ -0,0 +1,32 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <cstdint>
+#include <filesystem>
+
+namespace Wxiv
+{
+    /**
+     * @brief Minimal TIFF structure reading, without decoding any pixels.
+     */
+    namespace TiffUtil
+    {
+        /**
+         * @brief The fields of one page's IFD that describe its pixels. Only the first value of multi-value fields.
+         */
+        struct TiffPageInfo
+        {
+            uint64_t width = 0;
+            uint64_t height = 0;
+            int bitsPerSample = 1;
+            int samplesPerPixel = 1;
+            int sampleFormat = 1; // 1 unsigned, 2 signed, 3 float
+            int photometric = -1; // 3 is palette
+        };
+
+        bool checkIsTiffExtension(const std::string& ext);
+        int countPages(const std::filesystem::path& path);
+        TiffPageInfo readPageInfo(const std::filesystem::path& path, int page);
+    }
+}
@@ -0,0 +1,331 @@
+/* Copyright(c) 2023 Ryan Seghers
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ *
+ * Shared-memory ring buffer of images, for a producer process (e.g. an algorithm under development) to show frames in
+ * wxiv without writing them to disk. This is plain C (C99 or C++) with no dependencies, so it can be copied into the
+ * producer's code. The producer side is POSIX only (shm_open).
+ *
+ * Layout of the shared memory object: a WxivShmRingHeader, then slotCount slots of slotSize bytes, each a
+ * WxivShmFrameHeader followed by the pixels. All fields are native-endian.
+ *
+ * Each slot's sequence is 0 while empty or being written, and set to the frame's sequence number (1, 2, ...) once the
+ * frame is complete. The producer writes each new frame over the slot with the oldest frame, except the one the viewer
+ * has pinned (pinnedSequence), which it is displaying straight from the shared memory. So the viewer can display
+ * frames with no copy, and the producer never waits on the viewer.
+ *
+ * Example producer:
+ *
+ *     WxivShmRing ring;
+ *     if (wxivShmRingCreate("/wxiv", 8, 2048 * 2048 * 2, &ring) != 0) { ... }
+ *
+ *     for (...)
+ *     {
+ *         // 16-bit gray, rows packed
+ *         uint16_t* p = (uint16_t*)wxivShmRingBeginFrame(&ring, 2048, 2048, 1, WXIV_SHM_DEPTH_16U, 2048 * 2, "denoised");
+ *         ... fill p, or use wxivShmRingWriteFrame to copy from a buffer ...
+ *         wxivShmRingEndFrame(&ring);
+ *     }
+ *
+ *     wxivShmRingClose(&ring, 1);
+ *
+ * and then open "shm:/wxiv" in wxiv (File -> Attach Shared Memory, or on the command line).
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define WXIV_SHM_RING_MAGIC 0x474e495256495857ull /* "WXIVRING" */
+#define WXIV_SHM_RING_VERSION 1
+#define WXIV_SHM_NAME_SIZE 64
+
+/* OpenCV depth codes, like .raw files */
+#define WXIV_SHM_DEPTH_8U 0
+#define WXIV_SHM_DEPTH_8S 1
+#define WXIV_SHM_DEPTH_16U 2
+#define WXIV_SHM_DEPTH_16S 3
+#define WXIV_SHM_DEPTH_32S 4
+#define WXIV_SHM_DEPTH_32F 5
+#define WXIV_SHM_DEPTH_64F 6
+
+    typedef struct WxivShmRingHeader
+    {
+        uint64_t magic;          /* WXIV_SHM_RING_MAGIC */
+        uint32_t version;        /* WXIV_SHM_RING_VERSION */
+        uint32_t headerSize;     /* bytes, offset of the first slot */
+        uint32_t slotCount;      /* at least 2 */
+        uint32_t reserved0;
+        uint64_t slotSize;       /* bytes per slot, frame header included, multiple of 64 */
+        uint64_t lastSequence;   /* atomic, newest complete frame, 0 if none yet */
+        uint64_t pinnedSequence; /* atomic, set by the viewer, the frame the producer must not overwrite, 0 if none */
+        uint8_t reserved[16];
+    } WxivShmRingHeader;
+
+    typedef struct WxivShmFrameHeader
+    {
+        uint64_t sequence;    /* atomic, 0 while empty or being written */
+        uint32_t width;       /* pixels */
+        uint32_t height;      /* pixels */
+        uint32_t channels;    /* 1, 3 (BGR), or 4 (BGRA) */
+        uint32_t depth;       /* WXIV_SHM_DEPTH_* */
+        uint64_t rowStride;   /* bytes */
+        uint64_t timestampNs; /* CLOCK_MONOTONIC when the frame was completed */
+        char name[WXIV_SHM_NAME_SIZE]; /* optional, null-terminated, e.g. the pipeline step */
+        uint8_t reserved[24];
+    } WxivShmFrameHeader;
+
+    /* sizes are fixed so producers built with other compilers agree */
+    typedef char WxivShmRingHeaderSizeCheck[(sizeof(WxivShmRingHeader) == 64) ? 1 : -1];
+    typedef char WxivShmFrameHeaderSizeCheck[(sizeof(WxivShmFrameHeader) == 128) ? 1 : -1];
+
+#ifdef _MSC_VER
+    static inline uint64_t wxivShmLoad(const uint64_t* p)
+    {
+        return (uint64_t)_InterlockedCompareExchange64((volatile __int64*)p, 0, 0);
+    }
+
+    static inline void wxivShmStore(uint64_t* p, uint64_t value)
+    {
+        _InterlockedExchange64((volatile __int64*)p, (__int64)value);
+    }
+
+    /* set to value only if it is still expected, returns nonzero if it was */
+    static inline int wxivShmCompareExchange(uint64_t* p, uint64_t expected, uint64_t value)
+    {
+        return _InterlockedCompareExchange64((volatile __int64*)p, (__int64)value, (__int64)expected) == (__int64)expected;
+    }
+#else
+    static inline uint64_t wxivShmLoad(const uint64_t* p)
+    {
+        return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+    }
+
+    static inline void wxivShmStore(uint64_t* p, uint64_t value)
+    {
+        __atomic_store_n(p, value, __ATOMIC_SEQ_CST);
+    }
+
+    /* set to value only if it is still expected, returns nonzero if it was */
+    static inline int wxivShmCompareExchange(uint64_t* p, uint64_t expected, uint64_t value)
+    {
+        return __atomic_compare_exchange_n(p, &expected, value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+#endif
+
+    static inline size_t wxivShmRingSize(uint32_t slotCount, uint64_t slotSize)
+    {
+        return sizeof(WxivShmRingHeader) + (size_t)slotCount * (size_t)slotSize;
+    }
+
+    static inline WxivShmFrameHeader* wxivShmRingSlot(WxivShmRingHeader* header, uint32_t slotIndex)
+    {
+        return (WxivShmFrameHeader*)((uint8_t*)header + header->headerSize + (size_t)slotIndex * header->slotSize);
+    }
+
+    static inline uint8_t wxivShmDepthBytes(uint32_t depth)
+    {
+        static const uint8_t bytes[] = {1, 1, 2, 2, 4, 4, 8};
+        return (depth < 7) ? bytes[depth] : 0;
+    }
+
+#ifndef _WIN32
+    /* producer side */
+    typedef struct WxivShmRing
+    {
+        char name[WXIV_SHM_NAME_SIZE];
+        WxivShmRingHeader* header;
+        size_t size;
+        WxivShmFrameHeader* writingSlot;
+    } WxivShmRing;
+
+    /**
+     * Create (or re-create) the shared memory object, with room for frames of up to maxFrameBytes.
+     * The name is like "/wxiv". Returns 0 on success, -1 on failure (see errno).
+     */
+    static inline int wxivShmRingCreate(const char* name, uint32_t slotCount, uint64_t maxFrameBytes, WxivShmRing* ring)
+    {
+        memset(ring, 0, sizeof(*ring));
+
+        if ((slotCount < 2) || (strlen(name) >= WXIV_SHM_NAME_SIZE))
+        {
+            return -1;
+        }
+
+        uint64_t slotSize = (sizeof(WxivShmFrameHeader) + maxFrameBytes + 63) / 64 * 64;
+        size_t size = wxivShmRingSize(slotCount, slotSize);
+
+        /* new object, so a viewer still attached to an old one doesn't see it change size under it */
+        shm_unlink(name);
+        int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+
+        if (fd < 0)
+        {
+            return -1;
+        }
+
+        if (ftruncate(fd, (off_t)size) != 0)
+        {
+            close(fd);
+            shm_unlink(name);
+            return -1;
+        }
+
+        void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (p == MAP_FAILED)
+        {
+            shm_unlink(name);
+            return -1;
+        }
+
+        /* ftruncate zero-filled it, so every slot is empty */
+        WxivShmRingHeader* header = (WxivShmRingHeader*)p;
+        header->version = WXIV_SHM_RING_VERSION;
+        header->headerSize = sizeof(WxivShmRingHeader);
+        header->slotCount = slotCount;
+        header->slotSize = slotSize;
+        wxivShmStore(&header->magic, WXIV_SHM_RING_MAGIC);
+
+        strcpy(ring->name, name);
+        ring->header = header;
+        ring->size = size;
+        return 0;
+    }
+
+    /**
+     * Start writing a frame, and get where to write its pixels. Returns NULL if the frame is too big for the slots.
+     */
+    static inline void* wxivShmRingBeginFrame(
+        WxivShmRing* ring, uint32_t width, uint32_t height, uint32_t channels, uint32_t depth, uint64_t rowStride, const char* name)
+    {
+        WxivShmRingHeader* header = ring->header;
+        uint64_t rowBytes = (uint64_t)width * channels * wxivShmDepthBytes(depth);
+
+        if ((rowBytes == 0) || (rowStride < rowBytes) || (height == 0) ||
+            (sizeof(WxivShmFrameHeader) + rowStride * (height - 1) + rowBytes > header->slotSize))
+        {
+            return NULL;
+        }
+
+        WxivShmFrameHeader* slot = NULL;
+
+        /* the oldest frame that isn't pinned, and the pin can change while choosing, so claim the slot then re-check */
+        while (slot == NULL)
+        {
+            uint64_t pinned = wxivShmLoad(&header->pinnedSequence);
+            uint64_t oldest = UINT64_MAX;
+
+            for (uint32_t i = 0; i < header->slotCount; i++)
+            {
+                WxivShmFrameHeader* s = wxivShmRingSlot(header, i);
+                uint64_t seq = wxivShmLoad(&s->sequence);
+
+                if (((seq != pinned) || (seq == 0)) && (seq < oldest))
+                {
+                    oldest = seq;
+                    slot = s;
+                }
+            }
+
+            wxivShmStore(&slot->sequence, 0);
+
+            if ((oldest != 0) && (wxivShmLoad(&header->pinnedSequence) == oldest))
+            {
+                /* pinned just now, so give it back */
+                wxivShmStore(&slot->sequence, oldest);
+                slot = NULL;
+            }
+        }
+
+        slot->width = width;
+        slot->height = height;
+        slot->channels = channels;
+        slot->depth = depth;
+        slot->rowStride = rowStride;
+        memset(slot->name, 0, sizeof(slot->name));
+
+        for (size_t i = 0; name && name[i] && (i < sizeof(slot->name) - 1); i++)
+        {
+            slot->name[i] = name[i];
+        }
+
+        ring->writingSlot = slot;
+        return (uint8_t*)slot + sizeof(WxivShmFrameHeader);
+    }
+
+    /**
+     * Publish the frame started by wxivShmRingBeginFrame.
+     */
+    static inline void wxivShmRingEndFrame(WxivShmRing* ring)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        ring->writingSlot->timestampNs = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+
+        uint64_t seq = wxivShmLoad(&ring->header->lastSequence) + 1;
+        wxivShmStore(&ring->writingSlot->sequence, seq);
+        wxivShmStore(&ring->header->lastSequence, seq);
+        ring->writingSlot = NULL;
+    }
+
+    /**
+     * Copy a frame in. srcStride is the source's bytes per row, the ring's rows are packed.
+     * Returns 0 on success, -1 if the frame is too big for the slots.
+     */
+    static inline int wxivShmRingWriteFrame(WxivShmRing* ring, const void* pixels, uint32_t width, uint32_t height, uint32_t channels,
+        uint32_t depth, uint64_t srcStride, const char* name)
+    {
+        uint64_t rowBytes = (uint64_t)width * channels * wxivShmDepthBytes(depth);
+        uint8_t* dst = (uint8_t*)wxivShmRingBeginFrame(ring, width, height, channels, depth, rowBytes, name);
+
+        if (!dst)
+        {
+            return -1;
+        }
+
+        for (uint32_t y = 0; y < height; y++)
+        {
+            memcpy(dst + y * rowBytes, (const uint8_t*)pixels + y * srcStride, (size_t)rowBytes);
+        }
+
+        wxivShmRingEndFrame(ring);
+        return 0;
+    }
+
+    static inline void wxivShmRingClose(WxivShmRing* ring, int doUnlink)
+    {
+        if (ring->header)
+        {
+            munmap(ring->header, ring->size);
+        }
+
+        if (doUnlink)
+        {
+            shm_unlink(ring->name);
+        }
+
+        memset(ring, 0, sizeof(*ring));
+    }
+#endif
+
+#ifdef __cplusplus
+}
+#endif
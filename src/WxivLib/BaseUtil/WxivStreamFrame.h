@@ -0,0 +1,225 @@
+/* Copyright(c) 2023 Ryan Seghers
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ *
+ * Frames streamed to wxiv over a Unix domain socket, for a producer process that can't easily share memory with wxiv
+ * (e.g. in a container, with the socket file in a mounted dir). This is plain C (C99 or C++) with no dependencies, so
+ * it can be copied into the producer's code. POSIX only.
+ *
+ * wxiv listens on the socket (File -> Listen on Socket, or "unix:/path/to.sock" on the command line), and one producer
+ * at a time connects and writes frames. Each frame is a WxivStreamFrameHeader, then imageBytes of image, then
+ * shapesBytes of shapes. All fields are native-endian. wxiv closes the connection on a frame of more than 256 MB.
+ *
+ * The image is either raw pixels (format "raw", rows packed, described by width, height, channels, and depth) or an
+ * encoded image file's bytes (format is the file extension, e.g. "png" or "tif"). The shapes are optional, an Arrow
+ * IPC stream of a table with the same columns as a .geo.csv or .parquet shapes file.
+ *
+ * Backpressure: wxiv queues a few received frames for the UI. When that queue is full it stops reading the socket, so
+ * the producer's writes block until wxiv catches up. A frame with WXIV_STREAM_FLAG_MAY_DROP set instead makes wxiv drop
+ * the oldest queued frame, so a producer that must not stall can set it on every frame.
+ *
+ * Example producer in C:
+ *
+ *     int fd = wxivStreamConnect("/tmp/wxiv.sock");
+ *     if (fd < 0) { ... }
+ *
+ *     for (...)
+ *     {
+ *         // 16-bit gray
+ *         if (wxivStreamSendRawFrame(fd, pixels, 640, 480, 1, WXIV_STREAM_DEPTH_16U, WXIV_STREAM_FLAG_MAY_DROP, "denoised") != 0) { ... }
+ *     }
+ *
+ *     close(fd);
+ *
+ * Example producer in Python:
+ *
+ *     import socket, struct
+ *     s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+ *     s.connect("/tmp/wxiv.sock")
+ *     png = open("step1.png", "rb").read()
+ *     header = struct.pack("=8sIIIIIII12sQQ48s16x", b"WXIVFRM", 1, 128, 1, 0, 0, 0, 0, b"png", len(png), 0, b"step1")
+ *     s.sendall(header + png)
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define WXIV_STREAM_MAGIC "WXIVFRM"
+#define WXIV_STREAM_VERSION 1
+#define WXIV_STREAM_FORMAT_SIZE 12
+#define WXIV_STREAM_NAME_SIZE 48
+
+/* flags */
+#define WXIV_STREAM_FLAG_MAY_DROP 1
+
+/* OpenCV depth codes, like .raw files */
+#define WXIV_STREAM_DEPTH_8U 0
+#define WXIV_STREAM_DEPTH_8S 1
+#define WXIV_STREAM_DEPTH_16U 2
+#define WXIV_STREAM_DEPTH_16S 3
+#define WXIV_STREAM_DEPTH_32S 4
+#define WXIV_STREAM_DEPTH_32F 5
+#define WXIV_STREAM_DEPTH_64F 6
+
+    typedef struct WxivStreamFrameHeader
+    {
+        char magic[8];                        /* WXIV_STREAM_MAGIC, null-terminated */
+        uint32_t version;                     /* WXIV_STREAM_VERSION */
+        uint32_t headerSize;                  /* bytes, the image follows this many bytes after the start */
+        uint32_t flags;                       /* WXIV_STREAM_FLAG_* */
+        uint32_t width;                       /* raw only, pixels */
+        uint32_t height;                      /* raw only, pixels */
+        uint32_t channels;                    /* raw only, 1, 3 (BGR), or 4 (BGRA) */
+        uint32_t depth;                       /* raw only, WXIV_STREAM_DEPTH_* */
+        char format[WXIV_STREAM_FORMAT_SIZE]; /* "raw", or the encoded image's file extension, null-terminated */
+        uint64_t imageBytes;                  /* bytes of image after the header */
+        uint64_t shapesBytes;                 /* bytes of Arrow IPC stream after the image, 0 if none */
+        char name[WXIV_STREAM_NAME_SIZE];     /* optional, null-terminated, e.g. the pipeline step */
+        uint8_t reserved[16];
+    } WxivStreamFrameHeader;
+
+    /* size is fixed so producers built with other compilers agree */
+    typedef char WxivStreamFrameHeaderSizeCheck[(sizeof(WxivStreamFrameHeader) == 128) ? 1 : -1];
+
+    static inline uint8_t wxivStreamDepthBytes(uint32_t depth)
+    {
+        static const uint8_t bytes[] = {1, 1, 2, 2, 4, 4, 8};
+        return (depth < 7) ? bytes[depth] : 0;
+    }
+
+    /**
+     * Fill in a header, with the strings truncated to fit.
+     */
+    static inline void wxivStreamInitHeader(WxivStreamFrameHeader* header, const char* format, uint64_t imageBytes, uint64_t shapesBytes,
+        uint32_t flags, const char* name)
+    {
+        memset(header, 0, sizeof(*header));
+        memcpy(header->magic, WXIV_STREAM_MAGIC, sizeof(WXIV_STREAM_MAGIC));
+        header->version = WXIV_STREAM_VERSION;
+        header->headerSize = sizeof(WxivStreamFrameHeader);
+        header->flags = flags;
+        header->imageBytes = imageBytes;
+        header->shapesBytes = shapesBytes;
+
+        for (size_t i = 0; format && format[i] && (i < sizeof(header->format) - 1); i++)
+        {
+            header->format[i] = format[i];
+        }
+
+        for (size_t i = 0; name && name[i] && (i < sizeof(header->name) - 1); i++)
+        {
+            header->name[i] = name[i];
+        }
+    }
+
+#ifndef _WIN32
+    /**
+     * Connect to wxiv listening on this socket path. Returns the socket, or -1 on failure (see errno).
+     */
+    static inline int wxivStreamConnect(const char* path)
+    {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+
+        if (strlen(path) >= sizeof(addr.sun_path))
+        {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+
+        strcpy(addr.sun_path, path);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (fd < 0)
+        {
+            return -1;
+        }
+
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+        {
+            close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+
+    /**
+     * Write all of it, blocking while wxiv applies backpressure. Returns 0 on success, -1 on failure (see errno).
+     */
+    static inline int wxivStreamSendAll(int fd, const void* data, uint64_t size)
+    {
+        const uint8_t* p = (const uint8_t*)data;
+
+        while (size > 0)
+        {
+#ifdef MSG_NOSIGNAL
+            ssize_t n = send(fd, p, (size_t)size, MSG_NOSIGNAL);
+#else
+            ssize_t n = send(fd, p, (size_t)size, 0);
+#endif
+
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                return -1;
+            }
+
+            p += n;
+            size -= (uint64_t)n;
+        }
+
+        return 0;
+    }
+
+    /**
+     * Send a frame with an image in any format and optional shapes (shapesBytes can be 0).
+     * Returns 0 on success, -1 on failure (see errno).
+     */
+    static inline int wxivStreamSendFrame(int fd, const WxivStreamFrameHeader* header, const void* image, const void* shapes)
+    {
+        if ((wxivStreamSendAll(fd, header, sizeof(*header)) != 0) || (wxivStreamSendAll(fd, image, header->imageBytes) != 0))
+        {
+            return -1;
+        }
+
+        return (header->shapesBytes > 0) ? wxivStreamSendAll(fd, shapes, header->shapesBytes) : 0;
+    }
+
+    /**
+     * Send raw pixels, rows packed. Returns 0 on success, -1 on failure (see errno).
+     */
+    static inline int wxivStreamSendRawFrame(
+        int fd, const void* pixels, uint32_t width, uint32_t height, uint32_t channels, uint32_t depth, uint32_t flags, const char* name)
+    {
+        WxivStreamFrameHeader header;
+        uint64_t imageBytes = (uint64_t)width * height * channels * wxivStreamDepthBytes(depth);
+        wxivStreamInitHeader(&header, "raw", imageBytes, 0, flags, name);
+        header.width = width;
+        header.height = height;
+        header.channels = channels;
+        header.depth = depth;
+        return wxivStreamSendFrame(fd, &header, pixels, NULL);
+    }
+#endif
+
+#ifdef __cplusplus
+}
+#endif
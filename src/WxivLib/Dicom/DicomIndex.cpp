@@ -0,0 +1,286 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <filesystem>
+
+#include "DicomIndex.h"
+#include "DicomUtil.h"
+#include "WxivUtil.h"
+
+#include "dcmtk/dcmdata/dcfilefo.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcuid.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace Wxiv
+{
+    // values longer than this (there shouldn't be any we need) are left unread
+    static const Uint32 HeaderMaxReadLength = 4096;
+
+    // indexes hold all the contours, so don't keep every dir ever opened
+    static const size_t MaxCachedDirs = 8;
+
+    std::mutex DicomIndex::cacheMutex;
+    std::list<DicomIndex::CacheEntry> DicomIndex::cacheLru;
+    std::unordered_map<std::string, std::list<DicomIndex::CacheEntry>::iterator> DicomIndex::cache;
+
+    DicomIndex::DicomIndex(const std::vector<wxString>& paths)
+    {
+        this->entries.resize(paths.size());
+        this->stamps.resize(paths.size());
+        vector<vector<Contour>> contoursByEntry(paths.size());
+
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            this->entries[i].path = paths[i];
+        }
+
+        // header reads mostly wait on the file system, so more threads than cores is ok
+        int threadCount = std::clamp((int)std::thread::hardware_concurrency(), 2, 8);
+        threadCount = std::min(threadCount, std::max(1, (int)paths.size()));
+        std::atomic<size_t> nextIndex = 0;
+        vector<std::thread> threads;
+
+        for (int t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back(
+                [&]()
+                {
+                    for (size_t i = nextIndex++; i < this->entries.size(); i = nextIndex++)
+                    {
+                        this->stamps[i] = getFileStamp(this->entries[i].path);
+                        readEntry(this->entries[i], contoursByEntry[i]);
+                    }
+                });
+        }
+
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+
+        for (vector<Contour>& entryContours : contoursByEntry)
+        {
+            this->contours.insert(this->contours.end(), entryContours.begin(), entryContours.end());
+        }
+
+        indexSlicePolygons();
+    }
+
+    DicomIndex::FileStamp DicomIndex::getFileStamp(const wxString& path)
+    {
+        FileStamp stamp;
+        std::error_code ec;
+        fs::path fsPath = toFilesystemPath(path);
+        stamp.size = fs::file_size(fsPath, ec);
+        stamp.modifyTime = ec ? 0 : (int64_t)fs::last_write_time(fsPath, ec).time_since_epoch().count();
+        return stamp;
+    }
+
+    /**
+     * @brief Read just the header elements we need, and if it's a structure set then also its contours.
+     * Any failure just leaves the entry not read.
+     */
+    void DicomIndex::readEntry(Entry& entry, std::vector<Contour>& entryContours)
+    {
+        if (!checkIsOnlyAscii(entry.path))
+        {
+            return;
+        }
+
+        DcmFileFormat dcmFile;
+        OFFilename dcmFilePath = entry.path.ToStdString().c_str();
+
+        if (dcmFile.loadFileUntilTag(dcmFilePath, EXS_Unknown, EGL_noChange, HeaderMaxReadLength, ERM_autoDetect, DCM_PixelData).bad())
+        {
+            return;
+        }
+
+        DcmDataset* dataset = dcmFile.getDataset();
+        OFString value;
+
+        if (dataset->findAndGetOFString(DCM_SOPInstanceUID, value).good())
+        {
+            entry.sopInstanceUid = value.c_str();
+        }
+
+        if (dataset->findAndGetOFString(DCM_SeriesInstanceUID, value).good())
+        {
+            entry.seriesInstanceUid = value.c_str();
+        }
+
+        if (dataset->findAndGetOFString(DCM_Modality, value).good())
+        {
+            entry.modality = value.c_str();
+        }
+
+        Sint32 instanceNumber = 0;
+
+        if (dataset->findAndGetSint32(DCM_InstanceNumber, instanceNumber).good())
+        {
+            entry.instanceNumber = instanceNumber;
+        }
+
+        Uint16 rows = 0, cols = 0;
+
+        if (dataset->findAndGetUint16(DCM_Rows, rows).good() && dataset->findAndGetUint16(DCM_Columns, cols).good())
+        {
+            entry.rows = rows;
+            entry.cols = cols;
+        }
+
+        entry.hasPosition = true;
+
+        for (unsigned long i = 0; i < 3; i++)
+        {
+            Float64 v = 0;
+            entry.hasPosition = entry.hasPosition && dataset->findAndGetFloat64(DCM_ImagePositionPatient, v, i).good();
+            entry.position[i] = v;
+        }
+
+        entry.hasOrientation = true;
+
+        for (unsigned long i = 0; i < 6; i++)
+        {
+            entry.hasOrientation = entry.hasOrientation && dataset->findAndGetFloat64(DCM_ImageOrientationPatient, entry.orientation[i], i).good();
+        }
+
+        entry.hasPixelSpacing = dataset->findAndGetFloat64(DCM_PixelSpacing, entry.pixelSpacing[0], 0).good() &&
+            dataset->findAndGetFloat64(DCM_PixelSpacing, entry.pixelSpacing[1], 1).good();
+
+        bool isStructureSetClass = dataset->findAndGetOFString(DCM_SOPClassUID, value).good() && (value == UID_RTStructureSetStorage);
+        entry.isStructureSet = (entry.modality == "RTSTRUCT") || isStructureSetClass;
+        entry.isRead = true;
+
+        if (entry.isStructureSet)
+        {
+            entryContours = loadContours(entry.path);
+        }
+    }
+
+    /**
+     * @brief Transform each contour slice to the pixel coords of the image it's on, once, and index them by that image.
+     * Slices on images that aren't in the dir, or that don't have position and spacing, are left out.
+     */
+    void DicomIndex::indexSlicePolygons()
+    {
+        unordered_map<string, const Entry*> entryByUid;
+
+        for (const Entry& entry : this->entries)
+        {
+            if (entry.hasPosition && entry.hasPixelSpacing && !entry.isStructureSet)
+            {
+                entryByUid[entry.sopInstanceUid] = &entry;
+            }
+        }
+
+        for (const Contour& contour : this->contours)
+        {
+            for (size_t s = 0; s < contour.referencedSopInstanceUids.size(); s++)
+            {
+                const string& uid = contour.referencedSopInstanceUids[s];
+                auto iter = entryByUid.find(uid);
+
+                if (iter == entryByUid.end())
+                {
+                    continue;
+                }
+
+                // world to pixel coords, by the pixel spacing and the position of the image
+                const Entry& entry = *iter->second;
+                Polygon poly;
+                poly.colorRgb = cv::Scalar(contour.rgbColor[0], contour.rgbColor[1], contour.rgbColor[2]);
+                poly.pointDim = 1;
+                poly.lineThickness = 1;
+                poly.points.reserve(contour.slicePoints[s].size());
+
+                for (const ContourPoint& pt : contour.slicePoints[s])
+                {
+                    float x = (float)(entry.pixelSpacing[0] * pt.x - entry.position[0]);
+                    float y = (float)(entry.pixelSpacing[1] * pt.y - entry.position[1]);
+                    poly.points.emplace_back(x, y);
+                }
+
+                this->slicePolygonsByUid[uid].push_back(std::move(poly));
+            }
+        }
+    }
+
+    bool DicomIndex::checkIsCurrent(const std::vector<wxString>& paths)
+    {
+        if (paths.size() != this->entries.size())
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            if ((paths[i] != this->entries[i].path) || !(getFileStamp(paths[i]) == this->stamps[i]))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::shared_ptr<DicomIndex> DicomIndex::getForDir(const wxString& dirPath, const std::vector<wxString>& paths)
+    {
+        string key(dirPath.ToUTF8().data());
+
+        {
+            const std::lock_guard<std::mutex> lock(cacheMutex);
+            auto iter = cache.find(key);
+
+            if ((iter != cache.end()) && iter->second->index->checkIsCurrent(paths))
+            {
+                // most recently used to front
+                cacheLru.splice(cacheLru.begin(), cacheLru, iter->second);
+                return iter->second->index;
+            }
+        }
+
+        // not under the lock, this is the slow part
+        auto index = std::make_shared<DicomIndex>(paths);
+
+        const std::lock_guard<std::mutex> lock(cacheMutex);
+        auto iter = cache.find(key);
+
+        if (iter != cache.end())
+        {
+            cacheLru.erase(iter->second);
+        }
+
+        cacheLru.push_front({key, index});
+        cache[key] = cacheLru.begin();
+
+        while (cacheLru.size() > MaxCachedDirs)
+        {
+            cache.erase(cacheLru.back().dirKey);
+            cacheLru.pop_back();
+        }
+
+        return index;
+    }
+
+    const std::vector<DicomIndex::Entry>& DicomIndex::getEntries()
+    {
+        return this->entries;
+    }
+
+    const std::vector<Contour>& DicomIndex::getContours()
+    {
+        return this->contours;
+    }
+
+    const std::vector<Polygon>* DicomIndex::findSlicePolygons(const std::string& sopInstanceUid)
+    {
+        auto iter = this->slicePolygonsByUid.find(sopInstanceUid);
+        return (iter != this->slicePolygonsByUid.end()) ? &iter->second : nullptr;
+    }
+}
@@ -0,0 +1,109 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <opencv2/opencv.hpp>
+
+#include "WxWidgetsUtil.h"
+#include "Contour.h"
+#include "Polygon.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief What's known about each dcm file in a dir from just its header, plus the contours from any structure set
+     * files, so a dir can be listed without decoding (or even reading) any pixel data.
+     *
+     * Headers are read on several threads, stopping at the pixel data and leaving long values unread. Only RTSTRUCT
+     * files are parsed fully, for their contours. Indexes are cached for the most recently used few dirs, and a cached
+     * index is reused as long as the dir has the same dcm files with the same sizes and modify times.
+     *
+     * The contour slices are also indexed by the SOP instance UID of the image each is on, already transformed to
+     * that image's pixel coords, so attaching them to a loaded image is just a lookup.
+     */
+    class DicomIndex
+    {
+      public:
+        struct Entry
+        {
+            wxString path;
+            bool isRead = false; // false if the header couldn't be read, and then the rest is empty
+            std::string sopInstanceUid;
+            std::string seriesInstanceUid;
+            std::string modality;
+            int instanceNumber = 0;
+            int rows = 0;
+            int cols = 0;
+            bool hasPosition = false;
+            double position[3] = {0, 0, 0}; // ImagePositionPatient
+            bool hasOrientation = false;
+            double orientation[6] = {0, 0, 0, 0, 0, 0}; // ImageOrientationPatient, row then col direction
+            bool hasPixelSpacing = false;
+            double pixelSpacing[2] = {0, 0}; // between rows, then cols
+            bool isStructureSet = false;
+        };
+
+      private:
+        struct FileStamp
+        {
+            uintmax_t size = 0;
+            int64_t modifyTime = 0;
+
+            bool operator==(const FileStamp&) const = default;
+        };
+
+        struct CacheEntry
+        {
+            std::string dirKey;
+            std::shared_ptr<DicomIndex> index;
+        };
+
+        std::vector<Entry> entries;
+        std::vector<FileStamp> stamps; // corresponds to entries
+        std::vector<Contour> contours;
+
+        // by the SOP instance UID of the image they're on
+        std::unordered_map<std::string, std::vector<Polygon>> slicePolygonsByUid;
+
+        // front is most recently used
+        static std::mutex cacheMutex;
+        static std::list<CacheEntry> cacheLru;
+        static std::unordered_map<std::string, std::list<CacheEntry>::iterator> cache;
+
+        static FileStamp getFileStamp(const wxString& path);
+        static void readEntry(Entry& entry, std::vector<Contour>& entryContours);
+        bool checkIsCurrent(const std::vector<wxString>& paths);
+        void indexSlicePolygons();
+
+      public:
+        /**
+         * @brief Index these files, on a few threads. Files that can't be read are still listed, with isRead false, and
+         * nothing is known about them, so they may even be structure sets.
+         */
+        DicomIndex(const std::vector<wxString>& paths);
+
+        /**
+         * @brief The cached index of these files in the dir if it is still current, else a new one (which is then cached).
+         * @param paths The dcm files in the dir, in list order.
+         */
+        static std::shared_ptr<DicomIndex> getForDir(const wxString& dirPath, const std::vector<wxString>& paths);
+
+        const std::vector<Entry>& getEntries();
+
+        /**
+         * @brief Contours from all the structure set files, in file order.
+         */
+        const std::vector<Contour>& getContours();
+
+        /**
+         * @brief The contour slices on this image, in pixel coords, or nullptr if none.
+         */
+        const std::vector<Polygon>* findSlicePolygons(const std::string& sopInstanceUid);
+    };
+}
@@ -1,6 +1,7 @@
 // Copyright(c) 2022 Ryan Seghers
 // Distributed under the MIT License (http://opensource.org/licenses/MIT)
 #include <filesystem>
+#include <memory>
 #include <fmt/core.h>
 #include <cstring>
 
@@ -329,84 +330,33 @@ namespace Wxiv
     //     return transform.inv();
     // }
 
-    bool findAndParseDecimalStringTwo(DcmDataset* dataset, DcmTagKey tag, double& v1, double& v2)
-    {
-        DcmElement* element = nullptr;
-
-        if (dataset->findAndGetElement(tag, element).good())
-        {
-            DcmDecimalString* dsTag = OFstatic_cast(DcmDecimalString*, element);
-
-            if (dsTag->getFloat64(v1, 0).bad() || dsTag->getFloat64(v2, 1).bad())
-            {
-                std::cerr << "Error: Cannot read required tags for affine transformation." << std::endl;
-                return false;
-            }
-        }
-        else
-        {
-            std::cerr << "Error: Cannot read required tags for affine transformation." << std::endl;
-            return false;
-        }
-
-        return true;
-    }
-
-    cv::Mat getAffineTransform(DcmDataset* dataset)
-    {
-        double xPatient, yPatient;
-        double xPixelSpacing, yPixelSpacing;
-
-        if (findAndParseDecimalStringTwo(dataset, DCM_ImagePositionPatient, xPatient, yPatient) &&
-            findAndParseDecimalStringTwo(dataset, DCM_PixelSpacing, xPixelSpacing, yPixelSpacing))
-        {
-            cv::Mat transform = (cv::Mat_<double>(3, 3) << xPixelSpacing, 0, -xPatient, 0, yPixelSpacing, -yPatient, 0, 0, 1);
-
-            return transform;
-        }
-        else
-        {
-            return cv::Mat();
-        }
-    }
-
     /**
+     * @brief Make a DicomImage of one frame of the loaded file. Only that frame is read and decompressed (DCMTK partial
+     * access), so this is cheap for one frame of a huge multi-frame file. The dataset must outlive the DicomImage.
      * @param uuidStr Output. The uuid (as string) that contours refer to.
-     * @param affineXform Output. Affine transform from world (e.g. contour points) to pixels.
+     * @param frameIndex Which frame.
+     * @param frameCount Output. How many frames are in the file.
      */
-    DicomImage* loadDicomImage(OFFilename dcmFilePath, string& uuidStr, cv::Mat& affineXform)
+    std::unique_ptr<DicomImage> loadDicomImage(DcmFileFormat& dcmFile, string& uuidStr, int frameIndex, int& frameCount)
     {
-        DcmFileFormat dcmFile;
-        OFCondition status = dcmFile.loadFile(dcmFilePath);
-
-        if (!status.good())
-        {
-            cerr << "Error: cannot read DICOM file (" << status.text() << ")" << endl;
-            return nullptr;
-        }
-
         DcmDataset* dataset = dcmFile.getDataset();
         E_TransferSyntax xfer = dataset->getOriginalXfer();
 
-        Sint32 frameCount;
-        if (dataset->findAndGetSint32(DCM_NumberOfFrames, frameCount).bad())
-            frameCount = 1;
-
-        if (frameCount > 1)
-        {
-            cout << "Warn: Just writing first frame but frame count is " << frameCount << endl;
-            frameCount = 1;
-        }
+        Sint32 numberOfFrames;
+        if (dataset->findAndGetSint32(DCM_NumberOfFrames, numberOfFrames).bad() || (numberOfFrames < 1))
+            numberOfFrames = 1;
 
-        unsigned long compatMode = CIF_MayDetachPixelData | CIF_TakeOverExternalDataset;
-        DicomImage* di = new DicomImage(dataset, xfer, compatMode, 0, frameCount);
+        frameCount = numberOfFrames;
 
-        if (di == NULL)
+        if ((frameIndex < 0) || (frameIndex >= frameCount))
         {
-            cerr << "Error: Failed to load dicom image (out of mem?)" << endl;
+            cerr << "Error: frame " << frameIndex << " is out of range, frame count is " << frameCount << endl;
             return nullptr;
         }
 
+        unsigned long compatMode = CIF_MayDetachPixelData | CIF_UsePartialAccessToPixelData;
+        auto di = std::make_unique<DicomImage>(dataset, xfer, compatMode, (unsigned long)frameIndex, 1ul);
+
         if (di->getStatus() != EIS_Normal)
         {
             cerr << "Error: getStatus not normal" << endl;
@@ -417,9 +367,9 @@ namespace Wxiv
         if (!di->isMonochrome())
         {
             cout << "Warn: Converting to monochrome" << endl;
-            DicomImage* newimage = di->createMonochromeImage();
+            std::unique_ptr<DicomImage> newimage(di->createMonochromeImage());
 
-            if (newimage == NULL)
+            if (newimage == nullptr)
             {
                 cout << "Out of memory or cannot convert to monochrome image" << endl;
                 return nullptr;
@@ -430,8 +380,7 @@ namespace Wxiv
                 return nullptr;
             }
 
-            delete di;
-            di = newimage;
+            di = std::move(newimage);
         }
 
         // referred to by contours as DCM_ReferencedSOPInstanceUID
@@ -441,26 +390,27 @@ namespace Wxiv
             return nullptr;
         }
 
-        // Build the affine xform from world to pixels.
-        // cv::Point2f worldPoints[3] = { cv::Point2f(0, 0), cv::Point2f(1, 0),
-        // cv::Point2f(0, 1)};
-        // cv::Point2f pixelPoints[3] = { cv::Point2f(0, 0), cv::Point2f(1, 0),
-        // cv::Point2f(0, 1)};
-
-        // cv::InputArray srcPoints({ cv::Point2f(0, 0), cv::Point2f(0, 0),
-        // cv::Point2f(0, 0)});
-        // cv::InputArray dstPoints;
-        // affineXform = cv::getAffineTransform(worldPoints, pixelPoints);
-        affineXform = getAffineTransform(dataset);
-
         return di;
     }
 
     void dumpImages(string dcmFilePath, string outputFilePath)
     {
         string uuidStr;
-        cv::Mat affineXform;
-        DicomImage* di = loadDicomImage(dcmFilePath, uuidStr, affineXform);
+        int frameCount = 1;
+        DcmFileFormat dcmFile;
+
+        if (dcmFile.loadFile(dcmFilePath.c_str()).bad())
+        {
+            cerr << "Error: cannot read DICOM file" << endl;
+            return;
+        }
+
+        std::unique_ptr<DicomImage> di = loadDicomImage(dcmFile, uuidStr, 0, frameCount);
+
+        if (!di)
+        {
+            return;
+        }
 
         // write
         auto ofile = fopen(outputFilePath.c_str(), "wb");
@@ -486,7 +436,7 @@ namespace Wxiv
                 // tiffPlugin.setRowsPerStrip(0);
                 // result = di->writePluginFormat(&tiffPlugin, ofile, frame);
 
-                cv::Mat img = dcmToOpencv(di, frame);
+                cv::Mat img = dcmToOpencv(di.get(), frame);
                 cv::imwrite(outputFilePath, img);
                 result = 1;
             }
@@ -514,19 +464,19 @@ namespace Wxiv
                 return;
             }
         }
-
-        // delete di; // is throwing
     }
 
     /**
-     * @brief wxWidgets to load image in cross-platform way. For paths with non-ASCII characters this can only load a single page
-     * from multi-page tif's.
+     * @brief Load and decode one frame of a DICOM file. Pixel data is only read for that frame, so for multi-frame files
+     * each frame can be loaded on its own.
      * @param path
      * @param mats
-     * @param The TODO uuid that contours refer to.
+     * @param uuidStr Output. The uuid that contours refer to.
+     * @param frameIndex Which frame.
+     * @param frameCount Output. How many frames are in the file.
      * @return
      */
-    bool wxLoadDicomImage(const wxString& path, vector<cv::Mat>& mats, string& uuidStr, cv::Mat& affineXform)
+    bool wxLoadDicomImage(const wxString& path, vector<cv::Mat>& mats, string& uuidStr, int frameIndex, int& frameCount)
     {
         bool result = false;
 
@@ -558,11 +508,12 @@ namespace Wxiv
             }
             else
             {
-                DicomImage* di = loadDicomImage(dcmFilePath, uuidStr, affineXform);
+                std::unique_ptr<DicomImage> di = loadDicomImage(dcmFile, uuidStr, frameIndex, frameCount);
 
                 if (di != nullptr)
                 {
-                    cv::Mat img = dcmToOpencv(di, 0);
+                    // the DicomImage has just the one frame
+                    cv::Mat img = dcmToOpencv(di.get(), 0);
                     mats.push_back(img);
                     result = true;
                 }
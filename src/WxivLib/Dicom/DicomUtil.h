@@ -11,6 +11,6 @@
 
 namespace Wxiv
 {
-    bool wxLoadDicomImage(const wxString& path, std::vector<cv::Mat>& mats, std::string& uuidStr, cv::Mat& affineXform);
+    bool wxLoadDicomImage(const wxString& path, std::vector<cv::Mat>& mats, std::string& uuidStr, int frameIndex, int& frameCount);
     std::vector<Contour> loadContours(const wxString& path);
 }
@@ -0,0 +1,208 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <fmt/core.h>
+#include <opencv2/opencv.hpp>
+
+#include "DicomVolume.h"
+#include "DicomUtil.h"
+#include "WxivUtil.h"
+#include "VectorUtil.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    std::mutex DicomVolume::cacheMutex;
+    wxString DicomVolume::cachedDirPath;
+    std::shared_ptr<DicomVolume> DicomVolume::cachedVolume;
+
+    static cv::Mat decodeSlice(const wxString& path)
+    {
+        vector<cv::Mat> mats;
+        string uuidStr;
+        int frameCount = 1;
+
+        if (!wxLoadDicomImage(path, mats, uuidStr, 0, frameCount) || mats.empty())
+        {
+            throw runtime_error("Failed to load and decode a slice of the series.");
+        }
+
+        return mats[0];
+    }
+
+    /**
+     * @brief Distance along the normal of the slice plane, for sorting.
+     */
+    static double getSlicePosition(const DicomIndex::Entry& entry, const cv::Vec3d& normal)
+    {
+        return cv::Vec3d(entry.position[0], entry.position[1], entry.position[2]).dot(normal);
+    }
+
+    DicomVolume::DicomVolume(std::shared_ptr<DicomIndex> index, size_t budgetBytes) : index(index)
+    {
+        // the biggest series of images with positions
+        unordered_map<string, vector<const DicomIndex::Entry*>> entriesBySeries;
+        const vector<const DicomIndex::Entry*>* slices = nullptr;
+
+        for (const DicomIndex::Entry& entry : index->getEntries())
+        {
+            if (entry.isRead && !entry.isStructureSet && entry.hasPosition && (entry.rows > 0) && (entry.cols > 0))
+            {
+                vector<const DicomIndex::Entry*>& series = entriesBySeries[entry.seriesInstanceUid];
+                series.push_back(&entry);
+
+                if (!slices || (series.size() > slices->size()))
+                {
+                    slices = &series;
+                }
+            }
+        }
+
+        if (!slices)
+        {
+            throw runtime_error("There is no series of DICOM images with positions in this dir.");
+        }
+
+        vector<const DicomIndex::Entry*> sorted = *slices;
+        const DicomIndex::Entry& first = *sorted[0];
+        cv::Vec3d normal(0, 0, 1);
+
+        if (first.hasOrientation)
+        {
+            cv::Vec3d rowDir(first.orientation[0], first.orientation[1], first.orientation[2]);
+            cv::Vec3d colDir(first.orientation[3], first.orientation[4], first.orientation[5]);
+            normal = rowDir.cross(colDir);
+        }
+
+        std::stable_sort(sorted.begin(), sorted.end(),
+            [&](const DicomIndex::Entry* a, const DicomIndex::Entry* b) { return getSlicePosition(*a, normal) < getSlicePosition(*b, normal); });
+
+        for (const DicomIndex::Entry* entry : sorted)
+        {
+            if ((entry->rows != first.rows) || (entry->cols != first.cols))
+            {
+                throw runtime_error("The slices of the series are not all the same size.");
+            }
+
+            this->sopInstanceUids.push_back(entry->sopInstanceUid);
+        }
+
+        // the first slice tells the type, and then the size can be checked before decoding the rest
+        int depth = (int)sorted.size();
+        cv::Mat firstSlice = decodeSlice(sorted[0]->path);
+        size_t bytes = firstSlice.total() * firstSlice.elemSize() * depth;
+
+        if (bytes > budgetBytes)
+        {
+            throw runtime_error(fmt::format(
+                "The series volume ({} MB) is bigger than the image memory budget ({} MB).", bytes / (1024 * 1024), budgetBytes / (1024 * 1024)));
+        }
+
+        this->volume = std::make_shared<ImageVolume>(depth, firstSlice.rows, firstSlice.cols, firstSlice.type());
+        this->volume->setExtraBudgetBytes(budgetBytes - bytes);
+        firstSlice.copyTo(this->volume->getStackedSlice(0));
+
+        double sliceSpacing = (depth > 1) ? std::abs(getSlicePosition(*sorted.back(), normal) - getSlicePosition(first, normal)) / (depth - 1) : 1.0;
+        double rowSpacing = first.hasPixelSpacing ? first.pixelSpacing[0] : 1.0;
+        double colSpacing = first.hasPixelSpacing ? first.pixelSpacing[1] : 1.0;
+        this->volume->setVoxelSpacing((sliceSpacing > 0) ? sliceSpacing : 1.0, rowSpacing, colSpacing);
+
+        // the rest decoded in parallel, each straight into its place
+        int threadCount = std::clamp((int)std::thread::hardware_concurrency(), 1, 8);
+        threadCount = std::min(threadCount, std::max(1, depth - 1));
+        std::atomic<int> nextIndex = 1;
+        std::mutex errorMutex;
+        string error;
+        vector<std::thread> threads;
+
+        for (int t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back(
+                [&]()
+                {
+                    for (int i = nextIndex++; i < depth; i = nextIndex++)
+                    {
+                        try
+                        {
+                            cv::Mat slice = decodeSlice(sorted[i]->path);
+
+                            if ((slice.size() != firstSlice.size()) || (slice.type() != firstSlice.type()))
+                            {
+                                throw runtime_error("The slices of the series are not all the same size and type.");
+                            }
+
+                            slice.copyTo(this->volume->getStackedSlice(i));
+                        }
+                        catch (std::exception& ex)
+                        {
+                            const std::lock_guard<std::mutex> lock(errorMutex);
+                            error = ex.what();
+
+                            // no point decoding the rest
+                            nextIndex = depth;
+                        }
+                    }
+                });
+        }
+
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+
+        if (!error.empty())
+        {
+            throw runtime_error(error);
+        }
+    }
+
+    std::shared_ptr<DicomVolume> DicomVolume::getForDir(const wxString& dirPath, size_t budgetBytes)
+    {
+        vector<wxString> paths = listFilesInDir(dirPath);
+        vector<wxString> dcmPaths = vectorSelect<wxString>(paths, [](const wxString& s) { return wxFileName(s).GetExt().Lower() == "dcm"; });
+        std::shared_ptr<DicomIndex> index = DicomIndex::getForDir(dirPath, dcmPaths);
+
+        const std::lock_guard<std::mutex> lock(cacheMutex);
+
+        if (cachedVolume && (cachedDirPath == dirPath) && (cachedVolume->index == index) && (cachedVolume->volume->getBytes() <= budgetBytes))
+        {
+            // the budget may have changed, so the transposed copy gets what the voxels leave of this one
+            cachedVolume->volume->setExtraBudgetBytes(budgetBytes - cachedVolume->volume->getBytes());
+            return cachedVolume;
+        }
+
+        // let go of the old one before making a new one
+        cachedVolume.reset();
+        cachedVolume = std::make_shared<DicomVolume>(index, budgetBytes);
+        cachedDirPath = dirPath;
+        return cachedVolume;
+    }
+
+    void DicomVolume::releaseCached()
+    {
+        const std::lock_guard<std::mutex> lock(cacheMutex);
+        cachedVolume.reset();
+        cachedDirPath.clear();
+    }
+
+    std::shared_ptr<DicomIndex> DicomVolume::getIndex()
+    {
+        return this->index;
+    }
+
+    std::shared_ptr<ImageVolume> DicomVolume::getVolume()
+    {
+        return this->volume;
+    }
+
+    const std::string& DicomVolume::getSopInstanceUid(int stackedIndex)
+    {
+        return this->sopInstanceUids[stackedIndex];
+    }
+}
@@ -0,0 +1,59 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "WxWidgetsUtil.h"
+#include "DicomIndex.h"
+#include "ImageVolume.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief The slices of the biggest series in a dir of dcm files, sorted by position along the slice normal (from
+     * ImageOrientationPatient and ImagePositionPatient) into one contiguous ImageVolume, for reslicing.
+     *
+     * Slices are decoded on several threads straight into the volume. The volume must fit in the memory budget, and
+     * whatever is left of the budget is what the volume may use for a transposed copy for sagittal slices, so the two
+     * together stay within it (this is re-checked when a cached volume is reused under a different budget).
+     *
+     * Only the most recent volume is cached, since they're big, so that the axes can share it. It's reused while the
+     * dir's index is, and released when something other than a volume is opened.
+     */
+    class DicomVolume
+    {
+      private:
+        std::shared_ptr<DicomIndex> index;
+        std::shared_ptr<ImageVolume> volume;
+        std::vector<std::string> sopInstanceUids; // by stacked slice
+
+        static std::mutex cacheMutex;
+        static wxString cachedDirPath;
+        static std::shared_ptr<DicomVolume> cachedVolume;
+
+      public:
+        /**
+         * @brief Throws runtime_error if there's no series with positions, the slices differ in size or type, a slice
+         * fails to decode, or the volume is bigger than the budget.
+         */
+        DicomVolume(std::shared_ptr<DicomIndex> index, size_t budgetBytes);
+
+        static std::shared_ptr<DicomVolume> getForDir(const wxString& dirPath, size_t budgetBytes);
+
+        /**
+         * @brief Let go of the cached volume. It's freed once the list sources using it are gone.
+         */
+        static void releaseCached();
+
+        std::shared_ptr<DicomIndex> getIndex();
+        std::shared_ptr<ImageVolume> getVolume();
+
+        /**
+         * @brief The SOP instance UID of a stacked (axial) slice, e.g. to find its contours.
+         */
+        const std::string& getSopInstanceUid(int stackedIndex);
+    };
+}
@@ -0,0 +1,142 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+
+#include "ImageMemoryCache.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    ImageMemoryCache::ImageMemoryCache(size_t budgetBytes) : budgetBytes(budgetBytes)
+    {
+    }
+
+    void ImageMemoryCache::touch(std::shared_ptr<WxivImage> image, bool doPin)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+
+        if (doPin)
+        {
+            this->pinnedImage = image.get();
+        }
+
+        auto iter = this->entries.find(image.get());
+
+        if (iter != this->entries.end())
+        {
+            this->residentBytes -= iter->second->bytes;
+            this->lru.erase(iter->second);
+            this->entries.erase(iter);
+        }
+
+        if (image->getIsLoaded())
+        {
+            size_t bytes = image->getMemoryBytes();
+            this->lru.push_front({image, bytes});
+            this->entries[image.get()] = this->lru.begin();
+            this->residentBytes += bytes;
+        }
+    }
+
+    void ImageMemoryCache::evictOverBudget()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        refreshBytes();
+        evict();
+    }
+
+    /**
+     * @brief Re-read the size of each image that isn't busy. Caller holds the mutex.
+     */
+    void ImageMemoryCache::refreshBytes()
+    {
+        for (Entry& entry : this->lru)
+        {
+            std::unique_lock<std::mutex> imageLock(entry.image->getLoadMutex(), std::try_to_lock);
+
+            if (imageLock.owns_lock() && entry.image->getIsLoaded())
+            {
+                size_t bytes = entry.image->getMemoryBytes();
+                this->residentBytes = this->residentBytes - entry.bytes + bytes;
+                entry.bytes = bytes;
+            }
+        }
+    }
+
+    /**
+     * @brief Evict from the least recently used end until under budget. Caller holds the mutex.
+     */
+    void ImageMemoryCache::evict()
+    {
+        auto iter = this->lru.end();
+
+        while ((this->residentBytes > this->budgetBytes) && (iter != this->lru.begin()))
+        {
+            --iter;
+            WxivImage* p = iter->image.get();
+
+            if (p == this->pinnedImage)
+            {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> imageLock(p->getLoadMutex(), std::try_to_lock);
+
+            if (!imageLock.owns_lock())
+            {
+                // being loaded right now, get it next time
+                continue;
+            }
+
+            p->unload();
+            this->residentBytes -= iter->bytes;
+            this->evictionCount++;
+            this->entries.erase(p);
+            iter = this->lru.erase(iter);
+        }
+    }
+
+    void ImageMemoryCache::remove(std::shared_ptr<WxivImage> image)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        auto iter = this->entries.find(image.get());
+
+        if (iter != this->entries.end())
+        {
+            this->residentBytes -= iter->second->bytes;
+            this->lru.erase(iter->second);
+            this->entries.erase(iter);
+        }
+
+        if (this->pinnedImage == image.get())
+        {
+            this->pinnedImage = nullptr;
+        }
+    }
+
+    void ImageMemoryCache::setBudgetBytes(size_t bytes)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        this->budgetBytes = bytes;
+        refreshBytes();
+        evict();
+    }
+
+    size_t ImageMemoryCache::getBudgetBytes()
+    {
+        return this->budgetBytes;
+    }
+
+    size_t ImageMemoryCache::getResidentBytes()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->residentBytes;
+    }
+
+    int ImageMemoryCache::getEvictionCount()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->evictionCount;
+    }
+}
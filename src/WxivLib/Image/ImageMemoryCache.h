@@ -0,0 +1,81 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+#include "WxivImage.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief Keeps the total size of loaded image pixels under a budget by unloading the least-recently viewed images.
+     *
+     * This keeps a reference to each loaded image it tracks, in the order they were used, so an evicted image is never
+     * one that was already deleted. The list source removes an image from here when it's dropped from the list.
+     * Unloaded images go back to not-loaded state and are re-loaded on demand.
+     *
+     * Loads (including on prefetch threads) only touch, and eviction is a separate call made from the UI thread, since
+     * that's where images are read, with no lock. So the cache can go over budget between evictions by about what's
+     * being prefetched.
+     *
+     * Sizes are re-read at each eviction, since an image can grow after it was touched (e.g. its pyramid is built in the
+     * background on the first zoomed-out view).
+     *
+     * The most recent image touched with doPin is never evicted, since that's the one being viewed.
+     * Eviction only try-locks image load mutexes so it never waits on (or deadlocks with) a load in progress; a busy
+     * image is just skipped until next time.
+     */
+    class ImageMemoryCache
+    {
+      private:
+        struct Entry
+        {
+            std::shared_ptr<WxivImage> image;
+            size_t bytes = 0;
+        };
+
+        size_t budgetBytes = 0;
+        size_t residentBytes = 0;
+        int evictionCount = 0;
+
+        // front is most recently used
+        std::list<Entry> lru;
+        std::unordered_map<WxivImage*, std::list<Entry>::iterator> entries;
+        WxivImage* pinnedImage = nullptr; // identity only
+        std::mutex mutex;
+
+        void refreshBytes();
+        void evict();
+
+      public:
+        ImageMemoryCache(size_t budgetBytes);
+
+        /**
+         * @brief Record that this image was just used (or loaded). This doesn't evict, so it's safe from any thread.
+         * @param doPin True if this is the image being viewed, so it is protected from eviction.
+         */
+        void touch(std::shared_ptr<WxivImage> image, bool doPin);
+
+        /**
+         * @brief Unload least recently used images until under budget. Call only from the UI thread, and not while
+         * holding any image load mutex.
+         */
+        void evictOverBudget();
+
+        /**
+         * @brief Stop tracking this image, e.g. it was removed from the list.
+         */
+        void remove(std::shared_ptr<WxivImage> image);
+
+        /**
+         * @brief And evict down to it, so the same as evictOverBudget() about threads.
+         */
+        void setBudgetBytes(size_t bytes);
+        size_t getBudgetBytes();
+        size_t getResidentBytes();
+        int getEvictionCount();
+    };
+}
@@ -297,6 +297,18 @@ namespace Wxiv
         return false;
     }
 
+    /**
+     * @brief Load shapes from the contents of a .geo.csv, .parquet, or Arrow IPC stream (.arrows) that is in memory, e.g. a
+     * member of an archive or a streamed frame.
+     * This throws like tryLoadNeighborShapesFile if the table doesn't meet the criteria.
+     * @param name File name, for the format.
+     */
+    void ShapeSet::loadShapesBuffer(const uint8_t* data, size_t size, const std::string& name)
+    {
+        this->ptable = ArrowUtil::loadBuffer(data, size, name);
+        this->rebuildShapeVectors();
+    }
+
     /**
      * @brief For code repetition findShape. Check dist from target point (x,y) to pt, if less than
      * radius then add information to the vectors.
@@ -91,6 +91,7 @@ namespace Wxiv
         bool empty();
         bool emptyPostFilter();
         bool tryLoadNeighborShapesFile(const wxFileName& imagePath);
+        void loadShapesBuffer(const uint8_t* data, size_t size, const std::string& name);
         bool findShape(float x, float y, float radius, ShapeType& type, int& idx);
         int getTableIndex(ShapeType type, int idx);
         std::string getValueString(int tableIdx, std::string colName);
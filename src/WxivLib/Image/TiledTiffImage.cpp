@@ -0,0 +1,581 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <opencv2/opencv.hpp>
+#include <tiffio.h>
+
+#include "TiledTiffImage.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace Wxiv
+{
+    // synthesized levels are halved until they fit in this
+    static const int SynthesizedMinDim = 1024;
+    static const int SynthesizedTileDim = 512;
+
+    // strips bigger than this part of the cache budget are read in bands of rows of this part of it
+    static const int MaxStripBudgetDivisor = 4;
+    static const int StripBandBudgetDivisor = 16;
+
+    /**
+     * @brief Map the current directory's sample layout to an OpenCV type, or throw if we can't read it.
+     */
+    static int getDirectoryCvType(TIFF* tif)
+    {
+        uint16_t bitsPerSample = 0, samplesPerPixel = 0, sampleFormat = 0, planarConfig = 0, photometric = 0;
+        TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+        TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &samplesPerPixel);
+        TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLEFORMAT, &sampleFormat);
+        TIFFGetFieldDefaulted(tif, TIFFTAG_PLANARCONFIG, &planarConfig);
+        TIFFGetField(tif, TIFFTAG_PHOTOMETRIC, &photometric);
+
+        if (planarConfig != PLANARCONFIG_CONTIG)
+        {
+            throw runtime_error("Separate-plane TIFF is not supported for tiled reading.");
+        }
+
+        if (photometric == PHOTOMETRIC_PALETTE)
+        {
+            throw runtime_error("Palette TIFF is not supported for tiled reading.");
+        }
+
+        int depth = -1;
+
+        if ((bitsPerSample == 8) && (sampleFormat == SAMPLEFORMAT_UINT))
+            depth = CV_8U;
+        else if ((bitsPerSample == 16) && (sampleFormat == SAMPLEFORMAT_UINT))
+            depth = CV_16U;
+        else if ((bitsPerSample == 16) && (sampleFormat == SAMPLEFORMAT_INT))
+            depth = CV_16S;
+        else if ((bitsPerSample == 32) && (sampleFormat == SAMPLEFORMAT_INT))
+            depth = CV_32S;
+        else if ((bitsPerSample == 32) && (sampleFormat == SAMPLEFORMAT_IEEEFP))
+            depth = CV_32F;
+
+        if (depth < 0)
+        {
+            throw runtime_error("Unsupported TIFF sample format for tiled reading.");
+        }
+
+        if ((samplesPerPixel == 1) || (((samplesPerPixel == 3) || (samplesPerPixel == 4)) && ((depth == CV_8U) || (depth == CV_16U))))
+        {
+            return CV_MAKETYPE(depth, samplesPerPixel);
+        }
+
+        throw runtime_error("Unsupported TIFF channel count for tiled reading.");
+    }
+
+    static bool checkIsReducedImage(TIFF* tif)
+    {
+        uint32_t subfileType = 0;
+        TIFFGetFieldDefaulted(tif, TIFFTAG_SUBFILETYPE, &subfileType);
+        return (subfileType & FILETYPE_REDUCEDIMAGE) != 0;
+    }
+
+    TiledTiffImage::TiledTiffImage(const fs::path& path, size_t cacheBudgetBytes) : cacheBudgetBytes(cacheBudgetBytes)
+    {
+#ifdef _WIN32
+        this->tif = TIFFOpenW(path.c_str(), "r");
+#else
+        this->tif = TIFFOpen(path.c_str(), "r");
+#endif
+
+        if (!this->tif)
+        {
+            throw runtime_error("Failed to open TIFF file.");
+        }
+
+        try
+        {
+            readLevels();
+        }
+        catch (...)
+        {
+            TIFFClose(this->tif);
+            this->tif = nullptr;
+            throw;
+        }
+    }
+
+    TiledTiffImage::~TiledTiffImage()
+    {
+        if (this->tif)
+        {
+            TIFFClose(this->tif);
+        }
+    }
+
+    std::shared_ptr<TiledTiffImage> TiledTiffImage::tryOpen(const fs::path& path, int64_t minPixelCount, size_t cacheBudgetBytes)
+    {
+        try
+        {
+            auto image = std::make_shared<TiledTiffImage>(path, cacheBudgetBytes);
+            cv::Size size = image->getSize();
+
+            if ((int64_t)size.width * size.height >= minPixelCount)
+            {
+                return image;
+            }
+        }
+        catch (std::runtime_error&)
+        {
+            // not a layout we read this way
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief Read the current directory's dims and layout.
+     * @param cacheBudgetBytes Strips too big for this are banded if uncompressed, else throw.
+     */
+    static void readDirectoryLayout(TIFF* tif, size_t cacheBudgetBytes, int& width, int& height, int& tileWidth, int& tileHeight, bool& isTiled,
+        bool& isYCbCrJpeg, bool& isBanded)
+    {
+        uint32_t w = 0, h = 0;
+        TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &w);
+        TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &h);
+        width = (int)w;
+        height = (int)h;
+
+        if ((width <= 0) || (height <= 0))
+        {
+            throw runtime_error("TIFF directory has no image dims.");
+        }
+
+        uint16_t compression = 0, photometric = 0;
+        TIFFGetFieldDefaulted(tif, TIFFTAG_COMPRESSION, &compression);
+        TIFFGetField(tif, TIFFTAG_PHOTOMETRIC, &photometric);
+        isYCbCrJpeg = (compression == COMPRESSION_JPEG) && (photometric == PHOTOMETRIC_YCBCR);
+
+        isTiled = TIFFIsTiled(tif);
+        isBanded = false;
+
+        if (isTiled)
+        {
+            uint32_t tw = 0, th = 0;
+            TIFFGetField(tif, TIFFTAG_TILEWIDTH, &tw);
+            TIFFGetField(tif, TIFFTAG_TILELENGTH, &th);
+            tileWidth = (int)tw;
+            tileHeight = (int)th;
+        }
+        else
+        {
+            uint32_t rowsPerStrip = 0;
+            TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+            tileWidth = width;
+            tileHeight = (int)std::min(rowsPerStrip, h);
+
+            // a strip is decoded whole, so one that is most of the image would be most of the image in memory
+            int64_t rowBytes = std::max<int64_t>((int64_t)TIFFScanlineSize64(tif), 1);
+
+            if (rowBytes * tileHeight > (int64_t)(cacheBudgetBytes / MaxStripBudgetDivisor))
+            {
+                if (compression != COMPRESSION_NONE)
+                {
+                    throw runtime_error("Compressed TIFF strips are too big for tiled reading.");
+                }
+
+                isBanded = true;
+                tileHeight = (int)std::clamp<int64_t>((int64_t)(cacheBudgetBytes / StripBandBudgetDivisor) / rowBytes, 1, height);
+            }
+        }
+
+        if ((tileWidth <= 0) || (tileHeight <= 0))
+        {
+            throw runtime_error("TIFF directory has no tile or strip dims.");
+        }
+    }
+
+    /**
+     * @brief Find the full-resolution image and any reduced-resolution levels in the file.
+     */
+    void TiledTiffImage::readLevels()
+    {
+        if (!TIFFSetDirectory(this->tif, 0))
+        {
+            throw runtime_error("Failed to read first TIFF directory.");
+        }
+
+        Level level0;
+        level0.dirIndex = 0;
+        readDirectoryLayout(this->tif, this->cacheBudgetBytes, level0.width, level0.height, level0.tileWidth, level0.tileHeight, level0.isTiled,
+            level0.isYCbCrJpeg, level0.isBanded);
+        this->cvType = getDirectoryCvType(this->tif);
+
+        // copy SubIFD offsets before changing directory, which frees them
+        vector<uint64_t> subIfdOffsets;
+        uint16_t subIfdCount = 0;
+        uint64_t* pSubIfdOffsets = nullptr;
+
+        if (TIFFGetField(this->tif, TIFFTAG_SUBIFD, &subIfdCount, &pSubIfdOffsets) && pSubIfdOffsets)
+        {
+            subIfdOffsets.assign(pSubIfdOffsets, pSubIfdOffsets + subIfdCount);
+        }
+
+        vector<Level> reduced;
+
+        auto tryAddReduced = [&](Level& level)
+        {
+            // all levels have to be the same type, skip any (e.g. a thumbnail or mask) that isn't
+            try
+            {
+                readDirectoryLayout(this->tif, this->cacheBudgetBytes, level.width, level.height, level.tileWidth, level.tileHeight, level.isTiled,
+                    level.isYCbCrJpeg, level.isBanded);
+
+                if (getDirectoryCvType(this->tif) == this->cvType)
+                {
+                    reduced.push_back(level);
+                }
+            }
+            catch (std::runtime_error&)
+            {
+                // not usable as a level
+            }
+        };
+
+        for (uint64_t offset : subIfdOffsets)
+        {
+            if (TIFFSetSubDirectory(this->tif, offset))
+            {
+                Level level;
+                level.subIfdOffset = offset;
+                tryAddReduced(level);
+            }
+        }
+
+        if (reduced.empty() && TIFFSetDirectory(this->tif, 0))
+        {
+            // some writers put the pyramid in the top-level chain instead, right after the full-res image
+            // (stop at the first that isn't, so a multi-page stack doesn't cost a walk of all its pages)
+            int dirIndex = 0;
+
+            while (TIFFReadDirectory(this->tif) && checkIsReducedImage(this->tif))
+            {
+                Level level;
+                level.dirIndex = ++dirIndex;
+                tryAddReduced(level);
+            }
+        }
+
+        this->currentLevel = -1;
+        this->levels.push_back(level0);
+
+        // finest to coarsest, and each has to actually be smaller than the last
+        std::sort(reduced.begin(), reduced.end(), [](const Level& a, const Level& b) { return a.width > b.width; });
+
+        for (Level& level : reduced)
+        {
+            if ((level.width < this->levels.back().width) && (level.height <= this->levels.back().height))
+            {
+                level.scale = cv::Point2f((float)level0.width / level.width, (float)level0.height / level.height);
+                this->levels.push_back(level);
+            }
+        }
+
+        addSynthesizedLevels();
+    }
+
+    void TiledTiffImage::addSynthesizedLevels()
+    {
+        while (std::max(this->levels.back().width, this->levels.back().height) > SynthesizedMinDim)
+        {
+            const Level& prev = this->levels.back();
+            Level level;
+            level.width = (prev.width + 1) / 2;
+            level.height = (prev.height + 1) / 2;
+            level.tileWidth = SynthesizedTileDim;
+            level.tileHeight = SynthesizedTileDim;
+            level.isSynthesized = true;
+            level.scale = cv::Point2f((float)this->levels[0].width / level.width, (float)this->levels[0].height / level.height);
+            this->levels.push_back(level);
+        }
+    }
+
+    void TiledTiffImage::setLevelDirectory(int level)
+    {
+        if (this->currentLevel == level)
+        {
+            return;
+        }
+
+        const Level& lv = this->levels[level];
+        bool isOk = (lv.subIfdOffset != 0) ? TIFFSetSubDirectory(this->tif, lv.subIfdOffset) : TIFFSetDirectory(this->tif, (tdir_t)lv.dirIndex);
+
+        if (!isOk)
+        {
+            this->currentLevel = -1;
+            throw runtime_error("Failed to read TIFF directory.");
+        }
+
+        if (lv.isYCbCrJpeg)
+        {
+            // pseudo-tag, reset on every directory read
+            TIFFSetField(this->tif, TIFFTAG_JPEGCOLORMODE, JPEGCOLORMODE_RGB);
+        }
+
+        this->currentLevel = level;
+    }
+
+    /**
+     * @brief Decode one tile (or strip, or band of rows) from the file, cropped to the image, and in OpenCV channel order.
+     */
+    cv::Mat TiledTiffImage::decodeTile(int level, int tx, int ty)
+    {
+        setLevelDirectory(level);
+        const Level& lv = this->levels[level];
+        int x0 = tx * lv.tileWidth;
+        int y0 = ty * lv.tileHeight;
+
+        cv::Mat full(lv.tileHeight, lv.tileWidth, this->cvType);
+        tmsize_t bufSize = (tmsize_t)(full.total() * full.elemSize());
+        tmsize_t nRead;
+
+        if (lv.isTiled)
+        {
+            if (TIFFTileSize(this->tif) > bufSize)
+            {
+                throw runtime_error("Unexpected TIFF tile size.");
+            }
+
+            nRead = TIFFReadEncodedTile(this->tif, TIFFComputeTile(this->tif, (uint32_t)x0, (uint32_t)y0, 0, 0), full.data, bufSize);
+        }
+        else if (lv.isBanded)
+        {
+            // uncompressed, so libtiff can seek to any row without decoding the strip up to it
+            int rowCount = std::min(lv.tileHeight, lv.height - y0);
+            nRead = 0;
+
+            for (int r = 0; (r < rowCount) && (nRead >= 0); r++)
+            {
+                nRead = TIFFReadScanline(this->tif, full.ptr(r), (uint32_t)(y0 + r), 0);
+            }
+        }
+        else
+        {
+            nRead = TIFFReadEncodedStrip(this->tif, TIFFComputeStrip(this->tif, (uint32_t)y0, 0), full.data, bufSize);
+        }
+
+        if (nRead < 0)
+        {
+            throw runtime_error("Failed to decode TIFF tile.");
+        }
+
+        this->tileReadCount++;
+
+        // edge tiles are padded in the file
+        int w = std::min(lv.tileWidth, lv.width - x0);
+        int h = std::min(lv.tileHeight, lv.height - y0);
+        cv::Mat tile = ((w == full.cols) && (h == full.rows)) ? full : full(cv::Rect(0, 0, w, h)).clone();
+
+        if (tile.channels() == 3)
+        {
+            cv::cvtColor(tile, tile, cv::COLOR_RGB2BGR);
+        }
+        else if (tile.channels() == 4)
+        {
+            cv::cvtColor(tile, tile, cv::COLOR_RGBA2BGRA);
+        }
+
+        return tile;
+    }
+
+    /**
+     * @brief Build a tile of a synthesized level by reducing the 2x2 tile area of the next-finer level.
+     */
+    cv::Mat TiledTiffImage::synthesizeTile(int level, int tx, int ty)
+    {
+        const Level& lv = this->levels[level];
+        int x0 = tx * lv.tileWidth;
+        int y0 = ty * lv.tileHeight;
+        int w = std::min(lv.tileWidth, lv.width - x0);
+        int h = std::min(lv.tileHeight, lv.height - y0);
+
+        cv::Mat finer;
+        readRegionLocked(level - 1, cv::Rect(x0 * 2, y0 * 2, w * 2, h * 2), finer);
+
+        cv::Mat tile;
+        cv::resize(finer, tile, cv::Size(w, h), 0, 0, cv::INTER_AREA);
+        return tile;
+    }
+
+    /**
+     * @brief Get a tile from cache or else decode or synthesize it. Caller holds the mutex.
+     */
+    cv::Mat TiledTiffImage::getTile(int level, int tx, int ty)
+    {
+        uint64_t key = ((uint64_t)level << 56) | ((uint64_t)ty << 28) | (uint64_t)tx;
+        auto iter = this->tiles.find(key);
+
+        if (iter != this->tiles.end())
+        {
+            // most recently used to front
+            this->lru.splice(this->lru.begin(), this->lru, iter->second);
+            return iter->second->tile;
+        }
+
+        cv::Mat tile = this->levels[level].isSynthesized ? synthesizeTile(level, tx, ty) : decodeTile(level, tx, ty);
+
+        this->lru.push_front({key, tile});
+        this->tiles[key] = this->lru.begin();
+        this->cacheBytes += tile.total() * tile.elemSize();
+        evictTiles();
+
+        return tile;
+    }
+
+    /**
+     * @brief Drop least recently used tiles until under budget, but always keep the newest one.
+     */
+    void TiledTiffImage::evictTiles()
+    {
+        while ((this->cacheBytes > this->cacheBudgetBytes) && (this->lru.size() > 1))
+        {
+            TileEntry& entry = this->lru.back();
+            this->cacheBytes -= entry.tile.total() * entry.tile.elemSize();
+            this->tiles.erase(entry.key);
+            this->lru.pop_back();
+        }
+    }
+
+    void TiledTiffImage::readRegionLocked(int level, cv::Rect roi, cv::Mat& dst)
+    {
+        const Level& lv = this->levels[level];
+        roi &= cv::Rect(0, 0, lv.width, lv.height);
+        dst.create(roi.size(), this->cvType);
+
+        if (roi.empty())
+        {
+            return;
+        }
+
+        int tx0 = roi.x / lv.tileWidth;
+        int tx1 = (roi.x + roi.width - 1) / lv.tileWidth;
+        int ty0 = roi.y / lv.tileHeight;
+        int ty1 = (roi.y + roi.height - 1) / lv.tileHeight;
+
+        for (int ty = ty0; ty <= ty1; ty++)
+        {
+            for (int tx = tx0; tx <= tx1; tx++)
+            {
+                cv::Mat tile = getTile(level, tx, ty);
+                cv::Rect tileRect(tx * lv.tileWidth, ty * lv.tileHeight, tile.cols, tile.rows);
+                cv::Rect isect = tileRect & roi;
+                tile(isect - tileRect.tl()).copyTo(dst(isect - roi.tl()));
+            }
+        }
+    }
+
+    void TiledTiffImage::readRegion(int level, cv::Rect roi, cv::Mat& dst)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+
+        if ((level < 0) || (level >= this->levels.size()))
+        {
+            throw runtime_error("Tiled image level out of range.");
+        }
+
+        readRegionLocked(level, roi, dst);
+    }
+
+    cv::Mat TiledTiffImage::readOverview(int maxDim)
+    {
+        int level = getLevelCount() - 1;
+
+        for (int i = 0; i < this->levels.size(); i++)
+        {
+            if ((this->levels[i].width <= maxDim) && (this->levels[i].height <= maxDim))
+            {
+                level = i;
+                break;
+            }
+        }
+
+        cv::Mat overview;
+        readRegion(level, cv::Rect(0, 0, this->levels[level].width, this->levels[level].height), overview);
+        return overview;
+    }
+
+    int TiledTiffImage::selectLevel(float zoom)
+    {
+        int best = 0;
+
+        if (zoom > 0.0f)
+        {
+            float maxScale = 1.0f / zoom;
+
+            for (int i = 1; i < this->levels.size(); i++)
+            {
+                const cv::Point2f& scale = this->levels[i].scale;
+
+                if (std::max(scale.x, scale.y) <= maxScale * 1.001f)
+                {
+                    best = i;
+                }
+            }
+        }
+
+        return best;
+    }
+
+    cv::Size TiledTiffImage::getSize()
+    {
+        return cv::Size(this->levels[0].width, this->levels[0].height);
+    }
+
+    int TiledTiffImage::getType()
+    {
+        return this->cvType;
+    }
+
+    int TiledTiffImage::getLevelCount()
+    {
+        return (int)this->levels.size();
+    }
+
+    /**
+     * @brief Levels that are in the file, which come before any synthesized levels.
+     */
+    int TiledTiffImage::getFileLevelCount()
+    {
+        int count = 0;
+
+        while ((count < this->levels.size()) && !this->levels[count].isSynthesized)
+        {
+            count++;
+        }
+
+        return count;
+    }
+
+    cv::Size TiledTiffImage::getLevelSize(int level)
+    {
+        return cv::Size(this->levels[level].width, this->levels[level].height);
+    }
+
+    cv::Point2f TiledTiffImage::getLevelScale(int level)
+    {
+        return this->levels[level].scale;
+    }
+
+    size_t TiledTiffImage::getCacheBytes()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->cacheBytes;
+    }
+
+    size_t TiledTiffImage::getCacheBudgetBytes()
+    {
+        return this->cacheBudgetBytes;
+    }
+
+    int TiledTiffImage::getTileReadCount()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->tileReadCount;
+    }
+}
@@ -0,0 +1,128 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <filesystem>
+#include <opencv2/opencv.hpp>
+
+// from tiffio.h, so that header isn't needed by everything that includes this
+struct tiff;
+
+namespace Wxiv
+{
+    /**
+     * @brief A (potentially huge) TIFF that is read a region at a time instead of all at once.
+     *
+     * Level 0 is the full resolution image. Reduced-resolution levels come from the file where it has them, either as
+     * SubIFDs of the first image or as following top-level images marked as reduced-resolution. Past the last level in
+     * the file, levels are synthesized by halving, with their tiles built from the next-finer level's tiles on demand,
+     * so zoomed-out views don't have to read a whole full-resolution image at once.
+     *
+     * Decoded tiles are kept in an LRU cache with a byte budget, so panning around uses bounded memory. Strip-organized
+ * levels are read a strip at a time, except that an uncompressed strip too big for the cache (e.g. a whole image
+ * written as one strip) is read in bands of rows, and a compressed one means the file can't be read this way.
+     * libtiff handles are not thread-safe, so everything here is serialized by one mutex.
+     */
+    class TiledTiffImage
+    {
+      private:
+        struct Level
+        {
+            int width = 0;
+            int height = 0;
+            int tileWidth = 0;  // for strip-organized levels this is the image width
+            int tileHeight = 0; // for strip-organized levels this is rows per strip (or per band)
+            bool isTiled = false;
+            bool isSynthesized = false;
+            bool isYCbCrJpeg = false; // have libtiff convert to RGB
+            bool isBanded = false;    // uncompressed strips too big to cache whole, read by scanline in bands of tileHeight rows
+
+            // where the level is in the file, top-level directory index or else SubIFD offset
+            int dirIndex = -1;
+            uint64_t subIfdOffset = 0;
+
+            cv::Point2f scale = cv::Point2f(1.0f, 1.0f); // level 0 pixels per level pixel
+        };
+
+        struct TileEntry
+        {
+            uint64_t key = 0;
+            cv::Mat tile;
+        };
+
+        struct tiff* tif = nullptr;
+        std::vector<Level> levels;
+        int currentLevel = -1; // which level's directory libtiff is on
+        int cvType = 0;
+
+        // tile cache, front is most recently used
+        std::list<TileEntry> lru;
+        std::unordered_map<uint64_t, std::list<TileEntry>::iterator> tiles;
+        size_t cacheBytes = 0;
+        size_t cacheBudgetBytes = 0;
+        int tileReadCount = 0;
+
+        std::mutex mutex;
+
+        void readLevels();
+        void addSynthesizedLevels();
+        void setLevelDirectory(int level);
+        cv::Mat getTile(int level, int tx, int ty);
+        cv::Mat decodeTile(int level, int tx, int ty);
+        cv::Mat synthesizeTile(int level, int tx, int ty);
+        void readRegionLocked(int level, cv::Rect roi, cv::Mat& dst);
+        void evictTiles();
+
+      public:
+        /**
+         * @brief Open the file and read its structure, but no pixels. Throws runtime_error if the file can't be read this way.
+         * @param cacheBudgetBytes Max bytes of decoded tiles to keep.
+         */
+        TiledTiffImage(const std::filesystem::path& path, size_t cacheBudgetBytes);
+        ~TiledTiffImage();
+
+        TiledTiffImage(const TiledTiffImage&) = delete;
+        TiledTiffImage& operator=(const TiledTiffImage&) = delete;
+
+        /**
+         * @brief Open as tiled if the first image is at least this many pixels and is a layout and type we can read,
+         * else nullptr (and the caller should decode the whole thing the usual way).
+         */
+        static std::shared_ptr<TiledTiffImage> tryOpen(const std::filesystem::path& path, int64_t minPixelCount, size_t cacheBudgetBytes);
+
+        cv::Size getSize();
+        int getType();
+        int getLevelCount();
+        int getFileLevelCount();
+        cv::Size getLevelSize(int level);
+
+        /**
+         * @brief Level 0 pixels per level pixel, in x and y, which can differ a little since level dims are rounded.
+         */
+        cv::Point2f getLevelScale(int level);
+
+        /**
+         * @brief The coarsest level that still has at least as much resolution as the view.
+         * @param zoom View pixels per level 0 pixel.
+         */
+        int selectLevel(float zoom);
+
+        /**
+         * @brief Read a region of a level, in that level's pixel coords. The roi is clipped to the level.
+         */
+        void readRegion(int level, cv::Rect roi, cv::Mat& dst);
+
+        /**
+         * @brief The whole image at the finest level that fits in maxDim (in both axes).
+         */
+        cv::Mat readOverview(int maxDim);
+
+        size_t getCacheBytes();
+        size_t getCacheBudgetBytes();
+        int getTileReadCount();
+    };
+}
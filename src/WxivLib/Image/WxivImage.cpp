@@ -23,8 +23,6 @@ namespace fs = std::filesystem;
 
 namespace Wxiv
 {
-    static std::mutex imreadMutex;
-
     WxivImage::WxivImage()
     {
     }
@@ -54,12 +52,119 @@ namespace Wxiv
         this->isLoaded = true;
     }
 
+    /**
+     * @brief Read just the file header for dims, type, and page count. Only one thread should call this for an image.
+     * An unprobeable file is still marked probed, with empty info.
+     * @param doReprobe Read it again even if already probed, e.g. the file changed.
+     */
+    void WxivImage::probeHeader(bool doReprobe)
+    {
+        if ((this->isHeaderProbed && !doReprobe) || !this->path.IsOk())
+        {
+            return;
+        }
+
+        ImageHeaderInfo info;
+        ImageHeader::probeFile(toFilesystemPath(this->path.GetFullPath()), this->type, this->page, info);
+        this->isHeaderProbed = false;
+        this->headerInfo = info;
+        this->isHeaderProbed = true;
+    }
+
+    /**
+     * @brief For an image that isn't a file the header can be read from by path, e.g. an archive member, its source
+     * reads the header instead. Same rules as probeHeader().
+     */
+    void WxivImage::setHeaderInfo(const ImageHeaderInfo& info)
+    {
+        this->isHeaderProbed = false;
+        this->headerInfo = info;
+        this->isHeaderProbed = true;
+    }
+
+    bool WxivImage::getIsHeaderProbed()
+    {
+        return this->isHeaderProbed;
+    }
+
+    /**
+     * @brief Empty until getIsHeaderProbed().
+     */
+    ImageHeaderInfo WxivImage::getHeaderInfo()
+    {
+        return this->isHeaderProbed ? this->headerInfo : ImageHeaderInfo();
+    }
+
     void WxivImage::setImage(cv::Mat& img)
     {
         this->image = img;
+
+        // not built until a zoomed-out view needs it
+        this->pyramid = ImagePyramid::checkShouldBuild(img) ? std::make_shared<ImagePyramid>(img) : nullptr;
+        this->isLoaded = true;
+    }
+
+    /**
+     * @brief For an image that is read by region. The image is then this small overview of the whole thing, which is
+     * what whole-image stats are computed on.
+     */
+    void WxivImage::setTiledImage(std::shared_ptr<TiledTiffImage> tiled, cv::Mat& overview)
+    {
+        this->tiledImage = tiled;
+        this->image = overview;
+        this->pyramid.reset(); // the tiled image has its own levels
         this->isLoaded = true;
     }
 
+    std::shared_ptr<TiledTiffImage> WxivImage::getTiledImage()
+    {
+        return this->tiledImage;
+    }
+
+    std::shared_ptr<ImagePyramid> WxivImage::getPyramid()
+    {
+        return this->pyramid;
+    }
+
+    /**
+     * @brief Drop the pixels and everything computed from them, back to the not-loaded state.
+     * Pages are separate images and are unloaded separately. Caller should hold the load mutex.
+     */
+    void WxivImage::unload()
+    {
+        this->image.release();
+        this->tiledImage.reset();
+        this->pyramid.reset();
+        this->imageStats = ImageUtil::ImageStats();
+        this->hist.clear();
+        this->shapes.clear();
+        this->shapes.polygons.clear();
+        this->shapeSetLoadError.clear();
+        this->isLoaded = false;
+    }
+
+    /**
+     * @brief Approximate bytes held by this image's pixels, not including pages.
+     * For a tiled image this counts the tile cache budget, since that is what it can grow to.
+     * A pyramid is counted once it's built.
+     */
+    size_t WxivImage::getMemoryBytes()
+    {
+        size_t bytes = this->image.total() * this->image.elemSize();
+
+        if (this->pyramid)
+        {
+            bytes += this->pyramid->getMemoryBytes();
+        }
+
+        if (this->tiledImage)
+        {
+            bytes += this->tiledImage->getCacheBudgetBytes();
+        }
+
+        return bytes;
+    }
+
     void WxivImage::setPage(int newPage)
     {
         this->page = newPage;
@@ -75,6 +180,21 @@ namespace Wxiv
         return this->isLoaded;
     }
 
+    std::mutex& WxivImage::getLoadMutex()
+    {
+        return this->loadMutex;
+    }
+
+    bool WxivImage::getArePagesListed()
+    {
+        return this->arePagesListed;
+    }
+
+    void WxivImage::setArePagesListed(bool isListed)
+    {
+        this->arePagesListed = isListed;
+    }
+
     bool WxivImage::empty()
     {
         return this->image.empty();
@@ -86,7 +206,23 @@ namespace Wxiv
     }
 
     /**
-     * @brief Not just path basename because can have "page N" appended for display.
+     * @brief Set the name to list, when the file name isn't unique in the source.
+     */
+    void WxivImage::setName(const wxString& inName)
+    {
+        this->name = inName;
+    }
+
+    /**
+     * @brief The path basename, unless the source set another name.
+     */
+    wxString WxivImage::getName()
+    {
+        return this->name.empty() ? this->path.GetFullName() : this->name;
+    }
+
+    /**
+     * @brief Not just name because can have "page N" appended for display.
      */
     wxString WxivImage::getDisplayName()
     {
@@ -94,19 +230,17 @@ namespace Wxiv
         {
             // parent image
             string pageStr = fmt::format(" (page {})", this->page + 1);
-            wxString name = this->path.GetFullName() + pageStr;
-            return name;
+            return getName() + pageStr;
         }
         else if (this->page > 0)
         {
             // child image
             string pageStr = fmt::format(" (page {})", this->page + 1);
-            wxString name = wxString("    ") + this->path.GetFullName() + pageStr;
-            return name;
+            return wxString("    ") + getName() + pageStr;
         }
         else
         {
-            return this->path.GetFullName();
+            return getName();
         }
     }
 
@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 #include <filesystem>
+#include <mutex>
+#include <atomic>
 #include <opencv2/opencv.hpp>
 
 #include "WxWidgetsUtil.h"
@@ -11,6 +13,9 @@
 #include "ShapeSet.h"
 #include "FloatHist.h"
 #include "Polygon.h"
+#include "TiledTiffImage.h"
+#include "ImagePyramid.h"
+#include "ImageHeader.h"
 
 namespace Wxiv
 {
@@ -20,8 +25,9 @@ namespace Wxiv
      *
      * The memory management design is to have single copies of each image in the process, with shared_ptr to pass them
      * around. For that to be really clean, each object should be immutable. However in this case there are several
-     * members that are mutable (shapes, imageStats, and hist). Right now with single-thread design that should be
-     * fine but will have to change if go multi-threaded.
+     * members that are mutable (shapes, imageStats, and hist).
+     * Images can be loaded on background threads (prefetch), so loaders hold getLoadMutex() while loading, and
+     * getIsLoaded() is safe to call from any thread.
      *
      * TIF images (at least) can have multiple pages, and thus this keeps a vector of pointers to other pages.
      */
@@ -30,14 +36,23 @@ namespace Wxiv
       private:
         wxFileName path;
 
+        // name in the list, if not just the file name, e.g. the path of an archive member within the archive
+        wxString name;
+
         // file type, probably just file name extension
         // This is not wide string on purpose, this is used as a sort of loose enum of image types, so not
         // necessarily the file name extension (though I hope foreign languages don't use wide chars for known image
         // types).
         std::string type;
-        int page = 0; // for multi-page tif's, we split on load
+        int page = 0; // for multi-page tif's, pages are listed on load and decoded when selected
         cv::Mat image;
 
+        // for huge tif's that are read by region, and then image is just an overview
+        std::shared_ptr<TiledTiffImage> tiledImage;
+
+        // for big images, reduced levels for zoomed-out render, built on first need
+        std::shared_ptr<ImagePyramid> pyramid;
+
         /**
          * For secondary pages loaded from this file.
          * This isn't supposed to provide a deep tree structure; this should only be non-empty for the top object.
@@ -52,7 +67,16 @@ namespace Wxiv
         ImageUtil::ImageStats imageStats;
         FloatHist hist;
 
-        bool isLoaded = false;
+        std::atomic<bool> isLoaded = false;
+        std::mutex loadMutex;
+
+        // from the file header, without decoding, so the list can describe images that aren't loaded
+        // Written once by probeHeader() before isHeaderProbed is set, and kept across unloads.
+        ImageHeaderInfo headerInfo;
+        std::atomic<bool> isHeaderProbed = false;
+
+        // whether the pages have been added to the image list, since pages can be created by a background load
+        bool arePagesListed = false;
 
         WxivImage();
 
@@ -63,13 +87,27 @@ namespace Wxiv
         WxivImage(const cv::Mat& img);
 
         bool getIsLoaded();
+        void probeHeader(bool doReprobe = false);
+        void setHeaderInfo(const ImageHeaderInfo& info);
+        bool getIsHeaderProbed();
+        ImageHeaderInfo getHeaderInfo();
+        std::mutex& getLoadMutex();
+        bool getArePagesListed();
+        void setArePagesListed(bool isListed);
         void setPage(int page);
         void addPage(std::shared_ptr<WxivImage> pageImage);
         void setImage(cv::Mat& img);
+        void setTiledImage(std::shared_ptr<TiledTiffImage> tiled, cv::Mat& overview);
+        std::shared_ptr<TiledTiffImage> getTiledImage();
+        std::shared_ptr<ImagePyramid> getPyramid();
+        void unload();
+        size_t getMemoryBytes();
         void save(const wxString& path, bool doParquet);
         bool empty();
 
         wxFileName getPath();
+        void setName(const wxString& name);
+        wxString getName();
         wxString getDisplayName();
         std::string getTypeStr();
         int getPage();
@@ -0,0 +1,195 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <exception>
+
+#include "AsyncImageLoader.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    static const int ThreadCount = 2;
+
+    AsyncImageLoader::AsyncImageLoader()
+    {
+    }
+
+    AsyncImageLoader::~AsyncImageLoader()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            this->isStopping = true;
+            this->hasPending = false;
+            this->pending = Request();
+        }
+
+        this->condition.notify_all();
+
+        for (std::thread& t : this->threads)
+        {
+            t.join();
+        }
+    }
+
+    void AsyncImageLoader::request(std::shared_ptr<WxivImage> image, const std::function<void(std::shared_ptr<WxivImage>)>& loadFunction,
+        const std::function<bool(std::shared_ptr<WxivImage>, cv::Mat&, cv::Size&)>& previewFunction)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            this->latestId++;
+            this->pending = Request{this->latestId, image, loadFunction, previewFunction};
+            this->hasPending = true;
+            this->isBusy = true;
+            clearResults();
+
+            // start threads on first use
+            if (this->threads.empty())
+            {
+                for (int i = 0; i < ThreadCount; i++)
+                {
+                    this->threads.emplace_back([this]() { this->workerLoop(); });
+                }
+            }
+        }
+
+        this->condition.notify_one();
+    }
+
+    void AsyncImageLoader::cancel()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        this->latestId++;
+        this->hasPending = false;
+        this->pending = Request();
+        this->isBusy = false;
+        clearResults();
+    }
+
+    /**
+     * @brief Drop any preview and result, which are from an older request. Call with mutex held.
+     */
+    void AsyncImageLoader::clearResults()
+    {
+        this->hasPreview = false;
+        this->previewOwner = nullptr;
+        this->previewImage = cv::Mat();
+        this->isDone = false;
+        this->doneImage = nullptr;
+        this->doneErrorMessage.clear();
+    }
+
+    bool AsyncImageLoader::checkIsBusy()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->isBusy;
+    }
+
+    bool AsyncImageLoader::takePreview(std::shared_ptr<WxivImage>& image, cv::Mat& preview, cv::Size& fullSize)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+
+        if (!this->hasPreview || this->isDone)
+        {
+            return false;
+        }
+
+        image = this->previewOwner;
+        preview = this->previewImage;
+        fullSize = this->previewFullSize;
+        this->hasPreview = false;
+        this->previewOwner = nullptr;
+        this->previewImage = cv::Mat();
+        return true;
+    }
+
+    bool AsyncImageLoader::takeResult(std::shared_ptr<WxivImage>& image, std::string& errorMessage)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+
+        if (!this->isDone)
+        {
+            return false;
+        }
+
+        image = this->doneImage;
+        errorMessage = this->doneErrorMessage;
+        this->isDone = false;
+        this->doneImage = nullptr;
+        this->doneErrorMessage.clear();
+        return true;
+    }
+
+    void AsyncImageLoader::workerLoop()
+    {
+        while (true)
+        {
+            Request req;
+
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->condition.wait(lock, [this]() { return this->isStopping || this->hasPending; });
+
+                if (this->isStopping)
+                {
+                    return;
+                }
+
+                req = std::move(this->pending);
+                this->pending = Request();
+                this->hasPending = false;
+            }
+
+            // preview first, unless already loaded, e.g. by a stale request for the same image
+            if (req.previewFunction && !req.image->getIsLoaded())
+            {
+                cv::Mat preview;
+                cv::Size fullSize;
+                bool hasPreview = false;
+
+                try
+                {
+                    hasPreview = req.previewFunction(req.image, preview, fullSize);
+                }
+                catch (std::exception&)
+                {
+                    // the full load will report it if the file is really bad
+                }
+
+                const std::lock_guard<std::mutex> lock(this->mutex);
+
+                if (hasPreview && !preview.empty() && (req.id == this->latestId))
+                {
+                    this->hasPreview = true;
+                    this->previewOwner = req.image;
+                    this->previewImage = preview;
+                    this->previewFullSize = fullSize;
+                }
+            }
+
+            string errorMessage;
+
+            try
+            {
+                req.loadFunction(req.image);
+            }
+            catch (std::exception& ex)
+            {
+                errorMessage = ex.what();
+            }
+
+            {
+                const std::lock_guard<std::mutex> lock(this->mutex);
+
+                // superseded while loading, so nobody wants this result
+                if (req.id == this->latestId)
+                {
+                    this->isBusy = false;
+                    this->isDone = true;
+                    this->doneImage = req.image;
+                    this->doneErrorMessage = errorMessage;
+                }
+            }
+        }
+    }
+}
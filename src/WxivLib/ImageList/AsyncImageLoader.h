@@ -0,0 +1,103 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "WxivImage.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief Loads the selected image off the UI thread, so the UI stays responsive during a long decode and stepping
+     * quickly through the list doesn't queue up blocking loads.
+     *
+     * Only the latest request matters. A new request replaces one that hasn't started yet, and the result of a load that
+     * was already running for an older request is dropped (the load still finishes, and the image stays loaded for if
+     * the user steps back to it). There are two worker threads so that a new request doesn't have to wait for one stale
+     * load to finish.
+     *
+     * A request can also have a preview function, which is run first, so a big image can be viewed at low resolution
+     * while the full load runs.
+     *
+     * The UI polls takePreview() and takeResult(), rather than being called back from the worker threads.
+     */
+    class AsyncImageLoader
+    {
+      private:
+        struct Request
+        {
+            int id = 0;
+            std::shared_ptr<WxivImage> image;
+            std::function<void(std::shared_ptr<WxivImage>)> loadFunction;
+            std::function<bool(std::shared_ptr<WxivImage>, cv::Mat&, cv::Size&)> previewFunction;
+        };
+
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool isStopping = false;
+
+        int latestId = 0;
+        bool hasPending = false;
+        Request pending;
+        bool isBusy = false; // latest request not done yet
+
+        // preview for the latest request, when ready
+        bool hasPreview = false;
+        std::shared_ptr<WxivImage> previewOwner;
+        cv::Mat previewImage;
+        cv::Size previewFullSize;
+
+        // result of the latest request, when done
+        bool isDone = false;
+        std::shared_ptr<WxivImage> doneImage;
+        std::string doneErrorMessage;
+
+        void workerLoop();
+        void clearResults();
+
+      public:
+        AsyncImageLoader();
+        ~AsyncImageLoader();
+
+        AsyncImageLoader(const AsyncImageLoader&) = delete;
+        AsyncImageLoader& operator=(const AsyncImageLoader&) = delete;
+
+        /**
+         * @brief Load this image on a worker thread, superseding any prior request.
+         * @param loadFunction Does the load, called on a worker thread. Throw to report an error.
+         * @param previewFunction Optional, called on the worker thread before the load, to get a quick low-resolution
+         * version of the image and the full-resolution size. Returns false if no preview.
+         */
+        void request(std::shared_ptr<WxivImage> image, const std::function<void(std::shared_ptr<WxivImage>)>& loadFunction,
+            const std::function<bool(std::shared_ptr<WxivImage>, cv::Mat&, cv::Size&)>& previewFunction = nullptr);
+
+        /**
+         * @brief Supersede any prior request without making a new one, e.g. an already loaded image was selected.
+         */
+        void cancel();
+
+        /**
+         * @brief Whether the latest request is still waiting or running.
+         */
+        bool checkIsBusy();
+
+        /**
+         * @brief If the latest request has a preview ready, get it and return true. Each preview is only returned once,
+         * and not at all if the load finished first.
+         */
+        bool takePreview(std::shared_ptr<WxivImage>& image, cv::Mat& preview, cv::Size& fullSize);
+
+        /**
+         * @brief If the latest request has finished, get its image and error message (empty if none) and return true.
+         * Each result is only returned once.
+         */
+        bool takeResult(std::shared_ptr<WxivImage>& image, std::string& errorMessage);
+    };
+}
@@ -0,0 +1,68 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <algorithm>
+#include <exception>
+
+#include "ImageHeaderProber.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    ImageHeaderProber::ImageHeaderProber(const std::vector<std::shared_ptr<WxivImage>>& images, int threadCount,
+        const std::function<void(std::shared_ptr<WxivImage>)>& probeFunction)
+        : images(images), probeFunction(probeFunction)
+    {
+        if (!this->probeFunction)
+        {
+            this->probeFunction = [](std::shared_ptr<WxivImage> image) { image->probeHeader(); };
+        }
+
+        threadCount = std::clamp(threadCount, 1, std::max(1, (int)images.size()));
+
+        for (int i = 0; i < threadCount; i++)
+        {
+            this->threads.emplace_back([this]() { this->workerLoop(); });
+        }
+    }
+
+    ImageHeaderProber::~ImageHeaderProber()
+    {
+        this->isStopping = true;
+
+        for (std::thread& t : this->threads)
+        {
+            t.join();
+        }
+    }
+
+    void ImageHeaderProber::workerLoop()
+    {
+        while (!this->isStopping)
+        {
+            size_t i = this->nextIndex++;
+
+            if (i >= this->images.size())
+            {
+                return;
+            }
+
+            try
+            {
+                this->probeFunction(this->images[i]);
+            }
+            catch (std::exception&)
+            {
+                // just not described in the list
+            }
+
+            this->doneCount++;
+        }
+    }
+
+    bool ImageHeaderProber::checkIsDone()
+    {
+        return this->doneCount >= this->images.size();
+    }
+}
@@ -0,0 +1,46 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+
+#include "WxivImage.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief A background pass that reads the header of each image (see WxivImage::probeHeader), in order, on a few
+     * threads, so the list can show dims and type without any decode.
+     *
+     * This starts on construct and stops (joins, letting in-progress probes finish) on destruct. Each image is probed by
+     * only one thread. Header reads are mostly waiting on the file system, so this uses more threads than decoding.
+     */
+    class ImageHeaderProber
+    {
+      private:
+        std::vector<std::shared_ptr<WxivImage>> images;
+        std::function<void(std::shared_ptr<WxivImage>)> probeFunction;
+        std::vector<std::thread> threads;
+        std::atomic<size_t> nextIndex = 0;
+        std::atomic<size_t> doneCount = 0;
+        std::atomic<bool> isStopping = false;
+
+        void workerLoop();
+
+      public:
+        /**
+         * @param probeFunction Reads one image's header, or null for WxivImage::probeHeader, which reads the file by path.
+         */
+        ImageHeaderProber(const std::vector<std::shared_ptr<WxivImage>>& images, int threadCount,
+            const std::function<void(std::shared_ptr<WxivImage>)>& probeFunction = nullptr);
+        ~ImageHeaderProber();
+
+        ImageHeaderProber(const ImageHeaderProber&) = delete;
+        ImageHeaderProber& operator=(const ImageHeaderProber&) = delete;
+
+        bool checkIsDone();
+    };
+}
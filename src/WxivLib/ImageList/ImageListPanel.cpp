@@ -2,6 +2,7 @@
 // Distributed under the MIT License (http://opensource.org/licenses/MIT)
 #include <vector>
 #include <cmath>
+#include <algorithm>
 #include <filesystem>
 #include <fmt/core.h>
 
@@ -30,6 +31,20 @@ namespace fs = std::filesystem;
 
 namespace Wxiv
 {
+    // default widths for the columns, which are name, type, then the header info columns
+    static const int DefaultColumnWidths[] = {200, 80, 90, 60, 70, 60};
+
+    // filter after typing pauses this long
+    static const int FilterDebounceMs = 150;
+
+    /**
+     * @brief The name the filter matches, lowercase.
+     */
+    static std::string getFilterName(std::shared_ptr<WxivImage> image)
+    {
+        return image->getName().Lower().ToUTF8().data();
+    }
+
     ImageListPanel::ImageListPanel(wxWindow* parent) : wxPanel(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxTAB_TRAVERSAL)
     {
         auto mainSizer = new wxBoxSizer(wxVERTICAL);
@@ -42,14 +57,24 @@ namespace Wxiv
         filterTextBox->Bind(wxEVT_TEXT, [&](wxCommandEvent& evt) { onFilterTextChanged(evt); });
         mainSizer->Add(filterLineSizer, 0, wxEXPAND | wxTOP, 8);
 
-        // listview
-        // trying to set styles for sort, but changes column display too: , -1, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_SORT_ASCENDING
-        this->listView = new wxListView(this);
+        // listview, virtual so it asks us for the rows it draws
+        this->listView = new ImageListView(this);
         this->listView->EnableCheckBoxes(true);
+        this->listView->setItemTextFunction([this](long item, long column) { return this->getItemText(item, column); });
+        this->listView->setItemIsCheckedFunction(
+            [this](long item) { return this->isCheckedByDataIndex[this->listedDataIndices[item]]; });
         listView->AppendColumn("Name");
         listView->AppendColumn("Type");
-        listView->SetColumnWidth(0, 200);
-        listView->SetColumnWidth(1, 80);
+        listView->AppendColumn("Size");
+        listView->AppendColumn("Depth");
+        listView->AppendColumn("Channels");
+        listView->AppendColumn("Pages");
+
+        for (int i = 0; i < listView->GetColumnCount(); i++)
+        {
+            listView->SetColumnWidth(i, DefaultColumnWidths[i]);
+        }
+
         mainSizer->Add(this->listView, 1, wxEXPAND | wxALL, 8);
 
         listView->Bind(wxEVT_LIST_ITEM_SELECTED, [&](wxListEvent& evt) { onItemSelected(evt.m_itemIndex); });
@@ -59,19 +84,35 @@ namespace Wxiv
 
         listView->Bind(wxEVT_LIST_ITEM_RIGHT_CLICK, [&](wxListEvent& evt) { onListRightClick(evt); });
 
+        // a virtual list doesn't keep checkbox state, so clicks just event and we keep it
+        listView->Bind(wxEVT_LIST_ITEM_CHECKED, [&](wxListEvent& evt) { onItemChecked(evt.GetIndex(), true); });
+        listView->Bind(wxEVT_LIST_ITEM_UNCHECKED, [&](wxListEvent& evt) { onItemChecked(evt.GetIndex(), false); });
+
+        this->headerInfoTimer.SetOwner(this);
+        this->Bind(wxEVT_TIMER, &ImageListPanel::onHeaderInfoTimer, this, this->headerInfoTimer.GetId());
+
+        this->filterDebounceTimer.SetOwner(this);
+        this->Bind(wxEVT_TIMER, &ImageListPanel::onFilterDebounceTimer, this, this->filterDebounceTimer.GetId());
+        this->filterResultTimer.SetOwner(this);
+        this->Bind(wxEVT_TIMER, &ImageListPanel::onFilterResultTimer, this, this->filterResultTimer.GetId());
+
         this->SetSizerAndFit(mainSizer);
     }
 
     void ImageListPanel::saveConfig()
     {
-        wxConfigBase::Get()->Write("ImageListPanelCol0Width", listView->GetColumnWidth(0));
-        wxConfigBase::Get()->Write("ImageListPanelCol1Width", listView->GetColumnWidth(1));
+        for (int i = 0; i < listView->GetColumnCount(); i++)
+        {
+            wxConfigBase::Get()->Write(wxString::Format("ImageListPanelCol%dWidth", i), listView->GetColumnWidth(i));
+        }
     }
 
     void ImageListPanel::restoreConfig()
     {
-        listView->SetColumnWidth(0, wxConfigBase::Get()->ReadLong("ImageListPanelCol0Width", 200));
-        listView->SetColumnWidth(1, wxConfigBase::Get()->ReadLong("ImageListPanelCol1Width", 80));
+        for (int i = 0; i < listView->GetColumnCount(); i++)
+        {
+            listView->SetColumnWidth(i, wxConfigBase::Get()->ReadLong(wxString::Format("ImageListPanelCol%dWidth", i), DefaultColumnWidths[i]));
+        }
     }
 
     /**
@@ -110,22 +151,98 @@ namespace Wxiv
         this->onListItemsChangeCallback = f;
     }
 
-    void ImageListPanel::insertListViewItem(int origIdx, std::shared_ptr<WxivImage> image)
+    /**
+     * @brief For the virtual list view, the text of a row that is being drawn.
+     */
+    wxString ImageListPanel::getItemText(long listIndex, long column)
     {
-        wxListItem item0;
-        item0.SetId(origIdx);
-        item0.SetData(origIdx);
-        item0.SetText(image->getDisplayName());
+        if ((listIndex < 0) || (listIndex >= (long)this->listedDataIndices.size()))
+        {
+            return wxString();
+        }
 
-        //// icon: did not work
-        // int imageIndex = 0;
-        // item0.SetImage(imageIndex);
+        std::shared_ptr<WxivImage> image = getImageByDataIndex(this->listedDataIndices[listIndex]);
 
-        // this is the only api to add an item
-        int listIndex = listView->InsertItem(item0);
+        if (column == 0)
+        {
+            return image->getDisplayName();
+        }
+        else if (column == 1)
+        {
+            return image->getTypeStr();
+        }
+        else
+        {
+            return getHeaderInfoColumnText(image, column);
+        }
+    }
 
-        // set the type column
-        listView->SetItem(listIndex, 1, image->getTypeStr());
+    /**
+     * @brief Text for the columns that come from the image header, empty if it hasn't been probed yet.
+     */
+    wxString ImageListPanel::getHeaderInfoColumnText(std::shared_ptr<WxivImage> image, long column)
+    {
+        if (!image->getIsHeaderProbed())
+        {
+            return wxString();
+        }
+
+        ImageHeaderInfo info = image->getHeaderInfo();
+
+        if (info.empty())
+        {
+            return wxString();
+        }
+
+        switch (column)
+        {
+        case 2:
+            return wxString::Format("%dx%d", info.width, info.height);
+        case 3:
+            return ImageUtil::getImageTypeString(info.depth);
+        case 4:
+            return wxString::Format("%d", info.channels);
+        case 5:
+            // pages are listed under the top image, which has the count
+            return (image->getPage() == 0) ? wxString::Format("%d", info.pageCount) : wxString();
+        default:
+            return wxString();
+        }
+    }
+
+    /**
+     * @brief While the header pass runs, redraw the visible rows so their header info columns fill in as it gets to
+     * them. Rows scrolled to later are drawn with whatever has been probed by then.
+     */
+    void ImageListPanel::onHeaderInfoTimer(wxTimerEvent& evt)
+    {
+        bool isProbing = this->imageListSource && this->imageListSource->checkIsProbingHeaders();
+        int n = this->listView->GetItemCount();
+
+        if (n > 0)
+        {
+            long top = this->listView->GetTopItem();
+            long bottom = std::min((long)n - 1, top + this->listView->GetCountPerPage());
+            this->listView->RefreshItems(top, bottom);
+        }
+
+        if (!isProbing)
+        {
+            this->headerInfoTimer.Stop();
+        }
+    }
+
+    /**
+     * @brief The image at this data index changed (e.g. its file was re-written), so update its item.
+     */
+    void ImageListPanel::updateImageItem(int origIdx)
+    {
+        int listIdx = findImageByDataIndex(origIdx);
+
+        if (listIdx >= 0)
+        {
+            this->listView->RefreshItem(listIdx);
+        }
     }
 
     /**
@@ -135,16 +252,16 @@ namespace Wxiv
     std::vector<int> ImageListPanel::getCheckedDataIndices()
     {
         vector<int> checkedDataIndices;
-        int n = this->listView->GetItemCount();
 
-        if (n > 0)
+        if (this->checkedCount > 0)
         {
+            int n = (int)this->isCheckedByDataIndex.size();
+
             for (int i = 0; i < n; i++)
             {
-                if (this->listView->IsItemChecked(i))
+                if (this->isCheckedByDataIndex[i])
                 {
-                    long thisOrigIndex = (long)this->listView->GetItemData(i);
-                    checkedDataIndices.push_back(thisOrigIndex);
+                    checkedDataIndices.push_back(i);
                 }
             }
         }
@@ -181,9 +298,7 @@ namespace Wxiv
 
     void ImageListPanel::onListRightClick(wxListEvent& evt)
     {
-        void* data = reinterpret_cast<void*>(evt.GetItem().GetData());
         wxMenu mnu;
-        mnu.SetClientData(data);
 
         if (this->getSelectedItemCount() == 1)
         {
@@ -203,7 +318,19 @@ namespace Wxiv
 
         for (int i : indices)
         {
-            this->listView->CheckItem(i, !this->listView->IsItemChecked(i));
+            int dataIdx = listViewIndexToDataIndex(i);
+            checkBoxByDataIndex(dataIdx, !this->isCheckedByDataIndex[dataIdx]);
+        }
+    }
+
+    /**
+     * @brief The user clicked a row's checkbox.
+     */
+    void ImageListPanel::onItemChecked(int listIndex, bool checked)
+    {
+        if ((listIndex >= 0) && (listIndex < (int)this->listedDataIndices.size()))
+        {
+            checkBoxByDataIndex(listViewIndexToDataIndex(listIndex), checked);
         }
     }
 
@@ -212,52 +339,64 @@ namespace Wxiv
      */
     void ImageListPanel::checkBoxByDataIndex(int idx, bool checked)
     {
-        int n = this->listView->GetItemCount();
-
-        for (int i = 0; i < n; i++)
+        if (this->isCheckedByDataIndex[idx] != checked)
         {
-            long thisOrigIndex = (long)this->listView->GetItemData(i);
+            this->isCheckedByDataIndex[idx] = checked;
+            this->checkedCount += checked ? 1 : -1;
+        }
 
-            if (idx == thisOrigIndex)
-            {
-                this->listView->CheckItem(i, checked);
-            }
+        int listIdx = findImageByDataIndex(idx);
+
+        if (listIdx >= 0)
+        {
+            this->listView->RefreshItem(listIdx);
         }
     }
 
     /**
-     * @brief Rebuild list from items in source.
+     * @brief The filter text as an ImageNameFilter query, which is lowercase except for a regex.
+     */
+    std::string ImageListPanel::getFilterQuery()
+    {
+        wxString filter = this->filterTextBox->GetValue();
+        return (filter.StartsWith("re:") ? filter : filter.Lower()).ToUTF8().data();
+    }
+
+    bool ImageListPanel::checkPassesFilter(std::shared_ptr<WxivImage> image)
+    {
+        return ImageNameFilter::checkMatches(ImageNameFilter::parseQuery(getFilterQuery()), getFilterName(image));
+    }
+
+    /**
+     * @brief Rebuild list from items in source. This only rebuilds the listed data indices, the list view just gets the
+     * new count and draws the visible rows.
      */
     void ImageListPanel::rebuildList()
     {
-        vector<int> checkedDataIndices = getCheckedDataIndices();
+        // clears the selection
         this->listView->DeleteAllItems();
+        this->lastSelectedListIndex = -1;
 
         int n = this->imageListSource->getImageCount();
+        this->isCheckedByDataIndex.resize(n, false);
+        vector<string> names(n);
 
-        if (n > 0)
+        for (int i = 0; i < n; i++)
         {
-            // only ones that pass the filter
-            wxString filter = this->filterTextBox->GetValue();
-
-            for (int i = 0; i < n; i++)
-            {
-                std::shared_ptr<WxivImage> img = this->imageListSource->getImage(i);
-
-                if (filter.empty() || img->getPath().GetFullName().Contains(filter))
-                {
-                    this->insertListViewItem(i, img);
-                }
-            }
+            names[i] = getFilterName(this->imageListSource->getImage(i));
         }
 
-        // re-apply checkboxes
-        if (!checkedDataIndices.empty())
+        // only ones that pass the filter, now, since callers go on to select in the new list
+        this->filterDebounceTimer.Stop();
+        this->filterResultTimer.Stop();
+        this->nameFilter.setNames(std::move(names));
+        this->listedDataIndices = this->nameFilter.filterNow(getFilterQuery());
+        setItemCount();
+
+        // rows the header pass hadn't got to yet are filled in as it does
+        if (this->imageListSource->checkIsProbingHeaders())
         {
-            for (int i : checkedDataIndices)
-            {
-                checkBoxByDataIndex(i, true);
-            }
+            this->headerInfoTimer.Start(200);
         }
 
         if (this->doCallbacks && this->onListItemsChangeCallback)
@@ -266,14 +405,35 @@ namespace Wxiv
         }
     }
 
+    /**
+     * @brief Tell the list view how many rows it has now, and redraw them.
+     */
+    void ImageListPanel::setItemCount()
+    {
+        this->listView->SetItemCount((long)this->listedDataIndices.size());
+        this->listView->Refresh();
+    }
+
     int ImageListPanel::getVisibleItemCount()
     {
-        return this->listView->GetItemCount();
+        return (int)this->listedDataIndices.size();
+    }
+
+    /**
+     * @brief Data indices of the listed (passing filter) items, in list order.
+     */
+    std::vector<int> ImageListPanel::getVisibleDataIndices()
+    {
+        return this->listedDataIndices;
     }
 
     void ImageListPanel::setSource(std::shared_ptr<ImageListSource> source)
     {
         this->imageListSource = source;
+
+        // checks are for the old source's images
+        this->isCheckedByDataIndex.clear();
+        this->checkedCount = 0;
         this->rebuildList();
     }
 
@@ -297,8 +457,20 @@ namespace Wxiv
      */
     bool ImageListPanel::selectImage(const wxString& path)
     {
-        wxString basename = wxFileName(path).GetFullName();
-        long idx = this->listView->FindItem(0, basename);
+        // by full path, since names aren't unique, e.g. archive members in different subdirs
+        wxFileName fileName(path);
+        fileName.Normalize(wxPATH_NORM_DOTS | wxPATH_NORM_ABSOLUTE);
+        wxString fullPath = fileName.GetFullPath();
+        long idx = -1;
+
+        for (int i = 0; i < (int)this->listedDataIndices.size(); i++)
+        {
+            if (getImageByDataIndex(this->listedDataIndices[i])->getPath().GetFullPath() == fullPath)
+            {
+                idx = i;
+                break;
+            }
+        }
 
         if ((idx >= 0) && !this->listView->IsSelected(idx))
         {
@@ -318,6 +490,13 @@ namespace Wxiv
 
     void ImageListPanel::onItemSelected(int idx)
     {
+        if ((this->lastSelectedListIndex >= 0) && (idx != this->lastSelectedListIndex))
+        {
+            this->isSteppingReverse = idx < this->lastSelectedListIndex;
+        }
+
+        this->lastSelectedListIndex = idx;
+
         if (this->doCallbacks && this->onSelectionChangeCallback)
         {
             this->onSelectionChangeCallback();
@@ -331,8 +510,7 @@ namespace Wxiv
 
     bool ImageListPanel::checkAnySelectedOrCheckedImages()
     {
-        std::vector<int> checkedIndices = getCheckedDataIndices();
-        return getSelectedItemCount() > 0 || checkedIndices.size() > 0;
+        return getSelectedItemCount() > 0 || this->checkedCount > 0;
     }
 
     /**
@@ -341,33 +519,21 @@ namespace Wxiv
      */
     int ImageListPanel::listViewIndexToDataIndex(int listViewIndex)
     {
-        long origIndex = (long)this->listView->GetItemData(listViewIndex);
-        return origIndex;
+        return this->listedDataIndices[listViewIndex];
     }
 
     /**
-     * @brief Used for filter changes.
+     * @brief Used for filter changes. The listed data indices are ascending so this is a binary search.
      * @param origIdx
      * @return The found index, or -1 for not found.
      */
     int ImageListPanel::findImageByDataIndex(int origIdx)
     {
-        int n = this->listView->GetItemCount();
+        auto it = std::lower_bound(this->listedDataIndices.begin(), this->listedDataIndices.end(), origIdx);
 
-        // iterate items in list because not all visible
-        if ((n > 0) && (origIdx >= 0))
+        if ((it != this->listedDataIndices.end()) && (*it == origIdx))
         {
-            int lastIdx = -1;
-
-            while ((lastIdx = this->listView->GetNextItem(lastIdx)) >= 0)
-            {
-                long thisOrigIndex = (long)this->listView->GetItemData(lastIdx);
-
-                if (thisOrigIndex == origIdx)
-                {
-                    return lastIdx;
-                }
-            }
+            return (int)(it - this->listedDataIndices.begin());
         }
 
         return -1;
@@ -485,14 +651,14 @@ namespace Wxiv
             // now we have a target index, but account for checkboxes
             if (this->listView->HasCheckBoxes())
             {
-                if (!getCheckedDataIndices().empty())
+                if (this->checkedCount > 0)
                 {
                     // some are checked so we scan to the next checked one
                     int delta = doReverse ? -1 : 1;
 
                     for (int i = idx; i >= 0 && i < n; i += delta)
                     {
-                        if (this->listView->IsItemChecked(i))
+                        if (this->isCheckedByDataIndex[listViewIndexToDataIndex(i)])
                         {
                             // found one
                             return i;
@@ -523,6 +689,7 @@ namespace Wxiv
     void ImageListPanel::selectNextImage(bool doReverse)
     {
         int n = this->listView->GetItemCount();
+        this->isSteppingReverse = doReverse;
 
         if (n > 0)
         {
@@ -544,22 +711,20 @@ namespace Wxiv
      */
     void ImageListPanel::selectImageByDataIndex(int origIdx)
     {
-        int n = this->listView->GetItemCount();
         int idx = findImageByDataIndex(origIdx);
 
         if (idx >= 0)
         {
-            for (int i = 0; i < n; i++)
+            // just the selected ones, not every row
+            for (int i : getSelectedListViewIndices())
             {
-                if (i == idx)
-                {
-                    this->selectImage(i, true);
-                }
-                else
+                if (i != idx)
                 {
                     this->selectImage(i, false);
                 }
             }
+
+            this->selectImage(idx, true);
         }
     }
 
@@ -574,13 +739,54 @@ namespace Wxiv
 
     void ImageListPanel::onFilterTextChanged(wxCommandEvent& evt)
     {
-        // right now updating list on-the-fly, so quickly, so don't try to preserve image load
+        // wait for a pause in typing
+        this->filterDebounceTimer.StartOnce(FilterDebounceMs);
+    }
+
+    void ImageListPanel::onFilterDebounceTimer(wxTimerEvent& evt)
+    {
+        if (this->imageListSource)
+        {
+            this->nameFilter.request(getFilterQuery());
+            this->filterResultTimer.Start(20);
+        }
+    }
+
+    /**
+     * @brief Poll for the filter result, which is only for the latest filter text.
+     */
+    void ImageListPanel::onFilterResultTimer(wxTimerEvent& evt)
+    {
+        vector<int> dataIndices;
+
+        if (this->nameFilter.takeResult(dataIndices))
+        {
+            this->filterResultTimer.Stop();
+            applyFilterResult(dataIndices);
+        }
+        else if (!this->nameFilter.checkIsBusy())
+        {
+            this->filterResultTimer.Stop();
+        }
+    }
+
+    /**
+     * @brief List these images, keeping the selected one selected if it's still listed.
+     */
+    void ImageListPanel::applyFilterResult(std::vector<int>& dataIndices)
+    {
         int origIndex = getSelectedImageDataIndex();
         this->unselectAll();
-        this->rebuildList();
-        int n = this->listView->GetItemCount();
+        this->lastSelectedListIndex = -1;
+        this->listedDataIndices = std::move(dataIndices);
+        setItemCount();
 
-        if ((n > 0) && (origIndex >= 0))
+        if (this->doCallbacks && this->onListItemsChangeCallback)
+        {
+            this->onListItemsChangeCallback();
+        }
+
+        if (!this->listedDataIndices.empty() && (origIndex >= 0))
         {
             // one was selected, try select if in list
             selectImageByDataIndex(origIndex);
@@ -593,18 +799,161 @@ namespace Wxiv
     void ImageListPanel::updateForMultiPageImageLoaded()
     {
         int idx = (int)this->listView->GetFirstSelected();
+        int addedCount = this->imageListSource->getImageCount() - this->nameFilter.getNameCount();
+
+        if ((idx < 0) || (addedCount <= 0))
+        {
+            this->doCallbacks = false;
+            this->rebuildList();
+            this->doCallbacks = true;
+            return;
+        }
 
+        // the pages were inserted in the source after the image, so insert just their rows, not rebuild the list
+        int dataIdx = listViewIndexToDataIndex(idx);
+        vector<string> names(addedCount);
+
+        for (int i = 0; i < addedCount; i++)
+        {
+            names[i] = getFilterName(this->imageListSource->getImage(dataIdx + 1 + i));
+        }
+
+        ImageNameFilter::Query query = ImageNameFilter::parseQuery(getFilterQuery());
+        vector<int> newDataIndices;
+
+        for (int i = 0; i < addedCount; i++)
+        {
+            if (ImageNameFilter::checkMatches(query, names[i]))
+            {
+                newDataIndices.push_back(dataIdx + 1 + i);
+            }
+        }
+
+        this->nameFilter.insertNames(dataIdx + 1, names);
+
+        if ((int)this->isCheckedByDataIndex.size() > dataIdx)
+        {
+            this->isCheckedByDataIndex.insert(this->isCheckedByDataIndex.begin() + dataIdx + 1, addedCount, false);
+        }
+
+        this->isCheckedByDataIndex.resize(this->imageListSource->getImageCount(), false);
+
+        // data indices after it shift up to match the source
+        for (int& listedIdx : this->listedDataIndices)
+        {
+            if (listedIdx > dataIdx)
+            {
+                listedIdx += addedCount;
+            }
+        }
+
+        // a virtual list's selection is by row, so keep just this one selected, as rows after it move down
         this->doCallbacks = false;
         this->unselectAll();
-        this->rebuildList();
+        this->listedDataIndices.insert(this->listedDataIndices.begin() + idx + 1, newDataIndices.begin(), newDataIndices.end());
+        setItemCount();
+        this->selectImage(idx, true);
+        this->doCallbacks = true;
+    }
 
-        if (idx >= 0)
+    /**
+     * @brief An image was appended to the source, so add it at the end of the list if it passes the filter.
+     * This doesn't rebuild the list, so selection, checkboxes and scroll position are kept.
+     * @return Whether it was added to the list.
+     */
+    bool ImageListPanel::appendImage(int origIdx)
+    {
+        std::shared_ptr<WxivImage> image = this->imageListSource->getImage(origIdx);
+        this->nameFilter.appendName(getFilterName(image));
+
+        if (!checkPassesFilter(image))
         {
-            // there is one selected
-            this->selectImage(idx, true);
+            return false;
         }
 
-        this->doCallbacks = true;
+        // data index is past all the others, so this lands at the end
+        this->isCheckedByDataIndex.resize(this->imageListSource->getImageCount(), false);
+        this->listedDataIndices.push_back(origIdx);
+        this->listView->SetItemCount((long)this->listedDataIndices.size());
+        this->listView->RefreshItem((long)this->listedDataIndices.size() - 1);
+
+        if (this->doCallbacks && this->onListItemsChangeCallback)
+        {
+            this->onListItemsChangeCallback();
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief The image at this data index was removed from the source, so remove its item (if listed) and shift the data
+     * indices of the items after it to match the source.
+     */
+    void ImageListPanel::removeImage(int origIdx)
+    {
+        int listIdx = findImageByDataIndex(origIdx);
+        bool wasSelected = (listIdx >= 0) && this->listView->IsSelected(listIdx);
+
+        if (listIdx >= 0)
+        {
+            // a virtual list's selection is by row, so move the selected rows after this one up by one
+            vector<int> selectedIndices = getSelectedListViewIndices();
+            bool oldDoCallbacks = this->doCallbacks;
+            this->doCallbacks = false;
+
+            for (int i : selectedIndices)
+            {
+                this->listView->Select(i, false);
+            }
+
+            this->listedDataIndices.erase(this->listedDataIndices.begin() + listIdx);
+            this->listView->SetItemCount((long)this->listedDataIndices.size());
+
+            if (this->lastSelectedListIndex >= listIdx)
+            {
+                this->lastSelectedListIndex--;
+            }
+
+            for (int i : selectedIndices)
+            {
+                if (i > listIdx)
+                {
+                    this->listView->Select(i - 1, true);
+                }
+            }
+
+            this->doCallbacks = oldDoCallbacks;
+        }
+
+        this->nameFilter.removeName(origIdx);
+
+        // data indices after it shift down to match the source
+        for (int& dataIdx : this->listedDataIndices)
+        {
+            if (dataIdx > origIdx)
+            {
+                dataIdx--;
+            }
+        }
+
+        if ((origIdx >= 0) && (origIdx < (int)this->isCheckedByDataIndex.size()))
+        {
+            this->checkedCount -= this->isCheckedByDataIndex[origIdx] ? 1 : 0;
+            this->isCheckedByDataIndex.erase(this->isCheckedByDataIndex.begin() + origIdx);
+        }
+
+        this->listView->Refresh();
+
+        // deleting an item doesn't event a selection change
+        if (wasSelected && this->doCallbacks && this->onSelectionChangeCallback)
+        {
+            this->onSelectionChangeCallback();
+        }
+
+        if (this->doCallbacks && this->onListItemsChangeCallback)
+        {
+            this->onListItemsChangeCallback();
+        }
     }
 
     std::vector<std::shared_ptr<WxivImage>> ImageListPanel::getCheckedImages()
@@ -635,4 +984,41 @@ namespace Wxiv
 
         return getSelectedImages();
     }
+
+    /**
+     * @brief Get the images the user is likely to view next, in list order and obeying the filter and the checkbox
+     * stepping, highest priority first.
+     * @param aheadCount How many to get in the direction the user has been stepping.
+     * @param behindCount How many to get in the other direction.
+     */
+    std::vector<std::shared_ptr<WxivImage>> ImageListPanel::getPrefetchImages(int aheadCount, int behindCount)
+    {
+        std::vector<std::shared_ptr<WxivImage>> images;
+        int n = this->listView->GetItemCount();
+        int selectedIdx = (int)this->listView->GetFirstSelected();
+
+        if ((n > 0) && (selectedIdx >= 0))
+        {
+            for (int direction = 0; direction < 2; direction++)
+            {
+                bool doReverse = (direction == 0) ? this->isSteppingReverse : !this->isSteppingReverse;
+                int count = (direction == 0) ? aheadCount : behindCount;
+                int idx = selectedIdx;
+
+                for (int i = 0; i < count; i++)
+                {
+                    idx = getNextImage(idx, doReverse);
+
+                    if ((idx < 0) || (idx >= n))
+                    {
+                        break;
+                    }
+
+                    images.push_back(getImageByDataIndex(listViewIndexToDataIndex(idx)));
+                }
+            }
+        }
+
+        return images;
+    }
 }
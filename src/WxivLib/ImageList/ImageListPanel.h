@@ -8,25 +8,52 @@
 #include <wx/splitter.h>
 #include <wx/notebook.h>
 #include <wx/listctrl.h>
+#include <wx/timer.h>
 
 #include <opencv2/opencv.hpp>
 
 #include "ImageListSource.h"
+#include "ImageListView.h"
+#include "ImageNameFilter.h"
 
 namespace Wxiv
 {
     /**
      * @brief A panel with a filter box and a listview to show list of images.
      *
-     * The wxListView items have Data which is the original index of the image in the imageListSource.
+     * The listview is virtual, so rows are just list indices into listedDataIndices, which holds the original index (data
+     * index) of each listed image in the imageListSource, in ascending order. Checkbox state is kept per data index, so
+     * it survives filtering. Filtering only rebuilds listedDataIndices, and row text is only made for drawn rows.
+     *
+     * Typing in the filter box is debounced and then filtered on a worker (see ImageNameFilter), and the list is updated
+     * when the result for the latest text is ready.
      */
     class ImageListPanel : public wxPanel
     {
         bool doCallbacks = true; // to avoid recursion from event handlers
         wxTextCtrl* filterTextBox = nullptr;
-        wxListView* listView = nullptr;
+        ImageListView* listView = nullptr;
         std::shared_ptr<ImageListSource> imageListSource;
 
+        // list index to data index, of the images that pass the filter
+        std::vector<int> listedDataIndices;
+
+        // by data index, including images that don't pass the filter
+        std::vector<bool> isCheckedByDataIndex;
+        int checkedCount = 0;
+
+        // header info columns are redrawn while the source's background header pass runs
+        wxTimer headerInfoTimer;
+
+        // lowercase names by data index, and the filter against them
+        ImageNameFilter nameFilter;
+        wxTimer filterDebounceTimer;
+        wxTimer filterResultTimer;
+
+        // to guess which way the user is stepping through the list, for prefetch
+        int lastSelectedListIndex = -1;
+        bool isSteppingReverse = false;
+
         /**
          * @brief For example on new source or filter change.
          */
@@ -35,12 +62,20 @@ namespace Wxiv
 
         void rebuildList();
 
-        void insertListViewItem(int origIdx, std::shared_ptr<WxivImage> image);
+        wxString getItemText(long listIndex, long column);
+        bool checkPassesFilter(std::shared_ptr<WxivImage> image);
+        wxString getHeaderInfoColumnText(std::shared_ptr<WxivImage> image, long column);
+        void onHeaderInfoTimer(wxTimerEvent& evt);
+        void onItemChecked(int listIndex, bool checked);
+        void setItemCount();
         void onItemSelected(int idx);
         void onFilterTextChanged(wxCommandEvent& evt);
+        void onFilterDebounceTimer(wxTimerEvent& evt);
+        void onFilterResultTimer(wxTimerEvent& evt);
+        void applyFilterResult(std::vector<int>& dataIndices);
+        std::string getFilterQuery();
         std::vector<int> getSelectedListViewIndices();
         int listViewIndexToDataIndex(int listViewIndex);
-        void selectImageByDataIndex(int origIdx);
         void toggleSelectedItemsCheckboxes();
         void setupIcons();
         int getNextImage(int idx, bool doReverse);
@@ -63,8 +98,13 @@ namespace Wxiv
         void selectNextImage(bool doReverse);
         void unselectAll();
         void updateForMultiPageImageLoaded();
+        bool appendImage(int origIdx);
+        void removeImage(int origIdx);
+        void updateImageItem(int origIdx);
+        void selectImageByDataIndex(int origIdx);
 
         int getVisibleItemCount();
+        std::vector<int> getVisibleDataIndices();
         int getSelectedItemCount();
         std::shared_ptr<WxivImage> getSelectedImage();
         std::shared_ptr<WxivImage> getImageByDataIndex(int origIdx);
@@ -73,6 +113,7 @@ namespace Wxiv
         std::vector<std::shared_ptr<WxivImage>> getSelectedImages();
         std::vector<std::shared_ptr<WxivImage>> getSelectedOrCheckedImages();
         bool checkAnySelectedOrCheckedImages();
+        std::vector<std::shared_ptr<WxivImage>> getPrefetchImages(int aheadCount, int behindCount);
 
         void saveConfig();
         void restoreConfig();
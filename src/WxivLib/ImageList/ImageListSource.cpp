@@ -17,4 +17,77 @@ namespace Wxiv
     ImageListSource::~ImageListSource()
     {
     }
+
+    void ImageListSource::prefetchImages(const std::vector<std::shared_ptr<WxivImage>>& images)
+    {
+    }
+
+    void ImageListSource::setMemoryBudget(size_t bytes)
+    {
+    }
+
+    void ImageListSource::trimMemory()
+    {
+    }
+
+    int ImageListSource::addImageFile(const wxString& path)
+    {
+        return -1;
+    }
+
+    int ImageListSource::removeImageFile(const wxString& path)
+    {
+        return -1;
+    }
+
+    int ImageListSource::invalidateImageFile(const wxString& path)
+    {
+        return -1;
+    }
+
+    void ImageListSource::setIsWatched(bool isWatched)
+    {
+    }
+
+    bool ImageListSource::checkIsProbingHeaders()
+    {
+        return false;
+    }
+
+    bool ImageListSource::decodePreview(std::shared_ptr<WxivImage> image, cv::Mat& preview, cv::Size& fullSize)
+    {
+        return false;
+    }
+
+    bool ImageListSource::decodeUnloaded(std::shared_ptr<WxivImage> image, cv::Mat& img)
+    {
+        return false;
+    }
+
+    bool ImageListSource::checkIsLive()
+    {
+        return false;
+    }
+
+    bool ImageListSource::checkIsQuickLoad(std::shared_ptr<WxivImage> image)
+    {
+        return image->getIsLoaded() || checkIsLive();
+    }
+
+    bool ImageListSource::takeLiveChanges(std::vector<int>& removedIndices, int& addedCount)
+    {
+        removedIndices.clear();
+        addedCount = 0;
+        return false;
+    }
+
+    std::string ImageListSource::getLiveStatus()
+    {
+        return "";
+    }
+
+    std::string ImageListSource::getLoadStatus()
+    {
+        return "";
+    }
 }
@@ -29,5 +29,101 @@ namespace Wxiv
         virtual int getImageCount() = 0;
         virtual std::shared_ptr<WxivImage> getImage(int idx) = 0;
         virtual void addImagePages(int idx, std::vector<std::shared_ptr<WxivImage>>& pages) = 0;
+
+        /**
+         * @brief Hint that these images are likely to be viewed soon, in priority order.
+         * Sources that can load in the background should start doing so. Default is to do nothing.
+         */
+        virtual void prefetchImages(const std::vector<std::shared_ptr<WxivImage>>& images);
+
+        /**
+         * @brief Limit on total bytes of loaded image pixels. Sources that can re-load images on demand should unload
+         * least-recently viewed images to stay under this. Default is to do nothing.
+         */
+        virtual void setMemoryBudget(size_t bytes);
+
+        /**
+         * @brief Unload least-recently viewed images past the memory budget. Loads only record use, and this does the
+         * unloading, so call it only from the UI thread, which is where images are read. Default is to do nothing.
+         */
+        virtual void trimMemory();
+
+        /**
+         * @brief For incremental updates from watching the source location, add this file at the end of the list if
+         * it's supported and not already listed. Default is to not support this.
+         * @return The new image index, or -1 if not added.
+         */
+        virtual int addImageFile(const wxString& path);
+
+        /**
+         * @brief Remove one listed image (top image or page) from this file. Call until it returns -1 to remove all.
+         * @return The removed image index, or -1 if none.
+         */
+        virtual int removeImageFile(const wxString& path);
+
+        /**
+         * @brief The file changed, so unload its image and pages so they are re-read when next viewed.
+         * @return The index of the file's (top) image, or -1 if not listed.
+         */
+        virtual int invalidateImageFile(const wxString& path);
+
+        /**
+         * @brief The source location is watched for changes, so its files may be rewritten while they're loaded. Sources
+         * that map files should read them into memory instead, and re-load any that are mapped now. Default is to do
+         * nothing.
+         */
+        virtual void setIsWatched(bool isWatched);
+
+        /**
+         * @brief Whether a background pass is still reading image headers (see WxivImage::probeHeader).
+         * Default is no such pass.
+         */
+        virtual bool checkIsProbingHeaders();
+
+        /**
+         * @brief For a big image that takes a while to decode, a quick low-resolution version of it to view until it's
+         * loaded. Safe to call from a background thread. Default is no preview.
+         * @param fullSize The full-resolution size, which the preview is a scaled version of.
+         * @return False if no preview, e.g. the image isn't big or the format has no cheap reduced decode.
+         */
+        virtual bool decodePreview(std::shared_ptr<WxivImage> image, cv::Mat& preview, cv::Size& fullSize);
+
+        /**
+         * @brief Decode the image without loading it into the image, e.g. for a thumbnail, for sources whose images
+         * aren't files that can be read by path. Safe to call from a background thread. Default is false, to read the
+         * file by path. Throws on a failed decode.
+         */
+        virtual bool decodeUnloaded(std::shared_ptr<WxivImage> image, cv::Mat& img);
+
+        /**
+         * @brief Whether images arrive on their own (e.g. from another process), to poll with takeLiveChanges.
+         * Default is not live.
+         */
+        virtual bool checkIsLive();
+
+        /**
+         * @brief Whether loadImage for this image is quick enough for the UI thread, e.g. it's loaded, or it's a live
+         * frame with no decode. Otherwise it's loaded on a worker. Default is loaded or live.
+         */
+        virtual bool checkIsQuickLoad(std::shared_ptr<WxivImage> image);
+
+        /**
+         * @brief For a live source, remove the images that went away and add the new ones at the end of the list.
+         * @param removedIndices The removed image indices, descending, so each is still right after the earlier ones are
+         * removed.
+         * @param addedCount How many images were added at the end, after the removals.
+         * @return False if nothing changed.
+         */
+        virtual bool takeLiveChanges(std::vector<int>& removedIndices, int& addedCount);
+
+        /**
+         * @brief For a live source, a line for the status bar, e.g. frame counts. Default is none.
+         */
+        virtual std::string getLiveStatus();
+
+        /**
+         * @brief For a source that loads on demand, a line for the status bar, e.g. prefetch hits. Default is none.
+         */
+        virtual std::string getLoadStatus();
     };
 }
@@ -0,0 +1,280 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <climits>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+
+#include "WxWidgetsUtil.h"
+#include <wx/mstream.h>
+#include <wx/zstream.h>
+
+#include "ImageListSourceArchive.h"
+#include "ImageDecoder.h"
+#include "ImageHeader.h"
+#include "ImageUtil.h"
+#include "MappedImage.h"
+#include "StringUtil.h"
+#include "WxivUtil.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    // enough of the start of a member for its header, even with a big EXIF block before a JPEG's frame header
+    static const size_t HeaderProbeBytes = 256 * 1024;
+
+    ImageListSourceArchive::~ImageListSourceArchive()
+    {
+        // prefetch and header pass threads call our decodeImage and probeImageHeader and use the archive
+        stopPrefetch();
+    }
+
+    bool ImageListSourceArchive::checkIsArchiveFile(const wxString& path)
+    {
+        wxFileName fn(path);
+        return fn.HasExt() && ArchiveIndex::checkIsArchiveExtension(fn.GetExt().ToStdString()) && fn.FileExists();
+    }
+
+    /**
+     * @brief Index the archive and create a not-loaded image for each supported image member, listed by its path in
+     * the archive. This starts a background pass to read the member headers.
+     */
+    void ImageListSourceArchive::load(wxString path)
+    {
+        this->archivePath = path;
+        this->archive = std::make_unique<ArchiveIndex>(toFilesystemPath(path));
+
+        const vector<ArchiveIndex::Entry>& entries = this->archive->getEntries();
+
+        for (int i = 0; i < (int)entries.size(); i++)
+        {
+            wxString memberName = wxString::FromUTF8(entries[i].name.c_str());
+
+            if (!checkSupportedFile(memberName))
+            {
+                continue;
+            }
+
+            auto image = std::make_shared<WxivImage>(path + wxFileName::GetPathSeparator() + memberName);
+            image->setName(memberName);
+            this->entryIndexByImagePath[string(image->getPath().GetFullPath().ToUTF8().data())] = i;
+            this->images.push_back(image);
+        }
+
+        startHeaderProbe();
+    }
+
+    int ImageListSourceArchive::findImageEntry(std::shared_ptr<WxivImage> image)
+    {
+        auto iter = this->entryIndexByImagePath.find(string(image->getPath().GetFullPath().ToUTF8().data()));
+        return (iter != this->entryIndexByImagePath.end()) ? iter->second : -1;
+    }
+
+    /**
+     * @brief Get the start of the member's data, up to maxSize: in the mapping if stored, else inflated into the
+     * inflated vector.
+     */
+    void ImageListSourceArchive::readEntryStart(
+        const ArchiveIndex::Entry& entry, size_t maxSize, const uint8_t*& data, size_t& size, std::vector<uint8_t>& inflated)
+    {
+        size = (size_t)std::min<uint64_t>(entry.size, maxSize);
+
+        if (entry.compression == ArchiveIndex::Compression::Stored)
+        {
+            data = this->archive->getEntryData(entry);
+        }
+        else if (entry.compression == ArchiveIndex::Compression::Deflated)
+        {
+            if ((entry.compressedSize > INT_MAX) || (entry.size > INT_MAX))
+            {
+                throw runtime_error("Compressed archive members of 2 GB or more are not supported.");
+            }
+
+            // raw deflate, straight from the mapping
+            wxMemoryInputStream compressed(this->archive->getEntryData(entry), (size_t)entry.compressedSize);
+            wxZlibInputStream zlib(compressed, wxZLIB_NO_HEADER);
+            inflated.resize(size);
+
+            if (!inflated.empty() && (zlib.Read(inflated.data(), inflated.size()).LastRead() != inflated.size()))
+            {
+                throw runtime_error("Failed to inflate the archive member.");
+            }
+
+            data = inflated.data();
+        }
+        else
+        {
+            throw runtime_error("Archive member compression method is not supported.");
+        }
+    }
+
+    /**
+     * @brief Get the member's data: in the mapping if stored, else inflated into the inflated vector. A zip member is
+     * checked against its CRC, so a corrupt archive fails to load rather than decoding garbage.
+     */
+    void ImageListSourceArchive::readEntry(const ArchiveIndex::Entry& entry, const uint8_t*& data, std::vector<uint8_t>& inflated)
+    {
+        size_t size = 0;
+        readEntryStart(entry, (size_t)entry.size, data, size, inflated);
+
+        if (!ArchiveIndex::checkCrc(entry, data))
+        {
+            throw runtime_error("Archive member is corrupt, its CRC doesn't match.");
+        }
+    }
+
+    /**
+     * @brief Like ShapeSet::tryLoadNeighborShapesFile, but for a .geo.csv or .parquet member next to the image member.
+     */
+    void ImageListSourceArchive::loadNeighborShapes(std::shared_ptr<WxivImage> image, const std::string& memberName)
+    {
+        size_t slashPos = memberName.rfind('/');
+        size_t dotPos = memberName.rfind('.');
+        string stem = ((dotPos != string::npos) && ((slashPos == string::npos) || (dotPos > slashPos))) ? memberName.substr(0, dotPos) : memberName;
+
+        for (const string& ext : {".geo.csv", ".parquet"})
+        {
+            int entryIndex = this->archive->findEntry(stem + ext);
+
+            if (entryIndex >= 0)
+            {
+                const ArchiveIndex::Entry& entry = this->archive->getEntries()[entryIndex];
+                const uint8_t* data = nullptr;
+                vector<uint8_t> inflated;
+                readEntry(entry, data, inflated);
+                image->getShapes().loadShapesBuffer(data, (size_t)entry.size, entry.name);
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief The image's member, which has to be the first page.
+     */
+    const ArchiveIndex::Entry& ImageListSourceArchive::getImageEntry(std::shared_ptr<WxivImage> image)
+    {
+        int entryIndex = findImageEntry(image);
+
+        if (entryIndex < 0)
+        {
+            throw runtime_error("Image is not in the archive.");
+        }
+
+        if (image->getPage() > 0)
+        {
+            throw runtime_error("Only the first page of images in archives can be loaded.");
+        }
+
+        return this->archive->getEntries()[entryIndex];
+    }
+
+    cv::Mat ImageListSourceArchive::decodeEntry(const ArchiveIndex::Entry& entry, const std::string& ext)
+    {
+        cv::Mat img;
+
+        if (MappedImage::checkIsMappedExtension(ext) && (entry.compression == ArchiveIndex::Compression::Stored))
+        {
+            if (!ArchiveIndex::checkCrc(entry, this->archive->getEntryData(entry)))
+            {
+                throw runtime_error("Archive member is corrupt, its CRC doesn't match.");
+            }
+
+            // no decode and no copy, the pixels are in the archive mapping
+            img = MappedImage::load(this->archive->getFile(), (size_t)entry.dataOffset, (size_t)entry.size, ext);
+        }
+        else if (MappedImage::checkIsMappedExtension(ext))
+        {
+            throw runtime_error("Compressed npy and raw archive members are not supported.");
+        }
+        else
+        {
+            const uint8_t* data = nullptr;
+            vector<uint8_t> inflated;
+            readEntry(entry, data, inflated);
+            vector<cv::Mat> mats;
+
+            if (!ImageDecoder::decodeBuffer(data, (size_t)entry.size, ext, mats) || mats.empty())
+            {
+                throw runtime_error("Failed to load and decode image file.");
+            }
+
+            img = mats[0];
+        }
+
+        ImageUtil::convertAfterLoad(img, ext, img);
+        return img;
+    }
+
+    void ImageListSourceArchive::decodeImage(std::shared_ptr<WxivImage> image)
+    {
+        const ArchiveIndex::Entry& entry = getImageEntry(image);
+        cv::Mat img = decodeEntry(entry, getNormalizedExt(image->getTypeStr()));
+        image->setImage(img);
+
+        try
+        {
+            loadNeighborShapes(image, entry.name);
+        }
+        catch (std::runtime_error& ex)
+        {
+            image->setShapeSetLoadError(wxString(ex.what()));
+        }
+    }
+
+    /**
+     * @brief Stored npy/raw members are wrapped just like a load, and png/jpg headers are read from the start of the
+     * member. Other formats are read by path, so are left undescribed.
+     */
+    void ImageListSourceArchive::probeImageHeader(std::shared_ptr<WxivImage> image)
+    {
+        ImageHeaderInfo info;
+
+        try
+        {
+            const ArchiveIndex::Entry& entry = getImageEntry(image);
+            string ext = getNormalizedExt(image->getTypeStr());
+
+            if (MappedImage::checkIsMappedExtension(ext))
+            {
+                if (entry.compression == ArchiveIndex::Compression::Stored)
+                {
+                    cv::Mat img = MappedImage::load(this->archive->getFile(), (size_t)entry.dataOffset, (size_t)entry.size, ext);
+                    info.width = img.cols;
+                    info.height = img.rows;
+                    info.depth = img.depth();
+                    info.channels = img.channels();
+                    info.pageCount = 1;
+                }
+            }
+            else
+            {
+                const uint8_t* data = nullptr;
+                size_t size = 0;
+                vector<uint8_t> inflated;
+                readEntryStart(entry, HeaderProbeBytes, data, size, inflated);
+                ImageHeader::probeBuffer(data, size, ext, info);
+            }
+        }
+        catch (std::exception&)
+        {
+            info = ImageHeaderInfo();
+        }
+
+        image->setHeaderInfo(info);
+    }
+
+    bool ImageListSourceArchive::decodePreview(std::shared_ptr<WxivImage> image, cv::Mat& preview, cv::Size& fullSize)
+    {
+        return false;
+    }
+
+    /**
+     * @brief A decode of the member, like decodeImage but without neighbor shapes.
+     */
+    bool ImageListSourceArchive::decodeUnloaded(std::shared_ptr<WxivImage> image, cv::Mat& img)
+    {
+        img = decodeEntry(getImageEntry(image), getNormalizedExt(image->getTypeStr()));
+        return true;
+    }
+}
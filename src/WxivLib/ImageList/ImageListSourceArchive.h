@@ -0,0 +1,62 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <opencv2/opencv.hpp>
+
+#include "WxivImage.h"
+#include "ImageListSource.h"
+#include "ImageListSourceDirectory.h"
+#include "ArchiveIndex.h"
+#include "WxWidgetsUtil.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief Concrete ImageListSource sub-class that lists the images in a zip or tar file, e.g. a bundle of debug images
+     * from a pipeline run, without extracting it.
+     *
+     * The archive is indexed once (see ArchiveIndex) and each image is decoded straight from the archive when selected
+     * or prefetched. Stored members are decoded from the mapping of the archive with no copy (and npy/raw members are
+     * wrapped in place), deflated members are inflated into memory first. Zip members are checked against their CRC.
+     * Neighbor .geo.csv/.parquet shape files are looked for in the archive, next to the image member.
+     *
+     * Images have the path of the archive joined with the member name, and are listed by the member name (with its
+     * dirs in the archive, since names in different dirs can be the same). Header columns and thumbnails are read from
+     * the members too. Only the first page of multi-page tif members is available, and there are no previews.
+     */
+    class ImageListSourceArchive : public ImageListSourceDirectory
+    {
+      private:
+        std::unique_ptr<ArchiveIndex> archive;
+        wxString archivePath;
+
+        // by the image's full path (utf-8), which includes pages of the image
+        std::unordered_map<std::string, int> entryIndexByImagePath;
+
+        int findImageEntry(std::shared_ptr<WxivImage> image);
+        void readEntry(const ArchiveIndex::Entry& entry, const uint8_t*& data, std::vector<uint8_t>& inflated);
+        void readEntryStart(const ArchiveIndex::Entry& entry, size_t maxSize, const uint8_t*& data, size_t& size, std::vector<uint8_t>& inflated);
+        const ArchiveIndex::Entry& getImageEntry(std::shared_ptr<WxivImage> image);
+        cv::Mat decodeEntry(const ArchiveIndex::Entry& entry, const std::string& ext);
+        void loadNeighborShapes(std::shared_ptr<WxivImage> image, const std::string& memberName);
+
+      protected:
+        void decodeImage(std::shared_ptr<WxivImage> image) override;
+        void probeImageHeader(std::shared_ptr<WxivImage> image) override;
+
+      public:
+        ~ImageListSourceArchive() override;
+
+        static bool checkIsArchiveFile(const wxString& path);
+
+        /**
+         * @param archivePath The zip or tar file, not a dir.
+         */
+        void load(wxString archivePath) override;
+        bool decodePreview(std::shared_ptr<WxivImage> image, cv::Mat& preview, cv::Size& fullSize) override;
+        bool decodeUnloaded(std::shared_ptr<WxivImage> image, cv::Mat& img) override;
+    };
+}
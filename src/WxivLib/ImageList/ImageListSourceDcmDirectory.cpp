@@ -12,6 +12,7 @@
 #include "ImageListSourceDcmDirectory.h"
 #include "StringUtil.h"
 #include "DicomUtil.h"
+#include "DicomIndex.h"
 #include "WxivUtil.h"
 #include "VectorUtil.h"
 
@@ -20,6 +21,12 @@ namespace fs = std::filesystem;
 
 namespace Wxiv
 {
+    ImageListSourceDcmDirectory::~ImageListSourceDcmDirectory()
+    {
+        // prefetch threads call our decodeImage and use the index
+        stopPrefetch();
+    }
+
     bool ImageListSourceDcmDirectory::checkSupportedFile(const wxString& name)
     {
         wxFileName wxn(name);
@@ -29,7 +36,9 @@ namespace Wxiv
     }
 
     /**
-     * @brief Need our own load to leave out structure dcm file(s).
+     * @brief Need our own load to leave out structure dcm file(s), which are found (and their contours loaded) by
+     * indexing the headers of all the dcm files. Files whose header couldn't be read are left out too, since they
+     * could be structure sets, and they wouldn't decode anyway.
      */
     void ImageListSourceDcmDirectory::load(wxString dirPath)
     {
@@ -37,112 +46,62 @@ namespace Wxiv
         auto thisPredicate = [=, this](const wxString& s) -> bool { return this->checkSupportedFile(s); };
         vector<wxString> selectedPaths = vectorSelect<wxString>(paths, thisPredicate);
 
-        vector<wxString> imageDcmPaths, structureDcmPaths;
+        this->dicomIndex = DicomIndex::getForDir(dirPath, selectedPaths);
 
-        for (const wxString& path : selectedPaths)
+        for (const DicomIndex::Entry& entry : this->dicomIndex->getEntries())
         {
-            // Use Contour load to decide if structure file, because if so we want to load the contours anyway
-            vector<Contour> thisContours = loadContours(path);
-
-            if (!thisContours.empty())
+            if (entry.isRead && !entry.isStructureSet)
             {
-                structureDcmPaths.push_back(path);
-                this->contours.insert(this->contours.end(), thisContours.begin(), thisContours.end());
+                WxivImage* p = new WxivImage(entry.path);
+                this->images.push_back(std::shared_ptr<WxivImage>(p));
             }
-            else
-            {
-                imageDcmPaths.push_back(path);
-            }
-        }
-
-        for (const auto& path : selectedPaths)
-        {
-            WxivImage* p = new WxivImage(path);
-            this->images.push_back(std::shared_ptr<WxivImage>(p));
         }
     }
 
-    cv::Point2f applyAffineTransform(const cv::Mat& transform, const cv::Point2f& point)
+    /**
+     * @brief Decodes just the one frame. Decoding the first frame of a multi-frame file creates not-loaded page images
+     * for the other frames, like the pages of a multi-page tif.
+     */
+    void ImageListSourceDcmDirectory::decodeImage(std::shared_ptr<WxivImage> image)
     {
-        int rows = transform.rows;
-        int cols = transform.cols;
-        if (rows != 3 || cols != 3)
+        vector<cv::Mat> mats;
+        string uuidStr;
+        wxString fullPath = image->getPath().GetFullPath();
+        int frameCount = 1;
+
+        if (!wxLoadDicomImage(fullPath, mats, uuidStr, image->getPage(), frameCount) || mats.empty())
         {
-            throw runtime_error("Transform matrix must be 3x3.");
+            throw runtime_error("Failed to load and decode image file.");
         }
 
-        cv::Mat src(3, 1, CV_64F);
-        src.at<double>(0, 0) = point.x;
-        src.at<double>(1, 0) = point.y;
-        src.at<double>(2, 0) = 1.0;
-        cv::Mat dst = transform * src;
-        return cv::Point2f(dst.at<double>(0, 0) / dst.at<double>(2, 0), dst.at<double>(1, 0) / dst.at<double>(2, 0));
-    }
+        image->setImage(mats[0]);
 
-    bool ImageListSourceDcmDirectory::loadImage(std::shared_ptr<WxivImage> image)
-    {
-        if (!image->getIsLoaded())
+        // frames, which stay listed across evictions of the first, so only create them once
+        if ((image->getPage() == 0) && image->getPages().empty())
         {
-            vector<cv::Mat> mats;
-            string uuidStr;
-            wxString fullPath = image->getPath().GetFullPath();
-            cv::Mat affineXform; // from world coords to pixel coords
-
-            if (!wxLoadDicomImage(fullPath, mats, uuidStr, affineXform))
+            for (int i = 1; i < frameCount; i++)
             {
-                throw runtime_error("Failed to load and decode image file.");
+                WxivImage* pimg = new WxivImage(image->getPath());
+                pimg->setPage(i);
+                image->addPage(std::shared_ptr<WxivImage>(pimg));
             }
+        }
 
-            if (mats.size() > 0)
-            {
-                // main image
-                image->setImage(mats[0]);
-
-                // I'm not sure multiple images per dcm file is a thing, so defer until have a case to develop against.
-                //// pages
-                // for (int i = 1; i < mats.size(); i++)
-                //{
-                //    WxivImage* pimg = new WxivImage(image->getPath());
-                //    pimg->setImage(mats[i]);
-                //    pimg->setPage(i);
-                //    image->addPage(std::shared_ptr<WxivImage>(pimg));
-                //}
-            }
-            else
-            {
-                throw runtime_error("Failed to read image file.");
-            }
-
-            // Contours
-            if (!this->contours.empty())
-            {
-                for (const Contour& contour : this->contours)
-                {
-                    // each Contour has all slices/images.
-                    auto iter = std::find(contour.referencedSopInstanceUids.begin(), contour.referencedSopInstanceUids.end(), uuidStr);
-
-                    if (iter != contour.referencedSopInstanceUids.end())
-                    {
-                        int sliceIndex = iter - contour.referencedSopInstanceUids.begin();
-                        std::vector<ContourPoint> slicePoints = contour.slicePoints[sliceIndex];
-                        Polygon poly;
-                        poly.colorRgb = cv::Scalar(contour.rgbColor[0], contour.rgbColor[1], contour.rgbColor[2]);
-                        poly.pointDim = 1;
-                        poly.lineThickness = 1;
-
-                        for (const ContourPoint& pt : slicePoints)
-                        {
-                            cv::Point2f worldPt(pt.x, pt.y);
-                            cv::Point2f pixelPt = applyAffineTransform(affineXform, worldPt);
-                            poly.points.push_back(pixelPt);
-                        }
+        // contour slices on this image, already in its pixel coords (contours refer to a whole multi-frame file, not a frame)
+        const std::vector<Polygon>* slicePolygons = (frameCount == 1) ? this->dicomIndex->findSlicePolygons(uuidStr) : nullptr;
 
-                        image->getShapes().polygons.push_back(poly);
-                    }
-                }
-            }
+        if (slicePolygons)
+        {
+            std::vector<Polygon>& polygons = image->getShapes().polygons;
+            polygons.insert(polygons.end(), slicePolygons->begin(), slicePolygons->end());
         }
+    }
 
-        return true;
+    /**
+     * @brief There are no headers to probe for frames, unlike tif pages.
+     */
+    void ImageListSourceDcmDirectory::addImagePages(int idx, std::vector<std::shared_ptr<WxivImage>>& pages)
+    {
+        this->images.insert(this->images.begin() + idx + 1, pages.begin(), pages.end());
     }
-}
\ No newline at end of file
+}
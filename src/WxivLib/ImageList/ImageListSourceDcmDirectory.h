@@ -9,26 +9,30 @@
 #include "ImageListSource.h"
 #include "ImageListSourceDirectory.h"
 #include "WxWidgetsUtil.h"
-#include "Contour.h"
+#include "DicomIndex.h"
 
 namespace Wxiv
 {
     /**
      * @brief Concrete ImageListSource sub-class that loads from a local dir of dcm files.
+     * The frames of multi-frame files are listed as pages, each decoded on its own when selected or prefetched.
      */
     class ImageListSourceDcmDirectory : public ImageListSourceDirectory
     {
       private:
         /**
-         * @brief Each contour has all images/slices (one vector of points per slice/image).
+         * @brief The dcm files' headers, and the contour slices on each image.
          */
-        std::vector<Contour> contours;
+        std::shared_ptr<DicomIndex> dicomIndex;
 
       protected:
         virtual bool checkSupportedFile(const wxString& name) override;
+        void decodeImage(std::shared_ptr<WxivImage> image) override;
 
       public:
-        bool loadImage(std::shared_ptr<WxivImage> image) override;
+        ~ImageListSourceDcmDirectory() override;
+
         void load(wxString dirPath) override;
+        void addImagePages(int idx, std::vector<std::shared_ptr<WxivImage>>& pages) override;
     };
 }
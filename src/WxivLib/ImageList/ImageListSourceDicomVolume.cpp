@@ -0,0 +1,146 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <fmt/core.h>
+#include <opencv2/opencv.hpp>
+
+#include "ImageListSourceDicomVolume.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    static const wxString VolumeLocationPrefix = "mpr:";
+
+    bool ImageListSourceDicomVolume::checkIsVolumeLocation(const wxString& location)
+    {
+        VolumeAxis axis;
+        wxString dirPath;
+        return tryParseLocation(location, axis, dirPath);
+    }
+
+    bool ImageListSourceDicomVolume::tryParseLocation(const wxString& location, VolumeAxis& axis, wxString& dirPath)
+    {
+        if (!location.StartsWith(VolumeLocationPrefix))
+        {
+            return false;
+        }
+
+        wxString rest = location.Mid(VolumeLocationPrefix.length());
+
+        for (VolumeAxis a : {VolumeAxis::Axial, VolumeAxis::Coronal, VolumeAxis::Sagittal})
+        {
+            wxString axisPrefix = ImageVolume::getAxisName(a) + ":";
+
+            if (rest.StartsWith(axisPrefix) && (rest.length() > axisPrefix.length()))
+            {
+                axis = a;
+                dirPath = rest.Mid(axisPrefix.length());
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    wxString ImageListSourceDicomVolume::makeLocation(VolumeAxis axis, const wxString& dirPath)
+    {
+        return VolumeLocationPrefix + ImageVolume::getAxisName(axis) + ":" + dirPath;
+    }
+
+    void ImageListSourceDicomVolume::load(wxString inLocation)
+    {
+        wxString dirPath;
+
+        if (!tryParseLocation(inLocation, this->axis, dirPath))
+        {
+            throw runtime_error("Volume location must be like mpr:axial:/path/to/dir");
+        }
+
+        this->location = inLocation;
+        this->dicomVolume = DicomVolume::getForDir(dirPath, this->memoryBudget);
+
+        std::shared_ptr<ImageVolume> volume = this->dicomVolume->getVolume();
+        int sliceCount = volume->getSliceCount(this->axis);
+        string axisName = ImageVolume::getAxisName(this->axis);
+
+        for (int i = 0; i < sliceCount; i++)
+        {
+            auto image = std::make_shared<WxivImage>(this->location + "/" + wxString(fmt::format("{} {:04d}", axisName, i)));
+            this->sliceIndexByImage[image.get()] = i;
+            this->images.push_back(image);
+        }
+    }
+
+    /**
+     * @brief Only the viewed slice is kept, since any slice can be cut from the volume again in a few ms.
+     */
+    bool ImageListSourceDicomVolume::loadImage(std::shared_ptr<WxivImage> image)
+    {
+        const std::lock_guard<std::mutex> lock(this->loadMutex);
+        auto iter = this->sliceIndexByImage.find(image.get());
+
+        if (iter == this->sliceIndexByImage.end())
+        {
+            throw runtime_error("Slice is not in the volume.");
+        }
+
+        if (!image->getIsLoaded())
+        {
+            int index = iter->second;
+            cv::Mat slice = this->dicomVolume->getVolume()->getDisplaySlice(this->axis, index);
+
+            {
+                const std::lock_guard<std::mutex> imageLock(image->getLoadMutex());
+                image->setImage(slice);
+            }
+
+            if (this->axis == VolumeAxis::Axial)
+            {
+                const std::vector<Polygon>* slicePolygons =
+                    this->dicomVolume->getIndex()->findSlicePolygons(this->dicomVolume->getSopInstanceUid(index));
+
+                if (slicePolygons)
+                {
+                    std::vector<Polygon>& polygons = image->getShapes().polygons;
+                    polygons.insert(polygons.end(), slicePolygons->begin(), slicePolygons->end());
+                }
+            }
+        }
+
+        if (this->loadedImage && (this->loadedImage != image))
+        {
+            this->loadedImage->unload();
+        }
+
+        this->loadedImage = image;
+        return true;
+    }
+
+    int ImageListSourceDicomVolume::getImageCount()
+    {
+        return (int)this->images.size();
+    }
+
+    std::shared_ptr<WxivImage> ImageListSourceDicomVolume::getImage(int idx)
+    {
+        if (idx < this->images.size())
+        {
+            return this->images[idx];
+        }
+        else
+        {
+            throw std::runtime_error("getImage index out of range");
+        }
+    }
+
+    void ImageListSourceDicomVolume::addImagePages(int idx, std::vector<std::shared_ptr<WxivImage>>& pages)
+    {
+        // slices have no pages
+    }
+
+    void ImageListSourceDicomVolume::setMemoryBudget(size_t bytes)
+    {
+        this->memoryBudget = bytes;
+    }
+}
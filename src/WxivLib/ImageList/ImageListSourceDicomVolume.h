@@ -0,0 +1,51 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "WxivImage.h"
+#include "ImageListSource.h"
+#include "DicomVolume.h"
+#include "WxWidgetsUtil.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief Concrete ImageListSource sub-class that lists the slices along one axis (axial, coronal, or sagittal) of
+     * the series volume in a dir of dcm files (see DicomVolume), so each axis is stepped through like a dir of images.
+     *
+     * The location is "mpr:", the axis name, ":", and the dir, like "mpr:coronal:/data/ct1". The volume is shared by
+     * all three axes, so switching axis doesn't load it again. Slices are cut from the volume when viewed, with no
+     * decode, and only the viewed slice is kept. Axial slices have their contours.
+     */
+    class ImageListSourceDicomVolume : public ImageListSource
+    {
+      private:
+        std::shared_ptr<DicomVolume> dicomVolume;
+        VolumeAxis axis = VolumeAxis::Axial;
+        wxString location;
+        std::vector<std::shared_ptr<WxivImage>> images;
+        std::unordered_map<WxivImage*, int> sliceIndexByImage; // only written by load
+        size_t memoryBudget = 1ull << 30;
+
+        // loadImage may be called on a loader thread
+        std::mutex loadMutex;
+        std::shared_ptr<WxivImage> loadedImage;
+
+      public:
+        static bool checkIsVolumeLocation(const wxString& location);
+        static bool tryParseLocation(const wxString& location, VolumeAxis& axis, wxString& dirPath);
+        static wxString makeLocation(VolumeAxis axis, const wxString& dirPath);
+
+        void load(wxString location) override;
+        bool loadImage(std::shared_ptr<WxivImage> image) override;
+        int getImageCount() override;
+        std::shared_ptr<WxivImage> getImage(int idx) override;
+        void addImagePages(int idx, std::vector<std::shared_ptr<WxivImage>>& pages) override;
+        void setMemoryBudget(size_t bytes) override;
+    };
+}
@@ -1,6 +1,8 @@
 // Copyright(c) 2022 Ryan Seghers
 // Distributed under the MIT License (http://opensource.org/licenses/MIT)
 #include <string>
+#include <algorithm>
+#include <thread>
 #include <opencv2/opencv.hpp>
 #include <fmt/core.h>
 #include <filesystem>
@@ -13,18 +15,31 @@
 #include "StringUtil.h"
 #include "WxivUtil.h"
 #include "VectorUtil.h"
+#include "TiffUtil.h"
+#include "TiledTiffImage.h"
+#include "MappedImage.h"
 
 using namespace std;
 namespace fs = std::filesystem;
 
 namespace Wxiv
 {
-    ImageListSourceDirectory::ImageListSourceDirectory()
+    ImageListSourceDirectory::ImageListSourceDirectory() : memoryCache((size_t)4 * 1024 * 1024 * 1024)
     {
     }
 
     ImageListSourceDirectory::~ImageListSourceDirectory()
     {
+        stopPrefetch();
+    }
+
+    /**
+     * @brief Join the prefetch and header pass threads, letting any in-progress load or header read finish.
+     */
+    void ImageListSourceDirectory::stopPrefetch()
+    {
+        this->prefetcher.reset();
+        this->headerProber.reset();
     }
 
     bool ImageListSourceDirectory::checkSupportedFile(const wxString& name)
@@ -33,65 +48,231 @@ namespace Wxiv
         return WxivImage::checkSupportedExtension(wxn);
     }
 
+    /**
+     * @brief Load the image if not already loaded (possibly by prefetch).
+     * @return True (errors are thrown).
+     */
     bool ImageListSourceDirectory::loadImage(std::shared_ptr<WxivImage> image)
     {
-        static std::mutex imreadMutex;
+        bool didLoad = tryLoadImage(image, true);
+        const std::lock_guard<std::mutex> lock(this->selectedMutex);
+
+        if (this->selectedImages.insert(image.get()).second)
+        {
+            (didLoad ? this->prefetchMissCount : this->prefetchHitCount)++;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Before an image is dropped or re-read, so its next selection counts again (and a new image at the same
+     * address isn't taken for it).
+     */
+    void ImageListSourceDirectory::forgetSelected(const std::shared_ptr<WxivImage>& image)
+    {
+        const std::lock_guard<std::mutex> lock(this->selectedMutex);
+        this->selectedImages.erase(image.get());
+    }
+
+    /**
+     * @brief Load under the image's load mutex, so this can be called from the UI thread and prefetch threads.
+     * @param isForeground True for the image being viewed (as opposed to prefetch), so it is kept loaded.
+     * @return True if this call did the load, false if it was already loaded.
+     */
+    bool ImageListSourceDirectory::tryLoadImage(std::shared_ptr<WxivImage> image, bool isForeground)
+    {
+        bool didLoad = false;
 
-        if (!image->getIsLoaded())
         {
-            const std::lock_guard<std::mutex> lock(imreadMutex); // imread is not MT-safe
-            vector<cv::Mat> mats;
-            wxString fullPath = image->getPath().GetFullPath();
+            const std::lock_guard<std::mutex> lock(image->getLoadMutex());
 
-            if (!wxLoadImage(fullPath, mats))
+            if (!image->getIsLoaded())
             {
-                throw runtime_error("Failed to load and decode image file.");
+                decodeImage(image);
+                didLoad = true;
+            }
+        }
+
+        this->memoryCache.touch(image, isForeground);
+        return didLoad;
+    }
+
+    // tif's at least this big are read by region instead of decoded whole
+    static const int64_t TiledMinPixelCount = (int64_t)16384 * 16384;
+    static const size_t TiledCacheBytes = (size_t)256 * 1024 * 1024;
+    static const int TiledOverviewMaxDim = 2048;
+
+    /**
+     * @brief For multi-page files this decodes just the one page. Opening the top image of a multi-page tif counts
+     * the pages from the file structure and creates not-loaded page images, which are decoded when selected (or prefetched)
+     * and are evicted independently.
+     */
+    void ImageListSourceDirectory::decodeImage(std::shared_ptr<WxivImage> image)
+    {
+        vector<cv::Mat> mats;
+        wxString fullPath = image->getPath().GetFullPath();
+
+        if (image->getPage() > 0)
+        {
+            if (!wxLoadImage(fullPath, mats, image->getPage(), this->isWatched))
+            {
+                throw runtime_error("Failed to load and decode image file page.");
             }
 
-            if (mats.size() > 0)
+            image->setImage(mats[0]);
+        }
+        else if (std::shared_ptr<TiledTiffImage> tiled = tryOpenTiled(fullPath))
+        {
+            // huge, so just an overview now and the rest is read as it's viewed
+            cv::Mat overview = tiled->readOverview(TiledOverviewMaxDim);
+            image->setTiledImage(tiled, overview);
+        }
+        else
+        {
+            int pageCount = wxCountImagePages(fullPath);
+
+            if (!wxLoadImage(fullPath, mats, 0, this->isWatched))
             {
-                // main image
-                image->setImage(mats[0]);
+                throw runtime_error("Failed to load and decode image file.");
+            }
+
+            image->setImage(mats[0]);
 
-                // pages
-                for (int i = 1; i < mats.size(); i++)
+            // pages, which stay listed across evictions of the top image, so only create them once
+            if (image->getPages().empty())
+            {
+                for (int i = 1; i < pageCount; i++)
                 {
                     WxivImage* pimg = new WxivImage(image->getPath());
-                    pimg->setImage(mats[i]);
                     pimg->setPage(i);
                     image->addPage(std::shared_ptr<WxivImage>(pimg));
                 }
             }
-            else
-            {
-                throw runtime_error("Failed to read image file.");
-            }
+        }
 
-            try
-            {
-                image->getShapes().tryLoadNeighborShapesFile(image->getPath());
-
-                //// TEMP add poly for dev
-                // Polygon poly;
-                // poly.colorRgb = cv::Scalar(255, 0, 0);
-                // poly.lineThickness = 1;
-                // poly.pointDim = 1;
-                // poly.points.push_back(cv::Point2f(0, 0));
-                // poly.points.push_back(cv::Point2f(120, 120));
-                // poly.points.push_back(cv::Point2f(120, 340));
-                // image->getShapes().polygons.push_back(poly);
-            }
-            catch (std::runtime_error& ex)
-            {
-                image->setShapeSetLoadError(wxString(ex.what()));
-            }
+        try
+        {
+            image->getShapes().tryLoadNeighborShapesFile(image->getPath());
+        }
+        catch (std::runtime_error& ex)
+        {
+            image->setShapeSetLoadError(wxString(ex.what()));
         }
+    }
 
-        return true;
+    // images at least this big get a preview while they load, at least this big in the larger axis
+    static const int64_t PreviewMinPixelCount = (int64_t)4096 * 4096;
+    static const int PreviewMinDim = 1024;
+
+    /**
+     * @brief From a reduced decode (see wxLoadImageReduced), for images big enough that a full decode takes a while.
+     * Huge tif's are skipped since they only load an overview anyway.
+     */
+    bool ImageListSourceDirectory::decodePreview(std::shared_ptr<WxivImage> image, cv::Mat& preview, cv::Size& fullSize)
+    {
+        wxString fullPath = image->getPath().GetFullPath();
+        ImageHeaderInfo info;
+
+        if (image->getIsHeaderProbed())
+        {
+            info = image->getHeaderInfo();
+        }
+        else
+        {
+            // the background pass hasn't got to it, and only that pass may set it on the image
+            ImageHeader::probeFile(toFilesystemPath(fullPath), image->getTypeStr(), image->getPage(), info);
+        }
+
+        int64_t pixelCount = (int64_t)info.width * info.height;
+
+        if (info.empty() || (pixelCount < PreviewMinPixelCount))
+        {
+            return false;
+        }
+
+        if (TiffUtil::checkIsTiffExtension(image->getTypeStr()) && (pixelCount >= TiledMinPixelCount))
+        {
+            return false;
+        }
+
+        return wxLoadImageReduced(fullPath, image->getPage(), PreviewMinDim, preview, fullSize, this->isWatched);
+    }
+
+    /**
+     * @brief Open for reading by region if this is a tif that's big enough to need it, else nullptr.
+     */
+    std::shared_ptr<TiledTiffImage> ImageListSourceDirectory::tryOpenTiled(const wxString& path)
+    {
+        wxFileName fn(path);
+
+        if (!checkIsOnlyAscii(fn.GetExt()) || !TiffUtil::checkIsTiffExtension(fn.GetExt().ToStdString()))
+        {
+            return nullptr;
+        }
+
+        return TiledTiffImage::tryOpen(toFilesystemPath(path), TiledMinPixelCount, TiledCacheBytes);
+    }
+
+    /**
+     * @brief Start loading these in the background, dropping any prior prefetch requests that have not started.
+     */
+    void ImageListSourceDirectory::prefetchImages(const std::vector<std::shared_ptr<WxivImage>>& prefetchImages)
+    {
+        if (!this->prefetcher)
+        {
+            // decodes run concurrently, but leave some cores for the UI and the foreground load
+            int threadCount = std::clamp((int)std::thread::hardware_concurrency() / 2, 1, 4);
+            this->prefetcher =
+                std::make_unique<ImagePrefetcher>(threadCount, [this](std::shared_ptr<WxivImage> image) { this->tryLoadImage(image, false); });
+        }
+
+        this->prefetcher->setQueue(prefetchImages);
+    }
+
+    int ImageListSourceDirectory::getPrefetchHitCount()
+    {
+        const std::lock_guard<std::mutex> lock(this->selectedMutex);
+        return this->prefetchHitCount;
+    }
+
+    int ImageListSourceDirectory::getPrefetchMissCount()
+    {
+        const std::lock_guard<std::mutex> lock(this->selectedMutex);
+        return this->prefetchMissCount;
+    }
+
+    std::string ImageListSourceDirectory::getLoadStatus()
+    {
+        int hitCount = getPrefetchHitCount();
+        int viewedCount = hitCount + getPrefetchMissCount();
+        double residentMb = getResidentBytes() / (1024.0 * 1024.0);
+        return fmt::format("Prefetched {} of {} viewed, {:.0f} MB loaded, {} unloaded", hitCount, viewedCount, residentMb, getEvictionCount());
+    }
+
+    void ImageListSourceDirectory::setMemoryBudget(size_t bytes)
+    {
+        this->memoryCache.setBudgetBytes(bytes);
+    }
+
+    void ImageListSourceDirectory::trimMemory()
+    {
+        this->memoryCache.evictOverBudget();
+    }
+
+    size_t ImageListSourceDirectory::getResidentBytes()
+    {
+        return this->memoryCache.getResidentBytes();
+    }
+
+    int ImageListSourceDirectory::getEvictionCount()
+    {
+        return this->memoryCache.getEvictionCount();
     }
 
     /**
      * @brief Load images from dir. Only known image types. This sorts.
+     * This starts a background pass to read the image headers.
      * @param dirPath
      */
     void ImageListSourceDirectory::load(wxString dirPath)
@@ -105,6 +286,143 @@ namespace Wxiv
             WxivImage* p = new WxivImage(path);
             this->images.push_back(std::shared_ptr<WxivImage>(p));
         }
+
+        startHeaderProbe();
+    }
+
+    /**
+     * @brief Start the background pass to read the headers of the images, see probeImageHeader.
+     */
+    void ImageListSourceDirectory::startHeaderProbe()
+    {
+        // header reads mostly wait on the file system, so more threads than cores is ok
+        int threadCount = std::clamp((int)std::thread::hardware_concurrency(), 2, 8);
+        auto probeFunction = [this](std::shared_ptr<WxivImage> image) { this->probeImageHeader(image); };
+        this->headerProber = std::make_unique<ImageHeaderProber>(this->images, threadCount, probeFunction);
+    }
+
+    void ImageListSourceDirectory::probeImageHeader(std::shared_ptr<WxivImage> image)
+    {
+        image->probeHeader();
+    }
+
+    /**
+     * @brief Index of the first listed image (which is the top image, before its pages) for this file, or -1.
+     * All images are from the one dir, so this just compares names.
+     */
+    int ImageListSourceDirectory::findImageFile(const wxString& path)
+    {
+        wxString name = wxFileName(path).GetFullName();
+
+        for (int i = 0; i < (int)this->images.size(); i++)
+        {
+            if (this->images[i]->getPath().GetFullName() == name)
+            {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    /**
+     * @brief Unload under the load mutex, so this waits for a load in progress, and stop tracking it for eviction.
+     */
+    void ImageListSourceDirectory::unloadImage(std::shared_ptr<WxivImage> image)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(image->getLoadMutex());
+            image->unload();
+        }
+
+        this->memoryCache.remove(image);
+        forgetSelected(image);
+    }
+
+    /**
+     * @brief Append, so existing indices stay valid. Pages are not listed until the image is selected, as in load().
+     */
+    int ImageListSourceDirectory::addImageFile(const wxString& path)
+    {
+        if (!checkSupportedFile(path) || (findImageFile(path) >= 0))
+        {
+            return -1;
+        }
+
+        auto image = std::make_shared<WxivImage>(path);
+        image->probeHeader();
+        this->images.push_back(image);
+        return (int)this->images.size() - 1;
+    }
+
+    int ImageListSourceDirectory::removeImageFile(const wxString& path)
+    {
+        int idx = findImageFile(path);
+
+        if (idx >= 0)
+        {
+            unloadImage(this->images[idx]);
+            this->images.erase(this->images.begin() + idx);
+        }
+
+        return idx;
+    }
+
+    /**
+     * @brief Listed pages stay listed, since the list can't be rebuilt under the user here, and a page past the new
+     * page count just fails to load.
+     */
+    int ImageListSourceDirectory::invalidateImageFile(const wxString& path)
+    {
+        int idx = findImageFile(path);
+
+        if (idx < 0)
+        {
+            return -1;
+        }
+
+        std::shared_ptr<WxivImage> image = this->images[idx];
+        unloadImage(image);
+
+        for (auto& page : image->getPages())
+        {
+            unloadImage(page);
+        }
+
+        // the prober has a header pass in progress only before it's marked probed
+        if (image->getIsHeaderProbed())
+        {
+            image->probeHeader(true);
+        }
+
+        return idx;
+    }
+
+    /**
+     * @brief npy and raw images are the ones whose pixels stay mapped while loaded (other formats only read the mapping
+     * while decoding), so when watching starts those are unloaded, to be read again into memory when next viewed.
+     */
+    void ImageListSourceDirectory::setIsWatched(bool isWatched)
+    {
+        this->isWatched = isWatched;
+
+        if (!isWatched)
+        {
+            return;
+        }
+
+        for (auto& image : this->images)
+        {
+            if (image->getIsLoaded() && MappedImage::checkIsMappedExtension(image->getTypeStr()))
+            {
+                unloadImage(image);
+            }
+        }
+    }
+
+    bool ImageListSourceDirectory::checkIsProbingHeaders()
+    {
+        return this->headerProber && !this->headerProber->checkIsDone();
     }
 
     int ImageListSourceDirectory::getImageCount()
@@ -126,6 +444,12 @@ namespace Wxiv
 
     void ImageListSourceDirectory::addImagePages(int idx, std::vector<std::shared_ptr<WxivImage>>& pages)
     {
+        // just the IFDs, which are small, so not worth the background
+        for (auto& page : pages)
+        {
+            page->probeHeader();
+        }
+
         images.insert(images.begin() + idx + 1, pages.begin(), pages.end());
     }
 }
@@ -3,10 +3,16 @@
 #pragma once
 #include <string>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
 #include <opencv2/opencv.hpp>
 
 #include "WxivImage.h"
 #include "ImageListSource.h"
+#include "ImagePrefetcher.h"
+#include "ImageHeaderProber.h"
+#include "ImageMemoryCache.h"
 #include "WxWidgetsUtil.h"
 
 namespace Wxiv
@@ -28,6 +34,50 @@ namespace Wxiv
          */
         virtual bool checkSupportedFile(const wxString& path);
 
+        /**
+         * @brief Actually read and decode the file into the image. Caller holds the image load mutex and has checked
+         * that it is not already loaded. This can be called on a prefetch thread.
+         */
+        virtual void decodeImage(std::shared_ptr<WxivImage> image);
+
+        /**
+         * @brief Read the image's header for the list (see WxivImage::probeHeader). This is called on the header pass
+         * threads.
+         */
+        virtual void probeImageHeader(std::shared_ptr<WxivImage> image);
+
+        bool tryLoadImage(std::shared_ptr<WxivImage> image, bool isForeground);
+        std::shared_ptr<TiledTiffImage> tryOpenTiled(const wxString& path);
+        int findImageFile(const wxString& path);
+        void unloadImage(std::shared_ptr<WxivImage> image);
+        void startHeaderProbe();
+
+        /**
+         * @brief Sub-classes with their own decodeImage or probeImageHeader should call this from their destructor.
+         */
+        void stopPrefetch();
+
+      private:
+        ImageMemoryCache memoryCache;
+
+        // created on first prefetch request, and destroyed (joined) before the images
+        std::unique_ptr<ImagePrefetcher> prefetcher;
+
+        // started by load()
+        std::unique_ptr<ImageHeaderProber> headerProber;
+
+        // read files into memory instead of mapping them, since they may be rewritten
+        std::atomic<bool> isWatched = false;
+
+        // a hit is the first selection of an image not having to decode (including if it had to wait for an in-progress
+        // prefetch), and later selections of the same image are not counted
+        std::unordered_set<const WxivImage*> selectedImages;
+        int prefetchHitCount = 0;
+        int prefetchMissCount = 0;
+        std::mutex selectedMutex;
+
+        void forgetSelected(const std::shared_ptr<WxivImage>& image);
+
       public:
         ImageListSourceDirectory();
         ~ImageListSourceDirectory() override;
@@ -37,5 +87,20 @@ namespace Wxiv
         int getImageCount() override;
         std::shared_ptr<WxivImage> getImage(int idx) override;
         void addImagePages(int idx, std::vector<std::shared_ptr<WxivImage>>& pages) override;
+        void prefetchImages(const std::vector<std::shared_ptr<WxivImage>>& images) override;
+        void setMemoryBudget(size_t bytes) override;
+        void trimMemory() override;
+        int addImageFile(const wxString& path) override;
+        int removeImageFile(const wxString& path) override;
+        int invalidateImageFile(const wxString& path) override;
+        void setIsWatched(bool isWatched) override;
+        bool checkIsProbingHeaders() override;
+        bool decodePreview(std::shared_ptr<WxivImage> image, cv::Mat& preview, cv::Size& fullSize) override;
+        std::string getLoadStatus() override;
+
+        int getPrefetchHitCount();
+        int getPrefetchMissCount();
+        size_t getResidentBytes();
+        int getEvictionCount();
     };
 }
@@ -0,0 +1,178 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <algorithm>
+#include <fmt/core.h>
+#include <opencv2/opencv.hpp>
+
+#include "ImageListSourceShmRing.h"
+#include "MappedImage.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    static const wxString ShmLocationPrefix = "shm:";
+
+    bool ImageListSourceShmRing::checkIsShmLocation(const wxString& location)
+    {
+        return location.StartsWith(ShmLocationPrefix) && (location.length() > ShmLocationPrefix.length());
+    }
+
+    void ImageListSourceShmRing::load(wxString inLocation)
+    {
+        if (!checkIsShmLocation(inLocation))
+        {
+            throw runtime_error("Shared memory location must be like shm:/name");
+        }
+
+        this->location = inLocation;
+        this->ring = std::make_shared<SharedMemoryRing>(string(inLocation.Mid(ShmLocationPrefix.length()).ToUTF8().data()));
+        appendFrames(this->ring->getLastSequence());
+    }
+
+    /**
+     * @brief List the frames that arrived since the last call, up to this sequence number.
+     * Only up to a sequence number read before the scan, since a newer frame can complete in a slot already scanned,
+     * and it would be skipped.
+     * @return How many were appended.
+     */
+    int ImageListSourceShmRing::appendFrames(uint64_t lastSequence)
+    {
+        int addedCount = 0;
+
+        for (const SharedMemoryRing::Frame& frame : this->ring->getFramesAfter(this->lastListedSequence))
+        {
+            if (frame.sequence > lastSequence)
+            {
+                break;
+            }
+
+            // the name is just a label, so it can't make more path levels
+            string name = fmt::format("{:06d}", frame.sequence);
+
+            if (!frame.name.empty())
+            {
+                name += " " + frame.name;
+                std::replace(name.begin(), name.end(), '/', '_');
+                std::replace(name.begin(), name.end(), '\\', '_');
+            }
+
+            auto image = std::make_shared<WxivImage>(this->location + "/" + wxString::FromUTF8(name.c_str()));
+            this->frameByImage[image.get()] = frame;
+            this->images.push_back(image);
+            addedCount++;
+        }
+
+        this->lastListedSequence = lastSequence;
+        return addedCount;
+    }
+
+    /**
+     * @brief Pin the frame and wrap its pixels, which is quick (no decode or copy), so this is fine on the UI thread.
+     * The previously pinned frame stays loaded while it's in the ring, and is re-pinned when it's selected again.
+     */
+    bool ImageListSourceShmRing::loadImage(std::shared_ptr<WxivImage> image)
+    {
+        const std::lock_guard<std::mutex> lock(this->frameMutex);
+        auto iter = this->frameByImage.find(image.get());
+
+        if (iter == this->frameByImage.end())
+        {
+            throw runtime_error("Frame is no longer in the shared memory.");
+        }
+
+        if ((image == this->pinnedImage) && image->getIsLoaded())
+        {
+            return true;
+        }
+
+        const SharedMemoryRing::Frame& frame = iter->second;
+
+        if (!this->ring->pin(frame))
+        {
+            image->unload();
+            this->pinnedImage.reset();
+            throw runtime_error("Frame was overwritten by the producer.");
+        }
+
+        this->pinnedImage = image;
+
+        if (!image->getIsLoaded())
+        {
+            const std::lock_guard<std::mutex> imageLock(image->getLoadMutex());
+            cv::Mat img =
+                MappedImage::wrapPixels(this->ring, frame.pixels, frame.height, frame.width, CV_MAKETYPE(frame.depth, frame.channels), frame.rowStride);
+            image->setImage(img);
+        }
+
+        return true;
+    }
+
+    int ImageListSourceShmRing::getImageCount()
+    {
+        return (int)this->images.size();
+    }
+
+    std::shared_ptr<WxivImage> ImageListSourceShmRing::getImage(int idx)
+    {
+        if (idx < this->images.size())
+        {
+            return this->images[idx];
+        }
+        else
+        {
+            throw std::runtime_error("getImage index out of range");
+        }
+    }
+
+    void ImageListSourceShmRing::addImagePages(int idx, std::vector<std::shared_ptr<WxivImage>>& pages)
+    {
+        // frames have no pages
+    }
+
+    bool ImageListSourceShmRing::checkIsLive()
+    {
+        return true;
+    }
+
+    /**
+     * @brief Drop the frames the producer overwrote and list the new ones. The pinned frame is never overwritten.
+     * This is cheap when nothing arrived, so it can be polled often.
+     */
+    bool ImageListSourceShmRing::takeLiveChanges(std::vector<int>& removedIndices, int& addedCount)
+    {
+        removedIndices.clear();
+        addedCount = 0;
+
+        if (!this->ring)
+        {
+            return false;
+        }
+
+        uint64_t lastSequence = this->ring->getLastSequence();
+
+        if (lastSequence == this->lastListedSequence)
+        {
+            return false;
+        }
+
+        const std::lock_guard<std::mutex> lock(this->frameMutex);
+
+        for (int i = (int)this->images.size() - 1; i >= 0; i--)
+        {
+            auto iter = this->frameByImage.find(this->images[i].get());
+
+            if (!this->ring->checkIsIntact(iter->second))
+            {
+                this->images[i]->unload();
+                this->frameByImage.erase(iter);
+                this->images.erase(this->images.begin() + i);
+                removedIndices.push_back(i);
+            }
+        }
+
+        addedCount = appendFrames(lastSequence);
+        return !removedIndices.empty() || (addedCount > 0);
+    }
+}
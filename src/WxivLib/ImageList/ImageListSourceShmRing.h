@@ -0,0 +1,56 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <opencv2/opencv.hpp>
+
+#include "WxivImage.h"
+#include "ImageListSource.h"
+#include "SharedMemoryRing.h"
+#include "WxWidgetsUtil.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief Concrete ImageListSource sub-class that lists the frames in a shared-memory ring written by another process
+     * (see WxivShmRing.h), e.g. the intermediate images of an algorithm under development, as they arrive.
+     *
+     * The location is "shm:" and the shared memory name, like "shm:/wxiv". Frames are viewed in place with no copy: the
+     * image's pixels are in the shared memory, and the selected one is pinned so the producer doesn't overwrite it.
+     * The list is the frames still in the ring, so history is bounded by the producer's slot count, and frames drop off
+     * the list as the producer overwrites them.
+     */
+    class ImageListSourceShmRing : public ImageListSource
+    {
+      private:
+        std::shared_ptr<SharedMemoryRing> ring;
+        wxString location;
+        std::vector<std::shared_ptr<WxivImage>> images;
+        uint64_t lastListedSequence = 0;
+
+        // loadImage may be called on a loader thread, and this guards the frames and the pin
+        std::mutex frameMutex;
+        std::unordered_map<WxivImage*, SharedMemoryRing::Frame> frameByImage;
+        std::shared_ptr<WxivImage> pinnedImage;
+
+        int appendFrames(uint64_t lastSequence);
+
+      public:
+        static bool checkIsShmLocation(const wxString& location);
+
+        /**
+         * @param location Like "shm:/wxiv".
+         */
+        void load(wxString location) override;
+        bool loadImage(std::shared_ptr<WxivImage> image) override;
+        int getImageCount() override;
+        std::shared_ptr<WxivImage> getImage(int idx) override;
+        void addImagePages(int idx, std::vector<std::shared_ptr<WxivImage>>& pages) override;
+        bool checkIsLive() override;
+        bool takeLiveChanges(std::vector<int>& removedIndices, int& addedCount) override;
+    };
+}
@@ -0,0 +1,295 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <algorithm>
+#include <fmt/core.h>
+#include <opencv2/opencv.hpp>
+
+#include "ImageListSourceSocket.h"
+#include "ImageDecoder.h"
+#include "ImageUtil.h"
+#include "MappedImage.h"
+#include "StringUtil.h"
+#include "WxivUtil.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    static const wxString SocketLocationPrefix = "unix:";
+
+    ImageListSourceSocket::ImageListSourceSocket(int maxListedCount) : maxListedCount(std::max(maxListedCount, 1))
+    {
+    }
+
+    bool ImageListSourceSocket::checkIsSocketLocation(const wxString& location)
+    {
+        return location.StartsWith(SocketLocationPrefix) && (location.length() > SocketLocationPrefix.length());
+    }
+
+    void ImageListSourceSocket::load(wxString inLocation)
+    {
+        if (!checkIsSocketLocation(inLocation))
+        {
+            throw runtime_error("Socket location must be like unix:/path/to.sock");
+        }
+
+        this->location = inLocation;
+        this->receiver = std::make_unique<SocketFrameReceiver>(toFilesystemPath(inLocation.Mid(SocketLocationPrefix.length())));
+    }
+
+    /**
+     * @brief The raw pixels are wrapped in place (the cv::Mat keeps the frame alive), anything else is decoded.
+     */
+    void ImageListSourceSocket::decodeFrame(std::shared_ptr<WxivImage> image, std::shared_ptr<SocketFrameReceiver::Frame> frame)
+    {
+        const WxivStreamFrameHeader& header = frame->header;
+        cv::Mat img;
+
+        if (frame->format == "raw")
+        {
+            size_t rowBytes = (size_t)header.width * header.channels * wxivStreamDepthBytes(header.depth);
+            img = MappedImage::wrapPixels(
+                frame, frame->image.data(), (int)header.height, (int)header.width, CV_MAKETYPE((int)header.depth, (int)header.channels), rowBytes);
+        }
+        else
+        {
+            string ext = getNormalizedExt(frame->format);
+            vector<cv::Mat> mats;
+
+            if (!ImageDecoder::decodeBuffer(frame->image.data(), frame->image.size(), ext, mats) || mats.empty())
+            {
+                throw runtime_error("Failed to decode the streamed image.");
+            }
+
+            img = mats[0];
+            ImageUtil::convertAfterLoad(img, ext, img);
+        }
+
+        {
+            const std::lock_guard<std::mutex> imageLock(image->getLoadMutex());
+            image->setImage(img);
+        }
+
+        if (!frame->shapes.empty())
+        {
+            try
+            {
+                image->getShapes().loadShapesBuffer(frame->shapes.data(), frame->shapes.size(), "shapes.arrows");
+            }
+            catch (std::runtime_error& ex)
+            {
+                image->setShapeSetLoadError(wxString(ex.what()));
+            }
+        }
+    }
+
+    /**
+     * @brief Only the viewed frame is kept decoded, the others are just their received bytes. The decode is outside the
+     * frame lock, so the UI thread listing new frames doesn't wait on a loader thread's decode.
+     */
+    bool ImageListSourceSocket::loadImage(std::shared_ptr<WxivImage> image)
+    {
+        std::shared_ptr<SocketFrameReceiver::Frame> frame;
+
+        {
+            const std::lock_guard<std::mutex> lock(this->frameMutex);
+            auto iter = this->frameByImage.find(image.get());
+
+            if (iter == this->frameByImage.end())
+            {
+                throw runtime_error("Frame is no longer listed.");
+            }
+
+            frame = iter->second;
+        }
+
+        bool didDecode = false;
+
+        if (!image->getIsLoaded())
+        {
+            decodeFrame(image, frame);
+            didDecode = true;
+        }
+
+        const std::lock_guard<std::mutex> lock(this->frameMutex);
+
+        if (didDecode)
+        {
+            this->renderedCount++;
+        }
+
+        if (this->loadedImage && (this->loadedImage != image))
+        {
+            this->loadedImage->unload();
+        }
+
+        // if it was removed meanwhile, this still unloads it on the next load
+        this->loadedImage = image;
+        return true;
+    }
+
+    int ImageListSourceSocket::getImageCount()
+    {
+        return (int)this->images.size();
+    }
+
+    std::shared_ptr<WxivImage> ImageListSourceSocket::getImage(int idx)
+    {
+        if (idx < this->images.size())
+        {
+            return this->images[idx];
+        }
+        else
+        {
+            throw std::runtime_error("getImage index out of range");
+        }
+    }
+
+    void ImageListSourceSocket::addImagePages(int idx, std::vector<std::shared_ptr<WxivImage>>& pages)
+    {
+        // frames have no pages
+    }
+
+    void ImageListSourceSocket::setMemoryBudget(size_t bytes)
+    {
+        this->memoryBudget = bytes;
+    }
+
+    bool ImageListSourceSocket::checkIsLive()
+    {
+        return true;
+    }
+
+    /**
+     * @brief Raw frames are just wrapped, encoded ones are decoded like files.
+     */
+    bool ImageListSourceSocket::checkIsQuickLoad(std::shared_ptr<WxivImage> image)
+    {
+        if (image->getIsLoaded())
+        {
+            return true;
+        }
+
+        const std::lock_guard<std::mutex> lock(this->frameMutex);
+        auto iter = this->frameByImage.find(image.get());
+        return (iter == this->frameByImage.end()) || (iter->second->format == "raw");
+    }
+
+    /**
+     * @brief List the frames received since the last call, and remove the oldest ones past the bounds.
+     */
+    bool ImageListSourceSocket::takeLiveChanges(std::vector<int>& removedIndices, int& addedCount)
+    {
+        removedIndices.clear();
+        addedCount = 0;
+
+        if (!this->receiver)
+        {
+            return false;
+        }
+
+        vector<std::shared_ptr<SocketFrameReceiver::Frame>> frames = this->receiver->takeFrames();
+
+        if (frames.empty())
+        {
+            return false;
+        }
+
+        const std::lock_guard<std::mutex> lock(this->frameMutex);
+        auto frameBytes = [](const std::shared_ptr<SocketFrameReceiver::Frame>& frame) { return frame->image.size() + frame->shapes.size(); };
+
+        // keep the newest that fit by themselves, and always the newest one
+        size_t firstKept = frames.size() - 1;
+        size_t newBytes = frameBytes(frames.back());
+
+        while ((firstKept > 0) && ((int)(frames.size() - firstKept) < this->maxListedCount) &&
+            (newBytes + frameBytes(frames[firstKept - 1]) <= this->memoryBudget))
+        {
+            firstKept--;
+            newBytes += frameBytes(frames[firstKept]);
+        }
+
+        this->skippedCount += firstKept;
+        this->nextFrameNumber += firstKept;
+        int keptCount = (int)(frames.size() - firstKept);
+
+        // then make room by removing the oldest listed
+        int removeCount = 0;
+
+        while ((removeCount < (int)this->images.size()) &&
+            (((int)this->images.size() - removeCount + keptCount > this->maxListedCount) || (this->listedBytes + newBytes > this->memoryBudget)))
+        {
+            std::shared_ptr<WxivImage> image = this->images[removeCount];
+            this->listedBytes -= frameBytes(this->frameByImage[image.get()]);
+            this->frameByImage.erase(image.get());
+            image->unload();
+
+            if (image == this->loadedImage)
+            {
+                this->loadedImage.reset();
+            }
+
+            removeCount++;
+        }
+
+        this->images.erase(this->images.begin(), this->images.begin() + removeCount);
+
+        for (int i = removeCount - 1; i >= 0; i--)
+        {
+            removedIndices.push_back(i);
+        }
+
+        for (size_t i = firstKept; i < frames.size(); i++)
+        {
+            const std::shared_ptr<SocketFrameReceiver::Frame>& frame = frames[i];
+
+            // the name is just a label, so it can't make more path levels
+            string name = fmt::format("{:06d}", this->nextFrameNumber++);
+
+            if (!frame->name.empty())
+            {
+                name += " " + frame->name;
+            }
+
+            if (frame->format != "raw")
+            {
+                name += "." + frame->format;
+            }
+
+            std::replace(name.begin(), name.end(), '/', '_');
+            std::replace(name.begin(), name.end(), '\\', '_');
+
+            auto image = std::make_shared<WxivImage>(this->location + "/" + wxString::FromUTF8(name.c_str()));
+            this->frameByImage[image.get()] = frame;
+            this->images.push_back(image);
+            this->listedBytes += frameBytes(frame);
+        }
+
+        addedCount = keptCount;
+        return true;
+    }
+
+    std::string ImageListSourceSocket::getLiveStatus()
+    {
+        if (!this->receiver)
+        {
+            return "";
+        }
+
+        string state;
+
+        if (!this->receiver->checkIsConnected())
+        {
+            state = " (waiting for a producer)";
+        }
+        else if (this->receiver->checkIsWaitingForSpace())
+        {
+            state = " (producer held back)";
+        }
+
+        const std::lock_guard<std::mutex> lock(this->frameMutex);
+        return fmt::format("{}: {} received, {} dropped, {} rendered{}", this->receiver->getSocketPath().string(), this->receiver->getReceivedCount(),
+            this->receiver->getDroppedCount() + this->skippedCount, this->renderedCount, state);
+    }
+}
@@ -0,0 +1,69 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <opencv2/opencv.hpp>
+
+#include "WxivImage.h"
+#include "ImageListSource.h"
+#include "SocketFrameReceiver.h"
+#include "WxWidgetsUtil.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief Concrete ImageListSource sub-class that lists the frames a producer process streams over a Unix domain
+     * socket (see WxivStreamFrame.h), e.g. from a container where shared memory is awkward, as they arrive.
+     *
+     * The location is "unix:" and the socket path, like "unix:/tmp/wxiv.sock", and wxiv listens there. Each frame's bytes
+     * are kept as received, and the frame is only decoded (or, for raw pixels, wrapped with no copy) when viewed, so
+     * frames that are stepped past cost nothing but their bytes. Encoded frames are decoded on the loader thread like
+     * files, raw frames are quick enough to wrap on the UI thread. The list is bounded by frame count and the memory
+     * budget, with the oldest frames removed first.
+     */
+    class ImageListSourceSocket : public ImageListSource
+    {
+      private:
+        std::unique_ptr<SocketFrameReceiver> receiver;
+        wxString location;
+        std::vector<std::shared_ptr<WxivImage>> images;
+        uint64_t nextFrameNumber = 1;
+        size_t listedBytes = 0;
+        size_t memoryBudget = 1ull << 30;
+        int maxListedCount;
+
+        // received but skipped because they alone were past the bounds
+        uint64_t skippedCount = 0;
+        uint64_t renderedCount = 0;
+
+        // loadImage may be called on a loader thread, and this guards the frames and the loaded image
+        std::mutex frameMutex;
+        std::unordered_map<WxivImage*, std::shared_ptr<SocketFrameReceiver::Frame>> frameByImage;
+        std::shared_ptr<WxivImage> loadedImage;
+
+        void decodeFrame(std::shared_ptr<WxivImage> image, std::shared_ptr<SocketFrameReceiver::Frame> frame);
+
+      public:
+        ImageListSourceSocket(int maxListedCount = 1000);
+
+        static bool checkIsSocketLocation(const wxString& location);
+
+        /**
+         * @param location Like "unix:/tmp/wxiv.sock".
+         */
+        void load(wxString location) override;
+        bool loadImage(std::shared_ptr<WxivImage> image) override;
+        int getImageCount() override;
+        std::shared_ptr<WxivImage> getImage(int idx) override;
+        void addImagePages(int idx, std::vector<std::shared_ptr<WxivImage>>& pages) override;
+        void setMemoryBudget(size_t bytes) override;
+        bool checkIsLive() override;
+        bool checkIsQuickLoad(std::shared_ptr<WxivImage> image) override;
+        bool takeLiveChanges(std::vector<int>& removedIndices, int& addedCount) override;
+        std::string getLiveStatus() override;
+    };
+}
@@ -0,0 +1,88 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <algorithm>
+#include <fmt/core.h>
+#include <opencv2/opencv.hpp>
+
+#include "ImageListSourceVideo.h"
+#include "WxivUtil.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    // the reader's cache gets a quarter of the memory budget, up to this
+    static const size_t FrameCacheBytes = (size_t)256 * 1024 * 1024;
+
+    ImageListSourceVideo::ImageListSourceVideo() : frameCacheBytes(FrameCacheBytes)
+    {
+    }
+
+    ImageListSourceVideo::~ImageListSourceVideo()
+    {
+        // prefetch threads call our decodeImage and use the reader
+        stopPrefetch();
+    }
+
+    bool ImageListSourceVideo::checkIsVideoFile(const wxString& path)
+    {
+        wxFileName fn(path);
+        return fn.HasExt() && checkIsOnlyAscii(fn.GetExt()) && VideoFrameReader::checkIsVideoExtension(fn.GetExt().ToStdString()) && fn.FileExists();
+    }
+
+    /**
+     * @brief Open the video and index its keyframes, and create a not-loaded image for each frame.
+     */
+    void ImageListSourceVideo::load(wxString path)
+    {
+        this->reader = std::make_unique<VideoFrameReader>(toFilesystemPath(path), this->frameCacheBytes);
+        int frameCount = this->reader->getFrameCount();
+        this->images.reserve(frameCount);
+
+        for (int i = 0; i < frameCount; i++)
+        {
+            auto image = std::make_shared<WxivImage>(path + wxFileName::GetPathSeparator() + wxString(fmt::format("{:06d}", i)));
+            this->frameIndexByImage[image.get()] = i;
+            this->images.push_back(image);
+        }
+    }
+
+    void ImageListSourceVideo::decodeImage(std::shared_ptr<WxivImage> image)
+    {
+        auto iter = this->frameIndexByImage.find(image.get());
+
+        if (iter == this->frameIndexByImage.end())
+        {
+            throw runtime_error("Image is not a frame of the video.");
+        }
+
+        // shares pixels with the reader's cache, which never modifies them
+        cv::Mat img = this->reader->readFrame(iter->second);
+        image->setImage(img);
+    }
+
+    bool ImageListSourceVideo::decodePreview(std::shared_ptr<WxivImage> image, cv::Mat& preview, cv::Size& fullSize)
+    {
+        return false;
+    }
+
+    /**
+     * @brief The reader's decoded frames count against the budget too, so the loaded frames get what's left.
+     */
+    void ImageListSourceVideo::setMemoryBudget(size_t bytes)
+    {
+        this->frameCacheBytes = std::min(FrameCacheBytes, bytes / 4);
+        ImageListSourceDirectory::setMemoryBudget(bytes - this->frameCacheBytes);
+
+        if (this->reader)
+        {
+            this->reader->setCacheBudgetBytes(this->frameCacheBytes);
+        }
+    }
+
+    VideoFrameReader* ImageListSourceVideo::getReader()
+    {
+        return this->reader.get();
+    }
+}
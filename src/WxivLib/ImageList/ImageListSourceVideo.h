@@ -0,0 +1,56 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <opencv2/opencv.hpp>
+
+#include "WxivImage.h"
+#include "ImageListSource.h"
+#include "ImageListSourceDirectory.h"
+#include "VideoFrameReader.h"
+#include "WxWidgetsUtil.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief Concrete ImageListSource sub-class that lists the frames of a video file, e.g. a debug video from a
+     * pipeline run, so they can be stepped through like images.
+     *
+     * Frames are read with a VideoFrameReader, which indexes the keyframes in the background and keeps recently decoded
+     * frames, so stepping forward decodes one frame and jumping around decodes from the nearest keyframe. The frames
+     * being viewed and prefetched are also kept loaded like any images in a dir. The memory budget is split between
+     * the reader's cache and the loaded frames.
+     *
+     * Images have the path of the video joined with the frame number, so the list shows frame numbers. There are no
+     * header columns, previews, or shapes.
+     */
+    class ImageListSourceVideo : public ImageListSourceDirectory
+    {
+      private:
+        std::unique_ptr<VideoFrameReader> reader;
+        size_t frameCacheBytes = 0;
+
+        // only written by load
+        std::unordered_map<WxivImage*, int> frameIndexByImage;
+
+      protected:
+        void decodeImage(std::shared_ptr<WxivImage> image) override;
+
+      public:
+        ImageListSourceVideo();
+        ~ImageListSourceVideo() override;
+
+        static bool checkIsVideoFile(const wxString& path);
+
+        /**
+         * @param videoPath The video file, not a dir.
+         */
+        void load(wxString videoPath) override;
+        bool decodePreview(std::shared_ptr<WxivImage> image, cv::Mat& preview, cv::Size& fullSize) override;
+        void setMemoryBudget(size_t bytes) override;
+
+        VideoFrameReader* getReader();
+    };
+}
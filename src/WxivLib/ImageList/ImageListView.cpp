@@ -0,0 +1,30 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include "ImageListView.h"
+
+namespace Wxiv
+{
+    ImageListView::ImageListView(wxWindow* parent) : wxListView(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_VIRTUAL)
+    {
+    }
+
+    void ImageListView::setItemTextFunction(const std::function<wxString(long, long)>& f)
+    {
+        this->itemTextFunction = f;
+    }
+
+    void ImageListView::setItemIsCheckedFunction(const std::function<bool(long)>& f)
+    {
+        this->itemIsCheckedFunction = f;
+    }
+
+    wxString ImageListView::OnGetItemText(long item, long column) const
+    {
+        return this->itemTextFunction ? this->itemTextFunction(item, column) : wxString();
+    }
+
+    bool ImageListView::OnGetItemIsChecked(long item) const
+    {
+        return this->itemIsCheckedFunction && this->itemIsCheckedFunction(item);
+    }
+}
@@ -0,0 +1,38 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <functional>
+
+#include "WxWidgetsUtil.h"
+#include <wx/listctrl.h>
+
+namespace Wxiv
+{
+    /**
+     * @brief A virtual (wxLC_VIRTUAL) report list view, which holds no items, just a count, and asks its owner for the
+     * text and checkbox state of each row as it's drawn. So listing, filtering, and scrolling cost follows the visible
+     * rows, not the number of images.
+     */
+    class ImageListView : public wxListView
+    {
+        std::function<wxString(long, long)> itemTextFunction;
+        std::function<bool(long)> itemIsCheckedFunction;
+
+      protected:
+        wxString OnGetItemText(long item, long column) const override;
+        bool OnGetItemIsChecked(long item) const override;
+
+      public:
+        ImageListView(wxWindow* parent);
+
+        /**
+         * @brief Provides the text for a row index and column.
+         */
+        void setItemTextFunction(const std::function<wxString(long, long)>& f);
+
+        /**
+         * @brief Provides the checkbox state for a row index.
+         */
+        void setItemIsCheckedFunction(const std::function<bool(long)>& f);
+    };
+}
@@ -0,0 +1,401 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <vector>
+
+#include "ImageNameFilter.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    static const std::string RegexPrefix = "re:";
+
+    ImageNameFilter::ImageNameFilter()
+    {
+        this->names = std::make_shared<std::vector<std::string>>();
+    }
+
+    ImageNameFilter::~ImageNameFilter()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            this->isStopping = true;
+        }
+
+        this->condition.notify_all();
+
+        if (this->thread.joinable())
+        {
+            this->thread.join();
+        }
+    }
+
+    ImageNameFilter::Query ImageNameFilter::parseQuery(const std::string& query)
+    {
+        Query q;
+
+        if (query.rfind(RegexPrefix, 0) == 0)
+        {
+            q.text = query.substr(RegexPrefix.size());
+
+            if (!q.text.empty())
+            {
+                q.mode = Mode::Regex;
+
+                try
+                {
+                    q.regex = std::make_shared<std::regex>(q.text, std::regex::ECMAScript | std::regex::icase | std::regex::optimize);
+                }
+                catch (std::regex_error&)
+                {
+                    // probably still being typed
+                    q.regex = nullptr;
+                }
+            }
+        }
+        else if (!query.empty())
+        {
+            q.text = query;
+            q.mode = (query.find_first_of("*?") != string::npos) ? Mode::Glob : Mode::Substring;
+        }
+
+        return q;
+    }
+
+    /**
+     * @brief Whole-name match with * for any run of chars and ? for any one char.
+     */
+    static bool checkGlobMatches(const std::string& pattern, const std::string& name)
+    {
+        size_t p = 0;
+        size_t n = 0;
+        size_t starP = string::npos;
+        size_t starN = 0;
+
+        while (n < name.size())
+        {
+            if ((p < pattern.size()) && ((pattern[p] == '?') || (pattern[p] == name[n])))
+            {
+                p++;
+                n++;
+            }
+            else if ((p < pattern.size()) && (pattern[p] == '*'))
+            {
+                starP = p++;
+                starN = n;
+            }
+            else if (starP != string::npos)
+            {
+                // let the last star take one more char
+                p = starP + 1;
+                n = ++starN;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        while ((p < pattern.size()) && (pattern[p] == '*'))
+        {
+            p++;
+        }
+
+        return p == pattern.size();
+    }
+
+    bool ImageNameFilter::checkMatches(const Query& query, const std::string& name)
+    {
+        switch (query.mode)
+        {
+        case Mode::All:
+            return true;
+        case Mode::Substring:
+            return name.find(query.text) != string::npos;
+        case Mode::Glob:
+            return checkGlobMatches(query.text, name);
+        case Mode::Regex:
+            return query.regex && std::regex_search(name, *query.regex);
+        default:
+            return false;
+        }
+    }
+
+    std::vector<int> ImageNameFilter::filter(const std::vector<std::string>& names, const Query& query, const std::vector<int>* candidates)
+    {
+        vector<int> dataIndices;
+
+        if (candidates)
+        {
+            for (int i : *candidates)
+            {
+                if (checkMatches(query, names[i]))
+                {
+                    dataIndices.push_back(i);
+                }
+            }
+        }
+        else
+        {
+            int n = (int)names.size();
+            dataIndices.reserve((query.mode == Mode::All) ? n : 0);
+
+            for (int i = 0; i < n; i++)
+            {
+                if (checkMatches(query, names[i]))
+                {
+                    dataIndices.push_back(i);
+                }
+            }
+        }
+
+        return dataIndices;
+    }
+
+    /**
+     * @brief The names to modify in place, copying them first if the worker or filterNow() is scanning a snapshot.
+     * Call with mutex held.
+     */
+    std::vector<std::string>& ImageNameFilter::getWritableNamesLocked()
+    {
+        if (this->names.use_count() > 1)
+        {
+            this->names = std::make_shared<std::vector<std::string>>(*this->names);
+        }
+
+        return *this->names;
+    }
+
+    /**
+     * @brief Call with mutex held, after changing the names.
+     */
+    void ImageNameFilter::onNamesChangedLocked()
+    {
+        this->namesGeneration++;
+
+        // a request in progress, or a result not taken yet, is against the old names, so re-run it
+        if (this->isBusy || this->isDone)
+        {
+            this->latestId++;
+            this->hasPending = true;
+            this->isBusy = true;
+            this->isDone = false;
+            this->doneDataIndices.clear();
+        }
+    }
+
+    void ImageNameFilter::setNames(std::vector<std::string> newNames)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            this->names = std::make_shared<std::vector<std::string>>(std::move(newNames));
+            onNamesChangedLocked();
+        }
+
+        this->condition.notify_one();
+    }
+
+    void ImageNameFilter::appendName(const std::string& name)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            getWritableNamesLocked().push_back(name);
+            onNamesChangedLocked();
+        }
+
+        this->condition.notify_one();
+    }
+
+    /**
+     * @brief Insert these names before this data index, e.g. for the pages of an image, after the image.
+     */
+    void ImageNameFilter::insertNames(int dataIndex, const std::vector<std::string>& newNames)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+
+            if ((dataIndex < 0) || (dataIndex > (int)this->names->size()))
+            {
+                return;
+            }
+
+            std::vector<std::string>& writableNames = getWritableNamesLocked();
+            writableNames.insert(writableNames.begin() + dataIndex, newNames.begin(), newNames.end());
+            onNamesChangedLocked();
+        }
+
+        this->condition.notify_one();
+    }
+
+    void ImageNameFilter::removeName(int dataIndex)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+
+            if ((dataIndex < 0) || (dataIndex >= (int)this->names->size()))
+            {
+                return;
+            }
+
+            std::vector<std::string>& writableNames = getWritableNamesLocked();
+            writableNames.erase(writableNames.begin() + dataIndex);
+            onNamesChangedLocked();
+        }
+
+        this->condition.notify_one();
+    }
+
+    int ImageNameFilter::getNameCount()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return (int)this->names->size();
+    }
+
+    void ImageNameFilter::request(const std::string& query)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            this->latestId++;
+            this->latestQuery = query;
+            this->hasPending = true;
+            this->isBusy = true;
+            this->isDone = false;
+            this->doneDataIndices.clear();
+
+            // start thread on first use
+            if (!this->thread.joinable())
+            {
+                this->thread = std::thread([this]() { this->workerLoop(); });
+            }
+        }
+
+        this->condition.notify_one();
+    }
+
+    std::vector<int> ImageNameFilter::filterNow(const std::string& query)
+    {
+        NamesPtr runNames;
+        int generation = 0;
+        int id = 0;
+
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            this->latestId++;
+            this->latestQuery = query;
+            this->hasPending = false;
+            this->isBusy = false;
+            this->isDone = false;
+            this->doneDataIndices.clear();
+            runNames = this->names;
+            generation = this->namesGeneration;
+            id = this->latestId;
+        }
+
+        Query q = parseQuery(query);
+        vector<int> dataIndices = run(q, runNames, generation);
+
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+
+            if (id == this->latestId)
+            {
+                this->lastQuery = q;
+                this->lastGeneration = generation;
+                this->lastDataIndices = dataIndices;
+            }
+        }
+
+        return dataIndices;
+    }
+
+    bool ImageNameFilter::checkIsBusy()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->isBusy;
+    }
+
+    bool ImageNameFilter::takeResult(std::vector<int>& dataIndices)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+
+        if (!this->isDone)
+        {
+            return false;
+        }
+
+        dataIndices = std::move(this->doneDataIndices);
+        this->doneDataIndices.clear();
+        this->isDone = false;
+        return true;
+    }
+
+    /**
+     * @brief Filter these names, narrowing from the last result when the query allows it.
+     */
+    std::vector<int> ImageNameFilter::run(const Query& query, NamesPtr runNames, int generation)
+    {
+        vector<int> candidates;
+        bool doNarrow = false;
+
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+
+            // every name containing the new text contains the last text too
+            doNarrow = (query.mode == Mode::Substring) && (this->lastQuery.mode == Mode::Substring) && (this->lastGeneration == generation) &&
+                (query.text.find(this->lastQuery.text) != string::npos);
+
+            if (doNarrow)
+            {
+                candidates = this->lastDataIndices;
+            }
+        }
+
+        return filter(*runNames, query, doNarrow ? &candidates : nullptr);
+    }
+
+    void ImageNameFilter::workerLoop()
+    {
+        while (true)
+        {
+            NamesPtr runNames;
+            int generation = 0;
+            int id = 0;
+            string query;
+
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->condition.wait(lock, [this]() { return this->isStopping || this->hasPending; });
+
+                if (this->isStopping)
+                {
+                    return;
+                }
+
+                this->hasPending = false;
+                runNames = this->names;
+                generation = this->namesGeneration;
+                id = this->latestId;
+                query = this->latestQuery;
+            }
+
+            Query q = parseQuery(query);
+            vector<int> dataIndices = run(q, runNames, generation);
+
+            {
+                const std::lock_guard<std::mutex> lock(this->mutex);
+
+                // superseded while filtering, so nobody wants this result
+                if (id == this->latestId)
+                {
+                    this->isBusy = false;
+                    this->isDone = true;
+                    this->doneDataIndices = dataIndices;
+                    this->lastQuery = q;
+                    this->lastGeneration = generation;
+                    this->lastDataIndices = std::move(dataIndices);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,121 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <regex>
+
+namespace Wxiv
+{
+    /**
+     * @brief Filters the image list by file name, against an index of the lowercase names, on a worker thread so typing
+     * in the filter box doesn't wait on a scan of a big dir.
+     *
+     * Queries are:
+     *    - plain text: names containing it
+     *    - a glob with * or ?: whole names matching it, e.g. *.png
+     *    - "re:" then a regex: names it is found in, ignoring case
+     * Queries and names should both be lowercase (except the regex part), the caller does that because it has the
+     * locale-aware lowercasing.
+     *
+     * Like AsyncImageLoader only the latest request matters, and the UI polls takeResult(). When a plain text query
+     * contains the last one (e.g. the user typed another char) only the last result is scanned.
+     * Results are data indices (indices into the names), ascending.
+     */
+    class ImageNameFilter
+    {
+      public:
+        enum class Mode
+        {
+            All,
+            Substring,
+            Glob,
+            Regex
+        };
+
+        struct Query
+        {
+            Mode mode = Mode::All;
+            std::string text;
+            std::shared_ptr<std::regex> regex; // for Mode::Regex, null if it doesn't compile, which matches nothing
+        };
+
+        static Query parseQuery(const std::string& query);
+        static bool checkMatches(const Query& query, const std::string& name);
+
+        /**
+         * @brief Scan these names, or just the candidates if not null.
+         */
+        static std::vector<int> filter(const std::vector<std::string>& names, const Query& query, const std::vector<int>* candidates = nullptr);
+
+      private:
+        typedef std::shared_ptr<const std::vector<std::string>> NamesPtr;
+
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool isStopping = false;
+
+        // the worker scans a snapshot without the lock, so names are copied before being modified while it holds one
+        std::shared_ptr<std::vector<std::string>> names;
+        int namesGeneration = 0;
+
+        int latestId = 0;
+        bool hasPending = false;
+        std::string latestQuery;
+        bool isBusy = false;
+
+        // result of the latest request, when done
+        bool isDone = false;
+        std::vector<int> doneDataIndices;
+
+        // last completed filter, to narrow from
+        Query lastQuery;
+        int lastGeneration = -1;
+        std::vector<int> lastDataIndices;
+
+        void workerLoop();
+        std::vector<std::string>& getWritableNamesLocked();
+        void onNamesChangedLocked();
+        std::vector<int> run(const Query& query, NamesPtr runNames, int generation);
+
+      public:
+        ImageNameFilter();
+        ~ImageNameFilter();
+
+        ImageNameFilter(const ImageNameFilter&) = delete;
+        ImageNameFilter& operator=(const ImageNameFilter&) = delete;
+
+        /**
+         * @brief Replace the names index, indexed by data index. A request in progress, or a result not taken yet, is
+         * re-run against these, and likewise for appendName(), insertNames() and removeName().
+         */
+        void setNames(std::vector<std::string> newNames);
+        void appendName(const std::string& name);
+        void insertNames(int dataIndex, const std::vector<std::string>& newNames);
+        void removeName(int dataIndex);
+        int getNameCount();
+
+        /**
+         * @brief Filter on the worker, superseding any prior request.
+         */
+        void request(const std::string& query);
+
+        /**
+         * @brief Filter now on this thread, superseding any prior request, e.g. when the list is rebuilt.
+         */
+        std::vector<int> filterNow(const std::string& query);
+
+        bool checkIsBusy();
+
+        /**
+         * @brief If the latest request has finished, get the matching data indices and return true.
+         * Each result is only returned once.
+         */
+        bool takeResult(std::vector<int>& dataIndices);
+    };
+}
@@ -0,0 +1,96 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <algorithm>
+#include <exception>
+
+#include "ImagePrefetcher.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    ImagePrefetcher::ImagePrefetcher(int threadCount, const std::function<void(std::shared_ptr<WxivImage>)>& loadFunction, bool doSkipLoaded)
+        : threadCount(std::max(1, threadCount)), loadFunction(loadFunction), doSkipLoaded(doSkipLoaded)
+    {
+    }
+
+    ImagePrefetcher::~ImagePrefetcher()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(this->queueMutex);
+            this->isStopping = true;
+            this->queue.clear();
+        }
+
+        this->queueCondition.notify_all();
+
+        for (std::thread& t : this->threads)
+        {
+            t.join();
+        }
+    }
+
+    void ImagePrefetcher::setQueue(const std::vector<std::shared_ptr<WxivImage>>& images)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(this->queueMutex);
+            this->queue.clear();
+
+            for (const auto& image : images)
+            {
+                if (image && !(this->doSkipLoaded && image->getIsLoaded()))
+                {
+                    this->queue.push_back(image);
+                }
+            }
+
+            // start threads on first use
+            if (this->threads.empty() && !this->queue.empty())
+            {
+                for (int i = 0; i < this->threadCount; i++)
+                {
+                    this->threads.emplace_back([this]() { this->workerLoop(); });
+                }
+            }
+        }
+
+        this->queueCondition.notify_all();
+    }
+
+    void ImagePrefetcher::clear()
+    {
+        const std::lock_guard<std::mutex> lock(this->queueMutex);
+        this->queue.clear();
+    }
+
+    void ImagePrefetcher::workerLoop()
+    {
+        while (true)
+        {
+            std::shared_ptr<WxivImage> image;
+
+            {
+                std::unique_lock<std::mutex> lock(this->queueMutex);
+                this->queueCondition.wait(lock, [this]() { return this->isStopping || !this->queue.empty(); });
+
+                if (this->isStopping)
+                {
+                    return;
+                }
+
+                image = this->queue.front();
+                this->queue.pop_front();
+            }
+
+            try
+            {
+                this->loadFunction(image);
+            }
+            catch (std::exception&)
+            {
+                // leave it not loaded, the foreground load will try again and report the error
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "WxivImage.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief A few worker threads that load images in the background, in priority order.
+     *
+     * The queue is replaced (not appended to) on each request, so when the user changes direction or jumps somewhere
+     * else the stale requests are just dropped. A load that is already running is allowed to finish.
+     * The threads are not started until the first request.
+     */
+    class ImagePrefetcher
+    {
+      private:
+        int threadCount = 1;
+        std::function<void(std::shared_ptr<WxivImage>)> loadFunction;
+        bool doSkipLoaded = true;
+
+        std::vector<std::thread> threads;
+        std::deque<std::shared_ptr<WxivImage>> queue;
+        std::mutex queueMutex;
+        std::condition_variable queueCondition;
+        bool isStopping = false;
+
+        void workerLoop();
+
+      public:
+        /**
+         * @param threadCount Number of worker threads.
+         * @param loadFunction Called on a worker thread to load one image. Must be safe to call concurrently with
+         * loads of the same image from other threads.
+         * @param doSkipLoaded Skip images that are already loaded, for when the function is a load. Other work on
+         * images (e.g. thumbnails) doesn't care whether the image is loaded.
+         */
+        ImagePrefetcher(int threadCount, const std::function<void(std::shared_ptr<WxivImage>)>& loadFunction, bool doSkipLoaded = true);
+        ~ImagePrefetcher();
+
+        /**
+         * @brief Replace the pending queue with these images, highest priority first. Already loaded ones are skipped,
+         * if so constructed.
+         */
+        void setQueue(const std::vector<std::shared_ptr<WxivImage>>& images);
+
+        /**
+         * @brief Drop any pending (not yet started) loads.
+         */
+        void clear();
+    };
+}
@@ -0,0 +1,514 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <algorithm>
+#include <fstream>
+#include <cstdlib>
+#include <thread>
+#include <fmt/core.h>
+#include <opencv2/opencv.hpp>
+
+#include "ThumbnailCache.h"
+#include "StringUtil.h"
+#include "TiffUtil.h"
+#include "TiledTiffImage.h"
+#include "WxivUtil.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace Wxiv
+{
+    // tif's at least this big are read from synthesized levels if they don't have reduced levels
+    static const int64_t TiledMinPixelCount = (int64_t)16384 * 16384;
+    static const size_t TiledCacheBytes = (size_t)64 * 1024 * 1024;
+
+    // disk cache limits, applied when a cache is created
+    static const uintmax_t DiskBudgetBytes = (uintmax_t)1024 * 1024 * 1024;
+    static const std::chrono::hours DiskMaxAge = std::chrono::hours(24 * 60);
+
+    static size_t getMatBytes(const cv::Mat& m)
+    {
+        return m.total() * m.elemSize();
+    }
+
+    ThumbnailCache::ThumbnailCache(const fs::path& cacheDir, int thumbDim, int threadCount, size_t budgetBytes)
+        : cacheDir(cacheDir), thumbDim(std::max(thumbDim, 8)), budgetBytes(budgetBytes)
+    {
+        // the image being loaded or not doesn't matter, each one still needs a thumbnail
+        this->workers = std::make_unique<ImagePrefetcher>(
+            threadCount, [this](std::shared_ptr<WxivImage> image) { this->loadThumbnail(image); }, false);
+
+        if (!this->cacheDir.empty())
+        {
+            this->pruneThread = std::thread([this]() { pruneDisk(this->cacheDir, DiskBudgetBytes, DiskMaxAge); });
+        }
+    }
+
+    ThumbnailCache::~ThumbnailCache()
+    {
+        // join before the rest of the members go away
+        this->workers.reset();
+
+        if (this->pruneThread.joinable())
+        {
+            this->pruneThread.join();
+        }
+    }
+
+    cv::Mat ThumbnailCache::getThumbnail(std::shared_ptr<WxivImage> image)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        auto iter = this->entries.find(image.get());
+
+        if (iter == this->entries.end())
+        {
+            return cv::Mat();
+        }
+
+        this->lru.splice(this->lru.begin(), this->lru, iter->second);
+        return iter->second->thumb;
+    }
+
+    void ThumbnailCache::request(const std::vector<std::shared_ptr<WxivImage>>& images)
+    {
+        std::vector<std::shared_ptr<WxivImage>> needed;
+
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+
+            for (const auto& image : images)
+            {
+                auto iter = this->entries.find(image.get());
+
+                if (iter == this->entries.end())
+                {
+                    needed.push_back(image);
+                }
+                else
+                {
+                    // requested means wanted, so keep it
+                    this->lru.splice(this->lru.begin(), this->lru, iter->second);
+                }
+            }
+        }
+
+        this->workers->setQueue(needed);
+    }
+
+    void ThumbnailCache::remove(std::shared_ptr<WxivImage> image)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        auto iter = this->entries.find(image.get());
+
+        if (iter != this->entries.end())
+        {
+            this->residentBytes -= getMatBytes(iter->second->thumb);
+            this->lru.erase(iter->second);
+            this->entries.erase(iter);
+        }
+    }
+
+    void ThumbnailCache::clear()
+    {
+        this->workers->clear();
+
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        this->lru.clear();
+        this->entries.clear();
+        this->residentBytes = 0;
+    }
+
+    void ThumbnailCache::setSource(std::shared_ptr<ImageListSource> newSource)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        this->source = newSource;
+    }
+
+    bool ThumbnailCache::checkHasEntry(WxivImage* image)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->entries.find(image) != this->entries.end();
+    }
+
+    void ThumbnailCache::store(std::shared_ptr<WxivImage> image, const cv::Mat& thumb)
+    {
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            auto iter = this->entries.find(image.get());
+
+            if (iter != this->entries.end())
+            {
+                // made twice because it was requested again while in progress
+                return;
+            }
+
+            this->lru.push_front(Entry{image, thumb});
+            this->entries[image.get()] = this->lru.begin();
+            this->residentBytes += getMatBytes(thumb);
+            evict();
+        }
+
+        this->generation++;
+    }
+
+    /**
+     * @brief Drop least recently used until under budget. Call with mutex held.
+     */
+    void ThumbnailCache::evict()
+    {
+        while ((this->residentBytes > this->budgetBytes) && (this->lru.size() > 1))
+        {
+            Entry& e = this->lru.back();
+            this->residentBytes -= getMatBytes(e.thumb);
+            this->entries.erase(e.image.get());
+            this->lru.pop_back();
+        }
+    }
+
+    /**
+     * @brief On a worker thread, get the thumbnail from disk or else make it (and write it to disk).
+     */
+    void ThumbnailCache::loadThumbnail(std::shared_ptr<WxivImage> image)
+    {
+        if (checkHasEntry(image.get()))
+        {
+            return;
+        }
+
+        fs::path diskPath = getDiskPath(image);
+        cv::Mat thumb;
+
+        if (!diskPath.empty())
+        {
+            thumb = readDisk(diskPath);
+
+            if (!thumb.empty())
+            {
+                // used, so pruning keeps it longer
+                std::error_code ec;
+                fs::last_write_time(diskPath, fs::file_time_type::clock::now(), ec);
+
+                this->diskHitCount++;
+                store(image, thumb);
+                return;
+            }
+        }
+
+        try
+        {
+            thumb = makeThumbnail(image);
+            this->generatedCount++;
+        }
+        catch (std::exception&)
+        {
+            // store the empty one so it isn't tried over and over, the foreground load reports the error
+        }
+
+        if (!thumb.empty() && !diskPath.empty())
+        {
+            writeDisk(diskPath, thumb);
+        }
+
+        store(image, thumb);
+    }
+
+    /**
+     * @brief Decode as little as we can to get at least thumbDim pixels (see wxLoadImageReduced), then area-reduce to fit
+     * in thumbDim.
+     */
+    cv::Mat ThumbnailCache::makeThumbnail(std::shared_ptr<WxivImage> image)
+    {
+        cv::Mat src;
+
+        if (image->getIsLoaded())
+        {
+            const std::lock_guard<std::mutex> lock(image->getLoadMutex());
+
+            if (image->getIsLoaded())
+            {
+                // the Mat header keeps the pixels alive if the image is evicted after this
+                src = image->getImage();
+            }
+        }
+
+        std::shared_ptr<ImageListSource> imageSource;
+
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            imageSource = this->source;
+        }
+
+        // not a file, e.g. an archive member, so the source decodes it
+        bool isDecodedBySource = src.empty() && imageSource && imageSource->decodeUnloaded(image, src);
+
+        string ext = getNormalizedExt(image->getTypeStr());
+        wxString fullPath = image->getPath().GetFullPath();
+        cv::Size fullSize;
+
+        if (src.empty() && !isDecodedBySource && !wxLoadImageReduced(fullPath, image->getPage(), this->thumbDim, src, fullSize) &&
+            (image->getPage() == 0) && TiffUtil::checkIsTiffExtension(ext))
+        {
+            // too big to decode whole, synthesized levels read it by tile
+            std::shared_ptr<TiledTiffImage> tiled = TiledTiffImage::tryOpen(toFilesystemPath(fullPath), TiledMinPixelCount, TiledCacheBytes);
+
+            if (tiled)
+            {
+                src = tiled->readOverview(this->thumbDim * 2);
+            }
+        }
+
+        if (src.empty() && !isDecodedBySource)
+        {
+            vector<cv::Mat> mats;
+
+            // every pixel is read anyway, so read npy and raw into memory rather than fault if they're rewritten meanwhile
+            if (!wxLoadImage(fullPath, mats, image->getPage(), true) || mats.empty())
+            {
+                throw runtime_error("Failed to load image for thumbnail.");
+            }
+
+            src = mats[0];
+        }
+
+        if (src.empty())
+        {
+            throw runtime_error("Empty image for thumbnail.");
+        }
+
+        float scale = std::min(1.0f, (float)this->thumbDim / std::max(src.cols, src.rows));
+        cv::Mat thumb;
+
+        if (scale < 1.0f)
+        {
+            cv::Size thumbSize(std::max(1, (int)std::round(src.cols * scale)), std::max(1, (int)std::round(src.rows * scale)));
+            cv::resize(src, thumb, thumbSize, 0, 0, cv::INTER_AREA);
+        }
+        else
+        {
+            thumb = src.clone();
+        }
+
+        return thumb;
+    }
+
+    /**
+     * @brief Where this image's thumbnail would be, or empty path if it's not a file we can key (e.g. gone).
+     */
+    fs::path ThumbnailCache::getDiskPath(std::shared_ptr<WxivImage> image)
+    {
+        if (this->cacheDir.empty())
+        {
+            return fs::path();
+        }
+
+        wxString fullPath = image->getPath().GetFullPath();
+        fs::path path = toFilesystemPath(fullPath);
+        std::error_code ec;
+        uintmax_t size = fs::file_size(path, ec);
+
+        if (ec)
+        {
+            return fs::path();
+        }
+
+        auto mtime = fs::last_write_time(path, ec);
+
+        if (ec)
+        {
+            return fs::path();
+        }
+
+        string key = fmt::format("{}|{}|{}|{}|{}", fullPath.ToUTF8().data(), (int64_t)mtime.time_since_epoch().count(), size,
+            image->getPage(), this->thumbDim);
+
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ull;
+
+        for (char c : key)
+        {
+            hash ^= (uint8_t)c;
+            hash *= 1099511628211ull;
+        }
+
+        return this->cacheDir / fmt::format("{:016x}.tif", hash);
+    }
+
+    cv::Mat ThumbnailCache::readDisk(const fs::path& path)
+    {
+        std::ifstream f(path, std::ios::binary);
+
+        if (!f)
+        {
+            return cv::Mat();
+        }
+
+        std::vector<uchar> buffer((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+        try
+        {
+            return cv::imdecode(buffer, cv::IMREAD_UNCHANGED);
+        }
+        catch (cv::Exception&)
+        {
+            // e.g. truncated by a crash mid-write, will be re-made
+            return cv::Mat();
+        }
+    }
+
+    /**
+     * @brief Write to a temp name then rename, so another process never reads a partial file.
+     */
+    void ThumbnailCache::writeDisk(const fs::path& path, const cv::Mat& thumb)
+    {
+        try
+        {
+            std::vector<uchar> buffer;
+
+            if (!cv::imencode(".tif", thumb, buffer))
+            {
+                return;
+            }
+
+            std::error_code ec;
+            fs::create_directories(this->cacheDir, ec);
+
+            fs::path tempPath = path;
+            tempPath += fmt::format(".{}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+            {
+                std::ofstream f(tempPath, std::ios::binary);
+                f.write((const char*)buffer.data(), buffer.size());
+
+                if (!f)
+                {
+                    fs::remove(tempPath, ec);
+                    return;
+                }
+            }
+
+            fs::rename(tempPath, path, ec);
+
+            if (ec)
+            {
+                fs::remove(tempPath, ec);
+            }
+        }
+        catch (cv::Exception&)
+        {
+            // pixel type the encoder doesn't take, just not cached on disk
+        }
+    }
+
+    int ThumbnailCache::getGeneration()
+    {
+        return this->generation;
+    }
+
+    int ThumbnailCache::getGeneratedCount()
+    {
+        return this->generatedCount;
+    }
+
+    int ThumbnailCache::getDiskHitCount()
+    {
+        return this->diskHitCount;
+    }
+
+    int ThumbnailCache::getThumbDim()
+    {
+        return this->thumbDim;
+    }
+
+    size_t ThumbnailCache::getResidentBytes()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->residentBytes;
+    }
+
+    fs::path ThumbnailCache::getDefaultCacheDir()
+    {
+#ifdef _WIN32
+        const char* localAppData = std::getenv("LOCALAPPDATA");
+
+        if (localAppData && *localAppData)
+        {
+            return fs::path(localAppData) / "wxiv" / "thumbnails";
+        }
+#else
+        const char* xdgCacheHome = std::getenv("XDG_CACHE_HOME");
+
+        if (xdgCacheHome && *xdgCacheHome)
+        {
+            return fs::path(xdgCacheHome) / "wxiv" / "thumbnails";
+        }
+
+        const char* home = std::getenv("HOME");
+
+        if (home && *home)
+        {
+            return fs::path(home) / ".cache" / "wxiv" / "thumbnails";
+        }
+#endif
+        return fs::temp_directory_path() / "wxiv" / "thumbnails";
+    }
+
+    void ThumbnailCache::pruneDisk(const fs::path& dir, uintmax_t maxBytes, std::chrono::hours maxAge)
+    {
+        struct DiskFile
+        {
+            fs::path path;
+            fs::file_time_type time;
+            uintmax_t bytes = 0;
+        };
+
+        vector<DiskFile> files;
+        uintmax_t totalBytes = 0;
+        auto now = fs::file_time_type::clock::now();
+        std::error_code ec;
+
+        for (auto iter = fs::directory_iterator(dir, ec); !ec && (iter != fs::directory_iterator()); iter.increment(ec))
+        {
+            // thumbnails, and temp files left by a crash mid-write
+            string ext = iter->path().extension().string();
+            std::error_code fileEc;
+
+            if (!iter->is_regular_file(fileEc) || ((ext != ".tif") && (ext != ".tmp")))
+            {
+                continue;
+            }
+
+            DiskFile file{iter->path(), iter->last_write_time(fileEc), iter->file_size(fileEc)};
+
+            if (fileEc)
+            {
+                continue;
+            }
+
+            if (now - file.time > maxAge)
+            {
+                fs::remove(file.path, fileEc);
+            }
+            else
+            {
+                totalBytes += file.bytes;
+                files.push_back(file);
+            }
+        }
+
+        if (totalBytes > maxBytes)
+        {
+            std::sort(files.begin(), files.end(), [](const DiskFile& a, const DiskFile& b) { return a.time < b.time; });
+
+            for (int i = 0; (i < files.size()) && (totalBytes > maxBytes); i++)
+            {
+                std::error_code fileEc;
+
+                if (fs::remove(files[i].path, fileEc))
+                {
+                    totalBytes -= files[i].bytes;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,137 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <filesystem>
+#include <opencv2/opencv.hpp>
+
+#include "WxivImage.h"
+#include "ImagePrefetcher.h"
+#include "ImageListSource.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief Small versions of images, made on background threads and kept both in memory and on disk, so re-opening a
+     * dir shows thumbnails without decoding anything.
+     *
+     * Thumbnails are made with the cheapest decode that gives enough pixels: a JPEG is decoded at 1/2, 1/4, or 1/8
+     * scale, a TIFF with reduced-resolution IFDs is read from the coarsest one that is big enough, and an image that is
+     * already loaded is just resized.
+     *
+     * Images that aren't files (e.g. archive members) are decoded by their source instead, see
+     * ImageListSource::decodeUnloaded, and are only cached in memory.
+     *
+     * Thumbnails keep the source pixel type (e.g. 16U), not display RGB, so they can be rendered through whatever the
+     * current intensity range settings are, and changing those doesn't invalidate the cache. The disk cache key is the
+     * path, file modify time and size, page, and thumbnail dim, so a changed file just misses and stale entries are
+     * never read. Those stale files are pruned by a background pass on construct, which drops files not used in a while
+     * and then the least recently used until the dir is under a size budget (a disk hit counts as a use).
+     *
+     * The UI polls getGeneration() to know when to repaint, rather than being called back from the worker threads.
+     */
+    class ThumbnailCache
+    {
+      private:
+        struct Entry
+        {
+            std::shared_ptr<WxivImage> image;
+            cv::Mat thumb; // empty if it failed
+        };
+
+        std::filesystem::path cacheDir;
+        int thumbDim = 128;
+        size_t budgetBytes = 0;
+        size_t residentBytes = 0;
+
+        // front is most recently used
+        std::list<Entry> lru;
+        std::unordered_map<WxivImage*, std::list<Entry>::iterator> entries;
+        std::mutex mutex;
+
+        // for images that aren't files, kept alive while a worker uses it
+        std::shared_ptr<ImageListSource> source;
+
+        std::unique_ptr<ImagePrefetcher> workers;
+        std::thread pruneThread;
+        std::atomic<int> generation = 0;
+        std::atomic<int> generatedCount = 0;
+        std::atomic<int> diskHitCount = 0;
+
+        bool checkHasEntry(WxivImage* image);
+        void store(std::shared_ptr<WxivImage> image, const cv::Mat& thumb);
+        void evict();
+        void loadThumbnail(std::shared_ptr<WxivImage> image);
+        std::filesystem::path getDiskPath(std::shared_ptr<WxivImage> image);
+        cv::Mat readDisk(const std::filesystem::path& path);
+        void writeDisk(const std::filesystem::path& path, const cv::Mat& thumb);
+
+      public:
+        /**
+         * @param cacheDir Where to keep thumbnail files, created on first write. Empty for memory only.
+         * @param thumbDim Thumbnails fit in this (in both axes).
+         * @param threadCount Worker threads.
+         * @param budgetBytes Max bytes of thumbnails to keep in memory.
+         */
+        ThumbnailCache(const std::filesystem::path& cacheDir, int thumbDim, int threadCount, size_t budgetBytes = (size_t)256 * 1024 * 1024);
+        ~ThumbnailCache();
+
+        ThumbnailCache(const ThumbnailCache&) = delete;
+        ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+        /**
+         * @brief The thumbnail if it's ready, else an empty Mat. This doesn't request it.
+         */
+        cv::Mat getThumbnail(std::shared_ptr<WxivImage> image);
+
+        /**
+         * @brief Make thumbnails for these in the background, highest priority first, dropping prior requests that have not
+         * started. Ones already in memory are not re-made.
+         */
+        void request(const std::vector<std::shared_ptr<WxivImage>>& images);
+
+        /**
+         * @brief Forget this image's thumbnail, e.g. the file changed. The next request re-makes it.
+         */
+        void remove(std::shared_ptr<WxivImage> image);
+        void clear();
+
+        /**
+         * @brief The source of the images to come, which decodes the ones that aren't files. Can be null.
+         */
+        void setSource(std::shared_ptr<ImageListSource> source);
+
+        /**
+         * @brief Make a thumbnail now, on this thread, without the disk cache. Throws on failure.
+         */
+        cv::Mat makeThumbnail(std::shared_ptr<WxivImage> image);
+
+        /**
+         * @brief Incremented each time a thumbnail becomes ready.
+         */
+        int getGeneration();
+        int getGeneratedCount();
+        int getDiskHitCount();
+        int getThumbDim();
+        size_t getResidentBytes();
+
+        /**
+         * @brief $XDG_CACHE_HOME/wxiv/thumbnails, or the platform equivalent.
+         */
+        static std::filesystem::path getDefaultCacheDir();
+
+        /**
+         * @brief Delete thumbnail files in the dir not used for maxAge, then the least recently used until the rest fit in
+         * maxBytes. Other files are left alone.
+         */
+        static void pruneDisk(const std::filesystem::path& dir, uintmax_t maxBytes, std::chrono::hours maxAge);
+    };
+}
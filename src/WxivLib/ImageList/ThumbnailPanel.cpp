@@ -0,0 +1,402 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <algorithm>
+#include <thread>
+
+#include "WxWidgetsUtil.h"
+#include <wx/dcbuffer.h>
+
+#include "ThumbnailPanel.h"
+#include "ImageUtil.h"
+#include "RenderKernel.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    static const int ThumbDim = 128;
+    static const int CellMargin = 6;
+
+    ThumbnailPanel::ThumbnailPanel(wxWindow* parent)
+        : wxScrolledCanvas(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxVSCROLL | wxFULL_REPAINT_ON_RESIZE)
+    {
+        // reads are mostly waiting on disk, but generating decodes, so leave some cores for the main view
+        int threadCount = std::clamp((int)std::thread::hardware_concurrency() / 2, 1, 4);
+        this->cache = std::make_unique<ThumbnailCache>(ThumbnailCache::getDefaultCacheDir(), ThumbDim, threadCount);
+
+        this->SetBackgroundStyle(wxBG_STYLE_PAINT);
+        this->SetScrollRate(0, 16);
+
+        this->Bind(wxEVT_PAINT, &ThumbnailPanel::onPaint, this);
+        this->Bind(wxEVT_SIZE, &ThumbnailPanel::onSize, this);
+        this->Bind(wxEVT_LEFT_DOWN, &ThumbnailPanel::onLeftDown, this);
+
+        this->refreshTimer.SetOwner(this);
+        this->Bind(wxEVT_TIMER, &ThumbnailPanel::onRefreshTimer, this, this->refreshTimer.GetId());
+
+        updateLayout();
+    }
+
+    void ThumbnailPanel::setOnThumbnailClickCallback(const std::function<void(int)>& f)
+    {
+        this->onThumbnailClickCallback = f;
+    }
+
+    /**
+     * @brief Set the listed images, e.g. on new source or filter change.
+     */
+    void ThumbnailPanel::setImages(const std::vector<int>& dataIndices, const std::vector<std::shared_ptr<WxivImage>>& images)
+    {
+        this->items.clear();
+        this->items.reserve(dataIndices.size());
+
+        for (int i = 0; i < dataIndices.size(); i++)
+        {
+            this->items.push_back(Item{dataIndices[i], images[i]});
+        }
+
+        this->bitmaps.clear();
+        this->lastRequestedFirstIndex = -1;
+        this->lastRequestedLastIndex = -1;
+        updateLayout();
+        Refresh();
+
+        if (this->items.empty())
+        {
+            this->refreshTimer.Stop();
+        }
+        else if (!this->refreshTimer.IsRunning())
+        {
+            this->refreshTimer.Start(100);
+        }
+    }
+
+    void ThumbnailPanel::setSelectedDataIndex(int dataIndex)
+    {
+        if (dataIndex == this->selectedDataIndex)
+        {
+            return;
+        }
+
+        this->selectedDataIndex = dataIndex;
+
+        for (int i = 0; i < this->items.size(); i++)
+        {
+            if (this->items[i].dataIndex == dataIndex)
+            {
+                scrollToItem(i);
+                break;
+            }
+        }
+
+        Refresh();
+    }
+
+    void ThumbnailPanel::setIntensityRangeParams(const IntensityRangeParams& params)
+    {
+        if (params != this->intensityRangeParams)
+        {
+            // thumbnails are kept at source depth, so only the rendering changes
+            this->intensityRangeParams = params;
+            this->bitmaps.clear();
+            Refresh();
+        }
+    }
+
+    /**
+     * @brief Forget the thumbnail, e.g. the file was re-written, so it's re-made when next drawn.
+     */
+    void ThumbnailPanel::removeThumbnail(std::shared_ptr<WxivImage> image)
+    {
+        this->cache->remove(image);
+        this->bitmaps.erase(image.get());
+        this->lastRequestedFirstIndex = -1;
+        Refresh();
+    }
+
+    /**
+     * @brief Drop all thumbnails from memory, e.g. on new source. They are still on disk.
+     */
+    void ThumbnailPanel::clearThumbnails()
+    {
+        this->cache->clear();
+        this->bitmaps.clear();
+        this->lastRequestedFirstIndex = -1;
+        Refresh();
+    }
+
+    /**
+     * @brief New source, so drop the old one's thumbnails, and decode images that aren't files through this one.
+     */
+    void ThumbnailPanel::setSource(std::shared_ptr<ImageListSource> source)
+    {
+        clearThumbnails();
+        this->cache->setSource(source);
+    }
+
+    void ThumbnailPanel::updateLayout()
+    {
+        wxSize textSize = GetTextExtent("Wg");
+        this->cellWidth = ThumbDim + 2 * CellMargin;
+        this->cellHeight = ThumbDim + textSize.GetHeight() + 3 * CellMargin;
+
+        int clientWidth = GetClientSize().GetWidth();
+        this->columnCount = std::max(1, clientWidth / this->cellWidth);
+
+        int rowCount = ((int)this->items.size() + this->columnCount - 1) / this->columnCount;
+        SetVirtualSize(this->columnCount * this->cellWidth, rowCount * this->cellHeight);
+    }
+
+    /**
+     * @brief Ask the cache for the visible range and one screen past it, only when the range changed since the cache
+     * drops prior requests each time.
+     */
+    void ThumbnailPanel::requestVisible(int firstIndex, int lastIndex)
+    {
+        if ((firstIndex == this->lastRequestedFirstIndex) && (lastIndex == this->lastRequestedLastIndex))
+        {
+            return;
+        }
+
+        this->lastRequestedFirstIndex = firstIndex;
+        this->lastRequestedLastIndex = lastIndex;
+
+        int n = (int)this->items.size();
+        int aheadIndex = std::min(n - 1, lastIndex + (lastIndex - firstIndex + 1));
+        vector<std::shared_ptr<WxivImage>> images;
+
+        for (int i = firstIndex; i <= aheadIndex; i++)
+        {
+            images.push_back(this->items[i].image);
+        }
+
+        this->cache->request(images);
+    }
+
+    /**
+     * @brief The rendered thumbnail, or a null bitmap if the cache doesn't have it yet.
+     */
+    wxBitmap ThumbnailPanel::getBitmap(std::shared_ptr<WxivImage> image)
+    {
+        auto iter = this->bitmaps.find(image.get());
+
+        if (iter != this->bitmaps.end())
+        {
+            return iter->second;
+        }
+
+        cv::Mat thumb = this->cache->getThumbnail(image);
+
+        if (thumb.empty())
+        {
+            return wxBitmap();
+        }
+
+        wxImage wxImg = renderThumbnail(thumb, this->intensityRangeParams);
+        wxBitmap bmp(wxImg);
+        this->bitmaps[image.get()] = bmp;
+        return bmp;
+    }
+
+    void ThumbnailPanel::onPaint(wxPaintEvent& evt)
+    {
+        wxAutoBufferedPaintDC dc(this);
+        DoPrepareDC(dc);
+
+        int viewX, viewY;
+        CalcUnscrolledPosition(0, 0, &viewX, &viewY);
+        wxSize clientSize = GetClientSize();
+        dc.SetBackground(wxBrush(GetBackgroundColour()));
+        dc.Clear();
+
+        int n = (int)this->items.size();
+
+        if (n == 0)
+        {
+            return;
+        }
+
+        int firstRow = viewY / this->cellHeight;
+        int lastRow = (viewY + clientSize.GetHeight()) / this->cellHeight;
+        int firstIndex = std::min(n - 1, firstRow * this->columnCount);
+        int lastIndex = std::min(n - 1, (lastRow + 1) * this->columnCount - 1);
+        requestVisible(firstIndex, lastIndex);
+
+        // keep bitmaps only for what is on screen
+        std::unordered_map<WxivImage*, wxBitmap> drawnBitmaps;
+        int textHeight = GetTextExtent("Wg").GetHeight();
+
+        for (int i = firstIndex; i <= lastIndex; i++)
+        {
+            const Item& item = this->items[i];
+            int x = (i % this->columnCount) * this->cellWidth;
+            int y = (i / this->columnCount) * this->cellHeight;
+
+            if (item.dataIndex == this->selectedDataIndex)
+            {
+                dc.SetPen(*wxTRANSPARENT_PEN);
+                dc.SetBrush(wxBrush(wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHT)));
+                dc.DrawRectangle(x + 1, y + 1, this->cellWidth - 2, this->cellHeight - 2);
+            }
+
+            wxBitmap bmp = getBitmap(item.image);
+
+            if (bmp.IsOk())
+            {
+                int bx = x + CellMargin + (ThumbDim - bmp.GetWidth()) / 2;
+                int by = y + CellMargin + (ThumbDim - bmp.GetHeight()) / 2;
+                dc.DrawBitmap(bmp, bx, by);
+                drawnBitmaps[item.image.get()] = bmp;
+            }
+            else
+            {
+                // placeholder until it's ready
+                dc.SetPen(*wxLIGHT_GREY_PEN);
+                dc.SetBrush(*wxTRANSPARENT_BRUSH);
+                dc.DrawRectangle(x + CellMargin, y + CellMargin, ThumbDim, ThumbDim);
+            }
+
+            wxRect textRect(x + CellMargin, y + 2 * CellMargin + ThumbDim, ThumbDim, textHeight);
+            dc.SetClippingRegion(textRect);
+            dc.DrawLabel(item.image->getDisplayName(), textRect, wxALIGN_CENTER_HORIZONTAL | wxALIGN_TOP);
+            dc.DestroyClippingRegion();
+        }
+
+        this->bitmaps.swap(drawnBitmaps);
+    }
+
+    void ThumbnailPanel::onSize(wxSizeEvent& evt)
+    {
+        updateLayout();
+        evt.Skip();
+    }
+
+    int ThumbnailPanel::hitTest(wxPoint clientPos)
+    {
+        wxPoint pos = CalcUnscrolledPosition(clientPos);
+        int col = pos.x / this->cellWidth;
+        int row = pos.y / this->cellHeight;
+
+        if ((col < 0) || (col >= this->columnCount) || (row < 0))
+        {
+            return -1;
+        }
+
+        int i = row * this->columnCount + col;
+        return (i < this->items.size()) ? i : -1;
+    }
+
+    void ThumbnailPanel::scrollToItem(int itemIndex)
+    {
+        int y = (itemIndex / this->columnCount) * this->cellHeight;
+        int viewX, viewY;
+        CalcUnscrolledPosition(0, 0, &viewX, &viewY);
+        int clientHeight = GetClientSize().GetHeight();
+
+        int ppuX, ppuY;
+        GetScrollPixelsPerUnit(&ppuX, &ppuY);
+
+        if (ppuY <= 0)
+        {
+            return;
+        }
+
+        if (y < viewY)
+        {
+            Scroll(-1, y / ppuY);
+        }
+        else if (y + this->cellHeight > viewY + clientHeight)
+        {
+            Scroll(-1, (y + this->cellHeight - clientHeight + ppuY - 1) / ppuY);
+        }
+    }
+
+    void ThumbnailPanel::onLeftDown(wxMouseEvent& evt)
+    {
+        SetFocus();
+        int i = hitTest(evt.GetPosition());
+
+        if ((i >= 0) && this->onThumbnailClickCallback)
+        {
+            this->onThumbnailClickCallback(this->items[i].dataIndex);
+        }
+
+        evt.Skip();
+    }
+
+    void ThumbnailPanel::onRefreshTimer(wxTimerEvent& evt)
+    {
+        int generation = this->cache->getGeneration();
+
+        if ((generation != this->lastCacheGeneration) && IsShownOnScreen())
+        {
+            this->lastCacheGeneration = generation;
+            Refresh();
+        }
+    }
+
+    wxImage ThumbnailPanel::renderThumbnail(cv::Mat& thumb, const IntensityRangeParams& params)
+    {
+        cv::Mat ranged;
+        int type = thumb.type();
+
+        if ((type == CV_8UC3) || (type == CV_8UC4))
+        {
+            ranged = thumb;
+        }
+        else if ((params.mode == IntensityRangeMode::NoOp) || (thumb.channels() > 1) ||
+                 ((type != CV_8U) && (type != CV_16U) && (type != CV_16S) && (type != CV_32F) && (type != CV_32S)))
+        {
+            // raw cast
+            thumb.convertTo(ranged, CV_8U);
+        }
+        else
+        {
+            float lowVal = 0.0f, highVal = 0.0f;
+
+            if (params.mode == IntensityRangeMode::Explicit)
+            {
+                lowVal = params.explicitLowValue;
+                highVal = params.explicitHighValue;
+            }
+            else
+            {
+                // the thumbnail is the whole image, so view and whole image percentiles are the same thing here
+                bool isView = params.mode == IntensityRangeMode::ViewPercentile;
+                float lowPct = isView ? params.viewRoiLowPercentile : params.wholeImageLowPercentile;
+                float highPct = isView ? params.viewRoiHighPercentile : params.wholeImageHighPercentile;
+                std::pair<float, float> t = ImageUtil::histPercentiles(thumb, lowPct, highPct);
+                lowVal = t.first;
+                highVal = t.second;
+            }
+
+            ImageUtil::imgTo8u(thumb, ranged, lowVal, highVal);
+        }
+
+        wxImage wxImg(ranged.cols, ranged.rows, false);
+        cv::Mat wrapper(ranged.rows, ranged.cols, CV_8UC3, wxImg.GetData());
+
+        if (ranged.channels() == 1)
+        {
+            // through gamma and colormap, which for 8 bits is just the 256-entry table
+            RenderKernel::RenderLut lut;
+            lut.update(CV_8U, RenderKernel::RenderRange(), params.gamma, params.colormap);
+            RenderKernel::renderToRgb(ranged, 1.0f, ranged.size(), lut, 0, wrapper);
+        }
+        else if (ranged.channels() == 4)
+        {
+            cv::cvtColor(ranged, wrapper, cv::COLOR_BGRA2RGB);
+        }
+        else if (ranged.channels() == 3)
+        {
+            cv::cvtColor(ranged, wrapper, cv::COLOR_BGR2RGB);
+        }
+        else
+        {
+            wrapper = cv::Scalar(0, 0, 0);
+        }
+
+        return wxImg;
+    }
+}
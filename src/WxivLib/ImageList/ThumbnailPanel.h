@@ -0,0 +1,84 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+
+#include "WxWidgetsUtil.h"
+#include <wx/scrolwin.h>
+#include <wx/timer.h>
+
+#include <opencv2/opencv.hpp>
+
+#include "WxivImage.h"
+#include "ThumbnailCache.h"
+#include "IntensityRangeParams.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief A scrolling grid of thumbnails of the listed images, to find one by eye, for example the interesting step
+     * in a run.
+     *
+     * Only the visible cells are drawn and only those (and the next screen) are requested from the thumbnail cache, so
+     * this scales to big dirs. Thumbnails are rendered through the same intensity range settings as the main view.
+     * Cells are identified by data index (the index in the image list source) like the list panel items.
+     */
+    class ThumbnailPanel : public wxScrolledCanvas
+    {
+        struct Item
+        {
+            int dataIndex = -1;
+            std::shared_ptr<WxivImage> image;
+        };
+
+        std::unique_ptr<ThumbnailCache> cache;
+        std::vector<Item> items;
+        int selectedDataIndex = -1;
+        IntensityRangeParams intensityRangeParams;
+
+        // rendered thumbnails, only for the cells drawn in the last paint
+        std::unordered_map<WxivImage*, wxBitmap> bitmaps;
+
+        // poll the cache for newly made thumbnails
+        wxTimer refreshTimer;
+        int lastCacheGeneration = -1;
+        int lastRequestedFirstIndex = -1;
+        int lastRequestedLastIndex = -1;
+
+        int cellWidth = 0;
+        int cellHeight = 0;
+        int columnCount = 1;
+
+        std::function<void(int)> onThumbnailClickCallback;
+
+        void updateLayout();
+        void requestVisible(int firstIndex, int lastIndex);
+        wxBitmap getBitmap(std::shared_ptr<WxivImage> image);
+        int hitTest(wxPoint clientPos);
+        void scrollToItem(int itemIndex);
+
+        void onPaint(wxPaintEvent& evt);
+        void onSize(wxSizeEvent& evt);
+        void onLeftDown(wxMouseEvent& evt);
+        void onRefreshTimer(wxTimerEvent& evt);
+
+      public:
+        ThumbnailPanel(wxWindow* parent);
+
+        void setOnThumbnailClickCallback(const std::function<void(int)>& f);
+        void setImages(const std::vector<int>& dataIndices, const std::vector<std::shared_ptr<WxivImage>>& images);
+        void setSelectedDataIndex(int dataIndex);
+        void setIntensityRangeParams(const IntensityRangeParams& params);
+        void removeThumbnail(std::shared_ptr<WxivImage> image);
+        void clearThumbnails();
+        void setSource(std::shared_ptr<ImageListSource> source);
+
+        /**
+         * @brief Render a thumbnail (any pixel type) to RGB, ranging intensity like the main view does.
+         */
+        static wxImage renderThumbnail(cv::Mat& thumb, const IntensityRangeParams& params);
+    };
+}
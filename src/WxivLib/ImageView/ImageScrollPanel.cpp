@@ -17,6 +17,9 @@ using namespace std;
 
 namespace Wxiv
 {
+    // a drawn roi of a tiled image bigger than this is read from a reduced level
+    static const int64_t OrigRoiMaxPixelCount = (int64_t)64 * 1024 * 1024;
+
     ImageScrollPanel::ImageScrollPanel(wxWindow* parent) : wxWindow(parent, -1, wxDefaultPosition, wxDefaultSize, wxALWAYS_SHOW_SB)
     {
         build();
@@ -76,6 +79,9 @@ namespace Wxiv
         this->panel = new ImageViewPanel(this);
         this->panel->setOnRenderCallback([&](void) { this->onImageRender(); });
 
+        this->loadingIndicator = new wxActivityIndicator(this->panel, wxID_ANY);
+        this->loadingIndicator->Hide();
+
         // sizer hierarchy with one for the main panel and horizontal scrollbar below it,
         // then another for the first sizer with a vert scrollbar to the right
         this->hScrollBar = new wxScrollBar(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxSB_HORIZONTAL);
@@ -167,31 +173,64 @@ namespace Wxiv
         return this->panel->checkHasImage();
     }
 
-    void ImageScrollPanel::setImage(cv::Mat& newImage)
+    /**
+     * @brief Set the image to view.
+     * @param tiled For a huge image that is read by region, in which case newImage is an overview of it.
+     * @param pyramid Reduced levels of newImage for zoomed-out render, if any.
+     */
+    void ImageScrollPanel::setImage(cv::Mat& newImage, std::shared_ptr<TiledTiffImage> tiled, std::shared_ptr<ImagePyramid> pyramid)
     {
-        cv::Size2i newSize(newImage.cols, newImage.rows);
-        this->panel->setImage(newImage);
+        cv::Size2i newSize = tiled ? tiled->getSize() : cv::Size2i(newImage.cols, newImage.rows);
+        this->panel->setImage(newImage, tiled, pyramid);
 
         if (newSize != this->currentImageSize)
         {
             this->setViewToFitImage();
         }
 
-        this->currentImageSize = cv::Size2i(newImage.cols, newImage.rows);
+        this->currentImageSize = newSize;
 
-        this->imageTypeTextBox->SetLabelText(wxString(ImageUtil::getImageDescString(newImage)));
+        if (tiled)
+        {
+            string s = fmt::format("{} {}x{} ({} levels)", ImageUtil::getImageTypeString(newImage), newSize.width, newSize.height, tiled->getLevelCount());
+            this->imageTypeTextBox->SetLabelText(wxString(s));
+        }
+        else
+        {
+            this->imageTypeTextBox->SetLabelText(wxString(ImageUtil::getImageDescString(newImage)));
+        }
 
         // ensure drawnRoi is on image
         cv::Rect2f drawnRoi = this->panel->getDrawnRoi();
 
         if (!drawnRoi.empty())
         {
-            cv::Rect2f imageRoi(0, 0, newImage.cols, newImage.rows);
+            cv::Rect2f imageRoi(0, 0, newSize.width, newSize.height);
             drawnRoi = drawnRoi & imageRoi;
             this->panel->setDrawnRoi(drawnRoi);
         }
     }
 
+    void ImageScrollPanel::setPreviewImage(cv::Mat& preview, cv::Size fullSize)
+    {
+        this->panel->setPreviewImage(preview, fullSize);
+
+        if (fullSize != this->currentImageSize)
+        {
+            this->setViewToFitImage();
+        }
+
+        this->currentImageSize = fullSize;
+
+        string s = fmt::format("{} {}x{} (preview)", ImageUtil::getImageTypeString(preview), fullSize.width, fullSize.height);
+        this->imageTypeTextBox->SetLabelText(wxString(s));
+    }
+
+    bool ImageScrollPanel::checkIsPreview()
+    {
+        return this->panel->checkIsPreview();
+    }
+
     void ImageScrollPanel::clearImage()
     {
         this->panel->clearImage();
@@ -204,6 +243,11 @@ namespace Wxiv
         return this->panel->getImage();
     }
 
+    wxSize ImageScrollPanel::getFullImageSize()
+    {
+        return this->panel->getFullImageSize();
+    }
+
     void ImageScrollPanel::setShapes(ShapeSet& set)
     {
         this->panel->setShapes(set);
@@ -226,8 +270,24 @@ namespace Wxiv
         return this->panel->getViewRoi();
     }
 
-    cv::Mat ImageScrollPanel::getOrigViewImage()
+    cv::Mat ImageScrollPanel::getOrigViewImage(cv::Point2f* pScale)
     {
+        if (pScale)
+        {
+            *pScale = cv::Point2f(1.0f, 1.0f);
+        }
+
+        if (this->panel->getTiledImage() || this->panel->checkIsPreview())
+        {
+            // what was read for the render, at the rendered level, so this is bounded by the view size
+            if (pScale)
+            {
+                *pScale = this->panel->getOrigSubImageScale();
+            }
+
+            return this->panel->getOrigSubImage();
+        }
+
         // don't need a clone if we will select roi
         cv::Mat image = this->panel->getImage();
 
@@ -246,6 +306,59 @@ namespace Wxiv
         return image(roi);
     }
 
+    cv::Mat ImageScrollPanel::getOrigRoiImage(cv::Rect2i roi, cv::Point2f* pScale)
+    {
+        std::shared_ptr<TiledTiffImage> tiled = this->panel->getTiledImage();
+
+        if (pScale)
+        {
+            *pScale = cv::Point2f(1.0f, 1.0f);
+        }
+
+        if (this->panel->checkIsPreview())
+        {
+            // no full-resolution pixels yet
+            return cv::Mat();
+        }
+
+        if (tiled)
+        {
+            // a roi over much of a huge image is read from the finest level that keeps it in bounds
+            cv::Size size = tiled->getSize();
+            roi &= cv::Rect2i(0, 0, size.width, size.height);
+            int level = 0;
+
+            for (; level < tiled->getLevelCount() - 1; level++)
+            {
+                cv::Point2f levelScale = tiled->getLevelScale(level);
+
+                if ((double)roi.area() / ((double)levelScale.x * levelScale.y) <= (double)OrigRoiMaxPixelCount)
+                {
+                    break;
+                }
+            }
+
+            cv::Point2f scale = tiled->getLevelScale(level);
+            int x0 = (int)floorf(roi.x / scale.x);
+            int y0 = (int)floorf(roi.y / scale.y);
+            int x1 = (int)ceilf((roi.x + roi.width) / scale.x);
+            int y1 = (int)ceilf((roi.y + roi.height) / scale.y);
+
+            cv::Mat img;
+            tiled->readRegion(level, cv::Rect2i(x0, y0, x1 - x0, y1 - y0), img);
+
+            if (pScale)
+            {
+                *pScale = scale;
+            }
+
+            return img;
+        }
+
+        cv::Mat image = this->panel->getImage();
+        return image(roi & cv::Rect2i(0, 0, image.cols, image.rows));
+    }
+
     cv::Mat ImageScrollPanel::getViewImageClone()
     {
         return this->panel->getRenderedImageClone();
@@ -263,12 +376,12 @@ namespace Wxiv
 
     wxImage ImageScrollPanel::renderToWxImage(std::shared_ptr<WxivImage> image)
     {
-        return this->panel->renderToWxImage(image->getShapes(), image->getImage());
+        return this->panel->renderToWxImage(image->getShapes(), image->getImage(), image->getTiledImage(), image->getPyramid());
     }
 
     cv::Mat ImageScrollPanel::renderToImage(std::shared_ptr<WxivImage> image)
     {
-        return this->panel->renderToImage(image->getShapes(), image->getImage());
+        return this->panel->renderToImage(image->getShapes(), image->getImage(), image->getTiledImage(), image->getPyramid());
     }
 
     void ImageScrollPanel::updateView()
@@ -294,9 +407,41 @@ namespace Wxiv
     void ImageScrollPanel::onSize(wxSizeEvent& event)
     {
         this->updateView();
+        this->positionLoadingIndicator();
         event.Skip();
     }
 
+    /**
+     * @brief Center the spinner on the view.
+     */
+    void ImageScrollPanel::positionLoadingIndicator()
+    {
+        wxSize size = this->loadingIndicator->GetBestSize();
+        wxSize panelSize = this->panel->GetClientSize();
+        this->loadingIndicator->SetSize((panelSize.GetWidth() - size.GetWidth()) / 2, (panelSize.GetHeight() - size.GetHeight()) / 2,
+            size.GetWidth(), size.GetHeight());
+    }
+
+    void ImageScrollPanel::setIsLoading(bool isLoading)
+    {
+        if (isLoading == this->loadingIndicator->IsShown())
+        {
+            return;
+        }
+
+        if (isLoading)
+        {
+            positionLoadingIndicator();
+            this->loadingIndicator->Show();
+            this->loadingIndicator->Start();
+        }
+        else
+        {
+            this->loadingIndicator->Stop();
+            this->loadingIndicator->Hide();
+        }
+    }
+
     void ImageScrollPanel::onMouseLeftUp(wxMouseEvent& event)
     {
         if (isDrawing)
@@ -6,6 +6,7 @@
 
 #include "WxWidgetsUtil.h"
 #include <wx/splitter.h>
+#include <wx/activityindicator.h>
 #include "WxivImage.h"
 #include "ImageViewPanel.h"
 #include "ShapeSet.h"
@@ -21,6 +22,9 @@ namespace Wxiv
 
         wxPanel* toolbarPanel;
 
+        // shown over the view while the selected image loads in the background
+        wxActivityIndicator* loadingIndicator = nullptr;
+
 #ifdef __linux__
         // trouble with readonly wxTextCtrl on linux
         wxStaticText* imageTypeTextBox;
@@ -97,6 +101,7 @@ namespace Wxiv
         void updateView();
         void updateScrollbars();
         void updateDrawnRoiTextBox();
+        void positionLoadingIndicator();
 
       public:
         ImageScrollPanel(wxWindow* parent);
@@ -115,9 +120,21 @@ namespace Wxiv
         void setOnMouseOverShapeChangeCallback(const std::function<void(ShapeType, int)>& f);
 
         bool checkHasImage();
-        void setImage(cv::Mat& newImage);
+        void setImage(cv::Mat& newImage, std::shared_ptr<TiledTiffImage> tiled = nullptr, std::shared_ptr<ImagePyramid> pyramid = nullptr);
+
+        /**
+         * @brief View a reduced-resolution preview of an image that is still loading. The view is kept when the full
+         * image is set, since it's the same size.
+         */
+        void setPreviewImage(cv::Mat& preview, cv::Size fullSize);
+        bool checkIsPreview();
         void clearImage();
+
+        /**
+         * @brief The image, or for a tiled image just its overview.
+         */
         cv::Mat getImage();
+        wxSize getFullImageSize();
         void setShapes(ShapeSet& set);
         cv::Rect2f getDrawnRoi();
         void setViewToFitImage();
@@ -132,9 +149,19 @@ namespace Wxiv
          * @brief Get the viewed portion of the image.
          * This does not have rendered shapes.
          * This may not be the view aspect ratio.
+         * @param pScale If not null, set to full-resolution pixels per returned pixel (x and y), more than 1 when the
+         * view is rendered from a reduced level.
          * @return
          */
-        cv::Mat getOrigViewImage();
+        cv::Mat getOrigViewImage(cv::Point2f* pScale = nullptr);
+
+        /**
+         * @brief Get a portion of the image, in full-resolution coords, clipped to the image.
+         * This does not have rendered shapes.
+         * @param pScale If not null, set to full-resolution pixels per returned pixel (x and y), more than 1 when a roi
+         * of a tiled image is too big to read at full resolution and is read from a reduced level instead.
+         */
+        cv::Mat getOrigRoiImage(cv::Rect2i roi, cv::Point2f* pScale = nullptr);
 
         /**
          * @brief Viewed portion, with rendered shapes.
@@ -168,5 +195,10 @@ namespace Wxiv
         bool getRenderPixelValues();
 
         void showBrightnessSettingsDialog();
+
+        /**
+         * @brief Show or hide the spinner over the view. The current image stays until the next setImage.
+         */
+        void setIsLoading(bool isLoading);
     };
 }
@@ -13,6 +13,7 @@
 #include "WxivUtil.h"
 
 #define ID_POPUP_PLACEHOLDER 2000
+#define ID_PYRAMID_BUILT 2001
 
 using namespace std;
 
@@ -23,10 +24,17 @@ namespace Wxiv
         build();
     }
 
+    ImageViewPanel::~ImageViewPanel()
+    {
+        // so a build finishing later doesn't post to this
+        setPyramid(nullptr);
+    }
+
     void ImageViewPanel::build()
     {
         Bind(wxEVT_PAINT, &ImageViewPanel::paintEvent, this, wxID_ANY);
         Bind(wxEVT_ERASE_BACKGROUND, &ImageViewPanel::onEraseBackground, this, wxID_ANY);
+        Bind(wxEVT_THREAD, &ImageViewPanel::onPyramidBuilt, this, ID_PYRAMID_BUILT);
 
         Bind(wxEVT_CONTEXT_MENU, [this](wxContextMenuEvent& evt) { onImageRightClick(evt); });
     }
@@ -62,7 +70,16 @@ namespace Wxiv
 
     wxSize ImageViewPanel::getFullImageSize()
     {
-        if (!this->orig.empty())
+        if (this->tiled)
+        {
+            cv::Size size = this->tiled->getSize();
+            return wxSize(size.width, size.height);
+        }
+        else if (!this->previewFullSize.empty())
+        {
+            return wxSize(this->previewFullSize.width, this->previewFullSize.height);
+        }
+        else if (!this->orig.empty())
         {
             return wxSize(orig.cols, orig.rows);
         }
@@ -77,9 +94,17 @@ namespace Wxiv
         return !this->orig.empty();
     }
 
-    void ImageViewPanel::setImage(cv::Mat& newImage)
+    /**
+     * @brief Set the image to view.
+     * @param newTiled For a huge image that is read by region, in which case newImage is an overview of it.
+     * @param newPyramid Reduced levels of newImage, if any, which need not be built yet.
+     */
+    void ImageViewPanel::setImage(cv::Mat& newImage, std::shared_ptr<TiledTiffImage> newTiled, std::shared_ptr<ImagePyramid> newPyramid)
     {
         this->orig = newImage;
+        this->tiled = newTiled;
+        this->setPyramid(newPyramid);
+        this->previewFullSize = cv::Size();
         this->invalidateCaches();
         Refresh();
 
@@ -88,6 +113,53 @@ namespace Wxiv
         wholeImageHighValue = 0.0f;
     }
 
+    /**
+     * @brief Set the pyramid to render from, and hear when its background build is done so the view can re-render at
+     * the reduced level (until then zoomed-out renders are from level 0).
+     */
+    void ImageViewPanel::setPyramid(std::shared_ptr<ImagePyramid> newPyramid)
+    {
+        if (this->pyramid == newPyramid)
+        {
+            return;
+        }
+
+        if (this->pyramid)
+        {
+            this->pyramid->setBuiltCallback(nullptr);
+        }
+
+        this->pyramid = newPyramid;
+
+        if (this->pyramid)
+        {
+            // on the build thread, so just post to the UI thread
+            this->pyramid->setBuiltCallback([this]() { wxQueueEvent(this, new wxThreadEvent(wxEVT_THREAD, ID_PYRAMID_BUILT)); });
+        }
+    }
+
+    void ImageViewPanel::onPyramidBuilt(wxThreadEvent& event)
+    {
+        // the render picks the level, and the level change updates origSubImage
+        Refresh();
+    }
+
+    /**
+     * @brief Set a reduced-resolution preview of an image that is still loading, to view until setImage() is called
+     * with the full image. The view, shapes, and mouse coords are all in full-resolution coords as usual.
+     * @param fullSize The size of the full-resolution image.
+     */
+    void ImageViewPanel::setPreviewImage(cv::Mat& preview, cv::Size fullSize)
+    {
+        setImage(preview);
+        this->previewFullSize = fullSize;
+    }
+
+    bool ImageViewPanel::checkIsPreview()
+    {
+        return !this->previewFullSize.empty();
+    }
+
     /**
      * @brief Get a cv::Mat of the original image, not a clone.
      */
@@ -96,6 +168,24 @@ namespace Wxiv
         return this->orig;
     }
 
+    std::shared_ptr<TiledTiffImage> ImageViewPanel::getTiledImage()
+    {
+        return this->tiled;
+    }
+
+    cv::Mat ImageViewPanel::getOrigSubImage()
+    {
+        return this->origSubImage;
+    }
+
+    /**
+     * @brief Full-resolution pixels per origSubImage pixel.
+     */
+    cv::Point2f ImageViewPanel::getOrigSubImageScale()
+    {
+        return this->origSubImageScale;
+    }
+
     void ImageViewPanel::setShapes(ShapeSet& set)
     {
         // avoid render in the common case of having no shapes and setting no shapes
@@ -168,8 +258,9 @@ namespace Wxiv
     float ImageViewPanel::getZoomToFitImage()
     {
         wxSize clientSize = this->GetClientSize();
-        float zx = (float)clientSize.x / (float)this->orig.cols;
-        float zy = (float)clientSize.y / (float)this->orig.rows;
+        wxSize fullImageSize = this->getFullImageSize();
+        float zx = (float)clientSize.x / (float)fullImageSize.x;
+        float zy = (float)clientSize.y / (float)fullImageSize.y;
         return std::min(zx, zy);
     }
 
@@ -249,6 +340,19 @@ namespace Wxiv
 
     std::string ImageViewPanel::getPixelValueString(wxPoint imagePoint)
     {
+        if (checkIsPreview())
+        {
+            // not the real pixel values
+            return "";
+        }
+        else if (this->tiled)
+        {
+            // just the one pixel from full resolution, usually from a cached tile
+            cv::Mat px;
+            this->tiled->readRegion(0, cv::Rect(imagePoint.x, imagePoint.y, 1, 1), px);
+            return ImageUtil::getPixelValueString(px, cv::Point2i(0, 0));
+        }
+
         return ImageUtil::getPixelValueString(this->orig, cv::Point2i(imagePoint.x, imagePoint.y));
     }
 
@@ -524,16 +628,18 @@ namespace Wxiv
     }
 
     /**
-     * @brief Maybe update origSubImage, which is just a roi from the orig image.
+     * @brief Maybe update origSubImage, which is just a roi from the orig image (or read from the tiled image).
      */
     void ImageViewPanel::updateOrigSubImage()
     {
         static cv::Rect2i lastCvSrcIntersectRoi;
-        cv::Rect2i origImageRoi(0, 0, orig.cols, orig.rows);
+        static int lastLevel = 0;
+        wxSize fullImageSize = this->getFullImageSize();
+        cv::Rect2i origImageRoi(0, 0, fullImageSize.x, fullImageSize.y);
 
         // sub-images are integer sized despite float view roi, so preserve exact aspect ratio of portion of orig image to display
         // (and note that viewRoi often goes off orig image)
-        cv::Rect2f origImageRoi2f(0, 0, orig.cols, orig.rows);
+        cv::Rect2f origImageRoi2f(0, 0, fullImageSize.x, fullImageSize.y);
         cv::Rect2f cvSrcIntersectRoi2f = origImageRoi2f & viewRoi;
         origSubImageAr = cvSrcIntersectRoi2f.width / cvSrcIntersectRoi2f.height;
 
@@ -541,38 +647,112 @@ namespace Wxiv
         cv::Rect2i cvViewCeilRoi((int)viewRoi.x, (int)viewRoi.y, (int)ceilf(viewRoi.width), (int)ceilf(viewRoi.height));
         cv::Rect2i cvSrcIntersectRoi = origImageRoi & cvViewCeilRoi;
 
-        if (!isOrigSubImageValid || (cvSrcIntersectRoi != lastCvSrcIntersectRoi))
+        int level = 0;
+
+        if (this->tiled)
+        {
+            level = this->tiled->selectLevel(this->zoom);
+        }
+        else if (this->pyramid && (this->zoom < 1.0f))
         {
-            origSubImage = orig(cvSrcIntersectRoi);
+            // until it's built this is level 0, and the render after it's built picks up the level
+            this->pyramid->requestBuild();
+            level = this->pyramid->selectLevel(this->zoom);
+        }
+
+        if (!isOrigSubImageValid || (cvSrcIntersectRoi != lastCvSrcIntersectRoi) || (level != lastLevel))
+        {
+            if (this->tiled)
+            {
+                updateOrigSubImageTiled(cvSrcIntersectRoi, level);
+            }
+            else if (checkIsPreview())
+            {
+                updateOrigSubImagePreview(cvSrcIntersectRoi);
+            }
+            else if (level > 0)
+            {
+                updateOrigSubImagePyramid(cvSrcIntersectRoi, level);
+            }
+            else
+            {
+                origSubImage = orig(cvSrcIntersectRoi);
+                origSubImageScale = cv::Point2f(1.0f, 1.0f);
+            }
+
             isOrigSubImageValid = true;
-            isOrigSubImageRangedValid = false; // origSubImage has changed
+            isRenderRangeValid = false; // origSubImage has changed
             lastCvSrcIntersectRoi = cvSrcIntersectRoi;
+            lastLevel = level;
         }
     }
 
     /**
-     * @brief Maybe update origSubImageRanged, which is origSubImage converted to 8u via intensity ranging.
+     * @brief Level pixels that cover this roi (in full-resolution coords), rounding outward.
+     */
+    static cv::Rect2i toLevelRoi(cv::Rect2i roi, cv::Point2f scale)
+    {
+        int x0 = (int)floorf(roi.x / scale.x);
+        int y0 = (int)floorf(roi.y / scale.y);
+        int x1 = (int)ceilf((roi.x + roi.width) / scale.x);
+        int y1 = (int)ceilf((roi.y + roi.height) / scale.y);
+        return cv::Rect2i(x0, y0, x1 - x0, y1 - y0);
+    }
+
+    /**
+     * @brief Read the level pixels covering this roi (in full-resolution coords) from the tiled image into origSubImage.
+     * This only decodes the tiles under the roi, and those are usually cached from the last render.
+     */
+    void ImageViewPanel::updateOrigSubImageTiled(cv::Rect2i roi, int level)
+    {
+        cv::Point2f scale = this->tiled->getLevelScale(level);
+        this->tiled->readRegion(level, toLevelRoi(roi, scale), origSubImage);
+        origSubImageScale = scale;
+    }
+
+    /**
+     * @brief Take the level pixels covering this roi (in full-resolution coords) from the pyramid into origSubImage.
+     */
+    void ImageViewPanel::updateOrigSubImagePyramid(cv::Rect2i roi, int level)
+    {
+        cv::Mat levelImage = this->pyramid->getLevel(level);
+        cv::Point2f scale = this->pyramid->getLevelScale(level);
+        origSubImage = levelImage(toLevelRoi(roi, scale) & cv::Rect2i(0, 0, levelImage.cols, levelImage.rows));
+        origSubImageScale = scale;
+    }
+
+    /**
+     * @brief Take the preview pixels covering this roi (in full-resolution coords) into origSubImage.
+     */
+    void ImageViewPanel::updateOrigSubImagePreview(cv::Rect2i roi)
+    {
+        cv::Point2f scale((float)this->previewFullSize.width / orig.cols, (float)this->previewFullSize.height / orig.rows);
+        origSubImage = orig(toLevelRoi(roi, scale) & cv::Rect2i(0, 0, orig.cols, orig.rows));
+        origSubImageScale = scale;
+    }
+
+    /**
+     * @brief Maybe update renderRange, which maps origSubImage intensity to 8 bits.
      */
-    void ImageViewPanel::updateOrigSubImageRanged()
+    void ImageViewPanel::updateRenderRange()
     {
         // keep settings to look for any changes, this is overly broad but simple and settings should
         // not be changing often
         static ImageViewPanelSettings lastSettings;
 
         // try avoid work
-        if (!this->isOrigSubImageRangedValid || (lastSettings != this->settings))
+        if (!this->isRenderRangeValid || (lastSettings != this->settings))
         {
-            bool didRebuildNanMask = false;
-            // intensity ranging
-            float lowVal, highVal;
-
             if (this->settings.intensityRangeParams.mode == IntensityRangeMode::NoOp)
             {
                 // raw cast
-                origSubImage.convertTo(origSubImageRanged, CV_8U);
+                this->renderRange = RenderKernel::RenderRange();
             }
             else
             {
+                // intensity ranging
+                float lowVal, highVal;
+
                 if (this->settings.intensityRangeParams.mode == IntensityRangeMode::ViewPercentile)
                 {
                     float lowPct = this->settings.intensityRangeParams.viewRoiLowPercentile;
@@ -606,62 +786,35 @@ namespace Wxiv
                     throw std::runtime_error("This intensity range mode not implemented yet.");
                 }
 
-                ImageUtil::imgTo8u(origSubImage, origSubImageRanged, lowVal, highVal);
-                this->isOrigSubImageRangedValid = true;
-                this->isScaledSubImageValid = false;
                 this->lastLowValue = lowVal;
                 this->lastHighValue = highVal;
 
-                // If origSubImage is 32F, then also build a nan mask where the values are NANs.
-                if (origSubImage.type() == CV_32F)
+                if (highVal <= lowVal)
                 {
-                    // Use the fact that NAN != NAN
-                    // (This is setting some pixels but not all, for some reason)
-                    origSubImageNanMask = (origSubImage != origSubImage);
-
-                    // Set to 255 where origSubImage is NAN
-                    origSubImageNanMask.create(origSubImage.size(), CV_8U);
-
-                    for (int y = 0; y < origSubImage.rows; y++)
-                    {
-                        for (int x = 0; x < origSubImage.cols; x++)
-                        {
-                            if (std::isnan(origSubImage.at<float>(y, x)))
-                            {
-                                origSubImageNanMask.at<uint8_t>(y, x) = 255;
-                            }
-                            else
-                            {
-                                origSubImageNanMask.at<uint8_t>(y, x) = 0;
-                            }
-                        }
-                    }
-
-                    didRebuildNanMask = true;
+                    // range not specified so use min/max
+                    std::pair<float, float> minMax = ImageUtil::imgMinMax(origSubImage);
+                    lowVal = minMax.first;
+                    highVal = std::max(minMax.second, lowVal + 1.0f);
                 }
-            }
 
-            if (!didRebuildNanMask)
-            {
-                // clear any old nan mask
-                origSubImageNanMask.release();
+                this->renderRange = RenderKernel::RenderRange::fromLowHigh(lowVal, highVal);
             }
 
+            this->isRenderRangeValid = true;
             lastSettings = this->settings;
         }
     }
 
     /**
-     * @brief Maybe update scaledSubImage which is origSubImage resized to render size.
+     * @brief The part of the dc the sub-image is rendered to, always at the upper left.
+     * This may be more than the scaled sub-image covers, and render clips it to that.
      */
-    cv::Rect2i ImageViewPanel::updateScaledSubImage(int drawWidth, int drawHeight)
+    cv::Rect2i ImageViewPanel::computeCopyRoi(int drawWidth, int drawHeight)
     {
-        // avoid work by keeping last values and check if this time is different
-        static float lastZoom = NAN;
-        static cv::Rect2i lastCopyRoi;
+        // origSubImage may be from a reduced level
+        cv::Point2f renderZoom = this->zoom * this->origSubImageScale;
 
-        // always recompute the copy roi
-        cv::Rect2i copyRoi; // both src and dst roi for copy from origSubImageRanged to draw-surface image
+        cv::Rect2i copyRoi; // dst roi for render from origSubImage to draw-surface image
 
         if (this->settings.doScaleToFit)
         {
@@ -697,34 +850,13 @@ namespace Wxiv
         {
             // preserve aspect ratio
             // scale the sub-image (may not be same shape as dc) per zoom
-            int newWidth = std::min(drawWidth, (int)lroundf(origSubImageRanged.cols * this->zoom));
-            int newHeight = std::min(drawHeight, (int)lroundf(origSubImageRanged.rows * this->zoom));
+            int newWidth = std::min(drawWidth, (int)lroundf(origSubImage.cols * renderZoom.x));
+            int newHeight = std::min(drawHeight, (int)lroundf(origSubImage.rows * renderZoom.y));
 
             // put sub-image into dc-sized image (because scaled sub-image may not cover whole dc, e.g. due to aspect ratio)
             copyRoi = cv::Rect2i(0, 0, newWidth, newHeight);
         }
 
-        if (!this->isScaledSubImageValid || (copyRoi != lastCopyRoi) || (this->zoom != lastZoom))
-        {
-            int interp = this->zoom < 1.0f ? cv::INTER_AREA : cv::INTER_NEAREST;
-            cv::resize(origSubImageRanged, scaledSubImage, cv::Size(), zoom, zoom, interp);
-
-            // NaN render is broken, I've run into a couple bugs so far.
-            // I just hit a case where scaledSubImageNanMask is apparently an unexpected size
-            // if (origSubImageNanMask.size().width > 0)
-            //{
-            //    cv::resize(origSubImageNanMask, scaledSubImageNanMask, cv::Size(), zoom, zoom, cv::INTER_NEAREST);
-            //}
-
-            // ensure copy roi is not off scaled sub-image
-            copyRoi.width = std::min(copyRoi.width, scaledSubImage.cols);
-            copyRoi.height = std::min(copyRoi.height, scaledSubImage.rows);
-
-            this->isScaledSubImageValid = true;
-            lastCopyRoi = copyRoi;
-            lastZoom = this->zoom;
-        }
-
         return copyRoi;
     }
 
@@ -824,84 +956,36 @@ namespace Wxiv
             int drawWidth, drawHeight;
             dc.GetSize(&drawWidth, &drawHeight);
 
-            // intensity range
-            bool doRender = true;
+            // intensity range (color images are not ranged)
+            bool doRender = RenderKernel::checkIsSupportedType(origSubImage.type());
 
-            if ((origSubImage.type() == CV_16U) || (origSubImage.type() == CV_16S) || (origSubImage.type() == CV_8U) ||
-                (origSubImage.type() == CV_32F) || (origSubImage.type() == CV_32S))
-            {
-                updateOrigSubImageRanged();
-            }
-            else if ((origSubImage.type() == CV_8UC3) || (origSubImage.type() == CV_8UC4))
-            {
-                origSubImageRanged = origSubImage;
-                this->isOrigSubImageRangedValid = true;
-                this->isScaledSubImageValid = false;
-            }
-            else
+            if (doRender && (origSubImage.channels() == 1))
             {
-                doRender = false;
+                updateRenderRange();
+                const IntensityRangeParams& params = this->settings.intensityRangeParams;
+                this->renderLut.update(origSubImage.depth(), this->renderRange, params.gamma, params.colormap);
             }
 
             // ensure wxImgWrapper cv::Mat that wraps the wx image from which we will draw to the DC
             wxImg.Create(drawWidth, drawHeight, false);
             wxImgWrapper = cv::Mat(drawHeight, drawWidth, CV_8UC3, wxImg.GetData());
 
-            // fill bg for error cases and also when render doesn't cover whole thing
-            // PERF: could avoid this sometimes
-            wxImgWrapper = cv::Scalar(this->background, this->background, this->background);
-
-            if (doRender)
+            if (!doRender)
             {
-                // maybe rebuild scaledSubImage, and get the copy roi which is both src and dst roi for copy from scaledSubImage to draw-surface image
-                cv::Rect2i copyRoi = this->updateScaledSubImage(drawWidth, drawHeight);
-
-                // get pixels to wxImgWrapper, which is RGB (and is the dc)
-                if (scaledSubImage.type() == CV_8U)
-                {
-                    // dcImgTmp is size of the dc, so we copy to it and then convert to rgb from there
-                    dcImgTmp.create(drawHeight, drawWidth, CV_8U);
-                    dcImgTmp = this->background; // fill bg
-                    scaledSubImage(copyRoi).copyTo(dcImgTmp(copyRoi));
-
-                    // to rgb in a wxImage
-                    cv::cvtColor(dcImgTmp, wxImgWrapper, cv::COLOR_GRAY2BGR);
-                }
-                else if (scaledSubImage.type() == CV_8UC3)
-                {
-                    cv::cvtColor(scaledSubImage(copyRoi), wxImgWrapper(copyRoi), cv::COLOR_BGR2RGB);
-                }
-                else if (scaledSubImage.type() == CV_8UC4)
-                {
-                    // yes this needs to be "*2RGB", apparently
-                    cv::cvtColor(scaledSubImage(copyRoi), wxImgWrapper(copyRoi), cv::COLOR_BGRA2RGB);
-                }
-                else if (scaledSubImage.type() == CV_32F)
-                {
-                    // dcImgTmp is size of the dc, so we copy to it and then convert to rgb from there
-                    dcImgTmp.create(drawHeight, drawWidth, CV_8U);
-                    dcImgTmp = this->background; // fill bg
-                    cv::convertScaleAbs(scaledSubImage(copyRoi), dcImgTmp(copyRoi));
-
-                    // to rgb in a wxImage
-                    cv::cvtColor(dcImgTmp, wxImgWrapper, cv::COLOR_GRAY2BGR);
-                }
-                else
-                {
-                    bail("unhandled image type");
-                    return false;
-                }
-
-                // scaledSubImageNanMask is same size as scaledSubImage, and is a mask of where the values are NANs.
-                // Render the set pixels of it to the wxImgWrapper as blue.
-                // if (scaledSubImageNanMask.size().width > 0)
-                //{
-                //    wxImgWrapper(copyRoi).setTo(cv::Scalar(0, 70, 70), scaledSubImageNanMask(copyRoi));
-                //}
+                // fill bg for error cases
+                wxImgWrapper = cv::Scalar(this->background, this->background, this->background);
+            }
+            else
+            {
+                // get pixels to wxImgWrapper, which is RGB (and is the dc): ranged, scaled and converted in one pass,
+                // with background where the sub-image doesn't cover the dc
+                cv::Rect2i copyRoi = this->computeCopyRoi(drawWidth, drawHeight);
+                cv::Point2f renderZoom = this->zoom * this->origSubImageScale;
+                RenderKernel::renderToRgb(origSubImage, renderZoom, copyRoi.size(), this->renderLut, this->background, wxImgWrapper);
 
                 // pixel value strings (before shapes because we use rendered color (as opposed to orig color) for text color)
                 // my preference is to show for last two zoom levels
-                bool enoughZoomToRenderPixelValues = (zoom >= settings.maxZoom) || (zoom > 70.0f);
+                bool enoughZoomToRenderPixelValues = ((zoom >= settings.maxZoom) || (zoom > 70.0f)) && !checkIsPreview();
 
                 if (this->settings.doRenderPixelValues && enoughZoomToRenderPixelValues)
                 {
@@ -926,9 +1010,8 @@ namespace Wxiv
      */
     void ImageViewPanel::invalidateCaches()
     {
-        this->isOrigSubImageRangedValid = false;
+        this->isRenderRangeValid = false;
         this->isOrigSubImageValid = false;
-        this->isScaledSubImageValid = false;
     }
 
     /**
@@ -940,11 +1023,18 @@ namespace Wxiv
      *
      * @return The resulting image.
      */
-    wxImage ImageViewPanel::renderToWxImage(ShapeSet& inShapes, cv::Mat& img)
+    wxImage ImageViewPanel::renderToWxImage(
+        ShapeSet& inShapes, cv::Mat& img, std::shared_ptr<TiledTiffImage> imgTiled, std::shared_ptr<ImagePyramid> imgPyramid)
     {
         // temporarily overwrite orig image with the incoming image to be rendered
         cv::Mat oldOrig = this->orig;
+        std::shared_ptr<TiledTiffImage> oldTiled = this->tiled;
+        std::shared_ptr<ImagePyramid> oldPyramid = this->pyramid;
+        cv::Size oldPreviewFullSize = this->previewFullSize;
         this->orig = img;
+        this->tiled = imgTiled;
+        this->pyramid = imgPyramid;
+        this->previewFullSize = cv::Size();
 
         // invalidate caches because we are rendering a new image
         this->invalidateCaches();
@@ -953,6 +1043,9 @@ namespace Wxiv
 
         // restore
         this->orig = oldOrig;
+        this->tiled = oldTiled;
+        this->pyramid = oldPyramid;
+        this->previewFullSize = oldPreviewFullSize;
 
         // invalidate again because the cached data is from this image, not orig
         this->invalidateCaches();
@@ -964,16 +1057,16 @@ namespace Wxiv
      * @brief Call renderToWxImage and then return getRenderedImageClone() to get as cv::Mat.
      * @return The resulting image
      */
-    cv::Mat ImageViewPanel::renderToImage(ShapeSet& inShapes, cv::Mat& img)
+    cv::Mat ImageViewPanel::renderToImage(
+        ShapeSet& inShapes, cv::Mat& img, std::shared_ptr<TiledTiffImage> imgTiled, std::shared_ptr<ImagePyramid> imgPyramid)
     {
-        renderToWxImage(inShapes, img);
+        renderToWxImage(inShapes, img, imgTiled, imgPyramid);
         return getRenderedImageClone();
     }
 
     /*
      * Render view of image to the dc.
      *
-     * Some of the image copies could be replaced by a single custom op.
      * The intensity hist could potentially be lagging: compute during this render and used in next render.
      */
     void ImageViewPanel::render(wxDC& dc)
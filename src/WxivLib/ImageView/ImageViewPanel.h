@@ -2,6 +2,7 @@
 // Distributed under the MIT License (http://opensource.org/licenses/MIT)
 #pragma once
 #include <functional>
+#include <memory>
 #include <opencv2/opencv.hpp>
 
 #include "WxWidgetsUtil.h"
@@ -9,6 +10,9 @@
 
 #include "ShapeSet.h"
 #include "ImageViewPanelSettings.h"
+#include "TiledTiffImage.h"
+#include "ImagePyramid.h"
+#include "RenderKernel.h"
 
 namespace Wxiv
 {
@@ -22,9 +26,13 @@ namespace Wxiv
      * just-started capability to just paint the whole image zoomed to fit the panel.
      * The API isn't all consistent with that paradigm and maybe that should be a separate class.
      *
-     * There is some caching now for performance. In the chain of render images, often some of them do not need to be rebuilt.
-     * The design is to have an "is valid" bool per image and set it to false when it needs to be rebuilt and to true when it is rebuilt.
-     * The "is valid" bools only represent when the prior image in the chain is modified, not any other settings that might affect it.
+     * Render is two steps: take the sub-image of orig under the view (origSubImage, usually just a roi, no copy) and then
+     * one pass of RenderKernel from that straight into the dc-sized RGB wxImage, which does the ranging, scaling, RGB
+     * conversion and background fill together.
+     * There is some caching for performance: origSubImage and the intensity range (which may need a histogram) are only
+     * rebuilt when needed. The design is to have an "is valid" bool per cached thing and set it to false when it needs to
+     * be rebuilt and to true when it is rebuilt.
+     * The "is valid" bools only represent when the prior step is modified, not any other settings that might affect it.
      * This turns out to be fairly unfortunate with respect to renderToWxImage which wants to render a totally separate image,
      * but still worth it for perf, I think.
      *
@@ -33,6 +41,15 @@ namespace Wxiv
      * To enable this:
      *    1) viewRoi is float
      *    2) sub-images are over-sized (to have the partial pixels needed for render)
+     *
+     * For a huge tiled image, orig is just an overview and origSubImage is read from the tiled image at the pyramid level
+     * that matches the zoom, so only the tiles under the view are ever decoded. All coords (view roi, shapes, mouse) are
+     * still full-resolution image coords, and origSubImageScale accounts for the level in the render.
+     * Big in-memory images do the same from their ImagePyramid once it's built, which is requested on the first
+     * zoomed-out render, so zoomed-out render cost follows the view size instead of the image size.
+     *
+     * While a big image is loading, orig can be a reduced-resolution preview of it (see setPreviewImage()), which is
+     * rendered like a pyramid level, so the view roi is already in full-resolution coords when the full image arrives.
      */
     class ImageViewPanel : public wxWindow
     {
@@ -41,19 +58,24 @@ namespace Wxiv
         // original image (empty for no image)
         cv::Mat orig;
 
-        // keep pipeline of images as they will often not need to be reallocated
+        // when set, this is the real image and orig is an overview of it
+        std::shared_ptr<TiledTiffImage> tiled;
+
+        // reduced levels of orig, if it's big enough to have them
+        std::shared_ptr<ImagePyramid> pyramid;
+
+        // when not empty, orig is a reduced-resolution preview of an image of this size
+        cv::Size previewFullSize;
+
+        // keep render state as it will often not need to be rebuilt
         bool isOrigSubImageValid = false; // for caching, when false it means this needs to be rebuilt
         cv::Mat origSubImage;             // viewRoi-sized (but not dc sized) sub-image of orig image
-        cv::Mat origSubImageNanMask;      // mask of where origSubImage is nan, 8U
         float origSubImageAr = 0.0f;      // aspect ratio of origSubImage to preserve float precision (since origSubImage has integer dimensions).
+        cv::Point2f origSubImageScale = cv::Point2f(1.0f, 1.0f); // orig pixels per origSubImage pixel, more than 1 from a reduced level
 
-        bool isOrigSubImageRangedValid = false; // for caching, when false it means this needs to be rebuilt
-        cv::Mat origSubImageRanged;             // view-sized sub-image of orig image, intensity-ranged
-
-        bool isScaledSubImageValid = false; // for caching, when false it means this needs to be rebuilt
-        cv::Mat scaledSubImage;             // origSubImageRanged scaled to final size (but maybe only a portion of dc size)
-        cv::Mat scaledSubImageNanMask;      // mask of where scaledSubImage is nan, 8U
-        cv::Mat dcImgTmp;                   // size of the dc, type of the rendered image
+        bool isRenderRangeValid = false;       // for caching, when false it means this needs to be rebuilt
+        RenderKernel::RenderRange renderRange; // origSubImage intensity to 8 bits
+        RenderKernel::RenderLut renderLut;     // renderRange, gamma, and colormap as tables, rebuilt when they change
 
         wxImage dcImage;        // RGB image, size of the dc
         cv::Mat dcImageWrapper; // points to dcImage's data
@@ -92,12 +114,14 @@ namespace Wxiv
 
         // render image pipeline
         void updateOrigSubImage();
-        void updateOrigSubImageRanged();
-        cv::Rect2i updateScaledSubImage(int drawWidth, int drawHeight);
+        void updateRenderRange();
+        cv::Rect2i computeCopyRoi(int drawWidth, int drawHeight);
         void invalidateCaches();
 
         void render(wxDC& dc);
         void onEraseBackground(wxEraseEvent& event);
+        void onPyramidBuilt(wxThreadEvent& event);
+        void setPyramid(std::shared_ptr<ImagePyramid> newPyramid);
 
         void wxDrawShapes(wxDC& dc);
         void cvDrawShapes(ShapeSet& shapes, cv::Mat& imgRgb);
@@ -111,15 +135,28 @@ namespace Wxiv
         void onContextMenuClick(wxCommandEvent& evt);
 
         bool renderToWxImage(ShapeSet& inShapes, wxImage& wxImage, cv::Mat& wxImageWrapper);
+        void updateOrigSubImageTiled(cv::Rect2i roi, int level);
+        void updateOrigSubImagePyramid(cv::Rect2i roi, int level);
+        void updateOrigSubImagePreview(cv::Rect2i roi);
         void renderPixelStrings(cv::Mat& img);
 
       public:
         ImageViewPanel(wxWindow* parent);
+        ~ImageViewPanel();
 
         bool checkHasImage();
-        void setImage(cv::Mat& newImage);
+        void setImage(cv::Mat& newImage, std::shared_ptr<TiledTiffImage> newTiled = nullptr, std::shared_ptr<ImagePyramid> newPyramid = nullptr);
+        void setPreviewImage(cv::Mat& preview, cv::Size fullSize);
+        bool checkIsPreview();
         void clearImage();
         cv::Mat getImage();
+        std::shared_ptr<TiledTiffImage> getTiledImage();
+
+        /**
+         * @brief The viewed portion of the image as last rendered, which for a tiled image is at the rendered level.
+         */
+        cv::Mat getOrigSubImage();
+        cv::Point2f getOrigSubImageScale();
         wxBitmap getViewBitmap();
         wxImage getViewWxImageClone();
 
@@ -134,8 +171,10 @@ namespace Wxiv
          * The returned wxImage points to an existing object member that will be modified soon so take a copy
          * if needed.
          */
-        wxImage renderToWxImage(ShapeSet& inShapes, cv::Mat& img);
-        cv::Mat renderToImage(ShapeSet& inShapes, cv::Mat& img);
+        wxImage renderToWxImage(ShapeSet& inShapes, cv::Mat& img, std::shared_ptr<TiledTiffImage> imgTiled = nullptr,
+            std::shared_ptr<ImagePyramid> imgPyramid = nullptr);
+        cv::Mat renderToImage(ShapeSet& inShapes, cv::Mat& img, std::shared_ptr<TiledTiffImage> imgTiled = nullptr,
+            std::shared_ptr<ImagePyramid> imgPyramid = nullptr);
 
         void setView(wxPoint origPt, float zoom);
         void setViewToFitImage();
@@ -6,6 +6,7 @@
 
 #include <fmt/core.h>
 #include "ImageViewPanelSettingsPanel.h"
+#include "RenderKernel.h"
 
 namespace Wxiv
 {
@@ -80,6 +81,29 @@ namespace Wxiv
 
         vertSizer->Add(intensitySizer, 0, wxALL, 12);
 
+        // gamma and colormap, for gray images
+        auto displaySizer = new wxStaticBoxSizer(wxHORIZONTAL, this, "Gray Display");
+        this->gammaTextCtrl =
+            new wxTextCtrl(displaySizer->GetStaticBox(), wxID_ANY, fmt::format("{:.2f}", this->settings.intensityRangeParams.gamma));
+        this->colormapChoice = new wxChoice(displaySizer->GetStaticBox(), wxID_ANY);
+        const auto& colormaps = RenderKernel::getColormaps();
+
+        for (int i = 0; i < (int)colormaps.size(); i++)
+        {
+            this->colormapChoice->Append(colormaps[i].first);
+
+            if (colormaps[i].second == this->settings.intensityRangeParams.colormap)
+            {
+                this->colormapChoice->SetSelection(i);
+            }
+        }
+
+        displaySizer->Add(new wxStaticText(displaySizer->GetStaticBox(), wxID_ANY, "Gamma"), 0, wxALIGN_CENTER_VERTICAL | wxALL, 4);
+        displaySizer->Add(this->gammaTextCtrl, 0, wxALIGN_CENTER_VERTICAL | wxALL, 4);
+        displaySizer->Add(new wxStaticText(displaySizer->GetStaticBox(), wxID_ANY, "Colormap"), 0, wxALIGN_CENTER_VERTICAL | wxALL, 4);
+        displaySizer->Add(this->colormapChoice, 0, wxALIGN_CENTER_VERTICAL | wxALL, 4);
+        vertSizer->Add(displaySizer, 0, wxLEFT | wxRIGHT | wxBOTTOM, 12);
+
         this->radioButtonModeNone->SetValue(this->settings.intensityRangeParams.mode == IntensityRangeMode::NoOp);
         this->radioButtonModeWholeImagePercentile->SetValue(this->settings.intensityRangeParams.mode == IntensityRangeMode::WholeImagePercentile);
         this->radioButtonModeViewRoiPercentile->SetValue(this->settings.intensityRangeParams.mode == IntensityRangeMode::ViewPercentile);
@@ -122,6 +146,12 @@ namespace Wxiv
         this->settings.intensityRangeParams.explicitLowValue = std::stof(this->explicitValuesLow->GetValue().ToStdString());
         this->settings.intensityRangeParams.explicitHighValue = std::stof(this->explicitValuesHigh->GetValue().ToStdString());
 
+        float gamma = std::stof(this->gammaTextCtrl->GetValue().ToStdString());
+        this->settings.intensityRangeParams.gamma = (gamma > 0.0f) ? gamma : 1.0f;
+
+        int colormapIndex = this->colormapChoice->GetSelection();
+        this->settings.intensityRangeParams.colormap = (colormapIndex > 0) ? RenderKernel::getColormaps()[colormapIndex].second : -1;
+
         return this->settings;
     }
 }
@@ -27,6 +27,9 @@ namespace Wxiv
         wxTextCtrl* explicitValuesLow = nullptr;
         wxTextCtrl* explicitValuesHigh = nullptr;
 
+        wxTextCtrl* gammaTextCtrl = nullptr;
+        wxChoice* colormapChoice = nullptr;
+
       public:
         ImageViewPanelSettingsPanel(wxWindow* parent, ImageViewPanelSettings initialSettings, bool hideRenderShapesOption);
         ImageViewPanelSettings getSettings();
@@ -13,6 +13,8 @@ namespace Wxiv
         this->viewRoiLowPercentile = (float)cfg->ReadDouble("viewRoiLowPercentile", 0.1);
         this->wholeImageHighPercentile = (float)cfg->ReadDouble("wholeImageHighPercentile", 99.9);
         this->wholeImageLowPercentile = (float)cfg->ReadDouble("wholeImageLowPercentile", 0.1);
+        this->gamma = (float)cfg->ReadDouble("gamma", 1.0);
+        this->colormap = (int)cfg->ReadLong("colormap", -1);
     }
 
     void IntensityRangeParams::writeConfig(wxConfigBase* cfg)
@@ -24,5 +26,7 @@ namespace Wxiv
         cfg->Write("viewRoiLowPercentile", this->viewRoiLowPercentile);
         cfg->Write("wholeImageHighPercentile", this->wholeImageHighPercentile);
         cfg->Write("wholeImageLowPercentile", this->wholeImageLowPercentile);
+        cfg->Write("gamma", this->gamma);
+        cfg->Write("colormap", (long)this->colormap);
     }
 }
@@ -58,6 +58,16 @@ namespace Wxiv
          */
         float viewRoiHighPercentile = 99.9f;
 
+        /**
+         * @brief Gray images only: ranged intensity v (0 to 1) is shown as v^gamma, so less than 1 brightens the dark end.
+         */
+        float gamma = 1.0f;
+
+        /**
+         * @brief Gray images only: a cv::ColormapTypes value to show intensity in, or -1 for gray.
+         */
+        int colormap = -1;
+
         auto operator<=>(const IntensityRangeParams&) const = default;
         void loadConfig(wxConfigBase* cfg);
         void writeConfig(wxConfigBase* cfg);
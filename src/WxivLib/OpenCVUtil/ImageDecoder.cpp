@@ -0,0 +1,165 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <unordered_map>
+#include <limits>
+#include <opencv2/opencv.hpp>
+
+#include "ImageDecoder.h"
+#include "StringUtil.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    namespace ImageDecoder
+    {
+        /**
+         * @brief Codecs whose underlying library is not safe to use from more than one thread at a time.
+         * JasPer (used for JPEG 2000 when OpenCV is built with it instead of OpenJPEG) keeps global state.
+         */
+        static const std::unordered_map<std::string, std::string> serializedCodecs = {
+            {"jp2", "jpeg2000"},
+            {"j2k", "jpeg2000"},
+            {"jpc", "jpeg2000"},
+        };
+
+        static std::mutex& getCodecMutex(const std::string& codec)
+        {
+            static std::mutex mapMutex;
+            static std::unordered_map<std::string, std::unique_ptr<std::mutex>> codecMutexes;
+
+            const std::lock_guard<std::mutex> lock(mapMutex);
+            std::unique_ptr<std::mutex>& p = codecMutexes[codec];
+
+            if (!p)
+            {
+                p = std::make_unique<std::mutex>();
+            }
+
+            return *p;
+        }
+
+        /**
+         * @brief Lock for the codec if it needs serialization, else this does not lock anything.
+         */
+        static std::unique_lock<std::mutex> lockCodecIfNeeded(const std::string& ext)
+        {
+            auto iter = serializedCodecs.find(getNormalizedExt(ext));
+
+            if (iter != serializedCodecs.end())
+            {
+                return std::unique_lock<std::mutex>(getCodecMutex(iter->second));
+            }
+
+            return std::unique_lock<std::mutex>();
+        }
+
+        bool checkCodecNeedsSerialization(const std::string& ext)
+        {
+            return serializedCodecs.find(getNormalizedExt(ext)) != serializedCodecs.end();
+        }
+
+        /**
+         * @brief Decode all pages of an image file, or just one page. Safe to call from multiple threads.
+         * @param path Must be a path OpenCV can open, i.e. ASCII on Windows.
+         * @param ext File extension, to decide on serialization.
+         * @param page Zero-based page to decode, or -1 for all pages.
+         */
+        bool decodeFile(const std::string& path, const std::string& ext, std::vector<cv::Mat>& mats, int page)
+        {
+            std::unique_lock<std::mutex> lock = lockCodecIfNeeded(ext);
+
+            if (page >= 0)
+            {
+                // this skips to the page's directory without decoding the ones before it
+                return cv::imreadmulti(path, mats, page, 1, cv::IMREAD_UNCHANGED) && !mats.empty();
+            }
+
+            return cv::imreadmulti(path, mats, cv::IMREAD_UNCHANGED);
+        }
+
+        /**
+         * @brief Decode the first page of an in-memory encoded image. Safe to call from multiple threads.
+         */
+        bool decodeBuffer(const std::vector<uchar>& buffer, const std::string& ext, std::vector<cv::Mat>& mats)
+        {
+            return decodeBuffer(buffer.data(), buffer.size(), ext, mats);
+        }
+
+        /**
+         * @brief Decode the first page of an encoded image in memory that isn't ours, e.g. a mapped file, without copying
+         * it. Safe to call from multiple threads.
+         * @param size Must be less than 2 GB, since OpenCV wants the buffer as one row.
+         */
+        bool decodeBuffer(const uchar* data, size_t size, const std::string& ext, std::vector<cv::Mat>& mats)
+        {
+            if ((size == 0) || (size > (size_t)std::numeric_limits<int>::max()))
+            {
+                return false;
+            }
+
+            // just a header on the caller's bytes
+            const cv::Mat buffer(1, (int)size, CV_8U, const_cast<uchar*>(data));
+
+            std::unique_lock<std::mutex> lock = lockCodecIfNeeded(ext);
+            cv::Mat img;
+            cv::imdecode(buffer, cv::IMREAD_UNCHANGED, &img);
+
+            if (!img.empty())
+            {
+                mats.push_back(img);
+                return true;
+            }
+
+            return false;
+        }
+
+        /**
+         * @brief Decode a JPEG at 1/2, 1/4 or 1/8 size, which libjpeg does in the DCT so it is much faster than a full
+         * decode. Other formats and factors decode at full size. Output is 8-bit, gray or BGR.
+         * @param reduceFactor 1, 2, 4, or 8.
+         * @param isColor Whether to decode to BGR, else gray.
+         */
+        bool decodeBufferReduced(const std::vector<uchar>& buffer, const std::string& ext, int reduceFactor, bool isColor, cv::Mat& img)
+        {
+            return decodeBufferReduced(buffer.data(), buffer.size(), ext, reduceFactor, isColor, img);
+        }
+
+        /**
+         * @brief Same, from memory that isn't ours, e.g. a mapped file, without copying it.
+         * @param size Must be less than 2 GB, as for decodeBuffer.
+         */
+        bool decodeBufferReduced(const uchar* data, size_t size, const std::string& ext, int reduceFactor, bool isColor, cv::Mat& img)
+        {
+            if ((size == 0) || (size > (size_t)std::numeric_limits<int>::max()))
+            {
+                return false;
+            }
+
+            // just a header on the caller's bytes
+            const cv::Mat buffer(1, (int)size, CV_8U, const_cast<uchar*>(data));
+            int flags = isColor ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE;
+
+            if (reduceFactor == 2)
+            {
+                flags = isColor ? cv::IMREAD_REDUCED_COLOR_2 : cv::IMREAD_REDUCED_GRAYSCALE_2;
+            }
+            else if (reduceFactor == 4)
+            {
+                flags = isColor ? cv::IMREAD_REDUCED_COLOR_4 : cv::IMREAD_REDUCED_GRAYSCALE_4;
+            }
+            else if (reduceFactor == 8)
+            {
+                flags = isColor ? cv::IMREAD_REDUCED_COLOR_8 : cv::IMREAD_REDUCED_GRAYSCALE_8;
+            }
+
+            std::unique_lock<std::mutex> lock = lockCodecIfNeeded(ext);
+            cv::imdecode(buffer, flags, &img);
+            return !img.empty();
+        }
+    }
+}
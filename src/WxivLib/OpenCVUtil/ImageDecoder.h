@@ -0,0 +1,26 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+namespace Wxiv
+{
+    /**
+     * @brief Thin layer over OpenCV decode so that decodes of different files can run concurrently.
+     *
+     * OpenCV creates a new decoder instance (its own libtiff/libpng/libjpeg state) for every imread/imdecode call, so
+     * concurrent decodes are safe for the common codecs. The few codecs whose libraries keep global state are
+     * serialized here, each behind its own mutex, so they don't block decodes of other formats.
+     */
+    namespace ImageDecoder
+    {
+        bool checkCodecNeedsSerialization(const std::string& ext);
+        bool decodeFile(const std::string& path, const std::string& ext, std::vector<cv::Mat>& mats, int page = -1);
+        bool decodeBuffer(const std::vector<uchar>& buffer, const std::string& ext, std::vector<cv::Mat>& mats);
+        bool decodeBuffer(const uchar* data, size_t size, const std::string& ext, std::vector<cv::Mat>& mats);
+        bool decodeBufferReduced(const std::vector<uchar>& buffer, const std::string& ext, int reduceFactor, bool isColor, cv::Mat& img);
+        bool decodeBufferReduced(const uchar* data, size_t size, const std::string& ext, int reduceFactor, bool isColor, cv::Mat& img);
+    }
+}
@@ -0,0 +1,232 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <opencv2/opencv.hpp>
+
+#include "ImageHeader.h"
+#include "TiffUtil.h"
+#include "MappedImage.h"
+#include "StringUtil.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace Wxiv
+{
+    namespace ImageHeader
+    {
+        static uint32_t readBigEndian(const uint8_t* p, int byteCount)
+        {
+            uint32_t value = 0;
+
+            for (int i = 0; i < byteCount; i++)
+            {
+                value = (value << 8) | p[i];
+            }
+
+            return value;
+        }
+
+        /**
+         * @brief OpenCV loads unchanged, so gray stays 1 channel, palette expands to BGR, and alpha is kept.
+         */
+        static bool probeTiff(const fs::path& path, int page, ImageHeaderInfo& info)
+        {
+            TiffUtil::TiffPageInfo tiffInfo = TiffUtil::readPageInfo(path, page);
+            bool isPalette = (tiffInfo.photometric == 3);
+            int bits = isPalette ? 8 : tiffInfo.bitsPerSample;
+
+            if (tiffInfo.sampleFormat == 3)
+            {
+                info.depth = (bits == 64) ? CV_64F : CV_32F;
+            }
+            else if (bits <= 8)
+            {
+                info.depth = (tiffInfo.sampleFormat == 2) ? CV_8S : CV_8U;
+            }
+            else if (bits <= 16)
+            {
+                info.depth = (tiffInfo.sampleFormat == 2) ? CV_16S : CV_16U;
+            }
+            else
+            {
+                info.depth = CV_32S;
+            }
+
+            info.width = (int)tiffInfo.width;
+            info.height = (int)tiffInfo.height;
+            info.channels = isPalette ? 3 : tiffInfo.samplesPerPixel;
+
+            // pages past the first are listed under the first, which has the count
+            info.pageCount = (page == 0) ? TiffUtil::countPages(path) : 1;
+            return true;
+        }
+
+        static bool probePng(std::istream& f, ImageHeaderInfo& info)
+        {
+            // signature, then IHDR is always the first chunk
+            uint8_t buf[8 + 8 + 13];
+
+            if (!f.read((char*)buf, sizeof(buf)) || (memcmp(buf, "\x89PNG\r\n\x1a\n", 8) != 0) || (memcmp(buf + 12, "IHDR", 4) != 0))
+            {
+                return false;
+            }
+
+            const uint8_t* ihdr = buf + 16;
+            int bitDepth = ihdr[8];
+            int colorType = ihdr[9];
+
+            info.width = (int)readBigEndian(ihdr, 4);
+            info.height = (int)readBigEndian(ihdr + 4, 4);
+            info.depth = (bitDepth == 16) ? CV_16U : CV_8U;
+
+            switch (colorType)
+            {
+            case 0: // gray
+                info.channels = 1;
+                break;
+            case 2: // RGB
+            case 3: // palette
+                info.channels = 3;
+                break;
+            default: // gray+alpha, RGBA
+                info.channels = 4;
+                break;
+            }
+
+            info.pageCount = 1;
+            return true;
+        }
+
+        /**
+         * @brief Walk the marker segments to the first start-of-frame. These are usually in the first few KB, but EXIF
+         * can push it out, so this seeks over each segment rather than reading a fixed amount.
+         */
+        static bool probeJpeg(std::istream& f, ImageHeaderInfo& info)
+        {
+            uint8_t buf[8];
+
+            if (!f.read((char*)buf, 2) || (buf[0] != 0xFF) || (buf[1] != 0xD8))
+            {
+                return false;
+            }
+
+            while (f.read((char*)buf, 4))
+            {
+                if (buf[0] != 0xFF)
+                {
+                    return false;
+                }
+
+                int marker = buf[1];
+                int segmentLen = (int)readBigEndian(buf + 2, 2);
+
+                // SOF0-SOF15, except DHT, JPG, and DAC which share the range
+                if ((marker >= 0xC0) && (marker <= 0xCF) && (marker != 0xC4) && (marker != 0xC8) && (marker != 0xCC))
+                {
+                    if (!f.read((char*)buf, 6))
+                    {
+                        return false;
+                    }
+
+                    int precision = buf[0];
+                    int components = buf[5];
+
+                    info.height = (int)readBigEndian(buf + 1, 2);
+                    info.width = (int)readBigEndian(buf + 3, 2);
+                    info.depth = (precision > 8) ? CV_16U : CV_8U;
+                    info.channels = (components == 1) ? 1 : 3; // CMYK is converted to BGR
+                    info.pageCount = 1;
+                    return true;
+                }
+
+                if ((marker == 0xD9) || (marker == 0xDA) || (segmentLen < 2))
+                {
+                    // end of image or start of scan before any frame header
+                    return false;
+                }
+
+                f.seekg(segmentLen - 2, std::ios::cur);
+            }
+
+            return false;
+        }
+
+        /**
+         * @brief Mapping doesn't read the pixels, so this just uses the same path as load.
+         */
+        static bool probeMapped(const fs::path& path, ImageHeaderInfo& info)
+        {
+            cv::Mat img = MappedImage::load(path);
+            info.width = img.cols;
+            info.height = img.rows;
+            info.depth = img.depth();
+            info.channels = img.channels();
+            info.pageCount = 1;
+            return true;
+        }
+
+        bool probeFile(const fs::path& path, const std::string& inputExt, int page, ImageHeaderInfo& info)
+        {
+            string ext = getNormalizedExt(inputExt);
+            info = ImageHeaderInfo();
+
+            try
+            {
+                if (TiffUtil::checkIsTiffExtension(ext))
+                {
+                    return probeTiff(path, page, info);
+                }
+                else if (MappedImage::checkIsMappedExtension(ext))
+                {
+                    return probeMapped(path, info);
+                }
+
+                std::ifstream f(path, std::ios::binary);
+
+                if (!f)
+                {
+                    return false;
+                }
+
+                if (ext == "png")
+                {
+                    return probePng(f, info);
+                }
+                else if ((ext == "jpg") || (ext == "jpeg"))
+                {
+                    return probeJpeg(f, info);
+                }
+            }
+            catch (std::exception&)
+            {
+                info = ImageHeaderInfo();
+            }
+
+            return false;
+        }
+
+        bool probeBuffer(const uint8_t* data, size_t size, const std::string& inputExt, ImageHeaderInfo& info)
+        {
+            string ext = getNormalizedExt(inputExt);
+            info = ImageHeaderInfo();
+            std::istringstream f(string((const char*)data, size), std::ios::binary);
+
+            if (ext == "png")
+            {
+                return probePng(f, info);
+            }
+            else if ((ext == "jpg") || (ext == "jpeg"))
+            {
+                return probeJpeg(f, info);
+            }
+
+            return false;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <cstdint>
+#include <string>
+#include <filesystem>
+#include <opencv2/opencv.hpp>
+
+namespace Wxiv
+{
+    /**
+     * @brief What an image file will decode to, read from just its header (TIFF IFD, PNG IHDR, JPEG SOF, NPY/raw header)
+     * without decoding any pixels. This describes the cv::Mat that loading the file gives, so e.g. a palette PNG is 3
+     * channels.
+     */
+    struct ImageHeaderInfo
+    {
+        int width = 0;
+        int height = 0;
+        int depth = -1; // e.g. CV_16U
+        int channels = 0;
+        int pageCount = 0;
+
+        bool empty()
+        {
+            return width <= 0;
+        }
+    };
+
+    namespace ImageHeader
+    {
+        /**
+         * @brief Read the header of this page of the file.
+         * @return False if the format isn't one we can probe, or the file is bad.
+         */
+        bool probeFile(const std::filesystem::path& path, const std::string& ext, int page, ImageHeaderInfo& info);
+
+        /**
+         * @brief Like probeFile, but for the start of a file's bytes in memory, e.g. an archive member. Only png and jpg,
+         * since the other formats are read through functions that take a path.
+         */
+        bool probeBuffer(const uint8_t* data, size_t size, const std::string& ext, ImageHeaderInfo& info);
+    }
+}
@@ -0,0 +1,156 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+
+#include "ImagePyramid.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    // images smaller than this just reduce the full-res roi on render
+    static const int64_t PyramidMinPixelCount = (int64_t)2048 * 2048;
+
+    // stop halving once the level fits in this
+    static const int PyramidMinDim = 256;
+
+    ImagePyramid::ImagePyramid(const cv::Mat& base) : base(base)
+    {
+        this->levels.push_back(base);
+    }
+
+    ImagePyramid::~ImagePyramid()
+    {
+        this->isCancelled = true;
+
+        if (this->buildThread.joinable())
+        {
+            this->buildThread.join();
+        }
+    }
+
+    bool ImagePyramid::checkShouldBuild(const cv::Mat& img)
+    {
+        int depth = img.depth();
+
+        // INTER_AREA doesn't do 32S
+        bool isTypeOk = (depth == CV_8U) || (depth == CV_16U) || (depth == CV_16S) || (depth == CV_32F) || (depth == CV_64F);
+        return isTypeOk && ((int64_t)img.total() >= PyramidMinPixelCount);
+    }
+
+    void ImagePyramid::build()
+    {
+        if (this->isBuilt)
+        {
+            return;
+        }
+
+        vector<cv::Mat> newLevels;
+        newLevels.push_back(this->base);
+
+        while (std::max(newLevels.back().cols, newLevels.back().rows) > PyramidMinDim)
+        {
+            if (this->isCancelled)
+            {
+                return;
+            }
+
+            const cv::Mat& prev = newLevels.back();
+            cv::Mat level;
+            cv::resize(prev, level, cv::Size((prev.cols + 1) / 2, (prev.rows + 1) / 2), 0, 0, cv::INTER_AREA);
+            newLevels.push_back(level);
+        }
+
+        const std::lock_guard<std::mutex> lock(this->mutex);
+
+        if (!this->isBuilt)
+        {
+            this->levels = std::move(newLevels);
+
+            // readers check this before touching levels
+            this->isBuilt = true;
+
+            if (this->builtCallback)
+            {
+                this->builtCallback();
+            }
+        }
+    }
+
+    void ImagePyramid::requestBuild()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+
+        if (!this->isBuildStarted && !this->isBuilt)
+        {
+            this->isBuildStarted = true;
+            this->buildThread = std::thread([this]() { this->build(); });
+        }
+    }
+
+    void ImagePyramid::setBuiltCallback(const std::function<void()>& f)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        this->builtCallback = f;
+    }
+
+    bool ImagePyramid::getIsBuilt()
+    {
+        return this->isBuilt;
+    }
+
+    int ImagePyramid::getLevelCount()
+    {
+        return this->isBuilt ? (int)this->levels.size() : 1;
+    }
+
+    cv::Mat ImagePyramid::getLevel(int level)
+    {
+        return (this->isBuilt && (level > 0)) ? this->levels[level] : this->base;
+    }
+
+    cv::Point2f ImagePyramid::getLevelScale(int level)
+    {
+        cv::Mat levelImage = getLevel(level);
+        return cv::Point2f((float)this->base.cols / levelImage.cols, (float)this->base.rows / levelImage.rows);
+    }
+
+    int ImagePyramid::selectLevel(float zoom)
+    {
+        int best = 0;
+
+        if (this->isBuilt && (zoom > 0.0f))
+        {
+            float maxScale = 1.0f / zoom;
+
+            for (int i = 1; i < this->levels.size(); i++)
+            {
+                cv::Point2f scale = getLevelScale(i);
+
+                if (std::max(scale.x, scale.y) <= maxScale * 1.001f)
+                {
+                    best = i;
+                }
+            }
+        }
+
+        return best;
+    }
+
+    size_t ImagePyramid::getMemoryBytes()
+    {
+        size_t bytes = 0;
+
+        if (this->isBuilt)
+        {
+            for (int i = 1; i < this->levels.size(); i++)
+            {
+                bytes += this->levels[i].total() * this->levels[i].elemSize();
+            }
+        }
+
+        return bytes;
+    }
+}
@@ -0,0 +1,82 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <opencv2/opencv.hpp>
+
+namespace Wxiv
+{
+    /**
+     * @brief Mipmap levels of an image, each half the size of the last, for rendering zoomed-out views from a small image
+     * instead of reducing the full-resolution pixels on every render.
+     *
+     * Level 0 is the image itself (not a copy). The other levels are built once, either synchronously or on a
+     * background thread, and are immutable after that, so once getIsBuilt() is true they can be read from any thread
+     * without locking. Until then only level 0 is available. A viewer can set a callback to hear when a background
+     * build is done, e.g. to re-render at the new level.
+     */
+    class ImagePyramid
+    {
+      private:
+        cv::Mat base;
+        std::vector<cv::Mat> levels; // level 0 is base
+        std::atomic<bool> isBuilt = false;
+        std::atomic<bool> isCancelled = false;
+        bool isBuildStarted = false;
+        std::thread buildThread;
+        std::function<void()> builtCallback;
+        std::mutex mutex;
+
+      public:
+        ImagePyramid(const cv::Mat& base);
+        ~ImagePyramid();
+
+        ImagePyramid(const ImagePyramid&) = delete;
+        ImagePyramid& operator=(const ImagePyramid&) = delete;
+
+        /**
+         * @brief Whether a pyramid is worth it for this image (big enough, and a type cv::resize can area-reduce).
+         */
+        static bool checkShouldBuild(const cv::Mat& img);
+
+        /**
+         * @brief Build the levels on this thread, if not already built.
+         */
+        void build();
+
+        /**
+         * @brief Start building the levels on a background thread, if not already started.
+         */
+        void requestBuild();
+
+        /**
+         * @brief Called (on the building thread) when the build completes. This waits for a call in progress, so once
+         * it's been cleared (set to nullptr) the old callback is never called again.
+         */
+        void setBuiltCallback(const std::function<void()>& f);
+
+        bool getIsBuilt();
+        int getLevelCount();
+        cv::Mat getLevel(int level);
+
+        /**
+         * @brief Level 0 pixels per level pixel, in x and y, which differ a little since halving rounds up.
+         */
+        cv::Point2f getLevelScale(int level);
+
+        /**
+         * @brief The coarsest built level that still has at least as much resolution as the view.
+         * @param zoom View pixels per level 0 pixel.
+         */
+        int selectLevel(float zoom);
+
+        /**
+         * @brief Bytes of the reduced levels, not counting level 0.
+         */
+        size_t getMemoryBytes();
+    };
+}
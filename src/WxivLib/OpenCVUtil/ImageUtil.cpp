@@ -13,6 +13,8 @@
 #include "MiscUtil.h"
 #include "StringUtil.h"
 #include "MathUtil.h"
+#include "MappedImage.h"
+#include "RenderKernel.h"
 
 using namespace std;
 namespace fs = std::filesystem;
@@ -92,6 +94,13 @@ namespace Wxiv
         {
             initImageExtensions();
             string ext = getNormalizedExt(inputExt);
+
+            // these are loaded by mapping the file, not by opencv, and are not in the list because we can't save them
+            if (MappedImage::checkIsMappedExtension(ext))
+            {
+                return true;
+            }
+
             return std::find(allImageExtensions.begin(), allImageExtensions.end(), ext) != allImageExtensions.end();
         }
 
@@ -147,7 +156,7 @@ namespace Wxiv
         }
 
         /**
-         * @brief Convert to 8u via convertScaleAbs. Computes
+         * @brief Convert to 8u, saturating at both ends. 8U, 16U, and 16S images go through a table of every value.
          * @param img
          * @param dst
          * @param lowVal Optional. The pixel value in the image to pin to 0 in 8u. Default is to use min and max of image.
@@ -164,10 +173,29 @@ namespace Wxiv
             }
 
             // to 8-bit
-            float alpha = (float)(255.0 / (float)(highVal - lowVal));
-            float beta = -alpha * lowVal;
+            RenderKernel::RenderRange range = RenderKernel::RenderRange::fromLowHigh(lowVal, highVal);
+
+            if (RenderKernel::checkHasLevelTable(img.depth()))
+            {
+                // one table lookup per pixel, and the table is kept while the range is the same
+                thread_local int tableDepth = -1;
+                thread_local RenderKernel::RenderRange tableRange;
+                thread_local std::vector<uint8_t> table;
+
+                if ((img.depth() != tableDepth) || (range != tableRange))
+                {
+                    RenderKernel::buildLevelTable(img.depth(), range, table);
+                    tableDepth = img.depth();
+                    tableRange = range;
+                }
 
-            cv::convertScaleAbs(img, dst, alpha, beta);
+                RenderKernel::applyLevelTable(img, table, dst);
+            }
+            else
+            {
+                // saturate, same as the table
+                img.convertTo(dst, CV_8U, range.alpha, range.beta);
+            }
         }
 
         void imgToRgb(cv::Mat& img8u, uint8_t* dst)
@@ -500,10 +528,18 @@ namespace Wxiv
             {
                 return std::string("8U");
             }
+            else if (type == CV_8S)
+            {
+                return std::string("8S");
+            }
             else if (type == CV_32F)
             {
                 return std::string("32F");
             }
+            else if (type == CV_64F)
+            {
+                return std::string("64F");
+            }
             else if (type == CV_32S)
             {
                 return std::string("32S");
@@ -48,6 +48,7 @@ namespace Wxiv
         std::string getImageDescString(cv::Mat& img);
         std::string getPixelValueString(cv::Mat& img, cv::Point2i pt);
 
+        std::pair<float, float> imgMinMax(cv::Mat& img);
         void imgTo8u(cv::Mat& img, cv::Mat& dst, float lowVal = 0.0f, float highVal = 0.0f);
         void imgToRgb(cv::Mat& img8u, uint8_t* dst);
         ImageStats computeStats(cv::Mat& img);
@@ -0,0 +1,303 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <climits>
+#include <opencv2/opencv.hpp>
+
+#include "ImageVolume.h"
+#include "MappedImage.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    ImageVolume::ImageVolume(int depth, int rows, int cols, int type) : depth(depth), rows(rows), cols(cols), type(type)
+    {
+        if ((depth <= 0) || (rows <= 0) || (cols <= 0))
+        {
+            throw runtime_error("Volume dimensions must be positive.");
+        }
+
+        // one mat of depth * rows rows
+        if ((size_t)depth * rows > INT_MAX)
+        {
+            throw runtime_error("Volume has too many rows.");
+        }
+
+        this->voxels = std::make_shared<cv::Mat>(depth * rows, cols, type);
+    }
+
+    ImageVolume::~ImageVolume()
+    {
+        this->isStopping = true;
+
+        if (this->transposeThread.joinable())
+        {
+            this->transposeThread.join();
+        }
+    }
+
+    int ImageVolume::getDepth()
+    {
+        return this->depth;
+    }
+
+    int ImageVolume::getRows()
+    {
+        return this->rows;
+    }
+
+    int ImageVolume::getCols()
+    {
+        return this->cols;
+    }
+
+    int ImageVolume::getType()
+    {
+        return this->type;
+    }
+
+    size_t ImageVolume::getBytes()
+    {
+        return this->voxels->total() * this->voxels->elemSize();
+    }
+
+    void ImageVolume::setVoxelSpacing(double sliceSpacing, double rowSpacing, double colSpacing)
+    {
+        this->voxelSpacing = cv::Vec3d(sliceSpacing, rowSpacing, colSpacing);
+    }
+
+    cv::Vec3d ImageVolume::getVoxelSpacing()
+    {
+        return this->voxelSpacing;
+    }
+
+    void ImageVolume::setExtraBudgetBytes(size_t bytes)
+    {
+        const std::lock_guard<std::mutex> lock(this->transposeMutex);
+        this->extraBudgetBytes = bytes;
+
+        if (getBytes() > bytes)
+        {
+            this->transposedVoxels.reset();
+        }
+    }
+
+    bool ImageVolume::checkHasTransposedCopy()
+    {
+        const std::lock_guard<std::mutex> lock(this->transposeMutex);
+        return this->transposedVoxels != nullptr;
+    }
+
+    bool ImageVolume::checkIsTransposing()
+    {
+        const std::lock_guard<std::mutex> lock(this->transposeMutex);
+        return this->isTransposing;
+    }
+
+    size_t ImageVolume::getResidentBytes()
+    {
+        const std::lock_guard<std::mutex> lock(this->transposeMutex);
+        return this->transposedVoxels ? (2 * getBytes()) : getBytes();
+    }
+
+    cv::Mat ImageVolume::getStackedSlice(int index)
+    {
+        return this->voxels->rowRange(index * this->rows, (index + 1) * this->rows);
+    }
+
+    int ImageVolume::getSliceCount(VolumeAxis axis)
+    {
+        switch (axis)
+        {
+        case VolumeAxis::Axial:
+            return this->depth;
+        case VolumeAxis::Coronal:
+            return this->rows;
+        default:
+            return this->cols;
+        }
+    }
+
+    /**
+     * @brief On the transpose thread, make the transposed copy, and keep it if it still fits the budget.
+     */
+    void ImageVolume::buildTransposedCopy()
+    {
+        auto t = std::make_shared<cv::Mat>(this->cols * this->depth, this->rows, this->type);
+        size_t rowBytes = (size_t)this->rows * t->elemSize();
+
+        // each stacked slice is transposed in blocks by opencv, then its rows scattered to their sagittal slices
+        cv::parallel_for_(cv::Range(0, this->depth),
+            [&](const cv::Range& range)
+            {
+                cv::Mat slice;
+
+                for (int z = range.start; (z < range.end) && !this->isStopping; z++)
+                {
+                    cv::transpose(getStackedSlice(z), slice);
+
+                    for (int x = 0; x < this->cols; x++)
+                    {
+                        memcpy(t->ptr(x * this->depth + z), slice.ptr(x), rowBytes);
+                    }
+                }
+            });
+
+        const std::lock_guard<std::mutex> lock(this->transposeMutex);
+
+        if (!this->isStopping && (getBytes() <= this->extraBudgetBytes))
+        {
+            this->transposedVoxels = t;
+        }
+
+        this->isTransposing = false;
+    }
+
+    /**
+     * @brief From the transposed copy if there is one, else gathered, starting the copy if it can be made.
+     * @param isCopy Set to whether the slice is a new mat, not a view of the volume.
+     */
+    cv::Mat ImageVolume::getSagittalSlice(int col, bool& isCopy)
+    {
+        std::shared_ptr<cv::Mat> transposed;
+
+        {
+            const std::lock_guard<std::mutex> lock(this->transposeMutex);
+            bool canTranspose = (getBytes() <= this->extraBudgetBytes) && ((size_t)this->cols * this->depth <= INT_MAX);
+
+            if (!this->transposedVoxels && !this->isTransposing && canTranspose)
+            {
+                // a prior one finished, but didn't fit the budget by then
+                if (this->transposeThread.joinable())
+                {
+                    this->transposeThread.join();
+                }
+
+                this->isTransposing = true;
+                this->transposeThread = std::thread(&ImageVolume::buildTransposedCopy, this);
+            }
+
+            transposed = this->transposedVoxels;
+        }
+
+        if (transposed)
+        {
+            isCopy = false;
+            return MappedImage::wrapPixels(transposed, transposed->ptr(col * this->depth), this->depth, this->rows, this->type, transposed->step[0]);
+        }
+
+        cv::Mat dst(this->depth, this->rows, this->type);
+        size_t elemSize = dst.elemSize();
+
+        cv::parallel_for_(cv::Range(0, this->depth),
+            [&](const cv::Range& range)
+            {
+                for (int z = range.start; z < range.end; z++)
+                {
+                    uchar* d = dst.ptr(z);
+
+                    for (int y = 0; y < this->rows; y++)
+                    {
+                        memcpy(d + y * elemSize, this->voxels->ptr(z * this->rows + y) + col * elemSize, elemSize);
+                    }
+                }
+            });
+
+        isCopy = true;
+        return dst;
+    }
+
+    cv::Mat ImageVolume::getSlice(VolumeAxis axis, int index)
+    {
+        bool isCopy = false;
+        return getSlice(axis, index, isCopy);
+    }
+
+    cv::Mat ImageVolume::getSlice(VolumeAxis axis, int index, bool& isCopy)
+    {
+        if ((index < 0) || (index >= getSliceCount(axis)))
+        {
+            throw runtime_error("Volume slice index out of range.");
+        }
+
+        isCopy = false;
+
+        switch (axis)
+        {
+        case VolumeAxis::Axial:
+            return getStackedSlice(index);
+
+        case VolumeAxis::Coronal:
+            // the row from each stacked slice, one stacked slice apart
+            return MappedImage::wrapPixels(
+                this->voxels, this->voxels->ptr(index), this->depth, this->cols, this->type, this->voxels->step[0] * this->rows);
+
+        default:
+            return getSagittalSlice(index, isCopy);
+        }
+    }
+
+    cv::Mat ImageVolume::getDisplaySlice(VolumeAxis axis, int index)
+    {
+        bool isCopy = false;
+        cv::Mat slice = getSlice(axis, index, isCopy);
+
+        if (axis == VolumeAxis::Axial)
+        {
+            return slice;
+        }
+
+        // pixels are square if the slice spacing is the in-plane spacing along the slice's cols
+        double colSpacing = (axis == VolumeAxis::Coronal) ? this->voxelSpacing[2] : this->voxelSpacing[1];
+        double ratio = (colSpacing > 0) ? this->voxelSpacing[0] / colSpacing : 1.0;
+        int height = std::max(1, (int)std::lround(slice.rows * ratio));
+        bool doResize = std::abs(height - slice.rows) > slice.rows / 100;
+        bool doFlip = slice.rows > 1;
+        cv::Mat display;
+
+        // a vertical flip and a resize commute, so resize first and then flip that in place, for just the one copy
+        if (doResize)
+        {
+            cv::resize(slice, display, cv::Size(slice.cols, height), 0, 0, cv::INTER_LINEAR);
+            isCopy = true;
+        }
+        else
+        {
+            display = slice;
+        }
+
+        if (doFlip)
+        {
+            if (isCopy)
+            {
+                cv::flip(display, display, 0);
+            }
+            else
+            {
+                // a view of the volume, which mustn't be modified
+                cv::Mat flipped;
+                cv::flip(slice, flipped, 0);
+                display = flipped;
+            }
+        }
+
+        return display;
+    }
+
+    std::string ImageVolume::getAxisName(VolumeAxis axis)
+    {
+        switch (axis)
+        {
+        case VolumeAxis::Axial:
+            return "axial";
+        case VolumeAxis::Coronal:
+            return "coronal";
+        default:
+            return "sagittal";
+        }
+    }
+}
@@ -0,0 +1,110 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <opencv2/opencv.hpp>
+
+namespace Wxiv
+{
+    enum class VolumeAxis
+    {
+        Axial,    // slices as stacked, rows x cols
+        Coronal,  // fixed row, depth x cols
+        Sagittal, // fixed col, depth x rows
+    };
+
+    /**
+     * @brief A stack of same-size, same-type 2D slices in one contiguous buffer, that can be viewed as slices along any
+     * of the three axes (orthogonal multi-planar reslicing).
+     *
+     * Axial slices are just the stacked slices, and coronal slices are a strided view of the buffer (each row is a
+     * contiguous row of one stacked slice), so neither is copied. A sagittal slice gathers one column from every row of
+     * every stacked slice, which touches a cache line per pixel, so if the extra budget allows, a transposed copy of the
+     * whole volume is made (by blocked transposes of each stacked slice, in parallel) in the background the first time
+     * one is asked for. Sagittal slices are gathered until it's ready, and then are zero-copy views of it.
+     *
+     * The returned slices hold a reference to the buffer, so they stay valid after the volume is destroyed.
+     */
+    class ImageVolume
+    {
+      private:
+        int depth = 0;
+        int rows = 0;
+        int cols = 0;
+        int type = 0;
+        cv::Vec3d voxelSpacing = cv::Vec3d(1, 1, 1); // between slices, rows, cols
+
+        // depth * rows rows of cols
+        std::shared_ptr<cv::Mat> voxels;
+
+        // cols * depth rows of rows, so the sagittal slice for col x is the x'th depth rows
+        std::shared_ptr<cv::Mat> transposedVoxels;
+        size_t extraBudgetBytes = 0;
+        std::mutex transposeMutex;
+        std::thread transposeThread;
+        bool isTransposing = false;
+        std::atomic<bool> isStopping = false;
+
+        void buildTransposedCopy();
+        cv::Mat getSagittalSlice(int col, bool& isCopy);
+        cv::Mat getSlice(VolumeAxis axis, int index, bool& isCopy);
+
+      public:
+        ImageVolume(int depth, int rows, int cols, int type);
+        ~ImageVolume();
+
+        ImageVolume(const ImageVolume&) = delete;
+        ImageVolume& operator=(const ImageVolume&) = delete;
+
+        int getDepth();
+        int getRows();
+        int getCols();
+        int getType();
+        size_t getBytes();
+
+        /**
+         * @brief Spacing between slices, rows, and cols, e.g. in mm.
+         */
+        void setVoxelSpacing(double sliceSpacing, double rowSpacing, double colSpacing);
+        cv::Vec3d getVoxelSpacing();
+
+        /**
+         * @brief Memory this may use beyond the voxels, for the transposed copy. If there's already a copy and it no
+         * longer fits, it's dropped (slices already cut from it keep it until they're gone), and likewise for one still
+         * being made when it's done.
+         */
+        void setExtraBudgetBytes(size_t bytes);
+        bool checkHasTransposedCopy();
+        bool checkIsTransposing();
+
+        /**
+         * @brief The voxels plus the transposed copy, if there is one.
+         */
+        size_t getResidentBytes();
+
+        /**
+         * @brief For filling the volume, a view of one stacked slice.
+         */
+        cv::Mat getStackedSlice(int index);
+
+        int getSliceCount(VolumeAxis axis);
+
+        /**
+         * @brief A slice along the axis, as voxels (so with the spacing of the volume, not square pixels for coronal and
+         * sagittal), zero-copy where possible. Don't modify it.
+         */
+        cv::Mat getSlice(VolumeAxis axis, int index);
+
+        /**
+         * @brief A slice to display: for coronal and sagittal, flipped so the last stacked slice is at the top, and
+         * stretched vertically if needed so pixels are square. At most one copy is made, none if it's already as is.
+         */
+        cv::Mat getDisplaySlice(VolumeAxis axis, int index);
+
+        static std::string getAxisName(VolumeAxis axis);
+    };
+}
@@ -0,0 +1,360 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <vector>
+#include <cstring>
+#include <climits>
+#include <stdexcept>
+#include <opencv2/opencv.hpp>
+#include <fmt/core.h>
+
+#include "MappedImage.h"
+#include "StringUtil.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace Wxiv
+{
+    namespace MappedImage
+    {
+        /**
+         * @brief Allocator that owns a reference to the mapping (file or shared memory), so a cv::Mat (and every copy or
+         * ROI of it) keeps the mapping alive and the last one to go unmaps it. Any new allocation (e.g. create() to a
+         * different size) is just passed to the standard allocator.
+         */
+        class MappedMatAllocator : public cv::MatAllocator
+        {
+          public:
+            cv::UMatData* allocate(
+                int dims, const int* sizes, int type, void* data, size_t* step, cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override
+            {
+                return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+            }
+
+            bool allocate(cv::UMatData* u, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override
+            {
+                return cv::Mat::getStdAllocator()->allocate(u, accessFlags, usageFlags);
+            }
+
+            void deallocate(cv::UMatData* u) const override
+            {
+                if (u)
+                {
+                    delete static_cast<std::shared_ptr<void>*>(u->userdata);
+                    delete u;
+                }
+            }
+        };
+
+        static MappedMatAllocator mappedMatAllocator;
+
+        bool checkIsMappedExtension(const std::string& inputExt)
+        {
+            string ext = getNormalizedExt(inputExt);
+            return (ext == "npy") || (ext == "raw");
+        }
+
+        static void checkRange(std::shared_ptr<MappedFile> file, size_t offset, size_t size)
+        {
+            if ((offset > file->getSize()) || (size > file->getSize() - offset))
+            {
+                throw runtime_error("Image byte range is outside the file.");
+            }
+        }
+
+        /**
+         * @brief Pixels at this offset have to be within size bytes. The sizes come from the file header, so this divides
+         * instead of multiplying out, which a huge step or row count could overflow.
+         */
+        static void checkPixelsFit(size_t pixelOffset, int rows, int cols, int type, size_t step, size_t size)
+        {
+            size_t rowBytes = (size_t)cols * CV_ELEM_SIZE(type);
+
+            if ((rows <= 0) || (cols <= 0) || (step < rowBytes) || (pixelOffset > size) || (rowBytes > size - pixelOffset) ||
+                ((size_t)(rows - 1) > (size - pixelOffset - rowBytes) / step))
+            {
+                throw runtime_error("Image dimensions do not fit in the file.");
+            }
+        }
+
+        /**
+         * @brief Wrap part of the mapping in a cv::Mat that holds a reference to the mapping.
+         */
+        cv::Mat wrapMappedPixels(std::shared_ptr<MappedFile> file, size_t offset, int rows, int cols, int type, size_t step)
+        {
+            checkPixelsFit(offset, rows, cols, type, step, file->getSize());
+            return wrapPixels(file, file->getData() + offset, rows, cols, type, step);
+        }
+
+        /**
+         * @brief Wrap pixels that are in memory kept alive by the owner, in a cv::Mat that holds a reference to the owner.
+         */
+        cv::Mat wrapPixels(std::shared_ptr<void> owner, uchar* p, int rows, int cols, int type, size_t step)
+        {
+            cv::Mat img(rows, cols, type, p, step);
+
+            cv::UMatData* u = new cv::UMatData(&mappedMatAllocator);
+            u->data = u->origdata = p;
+            u->size = step * rows;
+            u->refcount = 1;
+            u->userdata = new std::shared_ptr<void>(owner);
+
+            img.u = u;
+            img.allocator = &mappedMatAllocator;
+            return img;
+        }
+
+        /**
+         * @brief Get the value text for a key in the npy header dict, e.g. for 'descr' get '<f4'.
+         */
+        static string getNpyHeaderValue(const string& header, const string& key)
+        {
+            size_t keyPos = header.find("'" + key + "'");
+
+            if (keyPos == string::npos)
+            {
+                throw runtime_error(fmt::format("NPY header is missing {}.", key));
+            }
+
+            size_t start = header.find(':', keyPos);
+
+            if (start == string::npos)
+            {
+                throw runtime_error("Failed to parse NPY header.");
+            }
+
+            start = header.find_first_not_of(' ', start + 1);
+
+            if (start == string::npos)
+            {
+                throw runtime_error("Failed to parse NPY header.");
+            }
+
+            size_t end = (header[start] == '(') ? header.find(')', start) : header.find_first_of(",}", start);
+
+            if ((end == string::npos) || (end <= start))
+            {
+                throw runtime_error("Failed to parse NPY header.");
+            }
+
+            if (header[start] == '(')
+            {
+                end++;
+            }
+
+            string value = header.substr(start, end - start);
+
+            // strip quotes
+            if ((value.size() >= 2) && (value.front() == '\'') && (value.back() == '\''))
+            {
+                value = value.substr(1, value.size() - 2);
+            }
+
+            return value;
+        }
+
+        /**
+         * @brief A shape dimension, which has to fit in an int like cv::Mat dims.
+         */
+        static int parseNpyDim(const string& s)
+        {
+            try
+            {
+                size_t parsedCount = 0;
+                long long dim = std::stoll(s, &parsedCount);
+
+                if ((parsedCount == s.size()) && (dim >= 0) && (dim <= INT_MAX))
+                {
+                    return (int)dim;
+                }
+            }
+            catch (std::logic_error&)
+            {
+                // invalid_argument or out_of_range
+            }
+
+            throw runtime_error("NPY shape is not valid: " + s);
+        }
+
+        static int npyDescrToDepth(const string& descr)
+        {
+            if (descr.size() < 3)
+            {
+                throw runtime_error("Unsupported NPY dtype: " + descr);
+            }
+
+            if (descr[0] == '>')
+            {
+                throw runtime_error("Big-endian NPY files are not supported.");
+            }
+
+            string code = descr.substr(1);
+
+            if (code == "u1")
+                return CV_8U;
+            if (code == "i1")
+                return CV_8S;
+            if (code == "u2")
+                return CV_16U;
+            if (code == "i2")
+                return CV_16S;
+            if (code == "i4")
+                return CV_32S;
+            if (code == "f4")
+                return CV_32F;
+            if (code == "f8")
+                return CV_64F;
+
+            throw runtime_error("Unsupported NPY dtype: " + descr);
+        }
+
+        /**
+         * @brief NPY format versions 1 to 3, C order, shape (rows, cols) or (rows, cols, channels).
+         */
+        cv::Mat loadNpy(std::shared_ptr<MappedFile> file)
+        {
+            return loadNpy(file, 0, file->getSize());
+        }
+
+        /**
+         * @brief An npy file at this byte range of the mapped file, e.g. a stored member of an archive.
+         */
+        cv::Mat loadNpy(std::shared_ptr<MappedFile> file, size_t offset, size_t size)
+        {
+            checkRange(file, offset, size);
+            const uint8_t* p = file->getData() + offset;
+            size_t fileSize = size;
+
+            if ((fileSize < 10) || (memcmp(p, "\x93NUMPY", 6) != 0))
+            {
+                throw runtime_error("Not an NPY file.");
+            }
+
+            int majorVersion = p[6];
+            size_t headerLen;
+            size_t headerStart;
+
+            if (majorVersion == 1)
+            {
+                headerLen = (size_t)p[8] | ((size_t)p[9] << 8);
+                headerStart = 10;
+            }
+            else
+            {
+                if (fileSize < 12)
+                {
+                    throw runtime_error("Not an NPY file.");
+                }
+
+                headerLen = (size_t)p[8] | ((size_t)p[9] << 8) | ((size_t)p[10] << 16) | ((size_t)p[11] << 24);
+                headerStart = 12;
+            }
+
+            if (headerStart + headerLen > fileSize)
+            {
+                throw runtime_error("NPY header is truncated.");
+            }
+
+            string header((const char*)p + headerStart, headerLen);
+
+            if (getNpyHeaderValue(header, "fortran_order") != "False")
+            {
+                throw runtime_error("Fortran-order NPY files are not supported.");
+            }
+
+            int depth = npyDescrToDepth(getNpyHeaderValue(header, "descr"));
+
+            // shape like (512, 640) or (512, 640, 3)
+            string shapeStr = getNpyHeaderValue(header, "shape");
+            vector<int> shape;
+
+            for (const string& s : splitString(shapeStr.substr(1, shapeStr.size() - 2), ","))
+            {
+                string trimmed = s;
+                trimmed.erase(0, trimmed.find_first_not_of(' '));
+                trimmed.erase(trimmed.find_last_not_of(' ') + 1);
+
+                if (!trimmed.empty())
+                {
+                    shape.push_back(parseNpyDim(trimmed));
+                }
+            }
+
+            if ((shape.size() < 2) || (shape.size() > 3) || ((shape.size() == 3) && ((shape[2] < 1) || (shape[2] > 4))))
+            {
+                throw runtime_error("NPY shape must be (rows, cols) or (rows, cols, channels) with up to 4 channels.");
+            }
+
+            int channels = (shape.size() == 3) ? shape[2] : 1;
+            int type = CV_MAKETYPE(depth, channels);
+            size_t step = (size_t)shape[1] * CV_ELEM_SIZE(type);
+
+            checkPixelsFit(headerStart + headerLen, shape[0], shape[1], type, step, size);
+            return wrapMappedPixels(file, offset + headerStart + headerLen, shape[0], shape[1], type, step);
+        }
+
+        cv::Mat loadRaw(std::shared_ptr<MappedFile> file)
+        {
+            return loadRaw(file, 0, file->getSize());
+        }
+
+        cv::Mat loadRaw(std::shared_ptr<MappedFile> file, size_t offset, size_t size)
+        {
+            checkRange(file, offset, size);
+
+            if (size < sizeof(RawImageHeader))
+            {
+                throw runtime_error("Raw image file is too small for its header.");
+            }
+
+            RawImageHeader header;
+            memcpy(&header, file->getData() + offset, sizeof(header));
+
+            if (memcmp(header.magic, "WXIVRAW", 8) != 0)
+            {
+                throw runtime_error("Raw image file does not start with the WXIVRAW header.");
+            }
+
+            if ((header.headerSize < sizeof(RawImageHeader)) || (header.channels < 1) || (header.channels > 4) || (header.depth > CV_64F))
+            {
+                throw runtime_error("Raw image file header is not valid.");
+            }
+
+            int type = CV_MAKETYPE((int)header.depth, (int)header.channels);
+            size_t step = (header.rowStride != 0) ? (size_t)header.rowStride : (size_t)header.width * CV_ELEM_SIZE(type);
+
+            checkPixelsFit(header.headerSize, (int)header.height, (int)header.width, type, step, size);
+            return wrapMappedPixels(file, offset + header.headerSize, (int)header.height, (int)header.width, type, step);
+        }
+
+        /**
+         * @brief Map and wrap an npy or raw file. Throws on failure.
+         * @param doCopy Read the file into memory instead of mapping it, for files that may be rewritten while viewed.
+         */
+        cv::Mat load(const fs::path& path, bool doCopy)
+        {
+            std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path, doCopy);
+            return load(file, 0, file->getSize(), path.extension().string());
+        }
+
+        /**
+         * @brief Wrap an npy or raw image stored at this byte range of an already mapped file. Throws on failure.
+         */
+        cv::Mat load(std::shared_ptr<MappedFile> file, size_t offset, size_t size, const std::string& ext)
+        {
+            string normalizedExt = getNormalizedExt(ext);
+
+            if (normalizedExt == "npy")
+            {
+                return loadNpy(file, offset, size);
+            }
+            else if (normalizedExt == "raw")
+            {
+                return loadRaw(file, offset, size);
+            }
+
+            throw runtime_error("Not a memory-mappable image file type.");
+        }
+    }
+}
@@ -0,0 +1,49 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <filesystem>
+#include <opencv2/opencv.hpp>
+
+#include "MappedFile.h"
+
+namespace Wxiv
+{
+    /**
+     * @brief Header at the start of a .raw image file. All fields little-endian.
+     * Pixel data starts at headerSize bytes from the start of the file, rows are rowStride bytes apart.
+     */
+    struct RawImageHeader
+    {
+        char magic[8];        // "WXIVRAW" plus null
+        uint32_t headerSize;  // bytes, at least sizeof(RawImageHeader), 64 recommended for alignment
+        uint32_t width;       // pixels
+        uint32_t height;      // pixels
+        uint32_t channels;    // 1, 3 (BGR), or 4 (BGRA)
+        uint32_t depth;       // OpenCV depth code: 0=8U, 1=8S, 2=16U, 3=16S, 4=32S, 5=32F, 6=64F
+        uint32_t reserved;    // zero
+        uint64_t rowStride;   // bytes, or 0 for width * channels * bytes per channel
+    };
+
+    static_assert(sizeof(RawImageHeader) == 40, "RawImageHeader must be packed to 40 bytes");
+
+    /**
+     * @brief Images that are loaded by memory-mapping the file and wrapping the mapped pages in a cv::Mat, with no decode
+     * and no copy. The mapping lives as long as any cv::Mat referencing it. A file that may be rewritten while it's
+     * viewed should be loaded with doCopy, since reading a mapping of a truncated file faults.
+     */
+    namespace MappedImage
+    {
+        bool checkIsMappedExtension(const std::string& ext);
+        cv::Mat loadNpy(std::shared_ptr<MappedFile> file);
+        cv::Mat loadNpy(std::shared_ptr<MappedFile> file, size_t offset, size_t size);
+        cv::Mat loadRaw(std::shared_ptr<MappedFile> file);
+        cv::Mat loadRaw(std::shared_ptr<MappedFile> file, size_t offset, size_t size);
+        cv::Mat load(const std::filesystem::path& path, bool doCopy = false);
+        cv::Mat load(std::shared_ptr<MappedFile> file, size_t offset, size_t size, const std::string& ext);
+        cv::Mat wrapMappedPixels(std::shared_ptr<MappedFile> file, size_t offset, int rows, int cols, int type, size_t step);
+        cv::Mat wrapPixels(std::shared_ptr<void> owner, uchar* p, int rows, int cols, int type, size_t step);
+    }
+}
@@ -0,0 +1,668 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <type_traits>
+#include <opencv2/opencv.hpp>
+
+#include "RenderKernel.h"
+
+using namespace std;
+
+namespace Wxiv
+{
+    namespace RenderKernel
+    {
+        /**
+         * @brief Source column or row and its weight for area averaging, like cv::resize INTER_AREA computes them.
+         */
+        struct AreaWeight
+        {
+            int src = 0;
+            float weight = 0.0f;
+        };
+
+        /**
+         * @brief The area weights for each output column or row, where the weights for output i are entries[starts[i]]
+         * up to entries[starts[i + 1]].
+         */
+        struct AreaTable
+        {
+            vector<AreaWeight> entries;
+            vector<int> starts;
+        };
+
+        RenderRange RenderRange::fromLowHigh(float lowVal, float highVal)
+        {
+            RenderRange range;
+            range.alpha = (float)(255.0 / (float)(highVal - lowVal));
+            range.beta = -range.alpha * lowVal;
+            return range;
+        }
+
+        bool checkIsSupportedType(int type)
+        {
+            return (type == CV_8U) || (type == CV_16U) || (type == CV_16S) || (type == CV_32S) || (type == CV_32F) || (type == CV_8UC3) ||
+                (type == CV_8UC4);
+        }
+
+        cv::Size getZoomedSize(cv::Size srcSize, float zoom)
+        {
+            return cv::Size(cv::saturate_cast<int>(srcSize.width * (double)zoom), cv::saturate_cast<int>(srcSize.height * (double)zoom));
+        }
+
+        /**
+         * @brief Source index for each of dstSize outputs, like cv::resize INTER_NEAREST.
+         */
+        static vector<int> computeNearestMap(int srcSize, int dstSize, float zoom)
+        {
+            vector<int> map(dstSize);
+            double invZoom = 1.0 / zoom;
+
+            for (int i = 0; i < dstSize; i++)
+            {
+                map[i] = std::min(cvFloor(i * invZoom), srcSize - 1);
+            }
+
+            return map;
+        }
+
+        /**
+         * @brief The source pixels each output pixel covers and how much, like cv::resize INTER_AREA.
+         */
+        static AreaTable computeAreaTable(int srcSize, int dstSize, float zoom)
+        {
+            AreaTable table;
+            double scale = 1.0 / zoom;
+
+            for (int i = 0; i < dstSize; i++)
+            {
+                table.starts.push_back((int)table.entries.size());
+
+                double f1 = i * scale;
+                double f2 = f1 + scale;
+                double cellWidth = std::min(scale, srcSize - f1);
+                int s2 = std::min(cvFloor(f2), srcSize - 1);
+                int s1 = std::min(cvCeil(f1), s2);
+
+                if (s1 - f1 > 1e-3)
+                {
+                    table.entries.push_back({s1 - 1, (float)((s1 - f1) / cellWidth)});
+                }
+
+                for (int s = s1; s < s2; s++)
+                {
+                    table.entries.push_back({s, (float)(1.0 / cellWidth)});
+                }
+
+                if (f2 - s2 > 1e-3)
+                {
+                    table.entries.push_back({s2, (float)(std::min(std::min(f2 - s2, 1.0), cellWidth) / cellWidth)});
+                }
+            }
+
+            table.starts.push_back((int)table.entries.size());
+            return table;
+        }
+
+        /**
+         * @brief Range one source value to [0, 255], NaN to 0.
+         */
+        static inline float rangeValue(float v, float alpha, float beta)
+        {
+            float f = v * alpha + beta;
+            f = f > 0.0f ? f : 0.0f; // NaN fails the compare
+            return f < 255.0f ? f : 255.0f;
+        }
+
+        /**
+         * @brief Range n source values to 8 bits into buf, and return the ranged row (which may be src itself).
+         */
+        template <typename T> static const uint8_t* rangeRow(const T* src, int n, const RenderRange& range, uint8_t* buf)
+        {
+            float alpha = range.alpha;
+            float beta = range.beta;
+
+            for (int i = 0; i < n; i++)
+            {
+                buf[i] = (uint8_t)(int)(rangeValue((float)src[i], alpha, beta) + 0.5f);
+            }
+
+            return buf;
+        }
+
+        /**
+         * @brief 8-bit at identity range (color images, and gray with no ranging) is used as is.
+         */
+        template <> const uint8_t* rangeRow<uint8_t>(const uint8_t* src, int n, const RenderRange& range, uint8_t* buf)
+        {
+            if (range.checkIsIdentity())
+            {
+                return src;
+            }
+
+            float alpha = range.alpha;
+            float beta = range.beta;
+
+            for (int i = 0; i < n; i++)
+            {
+                buf[i] = (uint8_t)(int)(rangeValue((float)src[i], alpha, beta) + 0.5f);
+            }
+
+            return buf;
+        }
+
+        /**
+         * @brief Range n source values to [0, 255] but not rounded, for averaging.
+         */
+        template <typename T> static void rangeRowFloat(const T* src, int n, const RenderRange& range, float* buf)
+        {
+            float alpha = range.alpha;
+            float beta = range.beta;
+
+            for (int i = 0; i < n; i++)
+            {
+                buf[i] = rangeValue((float)src[i], alpha, beta);
+            }
+        }
+
+        const std::vector<std::pair<std::string, int>>& getColormaps()
+        {
+            static const std::vector<std::pair<std::string, int>> colormaps = {{"Gray", -1}, {"Viridis", cv::COLORMAP_VIRIDIS},
+                {"Inferno", cv::COLORMAP_INFERNO}, {"Magma", cv::COLORMAP_MAGMA}, {"Plasma", cv::COLORMAP_PLASMA}, {"Turbo", cv::COLORMAP_TURBO},
+                {"Jet", cv::COLORMAP_JET}, {"Hot", cv::COLORMAP_HOT}, {"Bone", cv::COLORMAP_BONE}};
+            return colormaps;
+        }
+
+        bool checkHasLevelTable(int depth)
+        {
+            return (depth == CV_8U) || (depth == CV_16U) || (depth == CV_16S);
+        }
+
+        int getLevelTableOffset(int depth)
+        {
+            return (depth == CV_16S) ? 32768 : 0;
+        }
+
+        void buildLevelTable(int depth, const RenderRange& range, std::vector<uint8_t>& table)
+        {
+            if (!checkHasLevelTable(depth))
+            {
+                throw std::runtime_error("No level table for this depth.");
+            }
+
+            int n = (depth == CV_8U) ? 256 : 65536;
+            int firstValue = -getLevelTableOffset(depth);
+            float alpha = range.alpha;
+            float beta = range.beta;
+            table.resize(n);
+
+            for (int i = 0; i < n; i++)
+            {
+                table[i] = (uint8_t)(int)(rangeValue((float)(firstValue + i), alpha, beta) + 0.5f);
+            }
+        }
+
+        template <typename T> static void applyLevelTable(const cv::Mat& src, const uint8_t* table, int offset, cv::Mat& dst)
+        {
+            int n = src.cols * src.channels();
+
+            cv::parallel_for_(cv::Range(0, src.rows),
+                [&](const cv::Range& rows)
+                {
+                    for (int y = rows.start; y < rows.end; y++)
+                    {
+                        const T* s = src.ptr<T>(y);
+                        uint8_t* d = dst.ptr<uint8_t>(y);
+
+                        for (int i = 0; i < n; i++)
+                        {
+                            d[i] = table[s[i] + offset];
+                        }
+                    }
+                });
+        }
+
+        void applyLevelTable(const cv::Mat& src, const std::vector<uint8_t>& table, cv::Mat& dst)
+        {
+            dst.create(src.size(), CV_MAKETYPE(CV_8U, src.channels()));
+
+            switch (src.depth())
+            {
+            case CV_8U:
+                cv::LUT(src, cv::Mat(1, 256, CV_8U, (void*)table.data()), dst);
+                break;
+            case CV_16U:
+                applyLevelTable<uint16_t>(src, table.data(), 0, dst);
+                break;
+            case CV_16S:
+                applyLevelTable<int16_t>(src, table.data(), 32768, dst);
+                break;
+            default:
+                throw std::runtime_error("No level table for this depth.");
+            }
+        }
+
+        /**
+         * @brief RGB for each ranged 8-bit value, through gamma and then the colormap.
+         */
+        void RenderLut::buildColors()
+        {
+            cv::Mat ramp(1, 256, CV_8U);
+
+            for (int i = 0; i < 256; i++)
+            {
+                ramp.at<uint8_t>(0, i) = cv::saturate_cast<uint8_t>(255.0 * pow(i / 255.0, (double)this->gamma));
+            }
+
+            this->colors.resize(256 * 3);
+
+            if (this->colormap < 0)
+            {
+                for (int i = 0; i < 256; i++)
+                {
+                    uint8_t v = ramp.at<uint8_t>(0, i);
+                    this->colors[i * 3] = v;
+                    this->colors[i * 3 + 1] = v;
+                    this->colors[i * 3 + 2] = v;
+                }
+            }
+            else
+            {
+                cv::Mat bgr;
+                cv::applyColorMap(ramp, bgr, this->colormap);
+
+                for (int i = 0; i < 256; i++)
+                {
+                    cv::Vec3b c = bgr.at<cv::Vec3b>(0, i);
+                    this->colors[i * 3] = c[2];
+                    this->colors[i * 3 + 1] = c[1];
+                    this->colors[i * 3 + 2] = c[0];
+                }
+            }
+        }
+
+        bool RenderLut::update(int depth, const RenderRange& range, float gamma, int colormap)
+        {
+            bool isLevelsChanged = !this->isValid || (depth != this->depth) || (range != this->range);
+            bool isColorsChanged = !this->isValid || (gamma != this->gamma) || (colormap != this->colormap);
+
+            if (!isLevelsChanged && !isColorsChanged)
+            {
+                return false;
+            }
+
+            this->depth = depth;
+            this->range = range;
+            this->gamma = gamma;
+            this->colormap = colormap;
+
+            if (isColorsChanged)
+            {
+                buildColors();
+            }
+
+            if (checkHasLevelTable(depth))
+            {
+                if (isLevelsChanged)
+                {
+                    buildLevelTable(depth, range, this->levels);
+                }
+
+                // fold the colors into one table from source value to pixel
+                int n = (int)this->levels.size();
+                this->values.resize(n * 4);
+
+                for (int i = 0; i < n; i++)
+                {
+                    const uint8_t* c = this->colors.data() + this->levels[i] * 3;
+                    uint8_t* v = this->values.data() + i * 4;
+                    v[0] = c[0];
+                    v[1] = c[1];
+                    v[2] = c[2];
+                    v[3] = 0;
+                }
+            }
+            else
+            {
+                this->levels.clear();
+                this->values.clear();
+            }
+
+            this->isValid = true;
+            this->buildCount++;
+            return true;
+        }
+
+        bool RenderLut::checkIsBuiltFor(int depth) const
+        {
+            return this->isValid && (depth == this->depth);
+        }
+
+        const RenderRange& RenderLut::getRange() const
+        {
+            return this->range;
+        }
+
+        const uint8_t* RenderLut::getColors() const
+        {
+            return this->colors.data();
+        }
+
+        const uint8_t* RenderLut::getValues() const
+        {
+            return this->values.empty() ? nullptr : this->values.data();
+        }
+
+        const uint8_t* RenderLut::getLevels() const
+        {
+            return this->levels.empty() ? nullptr : this->levels.data();
+        }
+
+        int RenderLut::getValueOffset() const
+        {
+            return getLevelTableOffset(this->depth);
+        }
+
+        int RenderLut::getBuildCount() const
+        {
+            return this->buildCount;
+        }
+
+        /**
+         * @brief One BGR or BGRA source pixel to one RGB pixel.
+         */
+        static inline void writeRgb(const uint8_t* p, uint8_t* d)
+        {
+            d[0] = p[2];
+            d[1] = p[1];
+            d[2] = p[0];
+        }
+
+        /**
+         * @brief Fill a row from x to the end with background.
+         */
+        static inline void fillRow(uint8_t* d, int x, int cols, uint8_t background)
+        {
+            if (x < cols)
+            {
+                memset(d + x * 3, background, (cols - x) * 3);
+            }
+        }
+
+        /**
+         * @brief Gray types ranged through a table of every value, see RenderLut.
+         */
+        template <typename T>
+        static constexpr bool hasLevelTable = std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t> || std::is_same_v<T, int16_t>;
+
+        /**
+         * @brief Zoomed in (or 1:1): each output pixel is one source pixel.
+         */
+        template <typename T, int CN>
+        static void renderNearest(const cv::Mat& src, const vector<int>& colMap, const vector<int>& rowMap, const RenderLut& lut, uint8_t background,
+            cv::Mat& dst, const cv::Range& rows)
+        {
+            int width = (int)colMap.size();
+            int height = (int)rowMap.size();
+            int n = (width > 0) ? (colMap[width - 1] + 1) * CN : 0; // source values per row that are used
+            vector<uint8_t> buf(n);
+            vector<uint8_t> rgbBuf((CN == 1) ? n * 3 : 0);
+            RenderRange identity;
+            int lastSrcRow = -1;
+
+            for (int y = rows.start; y < rows.end; y++)
+            {
+                uint8_t* d = dst.ptr<uint8_t>(y);
+
+                if (y >= height)
+                {
+                    fillRow(d, 0, dst.cols, background);
+                    continue;
+                }
+
+                int srcRow = rowMap[y];
+
+                if (srcRow == lastSrcRow)
+                {
+                    memcpy(d, dst.ptr<uint8_t>(y - 1), dst.cols * 3);
+                    continue;
+                }
+
+                if constexpr (CN == 1)
+                {
+                    // source row to RGB, once per source pixel, and at 1:1 (when the column map is identity) that's the
+                    // output row
+                    uint8_t* rgb = (n == width) ? d : rgbBuf.data();
+
+                    if constexpr (hasLevelTable<T>)
+                    {
+                        // straight from source value to pixel
+                        const T* s = src.ptr<T>(srcRow);
+                        const uint8_t* values = lut.getValues() + lut.getValueOffset() * 4;
+
+                        for (int i = 0; i < n; i++)
+                        {
+                            const uint8_t* p = values + s[i] * 4;
+                            rgb[i * 3] = p[0];
+                            rgb[i * 3 + 1] = p[1];
+                            rgb[i * 3 + 2] = p[2];
+                        }
+                    }
+                    else
+                    {
+                        const uint8_t* s = rangeRow<T>(src.ptr<T>(srcRow), n, lut.getRange(), buf.data());
+                        const uint8_t* colors = lut.getColors();
+
+                        for (int i = 0; i < n; i++)
+                        {
+                            const uint8_t* p = colors + s[i] * 3;
+                            rgb[i * 3] = p[0];
+                            rgb[i * 3 + 1] = p[1];
+                            rgb[i * 3 + 2] = p[2];
+                        }
+                    }
+
+                    if (rgb != d)
+                    {
+                        for (int x = 0; x < width; x++)
+                        {
+                            const uint8_t* p = rgb + colMap[x] * 3;
+                            d[x * 3] = p[0];
+                            d[x * 3 + 1] = p[1];
+                            d[x * 3 + 2] = p[2];
+                        }
+                    }
+                }
+                else
+                {
+                    const uint8_t* s = rangeRow<T>(src.ptr<T>(srcRow), n, identity, buf.data());
+
+                    for (int x = 0; x < width; x++)
+                    {
+                        writeRgb(s + colMap[x] * CN, d + x * 3);
+                    }
+                }
+
+                fillRow(d, width, dst.cols, background);
+                lastSrcRow = srcRow;
+            }
+        }
+
+        /**
+         * @brief Zoomed out: each output pixel is the area-weighted average of the ranged source pixels it covers (and gray
+         * is then mapped through the color table).
+         */
+        template <typename T, int CN>
+        static void renderArea(const cv::Mat& src, const AreaTable& colTable, const AreaTable& rowTable, const RenderLut& lut, uint8_t background,
+            cv::Mat& dst, const cv::Range& rows)
+        {
+            int width = (int)colTable.starts.size() - 1;
+            int height = (int)rowTable.starts.size() - 1;
+            int n = colTable.entries.empty() ? 0 : (colTable.entries.back().src + 1) * CN;
+            vector<float> ranged(n);
+            vector<float> sums(width * CN);
+            vector<uint8_t> pixels(width * CN);
+            RenderRange identity;
+
+            for (int y = rows.start; y < rows.end; y++)
+            {
+                uint8_t* d = dst.ptr<uint8_t>(y);
+
+                if (y >= height)
+                {
+                    fillRow(d, 0, dst.cols, background);
+                    continue;
+                }
+
+                std::fill(sums.begin(), sums.end(), 0.0f);
+
+                for (int r = rowTable.starts[y]; r < rowTable.starts[y + 1]; r++)
+                {
+                    const AreaWeight& rowWeight = rowTable.entries[r];
+                    const T* s = src.ptr<T>(rowWeight.src);
+
+                    if constexpr ((CN == 1) && hasLevelTable<T>)
+                    {
+                        const uint8_t* levels = lut.getLevels() + lut.getValueOffset();
+
+                        for (int i = 0; i < n; i++)
+                        {
+                            ranged[i] = levels[s[i]];
+                        }
+                    }
+                    else
+                    {
+                        rangeRowFloat<T>(s, n, (CN == 1) ? lut.getRange() : identity, ranged.data());
+                    }
+
+                    for (int x = 0; x < width; x++)
+                    {
+                        float* sum = sums.data() + x * CN;
+
+                        for (int e = colTable.starts[x]; e < colTable.starts[x + 1]; e++)
+                        {
+                            const AreaWeight& colWeight = colTable.entries[e];
+                            float w = rowWeight.weight * colWeight.weight;
+                            const float* p = ranged.data() + colWeight.src * CN;
+
+                            for (int c = 0; c < CN; c++)
+                            {
+                                sum[c] += w * p[c];
+                            }
+                        }
+                    }
+                }
+
+                for (int i = 0; i < width * CN; i++)
+                {
+                    pixels[i] = (uint8_t)(int)(std::min(sums[i], 255.0f) + 0.5f);
+                }
+
+                if constexpr (CN == 1)
+                {
+                    const uint8_t* colors = lut.getColors();
+
+                    for (int x = 0; x < width; x++)
+                    {
+                        const uint8_t* p = colors + pixels[x] * 3;
+                        d[x * 3] = p[0];
+                        d[x * 3 + 1] = p[1];
+                        d[x * 3 + 2] = p[2];
+                    }
+                }
+                else
+                {
+                    for (int x = 0; x < width; x++)
+                    {
+                        writeRgb(pixels.data() + x * CN, d + x * 3);
+                    }
+                }
+
+                fillRow(d, width, dst.cols, background);
+            }
+        }
+
+        template <typename T, int CN>
+        static void render(const cv::Mat& src, cv::Point2f zoom, cv::Size renderSize, const RenderLut& lut, uint8_t background, cv::Mat& dst)
+        {
+            if ((zoom.x < 1.0f) || (zoom.y < 1.0f))
+            {
+                AreaTable colTable = computeAreaTable(src.cols, renderSize.width, zoom.x);
+                AreaTable rowTable = computeAreaTable(src.rows, renderSize.height, zoom.y);
+                cv::parallel_for_(cv::Range(0, dst.rows),
+                    [&](const cv::Range& rows) { renderArea<T, CN>(src, colTable, rowTable, lut, background, dst, rows); });
+            }
+            else
+            {
+                vector<int> colMap = computeNearestMap(src.cols, renderSize.width, zoom.x);
+                vector<int> rowMap = computeNearestMap(src.rows, renderSize.height, zoom.y);
+                cv::parallel_for_(cv::Range(0, dst.rows),
+                    [&](const cv::Range& rows) { renderNearest<T, CN>(src, colMap, rowMap, lut, background, dst, rows); });
+            }
+        }
+
+        void renderToRgb(const cv::Mat& src, float zoom, cv::Size renderSize, const RenderLut& lut, uint8_t background, cv::Mat& dstRgb)
+        {
+            renderToRgb(src, cv::Point2f(zoom, zoom), renderSize, lut, background, dstRgb);
+        }
+
+        void renderToRgb(const cv::Mat& src, cv::Point2f zoom, cv::Size renderSize, const RenderLut& lut, uint8_t background, cv::Mat& dstRgb)
+        {
+            if (dstRgb.type() != CV_8UC3)
+            {
+                throw std::runtime_error("Render destination must be 8UC3.");
+            }
+
+            if ((src.channels() == 1) && !lut.checkIsBuiltFor(src.depth()))
+            {
+                throw std::runtime_error("Render table was not updated for this image depth.");
+            }
+
+            cv::Size zoomedSize(getZoomedSize(src.size(), zoom.x).width, getZoomedSize(src.size(), zoom.y).height);
+            renderSize.width = std::max(0, std::min({renderSize.width, zoomedSize.width, dstRgb.cols}));
+            renderSize.height = std::max(0, std::min({renderSize.height, zoomedSize.height, dstRgb.rows}));
+
+            if (src.empty() || (zoom.x <= 0.0f) || (zoom.y <= 0.0f))
+            {
+                renderSize = cv::Size();
+            }
+
+            switch (src.type())
+            {
+            case CV_8U:
+                render<uint8_t, 1>(src, zoom, renderSize, lut, background, dstRgb);
+                break;
+            case CV_16U:
+                render<uint16_t, 1>(src, zoom, renderSize, lut, background, dstRgb);
+                break;
+            case CV_16S:
+                render<int16_t, 1>(src, zoom, renderSize, lut, background, dstRgb);
+                break;
+            case CV_32S:
+                render<int32_t, 1>(src, zoom, renderSize, lut, background, dstRgb);
+                break;
+            case CV_32F:
+                render<float, 1>(src, zoom, renderSize, lut, background, dstRgb);
+                break;
+            case CV_8UC3:
+                render<uint8_t, 3>(src, zoom, renderSize, lut, background, dstRgb);
+                break;
+            case CV_8UC4:
+                render<uint8_t, 4>(src, zoom, renderSize, lut, background, dstRgb);
+                break;
+            default:
+                throw std::runtime_error("Unsupported image type for render.");
+            }
+        }
+
+        void renderToRgb(const cv::Mat& src, float zoom, cv::Size renderSize, const RenderRange& range, uint8_t background, cv::Mat& dstRgb)
+        {
+            RenderLut lut;
+            lut.update(src.depth(), range);
+            renderToRgb(src, zoom, renderSize, lut, background, dstRgb);
+        }
+    }
+}
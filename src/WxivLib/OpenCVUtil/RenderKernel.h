@@ -0,0 +1,146 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+#include <opencv2/opencv.hpp>
+
+namespace Wxiv
+{
+    /**
+     * @brief Render an image ROI straight into an RGB display buffer (like a wxImage's data) in one pass.
+     *
+     * This is what used to be intensity ranging to 8 bits (convertScaleAbs), then resize, then a copy into a
+     * background-filled image, then a gray to RGB cvtColor, each a full-frame pass with its own buffer. Here each output
+     * row is made in one go: the source rows it needs are ranged into a small row buffer (once per source row, not per
+     * output pixel), and then looked up by precomputed column maps straight into the RGB row, with background filled only
+     * where nothing is rendered. When zoomed in, an output row that maps to the same source row as the one above it is
+     * just a copy of that row. The row loops are plain indexed loops over row buffers so the compiler vectorizes them, and
+     * output rows are split across threads.
+     *
+     * Each supported type (8U, 16U, 16S, 32S, 32F, 8UC3, 8UC4) gets its own instantiation, so the per-pixel code has no
+     * type switch. Color images are not ranged, just swapped from BGR(A) to RGB.
+     *
+     * Gray images go through a RenderLut, which maps ranged 8-bit values through gamma and a colormap. For 8U, 16U and
+     * 16S the RenderLut also has a table from every possible source value straight to the RGB pixel, so the per-pixel work
+     * zoomed in is one table lookup whatever the range, gamma and colormap are, and the tables are only rebuilt when those
+     * change. 32S and 32F are ranged with a multiply-add and then looked up in the 256-entry color table.
+     */
+    namespace RenderKernel
+    {
+        /**
+         * @brief Map from source values to 8 bits: saturate(v * alpha + beta), with NaN to 0.
+         */
+        struct RenderRange
+        {
+            float alpha = 1.0f;
+            float beta = 0.0f;
+
+            bool checkIsIdentity() const
+            {
+                return (alpha == 1.0f) && (beta == 0.0f);
+            }
+
+            /**
+             * @brief Map lowVal to 0 and highVal to 255, like ImageUtil::imgTo8u.
+             */
+            static RenderRange fromLowHigh(float lowVal, float highVal);
+
+            bool operator==(const RenderRange&) const = default;
+        };
+
+        /**
+         * @brief Tables from gray source values to RGB for a range, gamma and colormap, kept until one of those changes.
+         */
+        class RenderLut
+        {
+          private:
+            bool isValid = false;
+            int depth = -1;
+            RenderRange range;
+            float gamma = 1.0f;
+            int colormap = -1;
+            int buildCount = 0;
+
+            std::vector<uint8_t> colors; // RGB for each ranged 8-bit value, 3 bytes each
+            std::vector<uint8_t> levels; // ranged 8-bit value for each source value, for 8U, 16U, 16S
+            std::vector<uint8_t> values; // colors[levels[i]], padded to 4 bytes each
+
+            void buildColors();
+
+          public:
+            /**
+             * @brief Rebuild the tables if any of these differ from the last call.
+             * @param gamma Ranged values v in [0, 1] are shown as v^gamma, so less than 1 brightens the dark end.
+             * @param colormap A cv::ColormapTypes value, or -1 for gray.
+             * @return true if anything was rebuilt.
+             */
+            bool update(int depth, const RenderRange& range, float gamma = 1.0f, int colormap = -1);
+            bool checkIsBuiltFor(int depth) const;
+
+            const RenderRange& getRange() const;
+            const uint8_t* getColors() const;
+
+            /**
+             * @brief Four bytes (RGB and a pad) per source value, indexed by value + getValueOffset(), or nullptr for depths
+             * with no level table.
+             */
+            const uint8_t* getValues() const;
+            const uint8_t* getLevels() const;
+            int getValueOffset() const;
+            int getBuildCount() const;
+        };
+
+        /**
+         * @brief Colormaps to offer for gray images, by name, with their cv::ColormapTypes value (-1 for gray).
+         */
+        const std::vector<std::pair<std::string, int>>& getColormaps();
+
+        /**
+         * @brief True for depths small enough to range through a table of every value (8U, 16U, 16S).
+         */
+        bool checkHasLevelTable(int depth);
+
+        /**
+         * @brief Index from a source value into a level table, 32768 for 16S and else 0.
+         */
+        int getLevelTableOffset(int depth);
+
+        /**
+         * @brief The ranged 8-bit value of every possible source value of the depth, indexed by value + getLevelTableOffset().
+         */
+        void buildLevelTable(int depth, const RenderRange& range, std::vector<uint8_t>& table);
+
+        /**
+         * @brief dst is the table entry for each src value, for any number of channels.
+         */
+        void applyLevelTable(const cv::Mat& src, const std::vector<uint8_t>& table, cv::Mat& dst);
+
+        bool checkIsSupportedType(int type);
+
+        /**
+         * @brief Size of the whole source at this zoom, rounded like cv::resize does.
+         */
+        cv::Size getZoomedSize(cv::Size srcSize, float zoom);
+
+        /**
+         * @brief Render src at zoom into the upper-left renderSize of dstRgb and fill the rest with background.
+         * Zooming in is nearest neighbor and zooming out is area averaging, like cv::resize INTER_NEAREST and INTER_AREA.
+         * @param renderSize Clipped to getZoomedSize() and the dst size.
+         * @param lut Updated by the caller for the src depth, and ignored for color images.
+         * @param dstRgb CV_8UC3 in RGB order, already allocated (usually wrapping a wxImage).
+         */
+        void renderToRgb(const cv::Mat& src, float zoom, cv::Size renderSize, const RenderLut& lut, uint8_t background, cv::Mat& dstRgb);
+
+        /**
+         * @brief Same, with separate x and y zoom, e.g. for a reduced level whose dims were rounded when halving.
+         */
+        void renderToRgb(const cv::Mat& src, cv::Point2f zoom, cv::Size renderSize, const RenderLut& lut, uint8_t background, cv::Mat& dstRgb);
+
+        /**
+         * @brief Same, with gray and no gamma, building the tables for just this call.
+         */
+        void renderToRgb(const cv::Mat& src, float zoom, cv::Size renderSize, const RenderRange& range, uint8_t background, cv::Mat& dstRgb);
+    }
+}
@@ -0,0 +1,277 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#include <string>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+
+#include "VideoFrameReader.h"
+#include "StringUtil.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace Wxiv
+{
+    VideoFrameReader::VideoFrameReader(const fs::path& path, size_t cacheBudgetBytes) : path(path), cacheBudgetBytes(cacheBudgetBytes)
+    {
+        if (!this->capture.open(path.string()))
+        {
+            throw runtime_error("Failed to open video file.");
+        }
+
+        this->fps = this->capture.get(cv::CAP_PROP_FPS);
+        this->frameCount = (int)this->capture.get(cv::CAP_PROP_FRAME_COUNT);
+        this->nextDecodeIndex = 0;
+
+        if (this->frameCount > 0)
+        {
+            this->isIndexing = true;
+            this->indexThread = std::thread([this]() { this->indexLoop(); });
+            return;
+        }
+
+        // with no count from the container, counting the packets is the only way to know what to list
+        vector<int> found;
+        int count = 0;
+
+        if (buildKeyframeIndex(found, count))
+        {
+            this->keyframes = std::move(found);
+            this->hasKeyframeIndex = true;
+            this->frameCount = count;
+        }
+
+        if (this->frameCount <= 0)
+        {
+            throw runtime_error("Video file has no frames.");
+        }
+    }
+
+    VideoFrameReader::~VideoFrameReader()
+    {
+        this->isStopping = true;
+
+        if (this->indexThread.joinable())
+        {
+            this->indexThread.join();
+        }
+    }
+
+    bool VideoFrameReader::checkIsVideoExtension(const std::string& inputExt)
+    {
+        string ext = getNormalizedExt(inputExt);
+        return (ext == "mp4") || (ext == "avi") || (ext == "mov") || (ext == "mkv");
+    }
+
+    /**
+     * @brief Demux every packet with no decode (FFmpeg raw mode) and note which are keyframes. This also gives an exact
+     * frame count, where the container's may be an estimate. Returns false if the backend can't do this, or on stop.
+     */
+    bool VideoFrameReader::buildKeyframeIndex(vector<int>& found, int& count)
+    {
+        cv::VideoCapture demux;
+
+        if (!demux.open(this->path.string(), cv::CAP_FFMPEG) || !demux.set(cv::CAP_PROP_FORMAT, -1))
+        {
+            return false;
+        }
+
+        found.clear();
+        count = 0;
+
+        while (demux.grab())
+        {
+            if (this->isStopping)
+            {
+                return false;
+            }
+
+            if (demux.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0)
+            {
+                found.push_back(count);
+            }
+
+            count++;
+        }
+
+        // without a keyframe at the start it's not telling us about keyframes
+        return !found.empty() && (found[0] == 0);
+    }
+
+    /**
+     * @brief The background keyframe pass. The frame count stays the container's, since the frames are already listed
+     * by it, so if that was an over-estimate the extra frames just fail to decode.
+     */
+    void VideoFrameReader::indexLoop()
+    {
+        vector<int> found;
+        int count = 0;
+
+        if (buildKeyframeIndex(found, count))
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            this->keyframes = std::move(found);
+            this->hasKeyframeIndex = true;
+        }
+
+        this->isIndexing = false;
+    }
+
+    int VideoFrameReader::getFrameCount()
+    {
+        return this->frameCount;
+    }
+
+    double VideoFrameReader::getFps()
+    {
+        return this->fps;
+    }
+
+    std::vector<int> VideoFrameReader::getKeyframes()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->keyframes;
+    }
+
+    bool VideoFrameReader::checkHasKeyframeIndex()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->hasKeyframeIndex;
+    }
+
+    bool VideoFrameReader::checkIsIndexing()
+    {
+        return this->isIndexing;
+    }
+
+    /**
+     * @brief The nearest keyframe at or before the frame, or the frame itself if there's no index (yet). Caller holds
+     * the mutex.
+     */
+    int VideoFrameReader::findSeekFrame(int index)
+    {
+        if (!this->hasKeyframeIndex)
+        {
+            return index;
+        }
+
+        auto iter = std::upper_bound(this->keyframes.begin(), this->keyframes.end(), index);
+        return (iter == this->keyframes.begin()) ? 0 : *(iter - 1);
+    }
+
+    cv::Mat VideoFrameReader::readFrame(int index)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+
+        if ((index < 0) || (index >= this->frameCount))
+        {
+            throw runtime_error("Video frame index out of range.");
+        }
+
+        auto iter = this->frames.find(index);
+
+        if (iter != this->frames.end())
+        {
+            // most recently used to front
+            this->lru.splice(this->lru.begin(), this->lru, iter->second);
+            return iter->second->frame;
+        }
+
+        // decode forward from where we are, unless that's behind or there's a keyframe to skip ahead to
+        int seekFrame = findSeekFrame(index);
+
+        if ((this->nextDecodeIndex < 0) || (index < this->nextDecodeIndex) || (seekFrame > this->nextDecodeIndex))
+        {
+            if (!this->capture.set(cv::CAP_PROP_POS_FRAMES, seekFrame))
+            {
+                this->nextDecodeIndex = -1;
+                throw runtime_error("Failed to seek in video file.");
+            }
+
+            this->nextDecodeIndex = seekFrame;
+            this->seekCount++;
+        }
+
+        cv::Mat result;
+
+        while (this->nextDecodeIndex <= index)
+        {
+            cv::Mat frame;
+
+            if (!this->capture.read(frame) || frame.empty())
+            {
+                this->nextDecodeIndex = -1;
+                throw runtime_error("Failed to decode video frame.");
+            }
+
+            this->decodeCount++;
+
+            if (this->nextDecodeIndex == index)
+            {
+                result = frame;
+            }
+
+            cacheFrame(this->nextDecodeIndex++, frame);
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Caller holds the mutex.
+     */
+    void VideoFrameReader::cacheFrame(int index, const cv::Mat& frame)
+    {
+        auto iter = this->frames.find(index);
+
+        if (iter != this->frames.end())
+        {
+            this->lru.splice(this->lru.begin(), this->lru, iter->second);
+            return;
+        }
+
+        this->lru.push_front({index, frame});
+        this->frames[index] = this->lru.begin();
+        this->cacheBytes += frame.total() * frame.elemSize();
+        evictFrames();
+    }
+
+    /**
+     * @brief Drop least recently used frames until under budget, but always keep the newest one.
+     */
+    void VideoFrameReader::evictFrames()
+    {
+        while ((this->cacheBytes > this->cacheBudgetBytes) && (this->lru.size() > 1))
+        {
+            FrameEntry& entry = this->lru.back();
+            this->cacheBytes -= entry.frame.total() * entry.frame.elemSize();
+            this->frames.erase(entry.index);
+            this->lru.pop_back();
+        }
+    }
+
+    void VideoFrameReader::setCacheBudgetBytes(size_t bytes)
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        this->cacheBudgetBytes = bytes;
+        evictFrames();
+    }
+
+    size_t VideoFrameReader::getCacheBytes()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->cacheBytes;
+    }
+
+    int VideoFrameReader::getDecodeCount()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->decodeCount;
+    }
+
+    int VideoFrameReader::getSeekCount()
+    {
+        const std::lock_guard<std::mutex> lock(this->mutex);
+        return this->seekCount;
+    }
+}
@@ -0,0 +1,111 @@
+// Copyright(c) 2023 Ryan Seghers
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <opencv2/opencv.hpp>
+
+namespace Wxiv
+{
+    /**
+     * @brief Random access to the frames of a video file, on top of cv::VideoCapture, fast enough to step through
+     * long videos interactively.
+     *
+     * The keyframes are found by a pass over the demuxed packets with no decode (with the FFmpeg backend, else every
+     * frame is treated as a seek point and the backend seeks however it does). The pass runs on a thread started on
+     * open, since it reads the whole file, and until it's done every frame is a seek point. Reading the frame after the
+     * last one read just decodes the next frame. Reading a frame further ahead decodes forward from where the decoder is
+     * if there's no keyframe in between, and otherwise seeks to the nearest keyframe at or before it and decodes forward
+     * from there. Every frame decoded on the way goes in an LRU cache with a byte budget, so stepping back within the
+     * last GOP is a cache hit too.
+     *
+     * The capture is not thread-safe, so everything here is serialized by one mutex.
+     */
+    class VideoFrameReader
+    {
+      private:
+        struct FrameEntry
+        {
+            int index = 0;
+            cv::Mat frame;
+        };
+
+        cv::VideoCapture capture;
+        std::filesystem::path path;
+        int frameCount = 0;
+        double fps = 0;
+        bool hasKeyframeIndex = false;
+        std::vector<int> keyframes; // ascending, empty if no index
+
+        std::thread indexThread;
+        std::atomic<bool> isIndexing = false;
+        std::atomic<bool> isStopping = false;
+
+        // index of the frame the next read() decodes, or -1 if unknown (e.g. after a failed read)
+        int nextDecodeIndex = -1;
+
+        // frame cache, front is most recently used
+        std::list<FrameEntry> lru;
+        std::unordered_map<int, std::list<FrameEntry>::iterator> frames;
+        size_t cacheBytes = 0;
+        size_t cacheBudgetBytes = 0;
+
+        int decodeCount = 0;
+        int seekCount = 0;
+
+        std::mutex mutex;
+
+        bool buildKeyframeIndex(std::vector<int>& found, int& count);
+        void indexLoop();
+        int findSeekFrame(int index);
+        void cacheFrame(int index, const cv::Mat& frame);
+        void evictFrames();
+
+      public:
+        /**
+         * @brief Open the file and start indexing its keyframes in the background, but decode no frames. The frame count
+         * is the container's, unless it doesn't have one and then this indexes before returning to count them. Throws
+         * runtime_error if it can't be opened.
+         * @param cacheBudgetBytes Max bytes of decoded frames to keep.
+         */
+        VideoFrameReader(const std::filesystem::path& path, size_t cacheBudgetBytes);
+
+        /**
+         * @brief Stops (joins) the keyframe pass.
+         */
+        ~VideoFrameReader();
+
+        VideoFrameReader(const VideoFrameReader&) = delete;
+        VideoFrameReader& operator=(const VideoFrameReader&) = delete;
+
+        static bool checkIsVideoExtension(const std::string& ext);
+
+        int getFrameCount();
+        double getFps();
+
+        /**
+         * @brief Keyframe indices, ascending, or empty if the backend can't tell us or the pass isn't done (and then any
+         * frame is a seek point).
+         */
+        std::vector<int> getKeyframes();
+        bool checkHasKeyframeIndex();
+        bool checkIsIndexing();
+
+        /**
+         * @brief Get a frame, from cache or else decoded. The returned mat shares pixels with the cache, don't modify it.
+         * Throws runtime_error if the index is out of range or the frame fails to decode.
+         */
+        cv::Mat readFrame(int index);
+
+        void setCacheBudgetBytes(size_t bytes);
+        size_t getCacheBytes();
+        int getDecodeCount();
+        int getSeekCount();
+    };
+}
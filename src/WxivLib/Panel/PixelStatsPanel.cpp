@@ -20,6 +20,7 @@ namespace Wxiv
     // because mac listview has no padding for cell values
     const int StatsTableLabelIndex = 1;
     const int StatsTableValueIndex = 2;
+    const int StatsTableRowCount = 8;
 
     /**
      * @brief Constructor.
@@ -115,6 +116,7 @@ namespace Wxiv
         statsTableListView->InsertItem(rowIdx++, "");
         statsTableListView->InsertItem(rowIdx++, "");
         statsTableListView->InsertItem(rowIdx++, "");
+        statsTableListView->InsertItem(rowIdx++, "");
 
         rowIdx = 0;
         statsTableListView->SetItem(rowIdx++, StatsTableLabelIndex, "Type");
@@ -124,6 +126,7 @@ namespace Wxiv
         statsTableListView->SetItem(rowIdx++, StatsTableLabelIndex, "Sum");
         statsTableListView->SetItem(rowIdx++, StatsTableLabelIndex, "Min");
         statsTableListView->SetItem(rowIdx++, StatsTableLabelIndex, "Max");
+        statsTableListView->SetItem(rowIdx++, StatsTableLabelIndex, "Resolution");
 
         // hist chart panel
         this->histChartPanel = new HistChartPanel(mainSplitter, false, [&](wxString selection, int binCount, float min, float max, FloatHist& hist) {
@@ -185,7 +188,7 @@ namespace Wxiv
 
                 if (!roi.empty())
                 {
-                    img = this->imageScrollPanel->getImage()(roi);
+                    img = this->imageScrollPanel->getOrigRoiImage(roi);
                 }
             }
 
@@ -233,28 +236,41 @@ namespace Wxiv
 
             if (subjectStr.empty() || (subjectStr == "None"))
             {
-                for (int rowIdx = 0; rowIdx < 7; rowIdx++)
+                for (int rowIdx = 0; rowIdx < StatsTableRowCount; rowIdx++)
                 {
                     this->statsTableListView->SetItem(rowIdx, StatsTableValueIndex, std::string());
                 }
             }
             else
             {
+                // full-resolution pixels per pixel the stats are computed on, which is more than 1 for a huge tiled image
+                // where the pixels are from a reduced level
+                cv::Point2f scale(1.0f, 1.0f);
+
                 if (subjectStr == "Whole Image")
                 {
                     // compute and cache whole-image stats
                     ImageUtil::ImageStats& currentImageStats = this->currentImage->getImageStats();
+                    cv::Mat wholeImage = this->currentImage->getImage();
 
                     if (currentImageStats.empty())
                     {
-                        currentImageStats = ImageUtil::computeStats(this->currentImage->getImage());
+                        currentImageStats = ImageUtil::computeStats(wholeImage);
                     }
 
                     stats = currentImageStats;
+                    std::shared_ptr<TiledTiffImage> tiled = this->currentImage->getTiledImage();
+
+                    if (tiled && (wholeImage.cols > 0))
+                    {
+                        // just the overview
+                        cv::Size size = tiled->getSize();
+                        scale = cv::Point2f((float)size.width / wholeImage.cols, (float)size.height / wholeImage.rows);
+                    }
                 }
                 else if (subjectStr == "View ROI")
                 {
-                    cv::Mat viewImage = this->imageScrollPanel->getOrigViewImage();
+                    cv::Mat viewImage = this->imageScrollPanel->getOrigViewImage(&scale);
                     stats = ImageUtil::computeStats(viewImage);
                 }
                 else if (subjectStr == "Drawn ROI")
@@ -263,7 +279,7 @@ namespace Wxiv
 
                     if (!roi.empty())
                     {
-                        cv::Mat viewImage = this->imageScrollPanel->getImage()(roi);
+                        cv::Mat viewImage = this->imageScrollPanel->getOrigRoiImage(roi, &scale);
                         stats = ImageUtil::computeStats(viewImage);
                     }
                 }
@@ -286,6 +302,11 @@ namespace Wxiv
                 this->statsTableListView->SetItem(rowIdx++, StatsTableValueIndex, fmt::format(fmt::runtime(fmtStr), stats.sum));
                 this->statsTableListView->SetItem(rowIdx++, StatsTableValueIndex, fmt::format(fmt::runtime(fmtStr), stats.minVal));
                 this->statsTableListView->SetItem(rowIdx++, StatsTableValueIndex, fmt::format(fmt::runtime(fmtStr), stats.maxVal));
+
+                // so it's clear that the stats (and hist) are approximate, and the dims and counts are of the reduced pixels
+                float maxScale = std::max(scale.x, scale.y);
+                string resolutionStr = (maxScale > 1.0f) ? fmt::format("1/{:.3g} (approx)", maxScale) : "Full";
+                this->statsTableListView->SetItem(rowIdx++, StatsTableValueIndex, resolutionStr);
             }
 
             this->updateHistogram();
@@ -18,6 +18,32 @@ using namespace std;
 
 namespace Wxiv
 {
+    /**
+     * @brief Full-resolution row and col indices of the pixels of an image of this roi, which can be from a reduced level
+     * (e.g. of a tiled image), in which case the indices are spread over the roi.
+     */
+    static void getProfileIndices(cv::Rect2i roi, cv::Mat& image, vector<int>& rowIndices, vector<int>& colIndices)
+    {
+        rowIndices = vectorRange(roi.y, image.rows);
+        colIndices = vectorRange(roi.x, image.cols);
+
+        if ((image.cols > 0) && (image.cols != roi.width))
+        {
+            float xScale = (float)roi.width / image.cols;
+            float yScale = (float)roi.height / std::max(image.rows, 1);
+
+            for (int i = 0; i < colIndices.size(); i++)
+            {
+                colIndices[i] = roi.x + (int)(i * xScale);
+            }
+
+            for (int i = 0; i < rowIndices.size(); i++)
+            {
+                rowIndices[i] = roi.y + (int)(i * yScale);
+            }
+        }
+    }
+
     /**
      * @brief Constructor.
      * @param parent
@@ -153,28 +179,32 @@ namespace Wxiv
 
                 if (subjectStr == "Whole Image")
                 {
+                    // for a tiled image this is just the overview
                     viewImage = wholeImage;
-                    rowIndices = vectorRange(0, viewImage.rows);
-                    colIndices = vectorRange(0, viewImage.cols);
+                    std::shared_ptr<TiledTiffImage> tiled = this->currentImage->getTiledImage();
+                    cv::Size size = tiled ? tiled->getSize() : wholeImage.size();
+                    getProfileIndices(cv::Rect2i(0, 0, size.width, size.height), viewImage, rowIndices, colIndices);
                 }
                 else if (subjectStr == "View ROI")
                 {
                     viewImage = this->imageScrollPanel->getOrigViewImage();
                     wxRect roi = this->imageScrollPanel->getViewRoi(); // can be off-image
-                    wxRect imageOnlyViewRoi = roi.Intersect(wxRect(0, 0, wholeImage.cols, wholeImage.rows));
-                    rowIndices = vectorRange(imageOnlyViewRoi.y, imageOnlyViewRoi.height);
-                    colIndices = vectorRange(imageOnlyViewRoi.x, imageOnlyViewRoi.width);
+                    wxSize fullImageSize = this->imageScrollPanel->getFullImageSize();
+                    wxRect imageOnlyViewRoi = roi.Intersect(wxRect(0, 0, fullImageSize.x, fullImageSize.y));
+                    cv::Rect2i cvRoi(imageOnlyViewRoi.x, imageOnlyViewRoi.y, imageOnlyViewRoi.width, imageOnlyViewRoi.height);
+                    getProfileIndices(cvRoi, viewImage, rowIndices, colIndices);
                 }
                 else if (subjectStr == "Drawn ROI")
                 {
                     cv::Rect2f roi = this->imageScrollPanel->getDrawnRoi();
+                    wxSize fullImageSize = this->imageScrollPanel->getFullImageSize();
                     cv::Rect2i iroi((int)roi.x, (int)roi.y, (int)roi.width, (int)roi.height);
+                    iroi &= cv::Rect2i(0, 0, fullImageSize.x, fullImageSize.y);
 
-                    if (!roi.empty())
+                    if (!iroi.empty())
                     {
-                        viewImage = this->currentImage->getImage()(iroi);
-                        rowIndices = vectorRange<int>((int)iroi.y, (int)iroi.height);
-                        colIndices = vectorRange<int>((int)iroi.x, (int)iroi.width);
+                        viewImage = this->imageScrollPanel->getOrigRoiImage(iroi);
+                        getProfileIndices(iroi, viewImage, rowIndices, colIndices);
                     }
                 }
 
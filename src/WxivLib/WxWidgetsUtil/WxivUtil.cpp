@@ -1,6 +1,9 @@
 // Copyright(c) 2022 Ryan Seghers
 // Distributed under the MIT License (http://opensource.org/licenses/MIT)
 #include <filesystem>
+#include <algorithm>
+#include <fstream>
+#include <atomic>
 #include <fmt/core.h>
 
 #include <opencv2/opencv.hpp>
@@ -16,6 +19,12 @@
 #include "WxWidgetsUtil.h"
 #include "StringUtil.h"
 #include "ImageUtil.h"
+#include "ImageDecoder.h"
+#include "MappedImage.h"
+#include "MappedFile.h"
+#include "TiffUtil.h"
+#include "TiledTiffImage.h"
+#include "ImageHeader.h"
 
 using namespace std;
 namespace fs = std::filesystem;
@@ -145,14 +154,74 @@ namespace Wxiv
         }
     }
 
+    /**
+     * @brief For std file APIs, which want wide strings on Windows and (utf-8) narrow strings elsewhere.
+     */
+    std::filesystem::path toFilesystemPath(const wxString& s)
+    {
+#ifdef _WIN32
+        return fs::path(s.ToStdWstring());
+#else
+        return fs::path(toNativeString(s));
+#endif
+    }
+
+    /**
+     * @brief Inverse of toFilesystemPath.
+     */
+    wxString fromFilesystemPath(const std::filesystem::path& path)
+    {
+#ifdef _WIN32
+        return wxString(path.wstring());
+#else
+        return wxString::FromUTF8(path.string());
+#endif
+    }
+
+    // whether to decode ASCII paths from a mapping too, see setDoLoadImageMapped()
+    static std::atomic<bool> doLoadImageMapped = false;
+
+    /**
+     * @brief Whether wxLoadImage decodes the first page of files with ASCII paths from a mapping of the file (like it
+     * always does for non-ASCII paths) instead of letting OpenCV read the file.
+     */
+    void setDoLoadImageMapped(bool doMap)
+    {
+        doLoadImageMapped = doMap;
+    }
+
+    bool getDoLoadImageMapped()
+    {
+        return doLoadImageMapped;
+    }
+
+    /**
+     * @brief Decode the first page of an image file from a memory mapping of it, so the encoded bytes are never copied
+     * to the heap, and the path can be any path the OS can open.
+     * @param doCopy Read the file into memory instead, see wxLoadImage().
+     * @return False if not decoded, including for files of 2 GB or more. Throws if the file can't be mapped.
+     */
+    bool wxLoadImageMapped(const wxString& path, std::vector<cv::Mat>& mats, bool doCopy)
+    {
+        wxFileName fn(path);
+        MappedFile file(toFilesystemPath(path), doCopy);
+
+        // the decoded image doesn't refer to the mapping so it's fine to unmap after this
+        return ImageDecoder::decodeBuffer(file.getData(), file.getSize(), fn.GetExt().ToStdString(), mats);
+    }
+
     /**
      * @brief wxWidgets to load image in cross-platform way. For paths with non-ASCII characters this can only load a single page
      * from multi-page tif's.
      * @param path
      * @param mats
+     * @param page Zero-based page to load just that one, or -1 (default) for all pages.
+     * @param doCopy Read the file into memory instead of mapping it, for a file that may be truncated or rewritten while
+     * it's loaded (e.g. in a watched dir), since reading a mapping past the new end of the file faults. This matters
+     * most for npy and raw, whose pixels stay mapped for as long as the image is loaded.
      * @return
      */
-    bool wxLoadImage(const wxString& path, vector<cv::Mat>& mats)
+    bool wxLoadImage(const wxString& path, vector<cv::Mat>& mats, int page, bool doCopy)
     {
         bool result = false;
 
@@ -171,52 +240,154 @@ namespace Wxiv
             throw runtime_error("Image files must have known extensions and those must be ASCII.");
         }
 
-        if (checkIsOnlyAscii(path))
+        if (MappedImage::checkIsMappedExtension(wxExt.ToStdString()))
+        {
+            // no decode, just map the file and wrap the pixels
+            mats.push_back(MappedImage::load(toFilesystemPath(path), doCopy));
+            result = true;
+        }
+        else if (checkIsOnlyAscii(path) && !(getDoLoadImageMapped() && (page == 0)))
         {
             // ASCII path, can use opencv
-            result = imreadmulti(path.ToStdString(), mats, cv::IMREAD_UNCHANGED);
+            result = ImageDecoder::decodeFile(path.ToStdString(), wxExt.ToStdString(), mats, page);
+        }
+        else if (page > 0)
+        {
+            // can only decode the first page from a buffer
+            return false;
         }
         else
         {
-            wxFile file(path, wxFile::read);
+            result = wxLoadImageMapped(path, mats, doCopy);
+        }
 
-            if (file.IsOpened())
+        if (result && !mats.empty())
+        {
+            string ext = wxExt.ToStdString();
+
+            for (cv::Mat& img : mats)
             {
-                // get size
-                file.SeekEnd();
-                size_t n = file.Tell();
-                file.Seek(0); // back to start
+                ImageUtil::convertAfterLoad(img, ext, img);
+            }
+        }
 
-                vector<uchar> buffer(n);
-                size_t nRead = file.Read(buffer.data(), n);
+        return result;
+    }
 
-                if ((nRead == n) && !file.Error() && file.Eof())
-                {
-                    file.Close();
+    // for reading a reduced tif level, which is small, so just enough for a few tiles
+    static const size_t ReducedTiffCacheBytes = (size_t)64 * 1024 * 1024;
 
-                    cv::Mat img;
-                    cv::imdecode(buffer, cv::IMREAD_UNCHANGED, &img);
+    /**
+     * @brief Decode at reduced resolution, if the format has a cheap way to: JPEG is decoded at 1/2, 1/4, or 1/8 scale
+     * (libjpeg skips most of the IDCT work), and a tif with reduced-resolution IFDs is read from the coarsest one that is
+     * big enough. Other formats would need a full decode, so this returns false for them.
+     * @param minDim The result is at least this big in its larger axis, unless the full image is smaller.
+     * @param img The reduced image. Reduced JPEGs are 8-bit gray or BGR, like a full decode.
+     * @param fullSize The full-resolution size, which the result is a scaled version of.
+     * @param doCopy Read a JPEG into memory instead of decoding it from a mapping, see wxLoadImage(). Throws if the file
+     * can't be mapped (or read).
+     */
+    bool wxLoadImageReduced(const wxString& path, int page, int minDim, cv::Mat& img, cv::Size& fullSize, bool doCopy)
+    {
+        wxFileName fn(path);
 
-                    if (!img.empty())
-                    {
-                        mats.push_back(img);
-                        result = true;
-                    }
-                }
-            }
+        if (!fn.HasExt() || !checkIsOnlyAscii(fn.GetExt()))
+        {
+            return false;
         }
 
-        if (result && !mats.empty())
+        string ext = getNormalizedExt(fn.GetExt().ToStdString());
+        fs::path fsPath = toFilesystemPath(path);
+
+        if ((ext == "jpg") || (ext == "jpeg"))
         {
-            string ext = wxExt.ToStdString();
+            ImageHeaderInfo info;
 
-            for (cv::Mat& img : mats)
+            if (!ImageHeader::probeFile(fsPath, ext, page, info) || info.empty())
             {
-                ImageUtil::convertAfterLoad(img, ext, img);
+                return false;
+            }
+
+            int maxDim = std::max(info.width, info.height);
+            int factor = 8;
+
+            while ((factor > 1) && (maxDim / factor < minDim))
+            {
+                factor /= 2;
+            }
+
+            if (factor == 1)
+            {
+                return false;
             }
+
+            // the decoded image doesn't refer to the mapping so it's fine to unmap after this
+            MappedFile file(fsPath, doCopy);
+
+            if (!ImageDecoder::decodeBufferReduced(file.getData(), file.getSize(), ext, factor, info.channels >= 3, img))
+            {
+                return false;
+            }
+
+            fullSize = cv::Size(info.width, info.height);
+            return true;
         }
+        else if ((page == 0) && TiffUtil::checkIsTiffExtension(ext))
+        {
+            std::shared_ptr<TiledTiffImage> tiled = TiledTiffImage::tryOpen(fsPath, 0, ReducedTiffCacheBytes);
 
-        return result;
+            if (!tiled || (tiled->getFileLevelCount() < 2))
+            {
+                return false;
+            }
+
+            // coarsest level in the file that's still big enough
+            int level = 0;
+
+            for (int i = 1; i < tiled->getFileLevelCount(); i++)
+            {
+                cv::Size levelSize = tiled->getLevelSize(i);
+
+                if (std::max(levelSize.width, levelSize.height) >= minDim)
+                {
+                    level = i;
+                }
+            }
+
+            if (level == 0)
+            {
+                return false;
+            }
+
+            cv::Size levelSize = tiled->getLevelSize(level);
+            tiled->readRegion(level, cv::Rect(0, 0, levelSize.width, levelSize.height), img);
+            fullSize = tiled->getSize();
+            return !img.empty();
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Count the pages wxLoadImage can load from this file, without decoding any of them.
+     * This is 1 for anything but TIFF, and for TIFF paths with non-ASCII characters since only the first page of
+     * those can be loaded.
+     */
+    int wxCountImagePages(const wxString& path)
+    {
+        wxFileName fn(path);
+
+        if (!fn.HasExt() || !checkIsOnlyAscii(fn.GetExt()) || !TiffUtil::checkIsTiffExtension(fn.GetExt().ToStdString()))
+        {
+            return 1;
+        }
+
+        if (!checkIsOnlyAscii(path))
+        {
+            return 1;
+        }
+
+        return std::max(TiffUtil::countPages(toFilesystemPath(path)), 1);
     }
 
     /**
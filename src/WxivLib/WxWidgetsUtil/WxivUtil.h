@@ -4,6 +4,7 @@
 
 #include <string>
 #include <vector>
+#include <filesystem>
 
 #include "WxWidgetsUtil.h"
 #include "WxivImage.h"
@@ -15,7 +16,14 @@ namespace Wxiv
     wxFileName findInstalledFile(wxString basename);
     bool checkIsOnlyAscii(const wxString& s);
     std::string toNativeString(const wxString& s);
-    bool wxLoadImage(const wxString& path, std::vector<cv::Mat>& mats);
+    std::filesystem::path toFilesystemPath(const wxString& s);
+    wxString fromFilesystemPath(const std::filesystem::path& path);
+    bool wxLoadImage(const wxString& path, std::vector<cv::Mat>& mats, int page = -1, bool doCopy = false);
+    bool wxLoadImageMapped(const wxString& path, std::vector<cv::Mat>& mats, bool doCopy = false);
+    void setDoLoadImageMapped(bool doMap);
+    bool getDoLoadImageMapped();
+    bool wxLoadImageReduced(const wxString& path, int page, int minDim, cv::Mat& img, cv::Size& fullSize, bool doCopy = false);
+    int wxCountImagePages(const wxString& path);
     bool wxSaveImage(const wxString& path, cv::Mat& img, bool doShowErrorDialog = true);
     void saveCollageSpecToConfig(const ImageUtil::CollageSpec& spec);
     void loadCollageSpecFromConfig(ImageUtil::CollageSpec& spec);
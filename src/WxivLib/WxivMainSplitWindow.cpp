@@ -132,13 +132,29 @@ namespace Wxiv
         // temporarily turn off callback because we will handle the update ourself and we don't know
         // if imageScrollPanel is going to event a view change (because setting same image size doesn't change the "view")
         this->imageScrollPanel->setOnViewChangeCallback(nullptr);
-        this->imageScrollPanel->setImage(newImage->getImage());
+        this->imageScrollPanel->setImage(newImage->getImage(), newImage->getTiledImage(), newImage->getPyramid());
         this->imageScrollPanel->setOnViewChangeCallback([&](void) { this->onImageViewChange(); });
 
         this->onImageViewChange();
         this->onCurrentImageShapesChange();
     }
 
+    /**
+     * @brief View a reduced-resolution preview while an image loads. The stats, profiles, and shapes wait for the full
+     * image, which will be set by setImage().
+     */
+    void WxivMainSplitWindow::setPreviewImage(cv::Mat& preview, cv::Size fullSize)
+    {
+        this->currentImage = nullptr;
+        this->statsPanel->setImage(this->currentImage);
+        this->profilesPanel->setImage(this->currentImage);
+        this->onCurrentImageShapesChange();
+
+        this->imageScrollPanel->setOnViewChangeCallback(nullptr);
+        this->imageScrollPanel->setPreviewImage(preview, fullSize);
+        this->imageScrollPanel->setOnViewChangeCallback([&](void) { this->onImageViewChange(); });
+    }
+
     /**
      * @brief For example when filter is applied.
      */
@@ -247,4 +263,14 @@ namespace Wxiv
     {
         this->imageScrollPanel->showBrightnessSettingsDialog();
     }
+
+    IntensityRangeParams WxivMainSplitWindow::getIntensityRangeParams()
+    {
+        return this->imageScrollPanel->getSettings().intensityRangeParams;
+    }
+
+    void WxivMainSplitWindow::setIsLoading(bool isLoading)
+    {
+        this->imageScrollPanel->setIsLoading(isLoading);
+    }
 }
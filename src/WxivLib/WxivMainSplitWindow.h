@@ -48,6 +48,7 @@ namespace Wxiv
         WxivMainSplitWindow(wxWindow* parent);
 
         void setImage(std::shared_ptr<WxivImage> newImage);
+        void setPreviewImage(cv::Mat& preview, cv::Size fullSize);
         void clearImage();
         void setViewToFitImage();
         int getSashPosition();
@@ -74,5 +75,7 @@ namespace Wxiv
         bool getRenderPixelValues();
 
         void showBrightnessSettingsDialog();
+        IntensityRangeParams getIntensityRangeParams();
+        void setIsLoading(bool isLoading);
     };
 }
@@ -1,6 +1,7 @@
 // Copyright(c) 2022 Ryan Seghers
 // Distributed under the MIT License (http://opensource.org/licenses/MIT)
 #include <string>
+#include <algorithm>
 #include <filesystem>
 #include <fmt/core.h>
 #include <fmt/xchar.h>
@@ -12,8 +13,13 @@
 #include "WxivImage.h"
 #include "ImageUtil.h"
 #include "ImageListSourceDirectory.h"
+#include "ImageListSourceArchive.h"
+#include "ImageListSourceVideo.h"
+#include "ImageListSourceShmRing.h"
+#include "ImageListSourceSocket.h"
 #ifdef DO_DICOM
 #include "ImageListSourceDcmDirectory.h"
+#include "ImageListSourceDicomVolume.h"
 #endif
 #include "WxivUtil.h"
 #include "TextDisplayDialog.h"
@@ -82,6 +88,15 @@ namespace Wxiv
 
         this->Bind(wxEVT_CLOSE_WINDOW, &WxivMainFrame::OnClose, this, wxID_ANY);
 
+        this->dirWatchTimer.SetOwner(this);
+        this->Bind(wxEVT_TIMER, &WxivMainFrame::onDirWatchTimer, this, this->dirWatchTimer.GetId());
+
+        this->selectionLoadTimer.SetOwner(this);
+        this->Bind(wxEVT_TIMER, &WxivMainFrame::onSelectionLoadTimer, this, this->selectionLoadTimer.GetId());
+
+        this->liveTimer.SetOwner(this);
+        this->Bind(wxEVT_TIMER, &WxivMainFrame::onLiveTimer, this, this->liveTimer.GetId());
+
         // command-line arg for image/dir to open
         if (wxTheApp->argc > 1)
         {
@@ -96,6 +111,16 @@ namespace Wxiv
             {
                 this->loadImageAndDir(s);
             }
+            else if (ImageListSourceShmRing::checkIsShmLocation(s) || ImageListSourceSocket::checkIsSocketLocation(s))
+            {
+                this->loadDir(s);
+            }
+#ifdef DO_DICOM
+            else if (ImageListSourceDicomVolume::checkIsVolumeLocation(s))
+            {
+                this->loadDir(s);
+            }
+#endif
             else
             {
                 alert(wxString("File or directory does not exist: ") + s);
@@ -185,6 +210,15 @@ namespace Wxiv
     {
         mainSplitWindow->restoreConfig();
         imageListPanel->restoreConfig();
+        thumbnailPanel->setIntensityRangeParams(mainSplitWindow->getIntensityRangeParams());
+        imageListNotebook->SetSelection(std::clamp((int)wxConfigBase::Get()->ReadLong("ImageListTab", 0), 0, 1));
+
+        this->prefetchAheadCount = wxConfigBase::Get()->ReadLong("PrefetchAheadCount", 3);
+        this->prefetchBehindCount = wxConfigBase::Get()->ReadLong("PrefetchBehindCount", 1);
+        this->imageMemoryBudgetMb = wxConfigBase::Get()->ReadLong("ImageMemoryBudgetMB", 4096);
+        setDoLoadImageMapped(wxConfigBase::Get()->ReadBool("LoadImageMapped", false));
+        this->doWatchDirMenuItem->Check(wxConfigBase::Get()->ReadBool("WatchDir", false));
+        this->doFollowNewestMenuItem->Check(wxConfigBase::Get()->ReadBool("FollowNewest", false));
 
         // now that config is restored can sync menu options to restored settings
         if (this->mainSplitWindow)
@@ -198,6 +232,16 @@ namespace Wxiv
     {
         wxConfigBase::Get()->Write("IsMaximized", IsMaximized());
         wxConfigBase::Get()->Write("ImageListWidth", mainSplitter->GetSashPosition());
+        wxConfigBase::Get()->Write("ImageListTab", imageListNotebook->GetSelection());
+        wxConfigBase::Get()->Write("PrefetchAheadCount", this->prefetchAheadCount);
+        wxConfigBase::Get()->Write("PrefetchBehindCount", this->prefetchBehindCount);
+        wxConfigBase::Get()->Write("ImageMemoryBudgetMB", this->imageMemoryBudgetMb);
+        wxConfigBase::Get()->Write("LoadImageMapped", getDoLoadImageMapped());
+        wxConfigBase::Get()->Write("WatchDir", this->doWatchDirMenuItem->IsChecked());
+        wxConfigBase::Get()->Write("FollowNewest", this->doFollowNewestMenuItem->IsChecked());
+        this->dirWatchTimer.Stop();
+        this->selectionLoadTimer.Stop();
+        this->liveTimer.Stop();
         mainSplitWindow->saveConfig();
         imageListPanel->saveConfig();
 
@@ -245,6 +289,15 @@ namespace Wxiv
         this->menuFile = new wxMenu;
         menuFile->Append(ID_OpenFile, "&Open File...", "Open file");
         menuFile->Append(ID_OpenDir, "Open &Dir...", "Open directory");
+        wxMenuItem* attachSharedMemoryMenuItem =
+            menuFile->Append(ID_AttachSharedMemory, "Attach Shared &Memory...", "List the frames another process writes to a shared-memory ring");
+        wxMenuItem* listenOnSocketMenuItem =
+            menuFile->Append(ID_ListenOnSocket, "Listen on &Socket...", "List the frames another process streams to a Unix domain socket");
+#ifdef _WIN32
+        // POSIX shared memory and sockets only
+        attachSharedMemoryMenuItem->Enable(false);
+        listenOnSocketMenuItem->Enable(false);
+#endif
 
         wxString lastOpenPath;
 
@@ -261,6 +314,15 @@ namespace Wxiv
         // reload
         menuFile->AppendSeparator();
         menuItemsForAnyImagesListed.push_back(menuFile->Append(ID_ReloadDir, "&Reload Dir\tCtrl-R", "Reload directory"));
+        this->doWatchDirMenuItem =
+            menuFile->Append(ID_ToggleWatchDir, "&Watch Dir", "Update the list as files in the directory are written or removed", wxITEM_CHECK);
+        this->doFollowNewestMenuItem =
+            menuFile->Append(ID_ToggleFollowNewest, "&Follow Newest", "When watching or attached to a live source, select each new image as it appears", wxITEM_CHECK);
+#ifndef __linux__
+        // inotify only, for now
+        this->doWatchDirMenuItem->Enable(false);
+        this->doFollowNewestMenuItem->Enable(false);
+#endif
 
         // save
         menuFile->AppendSeparator();
@@ -293,8 +355,11 @@ namespace Wxiv
 
         Bind(wxEVT_MENU, &WxivMainFrame::onOpenFile, this, ID_OpenFile);
         Bind(wxEVT_MENU, &WxivMainFrame::onOpenDir, this, ID_OpenDir);
+        Bind(wxEVT_MENU, &WxivMainFrame::onAttachSharedMemory, this, ID_AttachSharedMemory);
+        Bind(wxEVT_MENU, &WxivMainFrame::onListenOnSocket, this, ID_ListenOnSocket);
         Bind(wxEVT_MENU, &WxivMainFrame::onOpenLast, this, ID_OpenLast);
         Bind(wxEVT_MENU, &WxivMainFrame::onReloadDir, this, ID_ReloadDir);
+        Bind(wxEVT_MENU, &WxivMainFrame::onToggleWatchDir, this, ID_ToggleWatchDir);
 
         Bind(wxEVT_MENU, &WxivMainFrame::onNextImage, this, ID_NextImage);
         Bind(wxEVT_MENU, &WxivMainFrame::onPreviousImage, this, ID_PreviousImage);
@@ -324,6 +389,16 @@ namespace Wxiv
         menuTools->Append(ID_FitViewToImage, "&Fit view\tCtrl-Shift-F", "Fit view to image");
         Bind(wxEVT_MENU, &WxivMainFrame::onFitViewToImage, this, ID_FitViewToImage);
 
+#ifdef DO_DICOM
+        // the open DICOM dir as its files, or as slices of its series volume along an axis
+        menuTools->AppendSeparator();
+        menuTools->Append(ID_ViewDicomFiles, "View DICOM Dir as F&iles", "List the dcm files in the open dir");
+        menuTools->Append(ID_ViewDicomAxial, "View DICOM Volume &Axial", "List axial slices of the series volume in the open dir");
+        menuTools->Append(ID_ViewDicomCoronal, "View DICOM Volume &Coronal", "List coronal slices of the series volume in the open dir");
+        menuTools->Append(ID_ViewDicomSagittal, "View DICOM Volume &Sagittal", "List sagittal slices of the series volume in the open dir");
+        Bind(wxEVT_MENU, &WxivMainFrame::onViewDicom, this, ID_ViewDicomFiles, ID_ViewDicomSagittal);
+#endif
+
         menuBar->Append(menuTools, "&Tools");
     }
 
@@ -414,12 +489,20 @@ namespace Wxiv
     {
         mainSplitter = new wxSplitterWindow(this, wxID_ANY, wxPoint(0, 0), wxSize(300, 400), wxSP_BORDER | wxSP_LIVE_UPDATE);
 
-        imageListPanel = new ImageListPanel(mainSplitter);
+        // list and thumbnails of the same images, as tabs
+        imageListNotebook = new wxNotebook(mainSplitter, wxID_ANY);
+
+        imageListPanel = new ImageListPanel(imageListNotebook);
         imageListPanel->setOnSelectionChangeCallback([&](void) { this->onImageListSelectionChange(); });
         imageListPanel->setOnListItemsChangeCallback([&](void) { this->onImageListItemsChange(); });
+        imageListNotebook->AddPage(imageListPanel, "List");
+
+        thumbnailPanel = new ThumbnailPanel(imageListNotebook);
+        thumbnailPanel->setOnThumbnailClickCallback([&](int dataIndex) { this->onThumbnailClick(dataIndex); });
+        imageListNotebook->AddPage(thumbnailPanel, "Thumbnails");
 
         mainSplitWindow = new WxivMainSplitWindow(mainSplitter);
-        mainSplitter->SplitVertically(imageListPanel, mainSplitWindow);
+        mainSplitter->SplitVertically(imageListNotebook, mainSplitWindow);
 
         // restore sash position
         int sashPosition = wxConfigBase::Get()->Read("ImageListWidth", 300);
@@ -466,8 +549,44 @@ namespace Wxiv
         showTextFile("wxiv Release Notes", "wxiv-release-notes.txt");
     }
 
+    /**
+     * @brief The dir can also be a zip or tar file, a video file, a shared memory location like "shm:/wxiv", a socket
+     * location like "unix:/tmp/wxiv.sock", or a DICOM volume location like "mpr:axial:/data/ct1".
+     */
     void WxivMainFrame::createImageListSourceForDir(wxString dirPath)
     {
+        if (ImageListSourceShmRing::checkIsShmLocation(dirPath))
+        {
+            this->imageListSource = std::make_shared<ImageListSourceShmRing>();
+            return;
+        }
+
+        if (ImageListSourceSocket::checkIsSocketLocation(dirPath))
+        {
+            this->imageListSource = std::make_shared<ImageListSourceSocket>();
+            return;
+        }
+
+        if (ImageListSourceArchive::checkIsArchiveFile(dirPath))
+        {
+            this->imageListSource = std::make_shared<ImageListSourceArchive>();
+            return;
+        }
+
+#ifdef DO_DICOM
+        if (ImageListSourceDicomVolume::checkIsVolumeLocation(dirPath))
+        {
+            this->imageListSource = std::make_shared<ImageListSourceDicomVolume>();
+            return;
+        }
+#endif
+
+        if (ImageListSourceVideo::checkIsVideoFile(dirPath))
+        {
+            this->imageListSource = std::make_shared<ImageListSourceVideo>();
+            return;
+        }
+
         // Use DICOM if more than half are DICOM files.
         vector<wxString> paths = listFilesInDir(dirPath);
         auto isDcm = [=](const wxString& s) -> bool { return wxFileName(s).GetExt().Lower() == "dcm"; };
@@ -489,11 +608,21 @@ namespace Wxiv
 
     void WxivMainFrame::loadDir(wxString dirPath)
     {
+#ifdef DO_DICOM
+        // the cached volume is only for switching between its axes
+        if (!ImageListSourceDicomVolume::checkIsVolumeLocation(dirPath))
+        {
+            DicomVolume::releaseCached();
+        }
+#endif
+
         createImageListSourceForDir(dirPath);
 
         if (this->imageListSource == nullptr)
             return;
 
+        this->imageListSource->setMemoryBudget((size_t)this->imageMemoryBudgetMb * 1024 * 1024);
+
         try
         {
             wxBusyCursor wait;
@@ -508,8 +637,11 @@ namespace Wxiv
             alert(msg);
         }
 
+        thumbnailPanel->setSource(this->imageListSource);
         imageListPanel->setSource(this->imageListSource);
         lastOpenDir = dirPath;
+        updateDirWatch();
+        updateLiveTimer();
     }
 
     void WxivMainFrame::loadImage(wxString imagePath)
@@ -524,11 +656,17 @@ namespace Wxiv
     }
 
     /**
-     * @brief Also loads the dir.
+     * @brief Also loads the dir. An archive or video is loaded like a dir.
      * @param path
      */
     void WxivMainFrame::loadImageAndDir(wxString path)
     {
+        if (ImageListSourceArchive::checkIsArchiveFile(path) || ImageListSourceVideo::checkIsVideoFile(path))
+        {
+            loadDir(path);
+            return;
+        }
+
         wxString dirPath = wxFileName(path).GetPath();
 
         if (!dirPath.empty())
@@ -549,11 +687,15 @@ namespace Wxiv
     void WxivMainFrame::onOpenFile(wxCommandEvent& event)
     {
         wxFileDialog openFileDialog(this, _("Open image file"), "", "",
-            "WxivImage files|*.tif;*.tiff;*.png;*.jpeg;*.jpg"
+            "WxivImage files|*.tif;*.tiff;*.png;*.jpeg;*.jpg;*.npy;*.raw;*.zip;*.tar;*.mp4;*.avi;*.mov;*.mkv"
             "|TIFF files (*.tif)|*.tif"
             "|JPEG files (*.jpeg)|*.jpeg"
             "|JPEG files (*.jpg)|*.jpg"
-            "|PNG files (*.png)|*.png",
+            "|PNG files (*.png)|*.png"
+            "|NumPy files (*.npy)|*.npy"
+            "|Raw files (*.raw)|*.raw"
+            "|Archives of images (*.zip;*.tar)|*.zip;*.tar"
+            "|Videos (*.mp4;*.avi;*.mov;*.mkv)|*.mp4;*.avi;*.mov;*.mkv",
             wxFD_OPEN | wxFD_FILE_MUST_EXIST);
 
         if (openFileDialog.ShowModal() == wxID_CANCEL)
@@ -609,6 +751,246 @@ namespace Wxiv
         }
     }
 
+    /**
+     * @brief Start or stop watching the open dir to match the menu option.
+     */
+    void WxivMainFrame::updateDirWatch()
+    {
+        this->dirWatchTimer.Stop();
+        this->dirWatcher.reset();
+
+        if (this->imageListSource)
+        {
+            this->imageListSource->setIsWatched(false);
+        }
+
+        // archives aren't watched
+        if (!this->doWatchDirMenuItem->IsChecked() || this->lastOpenDir.empty() || !this->imageListSource || !wxDirExists(this->lastOpenDir))
+        {
+            return;
+        }
+
+        try
+        {
+            this->dirWatcher = std::make_unique<DirectoryWatcher>(toFilesystemPath(this->lastOpenDir));
+        }
+        catch (exception& ex)
+        {
+            wxString msg = "Exception watching directory:\n";
+            msg += this->lastOpenDir;
+            msg += "\n\n";
+            msg += ex.what();
+            alert(msg);
+            return;
+        }
+
+        if (this->dirWatcher->checkIsWatching())
+        {
+            this->dirWatchTimer.Start(250);
+
+            // files can be rewritten from now on, so mapped images are unloaded, and the selected one re-read if it was
+            std::shared_ptr<WxivImage> selectedImage = this->imageListPanel->getSelectedImage();
+            bool wasSelectedLoaded = selectedImage && selectedImage->getIsLoaded();
+            this->imageListSource->setIsWatched(true);
+
+            if (wasSelectedLoaded && !selectedImage->getIsLoaded())
+            {
+                this->onImageListSelectionChange();
+            }
+        }
+    }
+
+    void WxivMainFrame::onToggleWatchDir(wxCommandEvent& event)
+    {
+        updateDirWatch();
+    }
+
+    /**
+     * @brief Apply the changes in the watched dir to the listed images, without rebuilding the list or dropping loaded
+     * images, except for files that changed.
+     */
+    void WxivMainFrame::onDirWatchTimer(wxTimerEvent& event)
+    {
+        if (!this->dirWatcher || !this->imageListSource)
+        {
+            return;
+        }
+
+        vector<DirectoryWatcher::Change> changes = this->dirWatcher->takeChanges();
+
+        if (!this->dirWatcher->checkIsWatching())
+        {
+            // the dir itself was deleted, moved, or unmounted, so the list can't be kept up to date any more
+            this->dirWatchTimer.Stop();
+            this->dirWatcher.reset();
+            this->imageListSource->setIsWatched(false);
+            this->doWatchDirMenuItem->Check(false);
+            alert(wxString("Stopped watching the directory, since it was deleted, moved, or unmounted:\n") + this->lastOpenDir);
+            return;
+        }
+
+        if (this->dirWatcher->takeIsOverflowed())
+        {
+            // missed some, so the only way to catch up is to re-list
+            wxCommandEvent evt;
+            onReloadDir(evt);
+            return;
+        }
+
+        std::shared_ptr<WxivImage> selectedImage = this->imageListPanel->getSelectedImage();
+        bool isSelectedChanged = false;
+        int newestIdx = -1;
+
+        for (const auto& change : changes)
+        {
+            wxString path = fromFilesystemPath(change.path);
+
+            if (change.type == DirectoryWatcher::ChangeType::Removed)
+            {
+                int idx;
+
+                // the file's pages are listed separately
+                while ((idx = this->imageListSource->removeImageFile(path)) >= 0)
+                {
+                    this->imageListPanel->removeImage(idx);
+
+                    if (newestIdx > idx)
+                    {
+                        newestIdx--;
+                    }
+                    else if (newestIdx == idx)
+                    {
+                        newestIdx = -1;
+                    }
+                }
+            }
+            else if (int idx = this->imageListSource->invalidateImageFile(path); idx >= 0)
+            {
+                // re-written
+                this->imageListPanel->updateImageItem(idx);
+                this->thumbnailPanel->removeThumbnail(this->imageListSource->getImage(idx));
+
+                if (selectedImage && (selectedImage->getPath().GetFullName() == wxFileName(path).GetFullName()))
+                {
+                    isSelectedChanged = true;
+                }
+            }
+            else
+            {
+                int idx = this->imageListSource->addImageFile(path);
+
+                if ((idx >= 0) && this->imageListPanel->appendImage(idx))
+                {
+                    newestIdx = idx;
+                }
+            }
+        }
+
+        if ((newestIdx >= 0) && this->doFollowNewestMenuItem->IsChecked())
+        {
+            this->imageListPanel->selectImageByDataIndex(newestIdx);
+        }
+        else if (isSelectedChanged)
+        {
+            // reload it
+            this->onImageListSelectionChange();
+        }
+    }
+
+    /**
+     * @brief Poll a live source often, since finding out is most of the latency from the producer writing a frame to it
+     * being on screen, and the poll is just an atomic read when nothing arrived.
+     */
+    void WxivMainFrame::updateLiveTimer()
+    {
+        this->liveTimer.Stop();
+
+        if (this->imageListSource && this->imageListSource->checkIsLive())
+        {
+            this->liveTimer.Start(4);
+        }
+        else if (!this->lastLiveStatus.empty())
+        {
+            this->lastLiveStatus.clear();
+            this->SetStatusText("");
+        }
+    }
+
+    /**
+     * @brief Like onDirWatchTimer, apply the live source's changes to the list without rebuilding it.
+     */
+    void WxivMainFrame::onLiveTimer(wxTimerEvent& event)
+    {
+        if (!this->imageListSource)
+        {
+            return;
+        }
+
+        string status = this->imageListSource->getLiveStatus();
+
+        if (status != this->lastLiveStatus)
+        {
+            this->lastLiveStatus = status;
+            this->SetStatusText(wxString::FromUTF8(status.c_str()));
+        }
+
+        vector<int> removedIndices;
+        int addedCount = 0;
+
+        if (!this->imageListSource->takeLiveChanges(removedIndices, addedCount))
+        {
+            return;
+        }
+
+        for (int idx : removedIndices)
+        {
+            this->imageListPanel->removeImage(idx);
+        }
+
+        int count = this->imageListSource->getImageCount();
+        int newestIdx = -1;
+
+        for (int idx = count - addedCount; idx < count; idx++)
+        {
+            if (this->imageListPanel->appendImage(idx))
+            {
+                newestIdx = idx;
+            }
+        }
+
+        if ((newestIdx >= 0) && this->doFollowNewestMenuItem->IsChecked())
+        {
+            this->imageListPanel->selectImageByDataIndex(newestIdx);
+        }
+    }
+
+    void WxivMainFrame::onAttachSharedMemory(wxCommandEvent& event)
+    {
+        wxString name = wxGetTextFromUser("Shared memory name, as the producer created it:", "Attach Shared Memory", "/wxiv", this);
+
+        if (name.empty())
+        {
+            return;
+        }
+
+        if (!name.StartsWith("/"))
+        {
+            name = "/" + name;
+        }
+
+        loadDir("shm:" + name);
+    }
+
+    void WxivMainFrame::onListenOnSocket(wxCommandEvent& event)
+    {
+        wxString path = wxGetTextFromUser("Socket path for producers to connect to:", "Listen on Socket", "/tmp/wxiv.sock", this);
+
+        if (!path.empty())
+        {
+            loadDir("unix:" + path);
+        }
+    }
+
     void WxivMainFrame::onOpenLast(wxCommandEvent& event)
     {
         wxString wpath;
@@ -650,61 +1032,197 @@ namespace Wxiv
     void WxivMainFrame::onImageListItemsChange()
     {
         this->enableDisableMenuItems();
+
+        vector<int> dataIndices = this->imageListPanel->getVisibleDataIndices();
+        vector<std::shared_ptr<WxivImage>> images;
+        images.reserve(dataIndices.size());
+
+        for (int idx : dataIndices)
+        {
+            images.push_back(this->imageListPanel->getImageByDataIndex(idx));
+        }
+
+        this->thumbnailPanel->setImages(dataIndices, images);
+        this->thumbnailPanel->setSelectedDataIndex(this->imageListPanel->getSelectedImageDataIndex());
+    }
+
+    /**
+     * @brief Select the clicked thumbnail's image in the list, which then comes back as a selection change.
+     */
+    void WxivMainFrame::onThumbnailClick(int dataIndex)
+    {
+        this->imageListPanel->selectImageByDataIndex(dataIndex);
     }
 
     /**
-     * @brief Callback from image panel when a single image is selected.
-     * @param image
+     * @brief Callback from image panel when the selection changes.
+     * An image that isn't loaded yet is loaded in the background, with the current view left up (under a spinner) until
+     * it's ready, so the UI stays responsive and stepping quickly through the list doesn't queue up loads.
+     * A big image is shown from a quick reduced-resolution decode while its full load runs.
      */
     void WxivMainFrame::onImageListSelectionChange()
     {
+        this->thumbnailPanel->setSelectedDataIndex(this->imageListPanel->getSelectedImageDataIndex());
+
         if (this->imageListPanel->getSelectedItemCount() == 1)
         {
             std::shared_ptr<WxivImage> image = this->imageListPanel->getSelectedImage();
 
-            if (image && !image->getIsLoaded())
+            if (this->imageListSource->checkIsQuickLoad(image))
             {
+                // e.g. prefetched, or a live frame with no decode
+                this->selectionLoader.cancel();
+                this->selectionLoadTimer.Stop();
+                this->mainSplitWindow->setIsLoading(false);
+                string errorMessage;
+
                 try
                 {
-                    // is not loaded yet
-                    wxBusyCursor waitCursor;
-                    int origIdx = this->imageListPanel->getSelectedImageDataIndex();
-
-                    if (this->imageListSource->loadImage(image))
-                    {
-                        if (image->getPages().size() > 0)
-                        {
-                            // multiple pages
-                            this->imageListSource->addImagePages(origIdx, image->getPages());
-                            this->imageListPanel->updateForMultiPageImageLoaded();
-                        }
-                    }
+                    this->imageListSource->loadImage(image);
                 }
                 catch (exception& ex)
                 {
-                    wxString msg = "Exception loading image:\n";
-                    msg += image->getPath().GetFullPath();
-                    msg += "\n\n";
-                    msg += ex.what();
-                    alert(msg);
+                    errorMessage = ex.what();
                 }
-            }
-
-            this->mainSplitWindow->setImage(image);
 
-            if (image->checkIsShapeSetLoadError())
+                showSelectedImage(image, errorMessage);
+            }
+            else
             {
-                alert(image->getShapeSetLoadError());
+                // the lambda keeps this source alive, in case a new dir is opened while it's loading
+                std::shared_ptr<ImageListSource> source = this->imageListSource;
+                this->selectionLoader.request(
+                    image, [source](std::shared_ptr<WxivImage> image) { source->loadImage(image); },
+                    [source](std::shared_ptr<WxivImage> image, cv::Mat& preview, cv::Size& fullSize)
+                    { return source->decodePreview(image, preview, fullSize); });
+                this->mainSplitWindow->setIsLoading(true);
+                this->selectionLoadTimer.Start(20);
             }
         }
         else
         {
+            this->selectionLoader.cancel();
+            this->selectionLoadTimer.Stop();
+            this->mainSplitWindow->setIsLoading(false);
             this->mainSplitWindow->clearImage();
         }
 
         this->enableDisableMenuItems();
     }
 
+    /**
+     * @brief Poll for the background load of the selected image, and its preview if any.
+     */
+    void WxivMainFrame::onSelectionLoadTimer(wxTimerEvent& event)
+    {
+        std::shared_ptr<WxivImage> image;
+        string errorMessage;
+        cv::Mat preview;
+        cv::Size fullSize;
+
+        if (this->selectionLoader.takeResult(image, errorMessage))
+        {
+            this->selectionLoadTimer.Stop();
+            this->mainSplitWindow->setIsLoading(false);
+
+            // the selection can't have changed without a new request or cancel, but be sure
+            if (image == this->imageListPanel->getSelectedImage())
+            {
+                showSelectedImage(image, errorMessage);
+            }
+        }
+        else if (this->selectionLoader.takePreview(image, preview, fullSize))
+        {
+            // still loading, so leave the spinner up
+            if (image == this->imageListPanel->getSelectedImage())
+            {
+                this->mainSplitWindow->setPreviewImage(preview, fullSize);
+            }
+        }
+        else if (!this->selectionLoader.checkIsBusy())
+        {
+            this->selectionLoadTimer.Stop();
+            this->mainSplitWindow->setIsLoading(false);
+        }
+    }
+
+    /**
+     * @brief The selected image has been loaded (or failed to load), so view it.
+     */
+    void WxivMainFrame::showSelectedImage(std::shared_ptr<WxivImage> image, const std::string& loadErrorMessage)
+    {
+        if (!loadErrorMessage.empty())
+        {
+            wxString msg = "Exception loading image:\n";
+            msg += image->getPath().GetFullPath();
+            msg += "\n\n";
+            msg += loadErrorMessage;
+            alert(msg);
+        }
+        else if ((image->getPages().size() > 0) && !image->getArePagesListed())
+        {
+            // pages may have been created by a prefetch, so list them the first time the image is selected
+            int origIdx = this->imageListPanel->getSelectedImageDataIndex();
+            image->setArePagesListed(true);
+            this->imageListSource->addImagePages(origIdx, image->getPages());
+            this->imageListPanel->updateForMultiPageImageLoaded();
+        }
+
+        this->mainSplitWindow->setImage(image);
+        this->imageListSource->trimMemory();
+
+        if (image->checkIsShapeSetLoadError())
+        {
+            alert(image->getShapeSetLoadError());
+        }
+
+        // a live source has its own status, from the live timer
+        if (!this->imageListSource->checkIsLive())
+        {
+            this->SetStatusText(wxString::FromUTF8(this->imageListSource->getLoadStatus().c_str()));
+        }
+
+        this->prefetchNeighborImages();
+        this->enableDisableMenuItems();
+    }
+
+    /**
+     * @brief Unload least-recently viewed images past the memory budget, e.g. between images of a batch save.
+     * The selected image is marked viewed again first, since a batch load moves that mark to the image it loaded.
+     */
+    void WxivMainFrame::trimImageMemory()
+    {
+        if (!this->imageListSource)
+        {
+            return;
+        }
+
+        if (this->imageListPanel->getSelectedItemCount() == 1)
+        {
+            std::shared_ptr<WxivImage> image = this->imageListPanel->getSelectedImage();
+
+            if (image->getIsLoaded())
+            {
+                // no decode, just marks it
+                this->imageListSource->loadImage(image);
+            }
+        }
+
+        this->imageListSource->trimMemory();
+    }
+
+    /**
+     * @brief Start loading the images the user is likely to step to next, so stepping doesn't wait on decode.
+     */
+    void WxivMainFrame::prefetchNeighborImages()
+    {
+        if (this->imageListSource)
+        {
+            vector<std::shared_ptr<WxivImage>> images = this->imageListPanel->getPrefetchImages(this->prefetchAheadCount, this->prefetchBehindCount);
+            this->imageListSource->prefetchImages(images);
+        }
+    }
+
     void WxivMainFrame::onNextImage(wxCommandEvent& event)
     {
         // selection change event comes back to this object onImageListSelectionChange
@@ -722,6 +1240,44 @@ namespace Wxiv
         this->mainSplitWindow->setViewToFitImage();
     }
 
+#ifdef DO_DICOM
+    /**
+     * @brief Re-open the current DICOM dir (whether open as files or as a volume) as files or along an axis.
+     */
+    void WxivMainFrame::onViewDicom(wxCommandEvent& event)
+    {
+        VolumeAxis axis;
+        wxString dirPath;
+
+        if (!ImageListSourceDicomVolume::tryParseLocation(this->lastOpenDir, axis, dirPath))
+        {
+            dirPath = this->lastOpenDir;
+        }
+
+        if (!wxDirExists(dirPath))
+        {
+            alert("Open a dir of DICOM files first.");
+            return;
+        }
+
+        switch (event.GetId())
+        {
+        case ID_ViewDicomAxial:
+            loadDir(ImageListSourceDicomVolume::makeLocation(VolumeAxis::Axial, dirPath));
+            break;
+        case ID_ViewDicomCoronal:
+            loadDir(ImageListSourceDicomVolume::makeLocation(VolumeAxis::Coronal, dirPath));
+            break;
+        case ID_ViewDicomSagittal:
+            loadDir(ImageListSourceDicomVolume::makeLocation(VolumeAxis::Sagittal, dirPath));
+            break;
+        default:
+            loadDir(dirPath);
+            break;
+        }
+    }
+#endif
+
     void WxivMainFrame::onToggleShapeRender(wxCommandEvent& event)
     {
         if (this->menuOptions != nullptr)
@@ -743,6 +1299,7 @@ namespace Wxiv
     void WxivMainFrame::onShowBrightnessSettings(wxCommandEvent& event)
     {
         this->mainSplitWindow->showBrightnessSettingsDialog();
+        this->thumbnailPanel->setIntensityRangeParams(this->mainSplitWindow->getIntensityRangeParams());
     }
 
     void WxivMainFrame::onSaveImage(wxCommandEvent& event)
@@ -786,6 +1343,7 @@ namespace Wxiv
 
                     // defer prompting user what to do for format mismatches and just auto-convert for now
                     wxSaveImage(newPath.GetFullPath(), img);
+                    trimImageMemory();
                 }
                 else
                 {
@@ -898,6 +1456,7 @@ namespace Wxiv
                 if (this->imageListSource->loadImage(img))
                 {
                     wxImages.push_back(mainSplitWindow->renderToWxImage(img));
+                    trimImageMemory();
                 }
                 else
                 {
@@ -931,6 +1490,7 @@ namespace Wxiv
                 if (this->imageListSource->loadImage(img))
                 {
                     images.push_back(mainSplitWindow->renderToImage(img));
+                    trimImageMemory();
                 }
                 else
                 {
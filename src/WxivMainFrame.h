@@ -9,6 +9,7 @@
 #include <wx/wxprec.h>
 #include <wx/splitter.h>
 #include <wx/notebook.h>
+#include <wx/timer.h>
 
 #ifndef WX_PRECOMP
 #include <wx/wx.h>
@@ -19,7 +20,10 @@
 #include "ImageScrollPanel.h"
 #include "WxivMainSplitWindow.h"
 #include "ImageListPanel.h"
+#include "ThumbnailPanel.h"
 #include "ImageListSource.h"
+#include "DirectoryWatcher.h"
+#include "AsyncImageLoader.h"
 
 const std::string WxivVersion = "0.1.0";
 
@@ -36,10 +40,19 @@ namespace Wxiv
       private:
         wxString lastOpenDir;
         ImageListPanel* imageListPanel = nullptr;
+        ThumbnailPanel* thumbnailPanel = nullptr;
+        wxNotebook* imageListNotebook = nullptr;
         WxivMainSplitWindow* mainSplitWindow = nullptr;
         std::shared_ptr<ImageListSource> imageListSource;
         wxSplitterWindow* mainSplitter;
 
+        // how many images to load in the background ahead of and behind the selected one
+        int prefetchAheadCount = 3;
+        int prefetchBehindCount = 1;
+
+        // limit on memory used for loaded image pixels, least-recently viewed are unloaded past this
+        int imageMemoryBudgetMb = 4096;
+
         wxMenuBar* mainMenuBar = nullptr;
         wxMenu* menuHelp = nullptr;
         wxMenu* menuFile = nullptr;
@@ -48,6 +61,20 @@ namespace Wxiv
         wxMenu* menuCapture = nullptr;
         wxMenuItem* menuItemClearCaptureList = nullptr;
 
+        // incremental updates from the open dir, when watching, polled on the timer
+        std::unique_ptr<DirectoryWatcher> dirWatcher;
+        wxTimer dirWatchTimer;
+        wxMenuItem* doWatchDirMenuItem = nullptr;
+        wxMenuItem* doFollowNewestMenuItem = nullptr;
+
+        // a live source (e.g. shared memory) is polled for new images on the timer
+        wxTimer liveTimer;
+        std::string lastLiveStatus;
+
+        // the selected image is loaded in the background, and polled for on the timer
+        AsyncImageLoader selectionLoader;
+        wxTimer selectionLoadTimer;
+
         wxMenuItem* doRenderShapesMenuItem = nullptr;
         wxMenuItem* doRenderPixelValuesMenuItem = nullptr;
 
@@ -95,8 +122,20 @@ namespace Wxiv
         void onOpenDir(wxCommandEvent& event);
         void onOpenLast(wxCommandEvent& event);
         void onReloadDir(wxCommandEvent& event);
+        void updateDirWatch();
+        void onToggleWatchDir(wxCommandEvent& event);
+        void onDirWatchTimer(wxTimerEvent& event);
+        void updateLiveTimer();
+        void onLiveTimer(wxTimerEvent& event);
+        void onAttachSharedMemory(wxCommandEvent& event);
+        void onListenOnSocket(wxCommandEvent& event);
         void onImageListSelectionChange();
+        void onSelectionLoadTimer(wxTimerEvent& event);
+        void showSelectedImage(std::shared_ptr<WxivImage> image, const std::string& loadErrorMessage);
+        void prefetchNeighborImages();
+        void trimImageMemory();
         void onImageListItemsChange();
+        void onThumbnailClick(int dataIndex);
         void onSaveImage(wxCommandEvent& event);
         void onSaveViewToFile(wxCommandEvent& event);
         void onSaveImages(wxCommandEvent& event);
@@ -126,6 +165,7 @@ namespace Wxiv
 
         // Tools
         void onFitViewToImage(wxCommandEvent& event);
+        void onViewDicom(wxCommandEvent& event);
     };
 
     enum
@@ -154,6 +194,14 @@ namespace Wxiv
         ID_SaveCaptureListToCollage,
         ID_SaveToCollage,
         ID_ShowBrightnessSettings,
+        ID_ToggleWatchDir,
+        ID_ToggleFollowNewest,
+        ID_AttachSharedMemory,
+        ID_ListenOnSocket,
+        ID_ViewDicomFiles,
+        ID_ViewDicomAxial,
+        ID_ViewDicomCoronal,
+        ID_ViewDicomSagittal,
     };
 
     class WxivApp : public wxApp
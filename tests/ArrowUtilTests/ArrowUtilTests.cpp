@@ -6,6 +6,8 @@
 #include <wx/stdpaths.h>
 
 #include "ArrowUtil.h"
+#include <arrow/io/memory.h>
+#include <arrow/ipc/writer.h>
 #include "TempFile.h"
 
 using namespace std;
@@ -43,4 +45,22 @@ namespace WxivTests
             }
         }
     }
-}
\ No newline at end of file
+
+    /**
+     * @brief Load an Arrow IPC stream from memory, e.g. the shapes of a streamed frame.
+     */
+    TEST(ArrowUtilTests, testLoadIpcBuffer)
+    {
+        std::shared_ptr<arrow::Table> ptable = ArrowUtil::createTestTable(10);
+
+        auto stream = arrow::io::BufferOutputStream::Create().ValueOrDie();
+        auto writer = arrow::ipc::MakeStreamWriter(stream, ptable->schema()).ValueOrDie();
+        ASSERT_TRUE(writer->WriteTable(*ptable).ok());
+        ASSERT_TRUE(writer->Close().ok());
+        std::shared_ptr<arrow::Buffer> buffer = stream->Finish().ValueOrDie();
+
+        std::shared_ptr<arrow::Table> rt = ArrowUtil::loadBuffer(buffer->data(), (size_t)buffer->size(), "shapes.arrows");
+        EXPECT_EQ(ptable->num_columns(), rt->num_columns());
+        EXPECT_EQ(ptable->num_rows(), rt->num_rows());
+    }
+}
@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "ArchiveIndex.h"
+#include "WxivUtil.h"
+#include "TempFile.h"
+#include "TestArchive.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+    static vector<uint8_t> toBytes(const string& s)
+    {
+        return vector<uint8_t>(s.begin(), s.end());
+    }
+
+    static void putLittleEndian(vector<uint8_t>& v, uint64_t x, int byteCount)
+    {
+        for (int i = 0; i < byteCount; i++)
+        {
+            v.push_back((uint8_t)(x >> (8 * i)));
+        }
+    }
+
+    /**
+     * @brief A zip64 end record (if end64Pos is where it is), its locator, and an end record that defers to it.
+     */
+    static void putZip64End(vector<uint8_t>& v, uint64_t end64Pos, uint64_t entryCount, uint64_t dirOffset)
+    {
+        if (end64Pos == v.size())
+        {
+            putLittleEndian(v, 0x06064b50, 4);
+            putLittleEndian(v, 44, 8);
+            putLittleEndian(v, 0, 20);
+            putLittleEndian(v, entryCount, 8);
+            putLittleEndian(v, 0, 8);
+            putLittleEndian(v, dirOffset, 8);
+        }
+
+        putLittleEndian(v, 0x07064b50, 4);
+        putLittleEndian(v, 0, 4);
+        putLittleEndian(v, end64Pos, 8);
+        putLittleEndian(v, 1, 4);
+
+        putLittleEndian(v, 0x06054b50, 4);
+        putLittleEndian(v, 0, 4);
+        putLittleEndian(v, 0xffff, 2);
+        putLittleEndian(v, 0xffff, 2);
+        putLittleEndian(v, 0, 4);
+        putLittleEndian(v, 0xffffffff, 4);
+        putLittleEndian(v, 0, 2);
+    }
+
+    static void checkIsRejected(const vector<uint8_t>& bytes)
+    {
+        TempFile tempFile("ArchiveIndexTests", "zip");
+        TestArchive::write(tempFile.GetFullPath(), bytes);
+        EXPECT_THROW(ArchiveIndex(toFilesystemPath(tempFile.GetFullPath())), std::runtime_error);
+    }
+
+    static string getEntryString(ArchiveIndex& index, const ArchiveIndex::Entry& entry)
+    {
+        return string((const char*)index.getEntryData(entry), (size_t)entry.size);
+    }
+
+    TEST(ArchiveIndexTests, testTar)
+    {
+        string longName = string(120, 'd') + "/long.png";
+        vector<TestArchive::Member> members = {
+            {"a.png", toBytes("first")},
+            {"./run1/b.png", toBytes(string(700, 'b'))},
+            {longName, toBytes("long one")},
+            {"a.png", toBytes("replaced")},
+        };
+
+        TempFile tempFile("ArchiveIndexTests", "tar");
+        TestArchive::write(tempFile.GetFullPath(), TestArchive::makeTar(members));
+        ArchiveIndex index(toFilesystemPath(tempFile.GetFullPath()));
+
+        ASSERT_EQ(index.getEntries().size(), 3);
+        EXPECT_EQ(index.getEntries()[1].name, "run1/b.png");
+        EXPECT_EQ(index.getEntries()[2].name, longName);
+
+        int i = index.findEntry("a.png");
+        ASSERT_EQ(i, 0);
+        EXPECT_EQ(getEntryString(index, index.getEntries()[i]), "replaced");
+        EXPECT_EQ(getEntryString(index, index.getEntries()[1]), string(700, 'b'));
+        EXPECT_EQ(index.getEntries()[1].compression, ArchiveIndex::Compression::Stored);
+        EXPECT_EQ(index.findEntry("missing.png"), -1);
+
+        // tar has no CRC
+        EXPECT_FALSE(index.getEntries()[0].hasCrc);
+        EXPECT_TRUE(ArchiveIndex::checkCrc(index.getEntries()[0], (const uint8_t*)"anything"));
+    }
+
+    TEST(ArchiveIndexTests, testZip)
+    {
+        vector<TestArchive::Member> members = {
+            {"dir/", {}},
+            {"dir/a.png", toBytes("stored data")},
+            {"b.geo.csv", toBytes("type,x,y\n")},
+        };
+
+        for (bool doDeflate : {false, true})
+        {
+            TempFile tempFile("ArchiveIndexTests", "zip");
+            TestArchive::write(tempFile.GetFullPath(), TestArchive::makeZip(members, doDeflate));
+            ArchiveIndex index(toFilesystemPath(tempFile.GetFullPath()));
+
+            // dirs are left out
+            ASSERT_EQ(index.getEntries().size(), 2);
+            int i = index.findEntry("dir/a.png");
+            ASSERT_EQ(i, 0);
+
+            const ArchiveIndex::Entry& entry = index.getEntries()[i];
+            EXPECT_EQ(entry.size, 11);
+            EXPECT_TRUE(entry.hasCrc);
+            EXPECT_EQ(entry.crc, ArchiveIndex::computeCrc((const uint8_t*)"stored data", 11));
+
+            if (doDeflate)
+            {
+                EXPECT_EQ(entry.compression, ArchiveIndex::Compression::Deflated);
+            }
+            else
+            {
+                // local header has an extra field the central one doesn't, which has to be skipped
+                EXPECT_EQ(entry.compression, ArchiveIndex::Compression::Stored);
+                EXPECT_EQ(getEntryString(index, entry), "stored data");
+                EXPECT_TRUE(ArchiveIndex::checkCrc(entry, index.getEntryData(entry)));
+                EXPECT_FALSE(ArchiveIndex::checkCrc(entry, (const uint8_t*)"stored date"));
+            }
+        }
+    }
+
+    TEST(ArchiveIndexTests, testStoredSizeMismatch)
+    {
+        vector<uint8_t> bytes = TestArchive::makeZip({{"a.png", toBytes("stored data")}}, false);
+
+        // the central header's uncompressed size, way more than is stored
+        size_t dirOffset = bytes[bytes.size() - 6] | (bytes[bytes.size() - 5] << 8);
+        bytes[dirOffset + 24 + 3] = 0x7f;
+        checkIsRejected(bytes);
+    }
+
+    /**
+     * @brief Offsets from the file near 2^64, where adding a header size to them wraps to inside the file.
+     */
+    TEST(ArchiveIndexTests, testWrappingOffsets)
+    {
+        const uint64_t nearMax = UINT64_MAX - 20;
+
+        // the zip64 end record
+        vector<uint8_t> bytes;
+        putZip64End(bytes, nearMax, 1, 0);
+        checkIsRejected(bytes);
+
+        // the central directory
+        bytes.clear();
+        putZip64End(bytes, 0, 1, nearMax);
+        checkIsRejected(bytes);
+
+        // a local header, with the offset in a zip64 extra field
+        bytes.clear();
+        string name = "a.png";
+        putLittleEndian(bytes, 0x02014b50, 4);
+        putLittleEndian(bytes, 20, 4);
+        putLittleEndian(bytes, 0, 12); // flags, method, time, date, crc
+        putLittleEndian(bytes, 0, 8);  // sizes
+        putLittleEndian(bytes, name.size(), 2);
+        putLittleEndian(bytes, 12, 2);
+        putLittleEndian(bytes, 0, 12); // comment length, disk, attributes
+        putLittleEndian(bytes, 0xffffffff, 4);
+        bytes.insert(bytes.end(), name.begin(), name.end());
+        putLittleEndian(bytes, 0x0001, 2);
+        putLittleEndian(bytes, 8, 2);
+        putLittleEndian(bytes, nearMax, 8);
+        size_t dirSize = bytes.size();
+        putLittleEndian(bytes, 0x06054b50, 4);
+        putLittleEndian(bytes, 0, 4);
+        putLittleEndian(bytes, 1, 2);
+        putLittleEndian(bytes, 1, 2);
+        putLittleEndian(bytes, dirSize, 4);
+        putLittleEndian(bytes, 0, 4);
+        putLittleEndian(bytes, 0, 2);
+        checkIsRejected(bytes);
+    }
+
+    TEST(ArchiveIndexTests, testCrc)
+    {
+        EXPECT_EQ(ArchiveIndex::computeCrc((const uint8_t*)"123456789", 9), 0xcbf43926);
+        EXPECT_EQ(ArchiveIndex::computeCrc(nullptr, 0), 0);
+    }
+
+    TEST(ArchiveIndexTests, testNotArchive)
+    {
+        TempFile tempFile("ArchiveIndexTests", "tar");
+        TestArchive::write(tempFile.GetFullPath(), vector<uint8_t>(1024, 'x'));
+        EXPECT_THROW(ArchiveIndex(toFilesystemPath(tempFile.GetFullPath())), std::runtime_error);
+
+        EXPECT_TRUE(ArchiveIndex::checkIsArchiveExtension(".ZIP"));
+        EXPECT_TRUE(ArchiveIndex::checkIsArchiveExtension("tar"));
+        EXPECT_FALSE(ArchiveIndex::checkIsArchiveExtension("gz"));
+    }
+}
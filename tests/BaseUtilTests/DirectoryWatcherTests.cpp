@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+
+#include "DirectoryWatcher.h"
+
+using namespace std;
+using namespace Wxiv;
+namespace fs = std::filesystem;
+
+namespace WxivTests
+{
+#ifdef __linux__
+    TEST(DirectoryWatcherTests, testWrittenAndRemoved)
+    {
+        fs::path dir = fs::temp_directory_path() / "DirectoryWatcherTests";
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+
+        {
+            DirectoryWatcher watcher(dir);
+            EXPECT_TRUE(watcher.checkIsWatching());
+            EXPECT_TRUE(watcher.takeChanges().empty());
+
+            {
+                std::ofstream f(dir / "a.png");
+                f << "not really a png";
+            }
+
+            fs::rename(dir / "a.png", dir / "b.png");
+            fs::remove(dir / "b.png");
+
+            vector<DirectoryWatcher::Change> changes = watcher.takeChanges();
+            ASSERT_EQ(changes.size(), 4);
+            EXPECT_EQ(changes[0].type, DirectoryWatcher::ChangeType::Written);
+            EXPECT_EQ(changes[0].path, dir / "a.png");
+            EXPECT_EQ(changes[1].type, DirectoryWatcher::ChangeType::Removed);
+            EXPECT_EQ(changes[1].path, dir / "a.png");
+            EXPECT_EQ(changes[2].type, DirectoryWatcher::ChangeType::Written);
+            EXPECT_EQ(changes[2].path, dir / "b.png");
+            EXPECT_EQ(changes[3].type, DirectoryWatcher::ChangeType::Removed);
+            EXPECT_EQ(changes[3].path, dir / "b.png");
+
+            EXPECT_TRUE(watcher.takeChanges().empty());
+            EXPECT_FALSE(watcher.takeIsOverflowed());
+        }
+
+        fs::remove_all(dir);
+    }
+
+    TEST(DirectoryWatcherTests, testDirGone)
+    {
+        fs::path dir = fs::temp_directory_path() / "DirectoryWatcherTests-gone";
+        fs::path movedDir = fs::temp_directory_path() / "DirectoryWatcherTests-moved";
+        fs::remove_all(dir);
+        fs::remove_all(movedDir);
+        fs::create_directories(dir);
+
+        {
+            DirectoryWatcher watcher(dir);
+
+            // what happened before is still reported
+            std::ofstream(dir / "a.png") << "not really a png";
+            fs::rename(dir, movedDir);
+            EXPECT_EQ(watcher.takeChanges().size(), 1);
+            EXPECT_FALSE(watcher.checkIsWatching());
+            EXPECT_TRUE(watcher.takeChanges().empty());
+        }
+
+        fs::rename(movedDir, dir);
+
+        {
+            DirectoryWatcher watcher(dir);
+            fs::remove_all(dir);
+            vector<DirectoryWatcher::Change> changes = watcher.takeChanges();
+            ASSERT_EQ(changes.size(), 1);
+            EXPECT_EQ(changes[0].type, DirectoryWatcher::ChangeType::Removed);
+            EXPECT_FALSE(watcher.checkIsWatching());
+        }
+    }
+
+    TEST(DirectoryWatcherTests, testMissingDirThrows)
+    {
+        EXPECT_THROW(DirectoryWatcher(fs::temp_directory_path() / "DirectoryWatcherTests-does-not-exist"), std::runtime_error);
+    }
+#endif
+}
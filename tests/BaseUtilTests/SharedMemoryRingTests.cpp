@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include "SharedMemoryRing.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+#ifndef _WIN32
+    static const char* TestRingName = "/wxiv-SharedMemoryRingTests";
+
+    /**
+     * @brief Example producer: write a frame of 8-bit gray filled with one value.
+     */
+    static void writeTestFrame(WxivShmRing& ring, int width, int height, uint8_t value, const char* name)
+    {
+        vector<uint8_t> pixels((size_t)width * height, value);
+        ASSERT_EQ(wxivShmRingWriteFrame(&ring, pixels.data(), width, height, 1, WXIV_SHM_DEPTH_8U, width, name), 0);
+    }
+
+    TEST(SharedMemoryRingTests, testFrames)
+    {
+        WxivShmRing producer;
+        ASSERT_EQ(wxivShmRingCreate(TestRingName, 3, 64 * 48, &producer), 0);
+
+        {
+            SharedMemoryRing ring(TestRingName);
+            EXPECT_EQ(ring.getSlotCount(), 3);
+            EXPECT_EQ(ring.getLastSequence(), 0);
+            EXPECT_TRUE(ring.getFramesAfter(0).empty());
+
+            // too big for the slots
+            EXPECT_EQ(wxivShmRingBeginFrame(&producer, 65, 48, 1, WXIV_SHM_DEPTH_8U, 65, "big"), nullptr);
+
+            writeTestFrame(producer, 64, 48, 1, "first");
+            writeTestFrame(producer, 32, 16, 2, "second");
+            EXPECT_EQ(ring.getLastSequence(), 2);
+
+            vector<SharedMemoryRing::Frame> frames = ring.getFramesAfter(0);
+            ASSERT_EQ(frames.size(), 2);
+            EXPECT_EQ(frames[0].sequence, 1);
+            EXPECT_EQ(frames[0].name, "first");
+            EXPECT_EQ(frames[1].width, 32);
+            EXPECT_EQ(frames[1].height, 16);
+            EXPECT_EQ(frames[1].rowStride, 32);
+            EXPECT_EQ(frames[1].pixels[0], 2);
+            EXPECT_GT(frames[1].timestampNs, 0);
+            EXPECT_LE(frames[1].timestampNs, SharedMemoryRing::getMonotonicNs());
+            EXPECT_EQ(ring.getFramesAfter(1).size(), 1);
+
+            // pinned one is skipped when the ring wraps
+            ASSERT_TRUE(ring.pin(frames[0]));
+            writeTestFrame(producer, 8, 8, 3, "third");
+            writeTestFrame(producer, 8, 8, 4, "fourth");
+            writeTestFrame(producer, 8, 8, 5, "fifth");
+
+            EXPECT_TRUE(ring.checkIsIntact(frames[0]));
+            EXPECT_FALSE(ring.checkIsIntact(frames[1]));
+            EXPECT_EQ(frames[0].pixels[0], 1);
+
+            frames = ring.getFramesAfter(0);
+            ASSERT_EQ(frames.size(), 3);
+            EXPECT_EQ(frames[0].sequence, 1);
+            EXPECT_EQ(frames[1].sequence, 4);
+            EXPECT_EQ(frames[2].sequence, 5);
+
+            // can't pin one that's gone
+            ring.unpin();
+            writeTestFrame(producer, 8, 8, 6, "sixth");
+            EXPECT_FALSE(ring.pin(frames[0]));
+        }
+
+        wxivShmRingClose(&producer, 1);
+        EXPECT_THROW(SharedMemoryRing ring(TestRingName), std::runtime_error);
+    }
+
+    TEST(SharedMemoryRingTests, testUnpinOnlyOwnPin)
+    {
+        WxivShmRing producer;
+        ASSERT_EQ(wxivShmRingCreate(TestRingName, 3, 64 * 48, &producer), 0);
+        writeTestFrame(producer, 8, 8, 1, "first");
+        writeTestFrame(producer, 8, 8, 2, "second");
+
+        {
+            // e.g. the source being replaced by a new one on the same ring
+            auto oldRing = std::make_unique<SharedMemoryRing>(TestRingName);
+            SharedMemoryRing newRing(TestRingName);
+            vector<SharedMemoryRing::Frame> frames = newRing.getFramesAfter(0);
+            ASSERT_EQ(frames.size(), 2);
+
+            ASSERT_TRUE(oldRing->pin(frames[0]));
+            ASSERT_TRUE(newRing.pin(frames[1]));
+            oldRing.reset();
+            EXPECT_EQ(wxivShmLoad(&producer.header->pinnedSequence), frames[1].sequence);
+
+            newRing.unpin();
+            EXPECT_EQ(wxivShmLoad(&producer.header->pinnedSequence), 0);
+        }
+
+        wxivShmRingClose(&producer, 1);
+    }
+
+    /**
+     * @brief A producer writing as fast as it can never changes the pinned frame's pixels.
+     */
+    TEST(SharedMemoryRingTests, testPinWhileWriting)
+    {
+        WxivShmRing producer;
+        ASSERT_EQ(wxivShmRingCreate(TestRingName, 4, 256 * 256, &producer), 0);
+        std::atomic<bool> isStopping = false;
+        std::atomic<int> writtenCount = 0;
+
+        std::thread t(
+            [&]()
+            {
+                for (uint8_t value = 1; !isStopping; value = (value % 250) + 1)
+                {
+                    writeTestFrame(producer, 256, 256, value, "");
+                    writtenCount++;
+                }
+            });
+
+        SharedMemoryRing ring(TestRingName);
+        int pinnedCount = 0;
+
+        auto start = std::chrono::steady_clock::now();
+
+        // until plenty of pins overlapped plenty of writes
+        while (((pinnedCount < 100) || (writtenCount < 1000)) && (std::chrono::steady_clock::now() - start < std::chrono::seconds(5)))
+        {
+            vector<SharedMemoryRing::Frame> frames = ring.getFramesAfter(0);
+
+            if (!frames.empty() && ring.pin(frames.back()))
+            {
+                const SharedMemoryRing::Frame& frame = frames.back();
+                uint8_t value = frame.pixels[0];
+
+                for (int k = 0; k < 1000; k++)
+                {
+                    ASSERT_EQ(frame.pixels[(k * 65) % (256 * 256)], value);
+                }
+
+                EXPECT_TRUE(ring.checkIsIntact(frame));
+                pinnedCount++;
+            }
+        }
+
+        isStopping = true;
+        t.join();
+        EXPECT_GE(pinnedCount, 100);
+        EXPECT_GE(writtenCount, 1000);
+        wxivShmRingClose(&producer, 1);
+    }
+#endif
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <functional>
+
+#include "SocketFrameReceiver.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+#ifndef _WIN32
+    static const char* TestSocketPath = "/tmp/wxiv-SocketFrameReceiverTests.sock";
+
+    /**
+     * @brief Wait up to a couple seconds for the receiver thread to get there.
+     */
+    static bool waitFor(std::function<bool()> isDone)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        while (!isDone())
+        {
+            if (std::chrono::steady_clock::now() - start > std::chrono::seconds(2))
+            {
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Example producer: send a frame of 8-bit gray filled with one value.
+     */
+    static int sendTestFrame(int fd, uint8_t value, uint32_t flags, const char* name)
+    {
+        vector<uint8_t> pixels(32 * 16, value);
+        return wxivStreamSendRawFrame(fd, pixels.data(), 32, 16, 1, WXIV_STREAM_DEPTH_8U, flags, name);
+    }
+
+    TEST(SocketFrameReceiverTests, testFrames)
+    {
+        SocketFrameReceiver receiver(TestSocketPath);
+        int fd = wxivStreamConnect(TestSocketPath);
+        ASSERT_GE(fd, 0);
+        EXPECT_TRUE(waitFor([&]() { return receiver.checkIsConnected(); }));
+
+        ASSERT_EQ(sendTestFrame(fd, 7, 0, "first"), 0);
+
+        // an encoded image with shapes, which the receiver passes through
+        vector<uint8_t> image = {1, 2, 3, 4, 5};
+        vector<uint8_t> shapes = {6, 7, 8};
+        WxivStreamFrameHeader header;
+        wxivStreamInitHeader(&header, "png", image.size(), shapes.size(), 0, "second");
+        ASSERT_EQ(wxivStreamSendFrame(fd, &header, image.data(), shapes.data()), 0);
+
+        vector<std::shared_ptr<SocketFrameReceiver::Frame>> frames;
+        EXPECT_TRUE(waitFor(
+            [&]()
+            {
+                for (auto& frame : receiver.takeFrames())
+                {
+                    frames.push_back(frame);
+                }
+
+                return frames.size() >= 2;
+            }));
+
+        ASSERT_EQ(frames.size(), 2);
+        EXPECT_EQ(frames[0]->format, "raw");
+        EXPECT_EQ(frames[0]->name, "first");
+        EXPECT_EQ(frames[0]->header.width, 32);
+        EXPECT_EQ(frames[0]->image.size(), 32 * 16);
+        EXPECT_EQ(frames[0]->image[0], 7);
+        EXPECT_EQ(frames[1]->format, "png");
+        EXPECT_EQ(frames[1]->image, image);
+        EXPECT_EQ(frames[1]->shapes, shapes);
+        EXPECT_EQ(receiver.getReceivedCount(), 2);
+
+        // raw size doesn't match the dims, so the connection is closed
+        wxivStreamInitHeader(&header, "raw", 10, 0, 0, "bad");
+        header.width = 3;
+        header.height = 3;
+        header.channels = 1;
+
+        // (the receiver may close before the payload is sent)
+        wxivStreamSendFrame(fd, &header, image.data(), nullptr);
+        EXPECT_TRUE(waitFor([&]() { return receiver.getErrorCount() == 1; }));
+        EXPECT_TRUE(waitFor([&]() { return !receiver.checkIsConnected(); }));
+        close(fd);
+
+        // and the next producer can connect
+        fd = wxivStreamConnect(TestSocketPath);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(sendTestFrame(fd, 9, 0, "third"), 0);
+        EXPECT_TRUE(waitFor([&]() { return receiver.getReceivedCount() == 3; }));
+        close(fd);
+    }
+
+    TEST(SocketFrameReceiverTests, testBackpressure)
+    {
+        SocketFrameReceiver receiver(TestSocketPath, 2);
+        int fd = wxivStreamConnect(TestSocketPath);
+        ASSERT_GE(fd, 0);
+
+        for (int i = 0; i < 5; i++)
+        {
+            ASSERT_EQ(sendTestFrame(fd, (uint8_t)i, 0, to_string(i).c_str()), 0);
+        }
+
+        // two queued and one waiting for space, the rest left in the socket
+        EXPECT_TRUE(waitFor([&]() { return receiver.checkIsWaitingForSpace(); }));
+        EXPECT_EQ(receiver.getReceivedCount(), 3);
+        EXPECT_EQ(receiver.getDroppedCount(), 0);
+
+        vector<std::shared_ptr<SocketFrameReceiver::Frame>> frames = receiver.takeFrames();
+        ASSERT_EQ(frames.size(), 2);
+        EXPECT_EQ(frames[0]->name, "0");
+        EXPECT_TRUE(waitFor([&]() { return receiver.getReceivedCount() == 5; }));
+        close(fd);
+    }
+
+    TEST(SocketFrameReceiverTests, testDrop)
+    {
+        SocketFrameReceiver receiver(TestSocketPath, 2);
+        int fd = wxivStreamConnect(TestSocketPath);
+        ASSERT_GE(fd, 0);
+
+        for (int i = 0; i < 5; i++)
+        {
+            ASSERT_EQ(sendTestFrame(fd, (uint8_t)i, WXIV_STREAM_FLAG_MAY_DROP, to_string(i).c_str()), 0);
+        }
+
+        // the newest are kept
+        EXPECT_TRUE(waitFor([&]() { return receiver.getReceivedCount() == 5; }));
+        EXPECT_EQ(receiver.getDroppedCount(), 3);
+
+        vector<std::shared_ptr<SocketFrameReceiver::Frame>> frames = receiver.takeFrames();
+        ASSERT_EQ(frames.size(), 2);
+        EXPECT_EQ(frames[0]->name, "3");
+        EXPECT_EQ(frames[1]->name, "4");
+        close(fd);
+    }
+
+    /**
+     * @brief A payload bigger than the first read buffer, which grows as the bytes arrive.
+     */
+    TEST(SocketFrameReceiverTests, testBigFrame)
+    {
+        SocketFrameReceiver receiver(TestSocketPath);
+        int fd = wxivStreamConnect(TestSocketPath);
+        ASSERT_GE(fd, 0);
+
+        int width = 2048;
+        int height = 1500;
+        vector<uint8_t> pixels((size_t)width * height);
+
+        for (size_t i = 0; i < pixels.size(); i++)
+        {
+            pixels[i] = (uint8_t)(i % 251);
+        }
+
+        ASSERT_EQ(wxivStreamSendRawFrame(fd, pixels.data(), width, height, 1, WXIV_STREAM_DEPTH_8U, 0, "big"), 0);
+        EXPECT_TRUE(waitFor([&]() { return receiver.getReceivedCount() == 1; }));
+
+        vector<std::shared_ptr<SocketFrameReceiver::Frame>> frames = receiver.takeFrames();
+        ASSERT_EQ(frames.size(), 1);
+        EXPECT_EQ(frames[0]->image, pixels);
+        close(fd);
+    }
+
+    /**
+     * @brief Listening again on the same path takes it over, and the old one going away doesn't remove the new socket.
+     */
+    TEST(SocketFrameReceiverTests, testRelisten)
+    {
+        auto oldReceiver = std::make_unique<SocketFrameReceiver>(TestSocketPath);
+        SocketFrameReceiver receiver(TestSocketPath);
+        oldReceiver.reset();
+
+        int fd = wxivStreamConnect(TestSocketPath);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(sendTestFrame(fd, 1, 0, ""), 0);
+        EXPECT_TRUE(waitFor([&]() { return receiver.getReceivedCount() == 1; }));
+        close(fd);
+    }
+#endif
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <opencv2/opencv.hpp>
+
+#include "TiffUtil.h"
+#include "WxivUtil.h"
+#include "TempFile.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+    void writeMultiPageTif(const wxString& path, int pageCount)
+    {
+        vector<cv::Mat> pages;
+
+        for (int i = 0; i < pageCount; i++)
+        {
+            cv::Mat img(32, 48, CV_16U);
+            img = i * 100;
+            pages.push_back(img);
+        }
+
+        EXPECT_TRUE(cv::imwrite(path.ToStdString(), pages));
+    }
+
+    TEST(TiffUtilTests, testCountPages)
+    {
+        for (int pageCount : {1, 2, 37})
+        {
+            TempFile tempFile("TiffUtilTests", "tif");
+            writeMultiPageTif(tempFile.GetFullPath(), pageCount);
+
+            EXPECT_EQ(pageCount, TiffUtil::countPages(toFilesystemPath(tempFile.GetFullPath())));
+            EXPECT_EQ(pageCount, wxCountImagePages(tempFile.GetFullPath()));
+        }
+    }
+
+    TEST(TiffUtilTests, testLoadSinglePage)
+    {
+        TempFile tempFile("TiffUtilTests", "tif");
+        writeMultiPageTif(tempFile.GetFullPath(), 10);
+
+        vector<cv::Mat> mats;
+        EXPECT_TRUE(wxLoadImage(tempFile.GetFullPath(), mats, 7));
+        ASSERT_EQ(1, mats.size());
+        EXPECT_EQ(CV_16U, mats[0].type());
+        EXPECT_EQ(700, mats[0].at<uint16_t>(5, 5));
+    }
+
+    TEST(TiffUtilTests, testNotTiffThrows)
+    {
+        TempFile tempFile("TiffUtilTests", "tif");
+
+        {
+            std::ofstream f(toFilesystemPath(tempFile.GetFullPath()), std::ios::binary);
+            f << "not a tiff file";
+        }
+
+        EXPECT_THROW(TiffUtil::countPages(toFilesystemPath(tempFile.GetFullPath())), std::runtime_error);
+    }
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <fmt/core.h>
+
+#include "DicomIndex.h"
+#include "WxWidgetsUtil.h"
+
+#include "dcmtk/dcmdata/dcfilefo.h"
+#include "dcmtk/dcmdata/dcdeftag.h"
+#include "dcmtk/dcmdata/dcuid.h"
+
+using namespace std;
+using namespace Wxiv;
+namespace fs = std::filesystem;
+
+namespace WxivTests
+{
+    // same as in DicomIndex.cpp
+    static const int MaxCachedDirs = 8;
+
+    static fs::path makeTestDir(const std::string& name)
+    {
+        fs::path dirPath = fs::temp_directory_path() / fmt::format("DicomIndexTests-{}-{}", name, std::random_device()());
+        fs::create_directories(dirPath);
+        return dirPath;
+    }
+
+    /**
+     * @brief Write a small CT slice at this z, or a structure set (with no contours) if rows is 0.
+     */
+    static wxString writeTestDcm(const fs::path& path, int instanceNumber, double z, int rows = 4)
+    {
+        DcmFileFormat dcmFile;
+        DcmDataset* dataset = dcmFile.getDataset();
+        char uid[100];
+        bool isStructureSet = (rows == 0);
+
+        dataset->putAndInsertString(DCM_SOPClassUID, isStructureSet ? UID_RTStructureSetStorage : UID_CTImageStorage);
+        dataset->putAndInsertString(DCM_SOPInstanceUID, dcmGenerateUniqueIdentifier(uid, SITE_INSTANCE_UID_ROOT));
+        dataset->putAndInsertString(DCM_SeriesInstanceUID, "1.2.826.0.1.3680043.2.1125.1");
+        dataset->putAndInsertString(DCM_Modality, isStructureSet ? "RTSTRUCT" : "CT");
+
+        if (!isStructureSet)
+        {
+            int cols = 6;
+            vector<Uint16> pixels(rows * cols, (Uint16)instanceNumber);
+            dataset->putAndInsertString(DCM_InstanceNumber, to_string(instanceNumber).c_str());
+            dataset->putAndInsertString(DCM_ImagePositionPatient, fmt::format("-10\\-20\\{}", z).c_str());
+            dataset->putAndInsertString(DCM_ImageOrientationPatient, "1\\0\\0\\0\\1\\0");
+            dataset->putAndInsertString(DCM_PixelSpacing, "0.5\\0.25");
+            dataset->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+            dataset->putAndInsertUint16(DCM_SamplesPerPixel, 1);
+            dataset->putAndInsertUint16(DCM_Rows, (Uint16)rows);
+            dataset->putAndInsertUint16(DCM_Columns, (Uint16)cols);
+            dataset->putAndInsertUint16(DCM_BitsAllocated, 16);
+            dataset->putAndInsertUint16(DCM_BitsStored, 16);
+            dataset->putAndInsertUint16(DCM_HighBit, 15);
+            dataset->putAndInsertUint16(DCM_PixelRepresentation, 0);
+            dataset->putAndInsertUint16Array(DCM_PixelData, pixels.data(), (unsigned long)pixels.size());
+        }
+
+        EXPECT_TRUE(dcmFile.saveFile(path.string().c_str(), EXS_LittleEndianExplicit).good());
+        return wxString(path.string());
+    }
+
+    TEST(DicomIndexTests, testEntries)
+    {
+        fs::path dirPath = makeTestDir("entries");
+        vector<wxString> paths;
+
+        for (int i = 0; i < 3; i++)
+        {
+            paths.push_back(writeTestDcm(dirPath / fmt::format("ct{}.dcm", i), i + 1, 2.5 * i));
+        }
+
+        paths.push_back(writeTestDcm(dirPath / "rtstruct.dcm", 0, 0, 0));
+
+        fs::path badPath = dirPath / "bad.dcm";
+        std::ofstream(badPath) << "not a dicom file";
+        paths.push_back(wxString(badPath.string()));
+
+        {
+            DicomIndex index(paths);
+            const vector<DicomIndex::Entry>& entries = index.getEntries();
+            ASSERT_EQ(entries.size(), paths.size());
+
+            for (int i = 0; i < 3; i++)
+            {
+                const DicomIndex::Entry& entry = entries[i];
+                EXPECT_EQ(entry.path, paths[i]);
+                EXPECT_TRUE(entry.isRead);
+                EXPECT_FALSE(entry.isStructureSet);
+                EXPECT_EQ(entry.modality, "CT");
+                EXPECT_EQ(entry.instanceNumber, i + 1);
+                EXPECT_EQ(entry.rows, 4);
+                EXPECT_EQ(entry.cols, 6);
+                EXPECT_FALSE(entry.sopInstanceUid.empty());
+                EXPECT_EQ(entry.seriesInstanceUid, "1.2.826.0.1.3680043.2.1125.1");
+                ASSERT_TRUE(entry.hasPosition && entry.hasOrientation && entry.hasPixelSpacing);
+                EXPECT_DOUBLE_EQ(entry.position[0], -10);
+                EXPECT_DOUBLE_EQ(entry.position[2], 2.5 * i);
+                EXPECT_DOUBLE_EQ(entry.orientation[4], 1);
+                EXPECT_DOUBLE_EQ(entry.pixelSpacing[0], 0.5);
+                EXPECT_DOUBLE_EQ(entry.pixelSpacing[1], 0.25);
+            }
+
+            EXPECT_NE(entries[0].sopInstanceUid, entries[1].sopInstanceUid);
+
+            // read, and a structure set even with no contours
+            EXPECT_TRUE(entries[3].isRead);
+            EXPECT_TRUE(entries[3].isStructureSet);
+            EXPECT_TRUE(index.getContours().empty());
+            EXPECT_EQ(index.findSlicePolygons(entries[0].sopInstanceUid), nullptr);
+
+            // listed, but nothing known
+            EXPECT_FALSE(entries[4].isRead);
+            EXPECT_FALSE(entries[4].isStructureSet);
+            EXPECT_TRUE(entries[4].sopInstanceUid.empty());
+        }
+
+        fs::remove_all(dirPath);
+    }
+
+    TEST(DicomIndexTests, testCacheIsCurrent)
+    {
+        fs::path dirPath = makeTestDir("current");
+        wxString dirStr(dirPath.string());
+        vector<wxString> paths;
+
+        for (int i = 0; i < 3; i++)
+        {
+            paths.push_back(writeTestDcm(dirPath / fmt::format("ct{}.dcm", i), i + 1, i));
+        }
+
+        std::shared_ptr<DicomIndex> index = DicomIndex::getForDir(dirStr, paths);
+        EXPECT_EQ(DicomIndex::getForDir(dirStr, paths), index);
+
+        // a file rewritten with a different size
+        writeTestDcm(dirPath / "ct1.dcm", 2, 1, 8);
+        std::shared_ptr<DicomIndex> resized = DicomIndex::getForDir(dirStr, paths);
+        EXPECT_NE(resized, index);
+        EXPECT_EQ(resized->getEntries()[1].rows, 8);
+        EXPECT_EQ(DicomIndex::getForDir(dirStr, paths), resized);
+
+        // same size, but touched
+        fs::path touchedPath = dirPath / "ct2.dcm";
+        fs::last_write_time(touchedPath, fs::last_write_time(touchedPath) + std::chrono::hours(1));
+        std::shared_ptr<DicomIndex> touched = DicomIndex::getForDir(dirStr, paths);
+        EXPECT_NE(touched, resized);
+
+        // a file added
+        paths.push_back(writeTestDcm(dirPath / "ct3.dcm", 4, 3));
+        std::shared_ptr<DicomIndex> added = DicomIndex::getForDir(dirStr, paths);
+        EXPECT_NE(added, touched);
+        EXPECT_EQ(added->getEntries().size(), 4);
+
+        // and removed
+        paths.erase(paths.begin());
+        std::shared_ptr<DicomIndex> removed = DicomIndex::getForDir(dirStr, paths);
+        EXPECT_NE(removed, added);
+        EXPECT_EQ(removed->getEntries().size(), 3);
+
+        fs::remove_all(dirPath);
+    }
+
+    TEST(DicomIndexTests, testCacheLru)
+    {
+        vector<fs::path> dirPaths;
+        vector<vector<wxString>> pathsByDir;
+
+        for (int d = 0; d < MaxCachedDirs + 1; d++)
+        {
+            dirPaths.push_back(makeTestDir(fmt::format("lru{}", d)));
+            pathsByDir.push_back({writeTestDcm(dirPaths[d] / "ct.dcm", 1, 0)});
+        }
+
+        auto getIndex = [&](int d) { return DicomIndex::getForDir(wxString(dirPaths[d].string()), pathsByDir[d]); };
+        vector<std::shared_ptr<DicomIndex>> indexes;
+
+        for (int d = 0; d < MaxCachedDirs; d++)
+        {
+            indexes.push_back(getIndex(d));
+        }
+
+        // using the first makes the second the least recently used, so that's the one dropped for one more dir
+        EXPECT_EQ(getIndex(0), indexes[0]);
+        getIndex(MaxCachedDirs);
+
+        EXPECT_EQ(getIndex(0), indexes[0]);
+        EXPECT_EQ(getIndex(2), indexes[2]);
+        EXPECT_NE(getIndex(1), indexes[1]);
+
+        for (const fs::path& dirPath : dirPaths)
+        {
+            fs::remove_all(dirPath);
+        }
+    }
+}
@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+
+#include <opencv2/opencv.hpp>
+
+#include "AsyncImageLoader.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+    /**
+     * @brief Poll until the loader has a result, or give up after a while.
+     */
+    static bool waitForResult(AsyncImageLoader& loader, std::shared_ptr<WxivImage>& image, std::string& errorMessage)
+    {
+        for (int i = 0; i < 500; i++)
+        {
+            if (loader.takeResult(image, errorMessage))
+            {
+                return true;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief A one-way signal between the test and a load function running on a worker thread.
+     */
+    class Gate
+    {
+      private:
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool isOpen = false;
+
+      public:
+        void open()
+        {
+            {
+                const std::lock_guard<std::mutex> lock(this->mutex);
+                this->isOpen = true;
+            }
+
+            this->condition.notify_all();
+        }
+
+        bool wait()
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            return this->condition.wait_for(lock, std::chrono::seconds(5), [this]() { return this->isOpen; });
+        }
+
+        bool checkIsOpen()
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            return this->isOpen;
+        }
+    };
+
+    /**
+     * @brief After a superseded load function has returned, the worker drops its result right after, so make sure
+     * nothing shows up for a little while.
+     */
+    static bool checkNoResult(AsyncImageLoader& loader)
+    {
+        std::shared_ptr<WxivImage> image;
+        string errorMessage;
+
+        for (int i = 0; i < 20; i++)
+        {
+            if (loader.takeResult(image, errorMessage))
+            {
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        return true;
+    }
+
+    TEST(AsyncImageLoaderTests, testLatestWins)
+    {
+        AsyncImageLoader loader;
+        auto slowImage = std::make_shared<WxivImage>(cv::Mat(4, 4, CV_8U));
+        auto fastImage = std::make_shared<WxivImage>(cv::Mat(4, 4, CV_8U));
+        Gate slowStarted, slowRelease, slowFinished;
+
+        loader.request(slowImage, [&](std::shared_ptr<WxivImage>) {
+            slowStarted.open();
+            slowRelease.wait();
+            slowFinished.open();
+        });
+
+        // superseded while the slow one is running, and doesn't wait for it
+        ASSERT_TRUE(slowStarted.wait());
+        loader.request(fastImage, [](std::shared_ptr<WxivImage>) {});
+        EXPECT_TRUE(loader.checkIsBusy());
+
+        std::shared_ptr<WxivImage> image;
+        string errorMessage;
+        bool didGetResult = waitForResult(loader, image, errorMessage);
+        EXPECT_FALSE(slowFinished.checkIsOpen());
+        slowRelease.open();
+        ASSERT_TRUE(didGetResult);
+        EXPECT_EQ(image, fastImage);
+        EXPECT_TRUE(errorMessage.empty());
+        EXPECT_FALSE(loader.checkIsBusy());
+
+        // the stale one's result is dropped
+        ASSERT_TRUE(slowFinished.wait());
+        EXPECT_TRUE(checkNoResult(loader));
+    }
+
+    TEST(AsyncImageLoaderTests, testPreview)
+    {
+        AsyncImageLoader loader;
+        auto img = std::make_shared<WxivImage>(wxString("not-loaded.png")); // not loaded, so gets a preview
+        Gate previewTaken;
+
+        loader.request(
+            img,
+            [&](std::shared_ptr<WxivImage>) {
+                // finish only after the preview was seen, so the test isn't racy
+                previewTaken.wait();
+            },
+            [](std::shared_ptr<WxivImage>, cv::Mat& preview, cv::Size& fullSize) {
+                preview = cv::Mat(2, 2, CV_8U, cv::Scalar(9));
+                fullSize = cv::Size(4, 4);
+                return true;
+            });
+
+        std::shared_ptr<WxivImage> image;
+        cv::Mat preview;
+        cv::Size fullSize;
+        bool didTakePreview = false;
+
+        for (int i = 0; (i < 500) && !didTakePreview; i++)
+        {
+            didTakePreview = loader.takePreview(image, preview, fullSize);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        ASSERT_TRUE(didTakePreview);
+        EXPECT_EQ(image, img);
+        EXPECT_EQ(preview.size(), cv::Size(2, 2));
+        EXPECT_EQ(fullSize, cv::Size(4, 4));
+        EXPECT_FALSE(loader.takePreview(image, preview, fullSize));
+        previewTaken.open();
+
+        string errorMessage;
+        ASSERT_TRUE(waitForResult(loader, image, errorMessage));
+        EXPECT_EQ(image, img);
+    }
+
+    TEST(AsyncImageLoaderTests, testErrorAndCancel)
+    {
+        AsyncImageLoader loader;
+        auto img = std::make_shared<WxivImage>(cv::Mat(4, 4, CV_8U));
+
+        loader.request(img, [](std::shared_ptr<WxivImage>) { throw std::runtime_error("bad file"); });
+        std::shared_ptr<WxivImage> image;
+        string errorMessage;
+        ASSERT_TRUE(waitForResult(loader, image, errorMessage));
+        EXPECT_EQ(errorMessage, "bad file");
+
+        Gate cancelledStarted, cancelledRelease, cancelledFinished;
+        loader.request(img, [&](std::shared_ptr<WxivImage>) {
+            cancelledStarted.open();
+            cancelledRelease.wait();
+            cancelledFinished.open();
+        });
+        ASSERT_TRUE(cancelledStarted.wait());
+        loader.cancel();
+        EXPECT_FALSE(loader.checkIsBusy());
+        cancelledRelease.open();
+        ASSERT_TRUE(cancelledFinished.wait());
+        EXPECT_TRUE(checkNoResult(loader));
+    }
+}
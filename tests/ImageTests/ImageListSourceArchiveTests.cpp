@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+
+#include <opencv2/opencv.hpp>
+
+#include "WxWidgetsUtil.h"
+#include "MappedImage.h"
+#include "TempFile.h"
+#include "TestArchive.h"
+#include "ImageListSourceArchive.h"
+#include "ThumbnailCache.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+    static vector<uint8_t> encodePng(const cv::Mat& img)
+    {
+        vector<uint8_t> bytes;
+        cv::imencode(".png", img, bytes);
+        return bytes;
+    }
+
+    static vector<uint8_t> makeRaw(const cv::Mat& img)
+    {
+        RawImageHeader header = {};
+        memcpy(header.magic, "WXIVRAW", 8);
+        header.headerSize = 64;
+        header.width = img.cols;
+        header.height = img.rows;
+        header.channels = 1;
+        header.depth = img.depth();
+
+        vector<uint8_t> bytes(64 + img.total() * img.elemSize());
+        memcpy(bytes.data(), &header, sizeof(header));
+        memcpy(bytes.data() + 64, img.data, img.total() * img.elemSize());
+        return bytes;
+    }
+
+    TEST(ImageListSourceArchiveTests, testLoad)
+    {
+        cv::Mat img(24, 32, CV_8U);
+        cv::randu(img, 0, 255);
+        string csv = "type,x,y,dim1\n1,3,4,2\n1,5,6,2\n";
+
+        vector<TestArchive::Member> members = {
+            {"run1/step01.png", encodePng(img)},
+            {"run1/step01.geo.csv", vector<uint8_t>(csv.begin(), csv.end())},
+            {"run1/step02.raw", makeRaw(img)},
+            {"run1/notes.txt", {'h', 'i'}},
+        };
+
+        for (bool doZip : {false, true})
+        {
+            TempFile tempFile("ImageListSourceArchiveTests", doZip ? "zip" : "tar");
+            TestArchive::write(tempFile.GetFullPath(), doZip ? TestArchive::makeZip(members, true) : TestArchive::makeTar(members));
+            EXPECT_TRUE(ImageListSourceArchive::checkIsArchiveFile(tempFile.GetFullPath()));
+
+            ImageListSourceArchive source;
+            source.load(tempFile.GetFullPath());
+            ASSERT_EQ(source.getImageCount(), 2);
+
+            auto png = source.getImage(0);
+            EXPECT_EQ(png->getName(), "run1/step01.png");
+            EXPECT_FALSE(png->getIsLoaded());
+            ASSERT_TRUE(source.loadImage(png));
+            EXPECT_EQ(cv::norm(png->getImage(), img, cv::NORM_INF), 0);
+            EXPECT_EQ(png->getShapes().points.size(), 2);
+
+            // compressed raw can't be wrapped in place
+            auto raw = source.getImage(1);
+
+            if (doZip)
+            {
+                EXPECT_THROW(source.loadImage(raw), std::runtime_error);
+            }
+            else
+            {
+                ASSERT_TRUE(source.loadImage(raw));
+                EXPECT_EQ(cv::norm(raw->getImage(), img, cv::NORM_INF), 0);
+            }
+        }
+    }
+
+    /**
+     * @brief Wait for the background pass to read the member headers.
+     */
+    static bool waitForHeaders(ImageListSource& source)
+    {
+        for (int i = 0; (i < 500) && source.checkIsProbingHeaders(); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        return !source.checkIsProbingHeaders();
+    }
+
+    TEST(ImageListSourceArchiveTests, testSameNameHeadersAndThumbnails)
+    {
+        cv::Mat img1(24, 32, CV_8U, cv::Scalar(1));
+        cv::Mat img2(48, 64, CV_16U, cv::Scalar(2));
+
+        vector<TestArchive::Member> members = {
+            {"run1/out.png", encodePng(img1)},
+            {"run2/out.png", encodePng(img2)},
+            {"run2/out.raw", makeRaw(img1)},
+        };
+
+        TempFile tempFile("ImageListSourceArchiveTests", "zip");
+        TestArchive::write(tempFile.GetFullPath(), TestArchive::makeZip(members, false));
+
+        auto source = std::make_shared<ImageListSourceArchive>();
+        source->load(tempFile.GetFullPath());
+        ASSERT_EQ(source->getImageCount(), 3);
+
+        // listed by path in the archive, so the two are told apart
+        EXPECT_EQ(source->getImage(0)->getDisplayName(), "run1/out.png");
+        EXPECT_EQ(source->getImage(1)->getDisplayName(), "run2/out.png");
+
+        ASSERT_TRUE(waitForHeaders(*source));
+        ImageHeaderInfo info = source->getImage(1)->getHeaderInfo();
+        EXPECT_EQ(info.width, 64);
+        EXPECT_EQ(info.height, 48);
+        EXPECT_EQ(info.depth, CV_16U);
+        info = source->getImage(2)->getHeaderInfo();
+        EXPECT_EQ(info.width, 32);
+        EXPECT_EQ(info.depth, CV_8U);
+
+        // made from the member, without loading the image
+        ThumbnailCache cache("", 16, 1);
+        cache.setSource(source);
+        cv::Mat thumb = cache.makeThumbnail(source->getImage(1));
+        EXPECT_EQ(thumb.size(), cv::Size(16, 12));
+        EXPECT_EQ(thumb.type(), CV_16U);
+        EXPECT_FALSE(source->getImage(1)->getIsLoaded());
+    }
+
+    TEST(ImageListSourceArchiveTests, testCorruptMember)
+    {
+        cv::Mat img(24, 32, CV_8U, cv::Scalar(3));
+        vector<TestArchive::Member> members = {
+            {"a.png", encodePng(img)},
+            {"b.raw", makeRaw(img)},
+        };
+
+        // flip a pixel byte of each stored member, which is past the headers
+        vector<uint8_t> zip = TestArchive::makeZip(members, false);
+        vector<uint8_t> raw = members[1].data;
+        auto rawPos = std::search(zip.begin(), zip.end(), raw.begin(), raw.end());
+        ASSERT_NE(rawPos, zip.end());
+        rawPos[100] ^= 0xff;
+
+        vector<uint8_t>& png = members[0].data;
+        auto pngPos = std::search(zip.begin(), zip.end(), png.begin(), png.end());
+        ASSERT_NE(pngPos, zip.end());
+        pngPos[png.size() - 20] ^= 0xff;
+
+        TempFile tempFile("ImageListSourceArchiveTests", "zip");
+        TestArchive::write(tempFile.GetFullPath(), zip);
+
+        ImageListSourceArchive source;
+        source.load(tempFile.GetFullPath());
+        ASSERT_EQ(source.getImageCount(), 2);
+        EXPECT_THROW(source.loadImage(source.getImage(0)), std::runtime_error);
+        EXPECT_THROW(source.loadImage(source.getImage(1)), std::runtime_error);
+    }
+}
@@ -1,5 +1,7 @@
 ﻿#include <gtest/gtest.h>
 #include <string>
+#include <chrono>
+#include <thread>
 
 #include <opencv2/opencv.hpp>
 
@@ -9,6 +11,7 @@
 #include "ArrowUtil.h"
 #include "VectorUtil.h"
 #include "TempFile.h"
+#include "ImageListSourceDirectory.h"
 
 using namespace std;
 using namespace Wxiv;
@@ -101,4 +104,71 @@ namespace WxivTests
     //        }
     //    }
     //}
+
+    TEST(ImageListSourceDirectoryTests, testIncrementalChanges)
+    {
+        wxString dir = wxFileName::GetTempDir();
+        ImageListSourceDirectory source;
+
+        EXPECT_EQ(source.addImageFile(dir + "/a.png"), 0);
+        EXPECT_EQ(source.addImageFile(dir + "/b.tif"), 1);
+        EXPECT_EQ(source.addImageFile(dir + "/notes.txt"), -1);
+        EXPECT_EQ(source.addImageFile(dir + "/a.png"), -1); // already listed
+        EXPECT_EQ(source.getImageCount(), 2);
+
+        // pages are listed after their top image and removed with it
+        std::shared_ptr<WxivImage> page = std::make_shared<WxivImage>(source.getImage(1)->getPath());
+        page->setPage(1);
+        vector<std::shared_ptr<WxivImage>> pages = {page};
+        source.addImagePages(1, pages);
+        EXPECT_EQ(source.addImageFile(dir + "/c.jpg"), 3);
+
+        EXPECT_EQ(source.invalidateImageFile(dir + "/b.tif"), 1);
+        EXPECT_EQ(source.invalidateImageFile(dir + "/d.jpg"), -1);
+
+        EXPECT_EQ(source.removeImageFile(dir + "/b.tif"), 1);
+        EXPECT_EQ(source.removeImageFile(dir + "/b.tif"), 1);
+        EXPECT_EQ(source.removeImageFile(dir + "/b.tif"), -1);
+        ASSERT_EQ(source.getImageCount(), 2);
+        EXPECT_EQ(source.getImage(1)->getPath().GetFullName(), "c.jpg");
+    }
+
+    TEST(ImageListSourceDirectoryTests, testPrefetchCounts)
+    {
+        TempFile fileA("ImageListSourceDirectoryTests", "png");
+        TempFile fileB("ImageListSourceDirectoryTests", "png");
+        cv::Mat img(16, 16, CV_8U, cv::Scalar(10));
+        ASSERT_TRUE(wxSaveImage(fileA.GetFullPath(), img, false));
+        ASSERT_TRUE(wxSaveImage(fileB.GetFullPath(), img, false));
+
+        ImageListSourceDirectory source;
+        ASSERT_EQ(source.addImageFile(fileA.GetFullPath()), 0);
+        ASSERT_EQ(source.addImageFile(fileB.GetFullPath()), 1);
+        std::shared_ptr<WxivImage> a = source.getImage(0);
+        std::shared_ptr<WxivImage> b = source.getImage(1);
+
+        // selecting the same image again doesn't count
+        source.loadImage(a);
+        source.loadImage(a);
+        EXPECT_EQ(source.getPrefetchMissCount(), 1);
+        EXPECT_EQ(source.getPrefetchHitCount(), 0);
+
+        source.prefetchImages({b});
+
+        for (int i = 0; (i < 500) && !b->getIsLoaded(); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        ASSERT_TRUE(b->getIsLoaded());
+        source.loadImage(b);
+        EXPECT_EQ(source.getPrefetchMissCount(), 1);
+        EXPECT_EQ(source.getPrefetchHitCount(), 1);
+        EXPECT_EQ(source.getLoadStatus().find("Prefetched 1 of 2 viewed"), 0);
+
+        // a changed file counts again when next selected
+        source.invalidateImageFile(fileA.GetFullPath());
+        source.loadImage(a);
+        EXPECT_EQ(source.getPrefetchMissCount(), 2);
+    }
 }
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "ImageListSourceShmRing.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+#ifndef _WIN32
+    static const char* TestRingName = "/wxiv-ImageListSourceShmRingTests";
+
+    static void writeTestFrame(WxivShmRing& ring, uint16_t value, const char* name)
+    {
+        cv::Mat img(16, 24, CV_16U, cv::Scalar(value));
+        ASSERT_EQ(wxivShmRingWriteFrame(&ring, img.data, img.cols, img.rows, 1, WXIV_SHM_DEPTH_16U, img.step, name), 0);
+    }
+
+    TEST(ImageListSourceShmRingTests, testLiveChanges)
+    {
+        EXPECT_TRUE(ImageListSourceShmRing::checkIsShmLocation("shm:/wxiv"));
+        EXPECT_FALSE(ImageListSourceShmRing::checkIsShmLocation("shm:"));
+        EXPECT_FALSE(ImageListSourceShmRing::checkIsShmLocation("/tmp/wxiv"));
+
+        WxivShmRing producer;
+        ASSERT_EQ(wxivShmRingCreate(TestRingName, 3, 16 * 24 * 2, &producer), 0);
+        writeTestFrame(producer, 100, "raw/input");
+
+        {
+            ImageListSourceShmRing source;
+            source.load(wxString("shm:") + TestRingName);
+            EXPECT_TRUE(source.checkIsLive());
+            ASSERT_EQ(source.getImageCount(), 1);
+            EXPECT_EQ(source.getImage(0)->getPath().GetFullName(), "000001 raw_input");
+
+            vector<int> removedIndices;
+            int addedCount = 0;
+            EXPECT_FALSE(source.takeLiveChanges(removedIndices, addedCount));
+
+            // zero-copy, so the pixels are in the shared memory
+            auto first = source.getImage(0);
+            ASSERT_TRUE(source.loadImage(first));
+            EXPECT_EQ(first->getImage().type(), CV_16U);
+            EXPECT_EQ(first->getImage().at<uint16_t>(15, 23), 100);
+
+            writeTestFrame(producer, 200, "denoised");
+            writeTestFrame(producer, 300, "");
+            ASSERT_TRUE(source.takeLiveChanges(removedIndices, addedCount));
+            EXPECT_TRUE(removedIndices.empty());
+            EXPECT_EQ(addedCount, 2);
+            ASSERT_EQ(source.getImageCount(), 3);
+            EXPECT_EQ(source.getImage(2)->getPath().GetFullName(), "000003");
+
+            // the ring is full, so the oldest unpinned one goes, and the pinned first frame stays
+            writeTestFrame(producer, 400, "");
+            ASSERT_TRUE(source.takeLiveChanges(removedIndices, addedCount));
+            EXPECT_EQ(removedIndices, vector<int>({1}));
+            EXPECT_EQ(addedCount, 1);
+            ASSERT_EQ(source.getImageCount(), 3);
+            EXPECT_EQ(first->getImage().at<uint16_t>(0, 0), 100);
+
+            // selecting another un-pins the first, which then goes
+            auto newest = source.getImage(2);
+            ASSERT_TRUE(source.loadImage(newest));
+            EXPECT_EQ(newest->getImage().at<uint16_t>(0, 0), 400);
+            writeTestFrame(producer, 500, "");
+            ASSERT_TRUE(source.takeLiveChanges(removedIndices, addedCount));
+            EXPECT_EQ(removedIndices, vector<int>({0}));
+            EXPECT_FALSE(first->getIsLoaded());
+            EXPECT_THROW(source.loadImage(first), std::runtime_error);
+        }
+
+        wxivShmRingClose(&producer, 1);
+
+        ImageListSourceShmRing source;
+        EXPECT_THROW(source.load(wxString("shm:") + TestRingName), std::runtime_error);
+    }
+#endif
+}
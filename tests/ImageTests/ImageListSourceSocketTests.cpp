@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include <opencv2/opencv.hpp>
+
+#include "ImageListSourceSocket.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+#ifndef _WIN32
+    static const char* TestSocketPath = "/tmp/wxiv-ImageListSourceSocketTests.sock";
+
+    /**
+     * @brief Take changes until the newest listed frame has this number, or a couple seconds pass.
+     */
+    static bool waitForFrame(ImageListSourceSocket& source, const string& frameNumber)
+    {
+        auto start = std::chrono::steady_clock::now();
+        vector<int> removedIndices;
+        int addedCount = 0;
+
+        while (std::chrono::steady_clock::now() - start < std::chrono::seconds(2))
+        {
+            source.takeLiveChanges(removedIndices, addedCount);
+            int n = source.getImageCount();
+
+            if ((n > 0) && source.getImage(n - 1)->getPath().GetFullName().StartsWith(frameNumber))
+            {
+                return true;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return false;
+    }
+
+    static void sendRawFrame(int fd, const cv::Mat& img, const char* name)
+    {
+        ASSERT_EQ(wxivStreamSendRawFrame(fd, img.data, img.cols, img.rows, 1, WXIV_STREAM_DEPTH_16U, 0, name), 0);
+    }
+
+    TEST(ImageListSourceSocketTests, testFrames)
+    {
+        EXPECT_TRUE(ImageListSourceSocket::checkIsSocketLocation("unix:/tmp/wxiv.sock"));
+        EXPECT_FALSE(ImageListSourceSocket::checkIsSocketLocation("unix:"));
+
+        ImageListSourceSocket source(3);
+        source.load(wxString("unix:") + TestSocketPath);
+        EXPECT_TRUE(source.checkIsLive());
+        EXPECT_EQ(source.getImageCount(), 0);
+
+        int fd = wxivStreamConnect(TestSocketPath);
+        ASSERT_GE(fd, 0);
+
+        cv::Mat raw(16, 24, CV_16U, cv::Scalar(100));
+        sendRawFrame(fd, raw, "raw/input");
+
+        cv::Mat img(20, 30, CV_8UC3);
+        cv::randu(img, 0, 255);
+        vector<uchar> png;
+        cv::imencode(".png", img, png);
+        WxivStreamFrameHeader header;
+        wxivStreamInitHeader(&header, "png", png.size(), 0, 0, "encoded");
+        ASSERT_EQ(wxivStreamSendFrame(fd, &header, png.data(), nullptr), 0);
+
+        ASSERT_TRUE(waitForFrame(source, "000002"));
+        ASSERT_EQ(source.getImageCount(), 2);
+        EXPECT_EQ(source.getImage(0)->getPath().GetFullName(), "000001 raw_input");
+        EXPECT_EQ(source.getImage(1)->getPath().GetFullName(), "000002 encoded.png");
+
+        // decoded only when viewed, and only the viewed one stays decoded
+        auto first = source.getImage(0);
+        EXPECT_FALSE(first->getIsLoaded());
+
+        // raw is just wrapped, encoded is decoded off the UI thread
+        EXPECT_TRUE(source.checkIsQuickLoad(first));
+        EXPECT_FALSE(source.checkIsQuickLoad(source.getImage(1)));
+        ASSERT_TRUE(source.loadImage(first));
+        EXPECT_EQ(cv::norm(first->getImage(), raw, cv::NORM_INF), 0);
+
+        auto second = source.getImage(1);
+        ASSERT_TRUE(source.loadImage(second));
+        EXPECT_EQ(cv::norm(second->getImage(), img, cv::NORM_INF), 0);
+        EXPECT_FALSE(first->getIsLoaded());
+        EXPECT_TRUE(source.checkIsQuickLoad(second));
+
+        // the list is bounded, oldest removed first
+        for (int i = 0; i < 3; i++)
+        {
+            sendRawFrame(fd, raw, "");
+        }
+
+        ASSERT_TRUE(waitForFrame(source, "000005"));
+        ASSERT_EQ(source.getImageCount(), 3);
+        EXPECT_EQ(source.getImage(0)->getPath().GetFullName(), "000003");
+        EXPECT_THROW(source.loadImage(first), std::runtime_error);
+        EXPECT_NE(source.getLiveStatus().find("5 received, 0 dropped, 2 rendered"), string::npos);
+        close(fd);
+    }
+#endif
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <memory>
+
+#include <opencv2/opencv.hpp>
+
+#include "WxivImage.h"
+#include "ImageMemoryCache.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+    std::shared_ptr<WxivImage> buildLoadedImage(int dim)
+    {
+        cv::Mat img(dim, dim, CV_8U);
+        img = 7;
+        return std::make_shared<WxivImage>(img);
+    }
+
+    TEST(ImageMemoryCacheTests, testEvictsLeastRecentlyUsed)
+    {
+        int dim = 1024;
+        size_t imageBytes = (size_t)dim * dim;
+        ImageMemoryCache cache(imageBytes * 2 + imageBytes / 2);
+
+        auto img0 = buildLoadedImage(dim);
+        auto img1 = buildLoadedImage(dim);
+        auto img2 = buildLoadedImage(dim);
+
+        cache.touch(img0, false);
+        cache.touch(img1, false);
+        EXPECT_EQ(cache.getResidentBytes(), imageBytes * 2);
+        EXPECT_EQ(cache.getEvictionCount(), 0);
+
+        // use img0 again so img1 is the oldest
+        cache.touch(img0, false);
+        cache.touch(img2, false);
+
+        // touching doesn't evict, that waits for the UI thread
+        EXPECT_EQ(cache.getEvictionCount(), 0);
+        EXPECT_TRUE(img1->getIsLoaded());
+        EXPECT_EQ(cache.getResidentBytes(), imageBytes * 3);
+
+        cache.evictOverBudget();
+        EXPECT_EQ(cache.getEvictionCount(), 1);
+        EXPECT_EQ(cache.getResidentBytes(), imageBytes * 2);
+        EXPECT_TRUE(img0->getIsLoaded());
+        EXPECT_FALSE(img1->getIsLoaded());
+        EXPECT_TRUE(img1->empty());
+        EXPECT_TRUE(img2->getIsLoaded());
+    }
+
+    TEST(ImageMemoryCacheTests, testPinnedImageNotEvicted)
+    {
+        int dim = 1024;
+        size_t imageBytes = (size_t)dim * dim;
+        ImageMemoryCache cache(imageBytes * 2);
+
+        auto viewed = buildLoadedImage(dim);
+        cache.touch(viewed, true);
+
+        // prefetched images push it over budget, but the viewed one stays
+        auto prefetched0 = buildLoadedImage(dim);
+        auto prefetched1 = buildLoadedImage(dim);
+        cache.touch(prefetched0, false);
+        cache.touch(prefetched1, false);
+        cache.evictOverBudget();
+
+        EXPECT_TRUE(viewed->getIsLoaded());
+        EXPECT_FALSE(prefetched0->getIsLoaded());
+        EXPECT_TRUE(prefetched1->getIsLoaded());
+        EXPECT_EQ(cache.getEvictionCount(), 1);
+    }
+
+    TEST(ImageMemoryCacheTests, testCountsPyramidBuiltAfterTouch)
+    {
+        int dim = 2048;
+        size_t imageBytes = (size_t)dim * dim;
+        ImageMemoryCache cache(imageBytes * 4);
+
+        cv::Mat pixels(dim, dim, CV_8U, cv::Scalar(7));
+        auto img = std::make_shared<WxivImage>();
+        img->setImage(pixels);
+        ASSERT_TRUE(img->getPyramid() != nullptr);
+        cache.touch(img, false);
+        EXPECT_EQ(cache.getResidentBytes(), imageBytes);
+
+        // built later, e.g. on the first zoomed-out render, and picked up at the next eviction
+        img->getPyramid()->build();
+        cache.evictOverBudget();
+        EXPECT_EQ(cache.getResidentBytes(), img->getMemoryBytes());
+        EXPECT_GT(cache.getResidentBytes(), imageBytes);
+    }
+
+    TEST(ImageMemoryCacheTests, testBusyImageSkipped)
+    {
+        int dim = 256;
+        size_t imageBytes = (size_t)dim * dim;
+        ImageMemoryCache cache(imageBytes);
+
+        auto busy = buildLoadedImage(dim);
+        auto other = buildLoadedImage(dim);
+        cache.touch(busy, false);
+
+        {
+            // as if another thread is loading it
+            const std::lock_guard<std::mutex> lock(busy->getLoadMutex());
+            cache.touch(other, true);
+            cache.evictOverBudget();
+        }
+
+        EXPECT_TRUE(busy->getIsLoaded());
+        EXPECT_EQ(cache.getEvictionCount(), 0);
+
+        // next time it is free to go
+        cache.setBudgetBytes(imageBytes);
+        EXPECT_FALSE(busy->getIsLoaded());
+        EXPECT_EQ(cache.getResidentBytes(), imageBytes);
+    }
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+#include "ImageNameFilter.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+    static vector<string> getTestNames()
+    {
+        return {"step01_mask.png", "step02_edges.tif", "step03_mask.png", "readme.txt"};
+    }
+
+    /**
+     * @brief Poll until the filter has a result, or give up after a while.
+     */
+    static bool waitForResult(ImageNameFilter& filter, vector<int>& dataIndices)
+    {
+        for (int i = 0; i < 500; i++)
+        {
+            if (filter.takeResult(dataIndices))
+            {
+                return true;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        return false;
+    }
+
+    TEST(ImageNameFilterTests, testQueryModes)
+    {
+        ImageNameFilter filter;
+        filter.setNames(getTestNames());
+
+        EXPECT_EQ(filter.filterNow(""), vector<int>({0, 1, 2, 3}));
+        EXPECT_EQ(filter.filterNow("mask"), vector<int>({0, 2}));
+        EXPECT_EQ(filter.filterNow("*.png"), vector<int>({0, 2}));
+        EXPECT_EQ(filter.filterNow("step0?_*"), vector<int>({0, 1, 2}));
+        EXPECT_EQ(filter.filterNow("re:^STEP0[12]"), vector<int>({0, 1}));
+
+        // doesn't compile (yet), so nothing
+        EXPECT_TRUE(filter.filterNow("re:(").empty());
+    }
+
+    TEST(ImageNameFilterTests, testLatestWins)
+    {
+        ImageNameFilter filter;
+        filter.setNames(getTestNames());
+
+        filter.request("step");
+        filter.request("step0");
+        filter.request("step03");
+
+        vector<int> dataIndices;
+        ASSERT_TRUE(waitForResult(filter, dataIndices));
+        EXPECT_EQ(dataIndices, vector<int>({2}));
+        EXPECT_FALSE(filter.takeResult(dataIndices));
+        EXPECT_FALSE(filter.checkIsBusy());
+    }
+
+    TEST(ImageNameFilterTests, testNamesChange)
+    {
+        ImageNameFilter filter;
+        filter.setNames(getTestNames());
+        EXPECT_EQ(filter.filterNow("mask"), vector<int>({0, 2}));
+
+        // doesn't narrow from a result for the old names
+        filter.removeName(0);
+        EXPECT_EQ(filter.filterNow("mask"), vector<int>({1}));
+        filter.appendName("x_mask.jpg");
+        EXPECT_EQ(filter.filterNow("mask"), vector<int>({1, 3}));
+        EXPECT_EQ(filter.getNameCount(), 4);
+
+        // pages after their image
+        filter.insertNames(1, {"step02_mask.tif", "step02_mask.tif"});
+        EXPECT_EQ(filter.filterNow("mask"), vector<int>({1, 2, 3, 5}));
+        EXPECT_EQ(filter.getNameCount(), 6);
+    }
+
+    TEST(ImageNameFilterTests, testNamesChangeRerunsResult)
+    {
+        ImageNameFilter filter;
+        filter.setNames(getTestNames());
+        filter.request("mask");
+
+        for (int i = 0; (i < 500) && filter.checkIsBusy(); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        // the result for the old names wasn't taken yet, so it's re-run against the new ones
+        ASSERT_FALSE(filter.checkIsBusy());
+        filter.appendName("x_mask.jpg");
+        vector<int> dataIndices;
+        ASSERT_TRUE(waitForResult(filter, dataIndices));
+        EXPECT_EQ(dataIndices, vector<int>({0, 2, 4}));
+
+        filter.request("mask");
+        ASSERT_TRUE(waitForResult(filter, dataIndices));
+        filter.removeName(0);
+        EXPECT_FALSE(filter.takeResult(dataIndices));
+        EXPECT_EQ(filter.filterNow("mask"), vector<int>({1, 3}));
+    }
+}
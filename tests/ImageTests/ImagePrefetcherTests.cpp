@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+
+#include <opencv2/opencv.hpp>
+
+#include "ImagePrefetcher.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+    /**
+     * @brief Records what the prefetcher ran, in order, and can hold the worker in the first run until released.
+     */
+    class PrefetchRecorder
+    {
+      private:
+        std::mutex mutex;
+        std::condition_variable condition;
+        vector<std::shared_ptr<WxivImage>> started;
+        int finishedCount = 0;
+        bool isHeld = false;
+
+      public:
+        void hold()
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            this->isHeld = true;
+        }
+
+        void release()
+        {
+            {
+                const std::lock_guard<std::mutex> lock(this->mutex);
+                this->isHeld = false;
+            }
+
+            this->condition.notify_all();
+        }
+
+        void run(std::shared_ptr<WxivImage> image)
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->started.push_back(image);
+            this->condition.notify_all();
+            this->condition.wait(lock, [this]() { return !this->isHeld; });
+            this->finishedCount++;
+            this->condition.notify_all();
+        }
+
+        bool waitForStarted(int count)
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            return this->condition.wait_for(lock, std::chrono::seconds(5), [&]() { return (int)this->started.size() >= count; });
+        }
+
+        bool waitForFinished(int count)
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            return this->condition.wait_for(lock, std::chrono::seconds(5), [&]() { return this->finishedCount >= count; });
+        }
+
+        vector<std::shared_ptr<WxivImage>> getStarted()
+        {
+            const std::lock_guard<std::mutex> lock(this->mutex);
+            return this->started;
+        }
+    };
+
+    TEST(ImagePrefetcherTests, testOrderAndSkipLoaded)
+    {
+        PrefetchRecorder recorder;
+        auto a = std::make_shared<WxivImage>(wxString("a.png"));
+        auto loaded = std::make_shared<WxivImage>(cv::Mat(4, 4, CV_8U));
+        auto b = std::make_shared<WxivImage>(wxString("b.png"));
+        ASSERT_TRUE(loaded->getIsLoaded());
+
+        {
+            ImagePrefetcher prefetcher(1, [&](std::shared_ptr<WxivImage> image) { recorder.run(image); });
+            prefetcher.setQueue({a, loaded, nullptr, b});
+            ASSERT_TRUE(recorder.waitForFinished(2));
+        }
+
+        vector<std::shared_ptr<WxivImage>> expected = {a, b};
+        EXPECT_EQ(recorder.getStarted(), expected);
+
+        // unless it's not for loads
+        PrefetchRecorder allRecorder;
+        ImagePrefetcher allPrefetcher(1, [&](std::shared_ptr<WxivImage> image) { allRecorder.run(image); }, false);
+        allPrefetcher.setQueue({loaded});
+        ASSERT_TRUE(allRecorder.waitForFinished(1));
+        EXPECT_EQ(allRecorder.getStarted()[0], loaded);
+    }
+
+    TEST(ImagePrefetcherTests, testReplaceQueue)
+    {
+        PrefetchRecorder recorder;
+        auto a = std::make_shared<WxivImage>(wxString("a.png"));
+        auto b = std::make_shared<WxivImage>(wxString("b.png"));
+        auto c = std::make_shared<WxivImage>(wxString("c.png"));
+        auto d = std::make_shared<WxivImage>(wxString("d.png"));
+
+        ImagePrefetcher prefetcher(1, [&](std::shared_ptr<WxivImage> image) { recorder.run(image); });
+        recorder.hold();
+        prefetcher.setQueue({a, b, c});
+        ASSERT_TRUE(recorder.waitForStarted(1));
+
+        // the running one finishes, and the rest of the old queue is dropped
+        prefetcher.setQueue({d});
+        recorder.release();
+        ASSERT_TRUE(recorder.waitForFinished(2));
+
+        vector<std::shared_ptr<WxivImage>> expected = {a, d};
+        EXPECT_EQ(recorder.getStarted(), expected);
+
+        // and clear drops what hasn't started
+        recorder.hold();
+        prefetcher.setQueue({b, c});
+        ASSERT_TRUE(recorder.waitForStarted(3));
+        prefetcher.clear();
+        recorder.release();
+        ASSERT_TRUE(recorder.waitForFinished(3));
+        EXPECT_EQ(recorder.getStarted().size(), 3);
+    }
+}
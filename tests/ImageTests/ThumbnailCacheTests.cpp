@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <fstream>
+
+#include <opencv2/opencv.hpp>
+
+#include "WxWidgetsUtil.h"
+#include "WxivUtil.h"
+#include "TempFile.h"
+#include "ThumbnailCache.h"
+
+using namespace std;
+using namespace Wxiv;
+namespace fs = std::filesystem;
+
+namespace WxivTests
+{
+    /**
+     * @brief Poll until the cache has the thumbnail, or give up after a while.
+     */
+    static cv::Mat waitForThumbnail(ThumbnailCache& cache, std::shared_ptr<WxivImage> image)
+    {
+        for (int i = 0; i < 500; i++)
+        {
+            cv::Mat thumb = cache.getThumbnail(image);
+
+            if (!thumb.empty())
+            {
+                return thumb;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        return cv::Mat();
+    }
+
+    TEST(ThumbnailCacheTests, testMakeThumbnail)
+    {
+        TempFile tempFile("ThumbnailCacheTests", "png");
+        cv::Mat img(600, 300, CV_16U);
+        cv::randu(img, 0, 4000);
+        ASSERT_TRUE(wxSaveImage(tempFile.GetFullPath(), img, false));
+
+        ThumbnailCache cache(fs::path(), 128, 1);
+        cv::Mat thumb = cache.makeThumbnail(std::make_shared<WxivImage>(tempFile.GetFullPath()));
+
+        // keeps aspect and depth
+        EXPECT_EQ(thumb.size(), cv::Size(64, 128));
+        EXPECT_EQ(thumb.type(), CV_16U);
+    }
+
+    TEST(ThumbnailCacheTests, testJpegReducedDecode)
+    {
+        TempFile tempFile("ThumbnailCacheTests", "jpg");
+        cv::Mat img(1024, 1024, CV_8UC3, cv::Scalar(10, 100, 200));
+        ASSERT_TRUE(wxSaveImage(tempFile.GetFullPath(), img, false));
+
+        ThumbnailCache cache(fs::path(), 100, 1);
+        cv::Mat thumb = cache.makeThumbnail(std::make_shared<WxivImage>(tempFile.GetFullPath()));
+
+        EXPECT_EQ(thumb.size(), cv::Size(100, 100));
+        EXPECT_EQ(thumb.type(), CV_8UC3);
+        EXPECT_NEAR(cv::mean(thumb)[2], 200.0, 4.0);
+    }
+
+    TEST(ThumbnailCacheTests, testDiskCache)
+    {
+        fs::path cacheDir = fs::temp_directory_path() / "ThumbnailCacheTests";
+        fs::remove_all(cacheDir);
+
+        TempFile tempFile("ThumbnailCacheTests", "tif");
+        cv::Mat img(256, 512, CV_8U, cv::Scalar(77));
+        ASSERT_TRUE(wxSaveImage(tempFile.GetFullPath(), img, false));
+
+        {
+            ThumbnailCache cache(cacheDir, 64, 2);
+            auto image = std::make_shared<WxivImage>(tempFile.GetFullPath());
+            cache.request({image});
+            cv::Mat thumb = waitForThumbnail(cache, image);
+            ASSERT_FALSE(thumb.empty());
+            EXPECT_EQ(thumb.size(), cv::Size(64, 32));
+            EXPECT_EQ(cache.getGeneratedCount(), 1);
+            EXPECT_EQ(cache.getDiskHitCount(), 0);
+            EXPECT_GT(cache.getGeneration(), 0);
+        }
+
+        {
+            // as if re-opened, so from disk
+            ThumbnailCache cache(cacheDir, 64, 2);
+            auto image = std::make_shared<WxivImage>(tempFile.GetFullPath());
+            cache.request({image});
+            cv::Mat thumb = waitForThumbnail(cache, image);
+            ASSERT_FALSE(thumb.empty());
+            EXPECT_EQ(thumb.at<uint8_t>(10, 10), 77);
+            EXPECT_EQ(cache.getGeneratedCount(), 0);
+            EXPECT_EQ(cache.getDiskHitCount(), 1);
+
+            // forgotten from memory, still on disk
+            cache.remove(image);
+            EXPECT_TRUE(cache.getThumbnail(image).empty());
+        }
+
+        {
+            // a different dim is a different key
+            ThumbnailCache cache(cacheDir, 32, 1);
+            auto image = std::make_shared<WxivImage>(tempFile.GetFullPath());
+            cache.request({image});
+            ASSERT_FALSE(waitForThumbnail(cache, image).empty());
+            EXPECT_EQ(cache.getGeneratedCount(), 1);
+        }
+
+        fs::remove_all(cacheDir);
+    }
+
+    TEST(ThumbnailCacheTests, testPruneDisk)
+    {
+        fs::path cacheDir = fs::temp_directory_path() / "ThumbnailCacheTests-prune";
+        fs::remove_all(cacheDir);
+        fs::create_directories(cacheDir);
+
+        // 1000 bytes each, last used one hour apart, newest first, and the last is past the max age
+        auto now = fs::file_time_type::clock::now();
+        vector<fs::path> paths;
+
+        for (int i = 0; i < 5; i++)
+        {
+            paths.push_back(cacheDir / (to_string(i) + ".tif"));
+            std::ofstream(paths.back(), std::ios::binary) << string(1000, 'x');
+            fs::last_write_time(paths.back(), now - std::chrono::hours(i == 4 ? 1000 : i));
+        }
+
+        // not ours, so kept however old
+        fs::path otherPath = cacheDir / "other.txt";
+        std::ofstream(otherPath, std::ios::binary) << string(5000, 'x');
+        fs::last_write_time(otherPath, now - std::chrono::hours(1000));
+
+        ThumbnailCache::pruneDisk(cacheDir, 2500, std::chrono::hours(500));
+
+        EXPECT_TRUE(fs::exists(paths[0]));
+        EXPECT_TRUE(fs::exists(paths[1]));
+        EXPECT_FALSE(fs::exists(paths[2]));
+        EXPECT_FALSE(fs::exists(paths[3]));
+        EXPECT_FALSE(fs::exists(paths[4]));
+        EXPECT_TRUE(fs::exists(otherPath));
+
+        fs::remove_all(cacheDir);
+    }
+}
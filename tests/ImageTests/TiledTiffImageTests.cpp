@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <filesystem>
+
+#include <opencv2/opencv.hpp>
+#include <tiffio.h>
+
+#include "TiledTiffImage.h"
+
+using namespace std;
+using namespace Wxiv;
+namespace fs = std::filesystem;
+
+namespace WxivTests
+{
+    /**
+     * @brief Write one tiled 8U or 16U directory.
+     */
+    void writeTiledDirectory(TIFF* tif, const cv::Mat& img, int tileDim, bool isReduced)
+    {
+        TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, (uint32_t)img.cols);
+        TIFFSetField(tif, TIFFTAG_IMAGELENGTH, (uint32_t)img.rows);
+        TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, (int)img.elemSize1() * 8);
+        TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+        TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
+        TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+        TIFFSetField(tif, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+        TIFFSetField(tif, TIFFTAG_TILEWIDTH, (uint32_t)tileDim);
+        TIFFSetField(tif, TIFFTAG_TILELENGTH, (uint32_t)tileDim);
+
+        if (isReduced)
+        {
+            TIFFSetField(tif, TIFFTAG_SUBFILETYPE, (uint32_t)FILETYPE_REDUCEDIMAGE);
+        }
+
+        cv::Mat tile(tileDim, tileDim, img.type());
+
+        for (int y = 0; y < img.rows; y += tileDim)
+        {
+            for (int x = 0; x < img.cols; x += tileDim)
+            {
+                tile = 0;
+                cv::Rect roi = cv::Rect(x, y, tileDim, tileDim) & cv::Rect(0, 0, img.cols, img.rows);
+                img(roi).copyTo(tile(cv::Rect(0, 0, roi.width, roi.height)));
+                ASSERT_GE(TIFFWriteTile(tif, tile.data, (uint32_t)x, (uint32_t)y, 0, 0), 0);
+            }
+        }
+
+        TIFFWriteDirectory(tif);
+    }
+
+    TEST(TiledTiffImageTests, testReadRegionWithFileLevels)
+    {
+        fs::path path = fs::temp_directory_path() / "TiledTiffImageTests-levels.tif";
+        cv::Mat img(700, 1000, CV_16U);
+        cv::randu(img, 0, 60000);
+        cv::Mat reducedImg;
+        cv::resize(img, reducedImg, cv::Size(500, 350), 0, 0, cv::INTER_AREA);
+
+        TIFF* tif = TIFFOpen(path.string().c_str(), "w");
+        ASSERT_TRUE(tif != nullptr);
+        writeTiledDirectory(tif, img, 128, false);
+        writeTiledDirectory(tif, reducedImg, 128, true);
+        TIFFClose(tif);
+
+        {
+            TiledTiffImage tiled(path, 64 * 1024 * 1024);
+            EXPECT_EQ(tiled.getSize(), img.size());
+            EXPECT_EQ(tiled.getType(), CV_16U);
+            ASSERT_EQ(tiled.getLevelCount(), 2);
+            EXPECT_EQ(tiled.getLevelScale(1), cv::Point2f(2.0f, 2.0f));
+
+            // spans tile boundaries and the padded edge tiles
+            cv::Rect roi(100, 250, 900, 300);
+            cv::Mat region;
+            tiled.readRegion(0, roi, region);
+            EXPECT_EQ(cv::norm(region, img(roi), cv::NORM_INF), 0.0);
+
+            cv::Mat reducedRegion;
+            tiled.readRegion(1, cv::Rect(0, 0, 500, 350), reducedRegion);
+            EXPECT_EQ(cv::norm(reducedRegion, reducedImg, cv::NORM_INF), 0.0);
+
+            // picks the reduced level only once zoomed out enough
+            EXPECT_EQ(tiled.selectLevel(1.0f), 0);
+            EXPECT_EQ(tiled.selectLevel(0.75f), 0);
+            EXPECT_EQ(tiled.selectLevel(0.5f), 1);
+            EXPECT_EQ(tiled.selectLevel(0.1f), 1);
+
+            // second read of the same region comes from the cache
+            int readCount = tiled.getTileReadCount();
+            tiled.readRegion(0, roi, region);
+            EXPECT_EQ(tiled.getTileReadCount(), readCount);
+        }
+
+        fs::remove(path);
+    }
+
+    TEST(TiledTiffImageTests, testSynthesizedLevelsAndBoundedCache)
+    {
+        fs::path path = fs::temp_directory_path() / "TiledTiffImageTests-synth.tif";
+        cv::Mat img(2000, 3000, CV_8U);
+        cv::randu(img, 0, 255);
+
+        TIFF* tif = TIFFOpen(path.string().c_str(), "w");
+        ASSERT_TRUE(tif != nullptr);
+        writeTiledDirectory(tif, img, 256, false);
+        TIFFClose(tif);
+
+        {
+            size_t budget = 256 * 256 * 8;
+            TiledTiffImage tiled(path, budget);
+
+            // no levels in the file, so halved until they fit in 1024
+            ASSERT_EQ(tiled.getLevelCount(), 3);
+            EXPECT_EQ(tiled.getLevelSize(2), cv::Size(750, 500));
+
+            // same as reducing the whole image, since 2x area reduction of aligned tiles is exact
+            cv::Mat expected1, expected2;
+            cv::resize(img, expected1, cv::Size(1500, 1000), 0, 0, cv::INTER_AREA);
+            cv::resize(expected1, expected2, cv::Size(750, 500), 0, 0, cv::INTER_AREA);
+
+            cv::Mat overview = tiled.readOverview(1024);
+            EXPECT_EQ(overview.size(), cv::Size(750, 500));
+            EXPECT_EQ(cv::norm(overview, expected2, cv::NORM_INF), 0.0);
+
+            // walking the whole full-res image keeps the cache in budget
+            for (int y = 0; y < img.rows; y += 400)
+            {
+                cv::Mat region;
+                tiled.readRegion(0, cv::Rect(0, y, 600, 400), region);
+                EXPECT_EQ(cv::norm(region, img(cv::Rect(0, y, 600, 400)), cv::NORM_INF), 0.0);
+                EXPECT_LE(tiled.getCacheBytes(), budget);
+            }
+        }
+
+        fs::remove(path);
+    }
+
+    /**
+     * @brief Write one strip-organized 16U directory that is all one strip.
+     */
+    void writeSingleStripDirectory(TIFF* tif, const cv::Mat& img, uint16_t compression)
+    {
+        TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, (uint32_t)img.cols);
+        TIFFSetField(tif, TIFFTAG_IMAGELENGTH, (uint32_t)img.rows);
+        TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, 16);
+        TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, 1);
+        TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
+        TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+        TIFFSetField(tif, TIFFTAG_COMPRESSION, compression);
+        TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, (uint32_t)img.rows);
+
+        for (int y = 0; y < img.rows; y++)
+        {
+            ASSERT_GE(TIFFWriteScanline(tif, (void*)img.ptr(y), (uint32_t)y, 0), 0);
+        }
+
+        TIFFWriteDirectory(tif);
+    }
+
+    TEST(TiledTiffImageTests, testSingleStripIsBandedOrRejected)
+    {
+        fs::path path = fs::temp_directory_path() / "TiledTiffImageTests-strip.tif";
+        cv::Mat img(700, 1000, CV_16U);
+        cv::randu(img, 0, 60000);
+
+        TIFF* tif = TIFFOpen(path.string().c_str(), "w");
+        ASSERT_TRUE(tif != nullptr);
+        writeSingleStripDirectory(tif, img, COMPRESSION_NONE);
+        TIFFClose(tif);
+
+        {
+            // the one strip is 1.4 MB, so with this budget it's read in bands of rows instead of all at once
+            size_t budget = 256 * 1024;
+            TiledTiffImage tiled(path, budget);
+            EXPECT_EQ(tiled.getSize(), img.size());
+
+            // read bottom up, so rows are read out of order
+            for (int y = img.rows - 100; y >= 0; y -= 100)
+            {
+                cv::Rect roi(300, y, 400, 100);
+                cv::Mat region;
+                tiled.readRegion(0, roi, region);
+                EXPECT_EQ(cv::norm(region, img(roi), cv::NORM_INF), 0.0);
+                EXPECT_LE(tiled.getCacheBytes(), budget);
+            }
+        }
+
+        // compressed can only be decoded a whole strip at a time, so it's not read this way
+        tif = TIFFOpen(path.string().c_str(), "w");
+        ASSERT_TRUE(tif != nullptr);
+        writeSingleStripDirectory(tif, img, COMPRESSION_LZW);
+        TIFFClose(tif);
+
+        EXPECT_TRUE(TiledTiffImage::tryOpen(path, 0, 256 * 1024) == nullptr);
+        EXPECT_TRUE(TiledTiffImage::tryOpen(path, 0, 64 * 1024 * 1024) != nullptr);
+
+        fs::remove(path);
+    }
+
+    TEST(TiledTiffImageTests, testTryOpenSmallReturnsNull)
+    {
+        fs::path path = fs::temp_directory_path() / "TiledTiffImageTests-small.tif";
+        cv::Mat img(64, 64, CV_16U);
+        img = 3;
+        ASSERT_TRUE(cv::imwrite(path.string(), img));
+
+        EXPECT_TRUE(TiledTiffImage::tryOpen(path, 100 * 100, 1024 * 1024) == nullptr);
+        EXPECT_TRUE(TiledTiffImage::tryOpen(path, 0, 1024 * 1024) != nullptr);
+
+        fs::remove(path);
+    }
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <filesystem>
+#include <random>
+#include <algorithm>
+#include <fmt/core.h>
+
+#include <opencv2/opencv.hpp>
+
+#include "ImageDecoder.h"
+#include "MiscUtil.h"
+#include "StringUtil.h"
+
+using namespace std;
+using namespace Wxiv;
+namespace fs = std::filesystem;
+
+namespace WxivTests
+{
+    /**
+     * @brief Write a mix of formats and types to a new temp dir.
+     * @return The paths of the written images.
+     */
+    static vector<fs::path> writeDecoderTestImages(const fs::path& dirPath, int countPerType, int imageDim)
+    {
+        vector<fs::path> paths;
+        vector<pair<string, int>> extTypes = {{"tif", CV_16U}, {"tif", CV_32F}, {"png", CV_8U}, {"png", CV_16U}, {"jpeg", CV_8UC3}};
+        int seed = 1;
+
+        for (const auto& extType : extTypes)
+        {
+            for (int i = 0; i < countPerType; i++)
+            {
+                cv::theRNG().state = seed++;
+                cv::Mat img(imageDim, imageDim, extType.second);
+                bool is8u = (CV_MAT_DEPTH(extType.second) == CV_8U);
+                cv::randu(img, 0, is8u ? 255 : 4000);
+
+                fs::path path = dirPath / fmt::format("img-{}.{}", paths.size(), extType.first);
+                EXPECT_TRUE(cv::imwrite(path.string(), img));
+                paths.push_back(path);
+            }
+        }
+
+        return paths;
+    }
+
+    /**
+     * @brief Decode each path on this many threads (1 for sequential, in order).
+     * @return Whether each decode succeeded.
+     */
+    static vector<bool> decodeAll(const vector<fs::path>& paths, int threadCount, vector<vector<cv::Mat>>& mats)
+    {
+        int n = (int)paths.size();
+        vector<char> isDecoded(n, 0); // not vector<bool>, since threads write neighbors
+        mats.assign(n, {});
+        std::atomic<int> nextIdx = 0;
+        vector<std::thread> threads;
+
+        for (int t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back(
+                [&]()
+                {
+                    int i;
+
+                    while ((i = nextIdx++) < n)
+                    {
+                        isDecoded[i] = ImageDecoder::decodeFile(paths[i].string(), getNormalizedExt(paths[i].extension().string()), mats[i]);
+                    }
+                });
+        }
+
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+
+        return vector<bool>(isDecoded.begin(), isDecoded.end());
+    }
+
+    static void checkDecodesMatch(const vector<fs::path>& paths, const vector<vector<cv::Mat>>& seqMats, const vector<vector<cv::Mat>>& parMats)
+    {
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            ASSERT_EQ(seqMats[i].size(), 1);
+            ASSERT_EQ(parMats[i].size(), 1);
+            const cv::Mat& a = seqMats[i][0];
+            const cv::Mat& b = parMats[i][0];
+            EXPECT_EQ(a.type(), b.type());
+            EXPECT_EQ(a.size(), b.size());
+            EXPECT_EQ(cv::norm(a, b, cv::NORM_INF), 0.0) << paths[i].string();
+        }
+    }
+
+    /**
+     * @brief Decode a dir on 8 threads and check every decode succeeds and we get exactly what a sequential decode gets.
+     */
+    TEST(ImageDecoderTests, testConcurrentDecodeMatchesSequential)
+    {
+        fs::path dirPath = fs::temp_directory_path() / fmt::format("ImageDecoderTests-{}", std::random_device()());
+        fs::create_directories(dirPath);
+        vector<fs::path> paths = writeDecoderTestImages(dirPath, 3, 128);
+
+        vector<vector<cv::Mat>> seqMats, parMats;
+        vector<bool> isSeqDecoded = decodeAll(paths, 1, seqMats);
+        vector<bool> isParDecoded = decodeAll(paths, 8, parMats);
+
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            EXPECT_TRUE(isSeqDecoded[i]) << paths[i].string();
+            EXPECT_TRUE(isParDecoded[i]) << paths[i].string();
+        }
+
+        checkDecodesMatch(paths, seqMats, parMats);
+        fs::remove_all(dirPath);
+    }
+
+    /**
+     * @brief Time decoding a dir sequentially and on 8 threads. Not a pass/fail on the times, they're just printed.
+     * Disabled because it writes and decodes 40 1024x1024 images, run with --gtest_also_run_disabled_tests.
+     */
+    TEST(ImageDecoderTests, DISABLED_benchmarkConcurrentDecode)
+    {
+        fs::path dirPath = fs::temp_directory_path() / fmt::format("ImageDecoderTests-{}", std::random_device()());
+        fs::create_directories(dirPath);
+        vector<fs::path> paths = writeDecoderTestImages(dirPath, 8, 1024);
+        int threadCount = 8;
+
+        vector<vector<cv::Mat>> seqMats, parMats;
+        auto t0 = getTimeNow();
+        decodeAll(paths, 1, seqMats);
+        float seqSeconds = getDurationSeconds(t0);
+
+        t0 = getTimeNow();
+        decodeAll(paths, threadCount, parMats);
+        float parSeconds = getDurationSeconds(t0);
+
+        checkDecodesMatch(paths, seqMats, parMats);
+        fmt::print("Decoded {} images: sequential {:.3f} s, {} threads {:.3f} s, speedup {:.2f}x\n", paths.size(), seqSeconds, threadCount,
+            parSeconds, seqSeconds / std::max(parSeconds, 1e-6f));
+
+        fs::remove_all(dirPath);
+    }
+
+    TEST(ImageDecoderTests, testCodecNeedsSerialization)
+    {
+        EXPECT_FALSE(ImageDecoder::checkCodecNeedsSerialization("tif"));
+        EXPECT_FALSE(ImageDecoder::checkCodecNeedsSerialization("PNG"));
+        EXPECT_TRUE(ImageDecoder::checkCodecNeedsSerialization("jp2"));
+    }
+}
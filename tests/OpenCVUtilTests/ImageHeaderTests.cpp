@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <chrono>
+
+#include <opencv2/opencv.hpp>
+
+#include "ImageHeader.h"
+#include "ImageHeaderProber.h"
+#include "WxivImage.h"
+#include "WxivUtil.h"
+#include "TempFile.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+    /**
+     * @brief Save, probe just the header, and check against what a full load gives.
+     */
+    void checkProbeMatchesLoad(const std::string& ext, const cv::Mat& img)
+    {
+        TempFile tempFile("ImageHeaderTests", ext);
+        ASSERT_TRUE(cv::imwrite(tempFile.GetFullPath().ToStdString(), img));
+
+        ImageHeaderInfo info;
+        ASSERT_TRUE(ImageHeader::probeFile(toFilesystemPath(tempFile.GetFullPath()), ext, 0, info));
+
+        cv::Mat loaded = cv::imread(tempFile.GetFullPath().ToStdString(), cv::IMREAD_UNCHANGED);
+        EXPECT_EQ(info.width, loaded.cols) << ext;
+        EXPECT_EQ(info.height, loaded.rows) << ext;
+        EXPECT_EQ(info.depth, loaded.depth()) << ext;
+        EXPECT_EQ(info.channels, loaded.channels()) << ext;
+        EXPECT_EQ(info.pageCount, 1) << ext;
+    }
+
+    TEST(ImageHeaderTests, testProbeMatchesLoad)
+    {
+        checkProbeMatchesLoad("png", cv::Mat(31, 47, CV_8U, cv::Scalar(5)));
+        checkProbeMatchesLoad("png", cv::Mat(31, 47, CV_16U, cv::Scalar(5000)));
+        checkProbeMatchesLoad("png", cv::Mat(31, 47, CV_8UC3, cv::Scalar(1, 2, 3)));
+        checkProbeMatchesLoad("png", cv::Mat(31, 47, CV_8UC4, cv::Scalar(1, 2, 3, 4)));
+        checkProbeMatchesLoad("jpg", cv::Mat(31, 47, CV_8U, cv::Scalar(5)));
+        checkProbeMatchesLoad("jpg", cv::Mat(31, 47, CV_8UC3, cv::Scalar(1, 2, 3)));
+        checkProbeMatchesLoad("tif", cv::Mat(31, 47, CV_16U, cv::Scalar(5000)));
+        checkProbeMatchesLoad("tif", cv::Mat(31, 47, CV_32F, cv::Scalar(0.5)));
+        checkProbeMatchesLoad("tif", cv::Mat(31, 47, CV_8UC3, cv::Scalar(1, 2, 3)));
+    }
+
+    TEST(ImageHeaderTests, testMultiPageTif)
+    {
+        TempFile tempFile("ImageHeaderTests", "tif");
+        vector<cv::Mat> pages = {cv::Mat(20, 30, CV_16U, cv::Scalar(1)), cv::Mat(40, 50, CV_8U, cv::Scalar(2))};
+        ASSERT_TRUE(cv::imwrite(tempFile.GetFullPath().ToStdString(), pages));
+
+        ImageHeaderInfo info;
+        ASSERT_TRUE(ImageHeader::probeFile(toFilesystemPath(tempFile.GetFullPath()), "tif", 0, info));
+        EXPECT_EQ(info.width, 30);
+        EXPECT_EQ(info.depth, CV_16U);
+        EXPECT_EQ(info.pageCount, 2);
+
+        ASSERT_TRUE(ImageHeader::probeFile(toFilesystemPath(tempFile.GetFullPath()), "tif", 1, info));
+        EXPECT_EQ(info.width, 50);
+        EXPECT_EQ(info.height, 40);
+        EXPECT_EQ(info.depth, CV_8U);
+    }
+
+    TEST(ImageHeaderTests, testProbeBuffer)
+    {
+        for (const string ext : {"png", "jpg"})
+        {
+            vector<uint8_t> bytes;
+            ASSERT_TRUE(cv::imencode("." + ext, cv::Mat(31, 47, CV_8UC3, cv::Scalar(1, 2, 3)), bytes));
+
+            ImageHeaderInfo info;
+            ASSERT_TRUE(ImageHeader::probeBuffer(bytes.data(), bytes.size(), ext, info)) << ext;
+            EXPECT_EQ(info.width, 47) << ext;
+            EXPECT_EQ(info.height, 31) << ext;
+            EXPECT_EQ(info.channels, 3) << ext;
+
+            // too short to have the header
+            EXPECT_FALSE(ImageHeader::probeBuffer(bytes.data(), 10, ext, info)) << ext;
+        }
+
+        uint8_t tif[8] = {'I', 'I', 42, 0, 8, 0, 0, 0};
+        ImageHeaderInfo info;
+        EXPECT_FALSE(ImageHeader::probeBuffer(tif, sizeof(tif), "tif", info));
+        EXPECT_TRUE(info.empty());
+    }
+
+    TEST(ImageHeaderTests, testBadFile)
+    {
+        TempFile tempFile("ImageHeaderTests", "png");
+
+        {
+            std::ofstream f(toFilesystemPath(tempFile.GetFullPath()), std::ios::binary);
+            f << "not a png file";
+        }
+
+        ImageHeaderInfo info;
+        EXPECT_FALSE(ImageHeader::probeFile(toFilesystemPath(tempFile.GetFullPath()), "png", 0, info));
+        EXPECT_TRUE(info.empty());
+    }
+
+    TEST(ImageHeaderTests, testProber)
+    {
+        // more images than threads, including one that can't be probed
+        vector<std::unique_ptr<TempFile>> files;
+        vector<std::shared_ptr<WxivImage>> images;
+
+        for (int i = 0; i < 7; i++)
+        {
+            files.push_back(std::make_unique<TempFile>("ImageHeaderTests", "png"));
+            ASSERT_TRUE(cv::imwrite(files.back()->GetFullPath().ToStdString(), cv::Mat(10 + i, 20 + i, CV_16U, cv::Scalar(i))));
+            images.push_back(std::make_shared<WxivImage>(files.back()->GetFullPath()));
+        }
+
+        files.push_back(std::make_unique<TempFile>("ImageHeaderTests", "png"));
+
+        {
+            std::ofstream f(toFilesystemPath(files.back()->GetFullPath()), std::ios::binary);
+            f << "not a png file";
+        }
+
+        images.push_back(std::make_shared<WxivImage>(files.back()->GetFullPath()));
+
+        {
+            ImageHeaderProber prober(images, 3);
+
+            for (int i = 0; (i < 500) && !prober.checkIsDone(); i++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            ASSERT_TRUE(prober.checkIsDone());
+        }
+
+        for (int i = 0; i < 7; i++)
+        {
+            ASSERT_TRUE(images[i]->getIsHeaderProbed());
+            ImageHeaderInfo info = images[i]->getHeaderInfo();
+            EXPECT_EQ(info.width, 20 + i);
+            EXPECT_EQ(info.height, 10 + i);
+            EXPECT_EQ(info.depth, CV_16U);
+            EXPECT_FALSE(images[i]->getIsLoaded());
+        }
+
+        // still marked probed, so it isn't tried again
+        EXPECT_TRUE(images[7]->getIsHeaderProbed());
+        EXPECT_TRUE(images[7]->getHeaderInfo().empty());
+    }
+}
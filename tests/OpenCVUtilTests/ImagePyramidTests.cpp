@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "ImagePyramid.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+    TEST(ImagePyramidTests, testCheckShouldBuild)
+    {
+        EXPECT_FALSE(ImagePyramid::checkShouldBuild(cv::Mat(1000, 1000, CV_8U)));
+        EXPECT_TRUE(ImagePyramid::checkShouldBuild(cv::Mat(3000, 3000, CV_16U)));
+        EXPECT_FALSE(ImagePyramid::checkShouldBuild(cv::Mat(3000, 3000, CV_32S)));
+    }
+
+    TEST(ImagePyramidTests, testBuild)
+    {
+        cv::Mat img(3000, 2001, CV_32F);
+        cv::randu(img, 0.0f, 1.0f);
+        ImagePyramid pyramid(img);
+
+        // only level 0 until built
+        EXPECT_FALSE(pyramid.getIsBuilt());
+        EXPECT_EQ(pyramid.getLevelCount(), 1);
+        EXPECT_EQ(pyramid.selectLevel(0.1f), 0);
+        EXPECT_EQ(pyramid.getMemoryBytes(), 0);
+
+        pyramid.build();
+        EXPECT_TRUE(pyramid.getIsBuilt());
+
+        // 3000, 1500, 750, 375, 188
+        ASSERT_EQ(pyramid.getLevelCount(), 5);
+        EXPECT_EQ(pyramid.getLevel(0).data, img.data);
+        EXPECT_EQ(pyramid.getLevel(1).size(), cv::Size(1001, 1500));
+
+        // halving rounds up, so x and y scales differ a little
+        EXPECT_FLOAT_EQ(pyramid.getLevelScale(1).x, 2001.0f / 1001.0f);
+        EXPECT_FLOAT_EQ(pyramid.getLevelScale(1).y, 2.0f);
+        EXPECT_EQ(pyramid.getLevel(4).rows, 188);
+        EXPECT_GT(pyramid.getMemoryBytes(), 0);
+
+        // area reduce keeps the mean
+        EXPECT_NEAR(cv::mean(pyramid.getLevel(3))[0], cv::mean(img)[0], 0.01);
+    }
+
+    TEST(ImagePyramidTests, testSelectLevel)
+    {
+        cv::Mat img(4096, 4096, CV_8U, cv::Scalar(7));
+        ImagePyramid pyramid(img);
+        pyramid.build();
+
+        EXPECT_EQ(pyramid.selectLevel(1.0f), 0);
+        EXPECT_EQ(pyramid.selectLevel(0.6f), 0);
+        EXPECT_EQ(pyramid.selectLevel(0.5f), 1);
+        EXPECT_EQ(pyramid.selectLevel(0.3f), 1);
+        EXPECT_EQ(pyramid.selectLevel(0.25f), 2);
+        EXPECT_EQ(pyramid.selectLevel(0.001f), pyramid.getLevelCount() - 1);
+        EXPECT_EQ(pyramid.getLevelScale(2), cv::Point2f(4.0f, 4.0f));
+    }
+
+    TEST(ImagePyramidTests, testRequestBuild)
+    {
+        cv::Mat img(2500, 2500, CV_8U, cv::Scalar(3));
+        ImagePyramid pyramid(img);
+        pyramid.requestBuild();
+        pyramid.requestBuild();
+
+        // build on this thread too, whichever finishes first wins
+        pyramid.build();
+        EXPECT_TRUE(pyramid.getIsBuilt());
+        EXPECT_GT(pyramid.getLevelCount(), 1);
+    }
+}
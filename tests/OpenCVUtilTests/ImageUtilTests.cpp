@@ -23,6 +23,34 @@ namespace WxivTests
         EXPECT_EQ(ImageUtil::getImageTypeString(img), "8U");
     }
 
+    /**
+     * @brief 8U, 16U, and 16S go through a table, the rest multiply-add, and all saturate at both ends.
+     */
+    TEST(ImageUtilTests, testImgTo8u)
+    {
+        for (int type : {CV_8U, CV_16U, CV_16S, CV_32S, CV_32F})
+        {
+            cv::Mat img = (cv::Mat_<int>(1, 4) << 0, 20, 60, 200);
+            img.convertTo(img, type);
+            cv::Mat dst;
+            ImageUtil::imgTo8u(img, dst, 20.0f, 120.0f);
+            ASSERT_EQ(dst.type(), CV_8U);
+            EXPECT_EQ(dst.at<uint8_t>(0, 0), 0) << type;
+            EXPECT_EQ(dst.at<uint8_t>(0, 1), 0) << type;
+            EXPECT_EQ(dst.at<uint8_t>(0, 2), 102) << type;
+            EXPECT_EQ(dst.at<uint8_t>(0, 3), 255) << type;
+        }
+
+        // negative 16S, and the table is rebuilt for a new range
+        cv::Mat img = (cv::Mat_<int16_t>(1, 2) << -1000, -600);
+        cv::Mat dst;
+        ImageUtil::imgTo8u(img, dst, -1000.0f, 0.0f);
+        EXPECT_EQ(dst.at<uint8_t>(0, 0), 0);
+        EXPECT_EQ(dst.at<uint8_t>(0, 1), 102);
+        ImageUtil::imgTo8u(img, dst, -2000.0f, -1000.0f);
+        EXPECT_EQ(dst.at<uint8_t>(0, 1), 255);
+    }
+
     cv::Mat generateBrightSpotImage(int rows, int cols, int spotCount, int prngSeed)
     {
         cv::Mat img = cv::Mat::zeros(rows, cols, CV_8UC1);
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <thread>
+
+#include <opencv2/opencv.hpp>
+
+#include "ImageVolume.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+    /**
+     * @brief Each voxel is z * 10000 + y * 100 + x, so it's easy to tell where one came from.
+     */
+    static std::unique_ptr<ImageVolume> makeTestVolume(int depth, int rows, int cols)
+    {
+        auto volume = std::make_unique<ImageVolume>(depth, rows, cols, CV_32F);
+
+        for (int z = 0; z < depth; z++)
+        {
+            cv::Mat slice = volume->getStackedSlice(z);
+
+            for (int y = 0; y < rows; y++)
+            {
+                for (int x = 0; x < cols; x++)
+                {
+                    slice.at<float>(y, x) = z * 10000 + y * 100 + x;
+                }
+            }
+        }
+
+        return volume;
+    }
+
+    static void checkSlices(ImageVolume& volume)
+    {
+        cv::Mat axial = volume.getSlice(VolumeAxis::Axial, 3);
+        ASSERT_EQ(axial.size(), cv::Size(volume.getCols(), volume.getRows()));
+        EXPECT_EQ(axial.at<float>(2, 5), 30205);
+
+        cv::Mat coronal = volume.getSlice(VolumeAxis::Coronal, 2);
+        ASSERT_EQ(coronal.size(), cv::Size(volume.getCols(), volume.getDepth()));
+        EXPECT_EQ(coronal.at<float>(4, 5), 40205);
+        EXPECT_EQ(coronal.at<float>(0, 0), 200);
+
+        cv::Mat sagittal = volume.getSlice(VolumeAxis::Sagittal, 5);
+        ASSERT_EQ(sagittal.size(), cv::Size(volume.getRows(), volume.getDepth()));
+        EXPECT_EQ(sagittal.at<float>(4, 2), 40205);
+        int lastZ = volume.getDepth() - 1;
+        int lastY = volume.getRows() - 1;
+        EXPECT_EQ(sagittal.at<float>(lastZ, lastY), lastZ * 10000 + lastY * 100 + 5);
+    }
+
+    /**
+     * @brief Poll until the transposed copy being made in the background is done, or give up after a while.
+     */
+    static void waitForTranspose(ImageVolume& volume)
+    {
+        for (int i = 0; (i < 500) && volume.checkIsTransposing(); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+
+    TEST(ImageVolumeTests, testSlices)
+    {
+        auto volume = makeTestVolume(7, 6, 9);
+        EXPECT_EQ(volume->getSliceCount(VolumeAxis::Axial), 7);
+        EXPECT_EQ(volume->getSliceCount(VolumeAxis::Coronal), 6);
+        EXPECT_EQ(volume->getSliceCount(VolumeAxis::Sagittal), 9);
+
+        // gathered
+        checkSlices(*volume);
+        EXPECT_FALSE(volume->checkHasTransposedCopy());
+
+        // gathered while the transposed copy is made in the background, and then from it
+        EXPECT_EQ(volume->getResidentBytes(), volume->getBytes());
+        volume->setExtraBudgetBytes(volume->getBytes());
+        checkSlices(*volume);
+        waitForTranspose(*volume);
+        ASSERT_TRUE(volume->checkHasTransposedCopy());
+        checkSlices(*volume);
+        EXPECT_EQ(volume->getResidentBytes(), 2 * volume->getBytes());
+
+        // which is dropped when it no longer fits, and slices from it stay valid
+        cv::Mat sagittal = volume->getSlice(VolumeAxis::Sagittal, 4);
+        cv::Mat expected = sagittal.clone();
+        volume->setExtraBudgetBytes(volume->getBytes() - 1);
+        EXPECT_FALSE(volume->checkHasTransposedCopy());
+        EXPECT_EQ(volume->getResidentBytes(), volume->getBytes());
+        EXPECT_EQ(cv::norm(sagittal, expected, cv::NORM_INF), 0);
+        checkSlices(*volume);
+
+        EXPECT_THROW(volume->getSlice(VolumeAxis::Coronal, 6), std::runtime_error);
+    }
+
+    TEST(ImageVolumeTests, testTransposeBudgetDropped)
+    {
+        auto volume = makeTestVolume(7, 6, 9);
+        volume->setExtraBudgetBytes(volume->getBytes());
+        volume->getSlice(VolumeAxis::Sagittal, 0);
+
+        // no longer fits by the time it's done, so it isn't kept
+        volume->setExtraBudgetBytes(0);
+        waitForTranspose(*volume);
+        EXPECT_FALSE(volume->checkIsTransposing());
+        EXPECT_FALSE(volume->checkHasTransposedCopy());
+        checkSlices(*volume);
+
+        // and the destructor waits for one still being made
+        volume->setExtraBudgetBytes(volume->getBytes());
+        volume->getSlice(VolumeAxis::Sagittal, 0);
+        volume.reset();
+    }
+
+    TEST(ImageVolumeTests, testTooManyRows)
+    {
+        EXPECT_THROW(ImageVolume(1 << 16, 1 << 16, 1, CV_8U), std::runtime_error);
+    }
+
+    TEST(ImageVolumeTests, testSlicesOutliveVolume)
+    {
+        auto volume = makeTestVolume(4, 6, 9);
+        cv::Mat coronal = volume->getSlice(VolumeAxis::Coronal, 2);
+        volume.reset();
+        EXPECT_EQ(coronal.at<float>(3, 5), 30205);
+    }
+
+    TEST(ImageVolumeTests, testDisplaySlice)
+    {
+        auto volume = makeTestVolume(10, 6, 9);
+        volume->setVoxelSpacing(2.0, 0.5, 1.0);
+
+        // last stacked slice at the top, stretched to square pixels
+        cv::Mat coronal = volume->getDisplaySlice(VolumeAxis::Coronal, 1);
+        EXPECT_EQ(coronal.size(), cv::Size(9, 20));
+        EXPECT_EQ(coronal.at<float>(0, 3), 90103);
+
+        cv::Mat sagittal = volume->getDisplaySlice(VolumeAxis::Sagittal, 1);
+        EXPECT_EQ(sagittal.size(), cv::Size(6, 40));
+
+        cv::Mat axial = volume->getDisplaySlice(VolumeAxis::Axial, 1);
+        EXPECT_EQ(axial.size(), cv::Size(9, 6));
+
+        // square pixels already, so just flipped, and not into the volume
+        volume->setVoxelSpacing(1.0, 1.0, 1.0);
+        coronal = volume->getDisplaySlice(VolumeAxis::Coronal, 1);
+        EXPECT_EQ(coronal.size(), cv::Size(9, 10));
+        EXPECT_EQ(coronal.at<float>(0, 3), 90103);
+        EXPECT_EQ(coronal.at<float>(9, 3), 103);
+        EXPECT_EQ(volume->getSlice(VolumeAxis::Coronal, 1).at<float>(0, 3), 103);
+
+        sagittal = volume->getDisplaySlice(VolumeAxis::Sagittal, 1);
+        EXPECT_EQ(sagittal.size(), cv::Size(6, 10));
+        EXPECT_EQ(sagittal.at<float>(0, 2), 90201);
+    }
+}
@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <filesystem>
+#include <fmt/core.h>
+
+#include <opencv2/opencv.hpp>
+
+#include "MappedImage.h"
+
+using namespace std;
+using namespace Wxiv;
+namespace fs = std::filesystem;
+
+namespace WxivTests
+{
+    /**
+     * @brief Write a version 1.0 npy file, like numpy.save does.
+     */
+    void writeNpy(const fs::path& path, const cv::Mat& img, const string& descr)
+    {
+        string shape = (img.channels() == 1) ? fmt::format("({}, {})", img.rows, img.cols)
+                                              : fmt::format("({}, {}, {})", img.rows, img.cols, img.channels());
+        string header = fmt::format("{{'descr': '{}', 'fortran_order': False, 'shape': {}, }}", descr, shape);
+
+        // pad with spaces and newline so the data starts on a 64-byte boundary
+        size_t total = 10 + header.size() + 1;
+        header.append((64 - total % 64) % 64, ' ');
+        header.push_back('\n');
+
+        std::ofstream f(path, std::ios::binary);
+        f.write("\x93NUMPY\x01\x00", 8);
+        uint16_t headerLen = (uint16_t)header.size();
+        f.write((const char*)&headerLen, 2);
+        f.write(header.data(), header.size());
+
+        for (int r = 0; r < img.rows; r++)
+        {
+            f.write((const char*)img.ptr(r), img.cols * img.elemSize());
+        }
+    }
+
+    TEST(MappedImageTests, testLoadNpy16U)
+    {
+        fs::path path = fs::temp_directory_path() / "MappedImageTests-16u.npy";
+        cv::Mat img(300, 200, CV_16U);
+        cv::randu(img, 0, 60000);
+        writeNpy(path, img, "<u2");
+
+        cv::Mat loaded = MappedImage::load(path);
+        EXPECT_EQ(loaded.type(), CV_16U);
+        EXPECT_EQ(loaded.size(), img.size());
+        EXPECT_EQ(cv::norm(loaded, img, cv::NORM_INF), 0.0);
+
+        // a copy of the header keeps the mapping alive after the original is released
+        cv::Mat roi = loaded(cv::Rect(10, 10, 50, 50));
+        loaded.release();
+        EXPECT_EQ(cv::norm(roi, img(cv::Rect(10, 10, 50, 50)), cv::NORM_INF), 0.0);
+        roi.release();
+
+        fs::remove(path);
+    }
+
+    TEST(MappedImageTests, testLoadNpy32FC3)
+    {
+        fs::path path = fs::temp_directory_path() / "MappedImageTests-32fc3.npy";
+        cv::Mat img(64, 80, CV_32FC3);
+        cv::randu(img, -1.0f, 1.0f);
+        writeNpy(path, img, "<f4");
+
+        cv::Mat loaded = MappedImage::load(path);
+        EXPECT_EQ(loaded.type(), CV_32FC3);
+        EXPECT_EQ(cv::norm(loaded, img, cv::NORM_INF), 0.0);
+
+        loaded.release();
+        fs::remove(path);
+    }
+
+    TEST(MappedImageTests, testLoadRawWithStride)
+    {
+        fs::path path = fs::temp_directory_path() / "MappedImageTests.raw";
+        cv::Mat img(100, 120, CV_32F);
+        cv::randu(img, 0.0f, 100.0f);
+
+        RawImageHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "WXIVRAW", 8);
+        header.headerSize = 64;
+        header.width = img.cols;
+        header.height = img.rows;
+        header.channels = 1;
+        header.depth = CV_32F;
+        header.rowStride = 512; // padded rows
+
+        {
+            std::ofstream f(path, std::ios::binary);
+            vector<char> headerBytes(header.headerSize, 0);
+            memcpy(headerBytes.data(), &header, sizeof(header));
+            f.write(headerBytes.data(), headerBytes.size());
+            vector<char> row(header.rowStride, 0);
+
+            for (int r = 0; r < img.rows; r++)
+            {
+                memcpy(row.data(), img.ptr(r), img.cols * img.elemSize());
+                f.write(row.data(), row.size());
+            }
+        }
+
+        cv::Mat loaded = MappedImage::load(path);
+        EXPECT_EQ(loaded.type(), CV_32F);
+        EXPECT_EQ(loaded.step[0], 512);
+        EXPECT_EQ(cv::norm(loaded, img, cv::NORM_INF), 0.0);
+
+        loaded.release();
+        fs::remove(path);
+    }
+
+    TEST(MappedImageTests, testTruncatedFileThrows)
+    {
+        fs::path path = fs::temp_directory_path() / "MappedImageTests-truncated.npy";
+        cv::Mat img(32, 32, CV_16U);
+        img = 5;
+        writeNpy(path, img, "<u2");
+        fs::resize_file(path, fs::file_size(path) - 100);
+
+        EXPECT_THROW(MappedImage::load(path), std::runtime_error);
+        fs::remove(path);
+    }
+
+    /**
+     * @brief Write an npy file with this header dict text and some zero bytes after it.
+     */
+    static void writeNpyHeader(const fs::path& path, const string& header, size_t dataBytes)
+    {
+        std::ofstream f(path, std::ios::binary);
+        f.write("\x93NUMPY\x01\x00", 8);
+        uint16_t headerLen = (uint16_t)header.size();
+        f.write((const char*)&headerLen, 2);
+        f.write(header.data(), header.size());
+        vector<char> data(dataBytes, 0);
+        f.write(data.data(), data.size());
+    }
+
+    TEST(MappedImageTests, testMalformedNpyHeaderThrows)
+    {
+        fs::path path = fs::temp_directory_path() / "MappedImageTests-malformed.npy";
+        vector<string> headers = {
+            "{'fortran_order': False, 'descr':",
+            "{'fortran_order': False, 'descr':      ",
+            "{'descr': '<u2', 'fortran_order': False, 'shape': (4, 4",
+            "{'descr': '<u2', 'fortran_order': False, 'shape': (4, x), }",
+            "{'descr': '<u2', 'fortran_order': False, 'shape': (4, 99999999999), }",
+            "{'descr': '<u2', 'fortran_order': False, 'shape': (-4, 4), }",
+        };
+
+        for (const string& header : headers)
+        {
+            writeNpyHeader(path, header, 64);
+            EXPECT_THROW(MappedImage::load(path), std::runtime_error) << header;
+        }
+
+        fs::remove(path);
+    }
+
+    TEST(MappedImageTests, testHugeRowStrideThrows)
+    {
+        fs::path path = fs::temp_directory_path() / "MappedImageTests-stride.raw";
+        RawImageHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "WXIVRAW", 8);
+        header.headerSize = 64;
+        header.width = 16;
+        header.height = 5;
+        header.channels = 1;
+        header.depth = CV_8U;
+
+        // (height - 1) * rowStride wraps to a small number
+        header.rowStride = ((uint64_t)1 << 62);
+
+        {
+            std::ofstream f(path, std::ios::binary);
+            vector<char> bytes(4096, 0);
+            memcpy(bytes.data(), &header, sizeof(header));
+            f.write(bytes.data(), bytes.size());
+        }
+
+        EXPECT_THROW(MappedImage::load(path), std::runtime_error);
+        fs::remove(path);
+    }
+
+    TEST(MappedImageTests, testCopyOutlivesTruncate)
+    {
+        fs::path path = fs::temp_directory_path() / "MappedImageTests-copy.npy";
+        cv::Mat img(256, 256, CV_16U);
+        cv::randu(img, 0, 60000);
+        writeNpy(path, img, "<u2");
+
+        // as if a watched file is rewritten while it's viewed, which would fault reading a mapping
+        cv::Mat loaded = MappedImage::load(path, true);
+        fs::resize_file(path, 0);
+        EXPECT_EQ(cv::norm(loaded, img, cv::NORM_INF), 0.0);
+
+        loaded.release();
+        fs::remove(path);
+    }
+}
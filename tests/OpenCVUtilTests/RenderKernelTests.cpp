@@ -0,0 +1,247 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include <opencv2/opencv.hpp>
+
+#include "ImageUtil.h"
+#include "RenderKernel.h"
+
+using namespace std;
+using namespace Wxiv;
+
+namespace WxivTests
+{
+    /**
+     * @brief The render pipeline RenderKernel replaced: range to 8 bits, resize, copy into a background-filled image the
+     * size of the dc, then convert to RGB.
+     */
+    static void renderStaged(cv::Mat& src, float zoom, cv::Size renderSize, float lowVal, float highVal, uint8_t background, cv::Mat& dstRgb)
+    {
+        cv::Mat ranged, scaled, dcImgTmp;
+
+        if (src.channels() == 1)
+        {
+            ImageUtil::imgTo8u(src, ranged, lowVal, highVal);
+        }
+        else
+        {
+            ranged = src;
+        }
+
+        int interp = zoom < 1.0f ? cv::INTER_AREA : cv::INTER_NEAREST;
+        cv::resize(ranged, scaled, cv::Size(), zoom, zoom, interp);
+        cv::Rect2i copyRoi(0, 0, std::min({renderSize.width, scaled.cols, dstRgb.cols}), std::min({renderSize.height, scaled.rows, dstRgb.rows}));
+
+        if (scaled.type() == CV_8U)
+        {
+            dcImgTmp.create(dstRgb.size(), CV_8U);
+            dcImgTmp = background;
+            scaled(copyRoi).copyTo(dcImgTmp(copyRoi));
+            cv::cvtColor(dcImgTmp, dstRgb, cv::COLOR_GRAY2BGR);
+        }
+        else
+        {
+            dstRgb = cv::Scalar(background, background, background);
+            cv::cvtColor(scaled(copyRoi), dstRgb(copyRoi), scaled.channels() == 3 ? cv::COLOR_BGR2RGB : cv::COLOR_BGRA2RGB);
+        }
+    }
+
+    /**
+     * @brief Same as the staged pipeline for in-range values, give or take rounding.
+     */
+    TEST(RenderKernelTests, testMatchesStaged)
+    {
+        vector<int> types = {CV_8U, CV_16U, CV_16S, CV_32S, CV_32F, CV_8UC3, CV_8UC4};
+        vector<float> zooms = {3.0f, 2.5f, 1.0f, 0.9f, 0.5f, 0.37f, 0.25f};
+
+        for (int type : types)
+        {
+            ASSERT_TRUE(RenderKernel::checkIsSupportedType(type));
+            float lowVal = (CV_MAT_DEPTH(type) == CV_8U) ? 10.0f : -100.0f;
+            float highVal = (CV_MAT_DEPTH(type) == CV_8U) ? 240.0f : 3000.0f;
+            cv::Mat src(97, 131, type);
+            cv::randu(src, lowVal, highVal);
+
+            for (float zoom : zooms)
+            {
+                cv::Mat expected(180, 200, CV_8UC3);
+                cv::Mat actual(180, 200, CV_8UC3);
+                renderStaged(src, zoom, cv::Size(190, 170), lowVal, highVal, 50, expected);
+                RenderKernel::renderToRgb(src, zoom, cv::Size(190, 170), RenderKernel::RenderRange::fromLowHigh(lowVal, highVal), 50, actual);
+                EXPECT_LE(cv::norm(actual, expected, cv::NORM_INF), 1) << "type " << type << " zoom " << zoom;
+            }
+        }
+    }
+
+    TEST(RenderKernelTests, testSeparateZoom)
+    {
+        cv::Mat src(40, 50, CV_8U);
+        cv::randu(src, 0, 255);
+        RenderKernel::RenderLut lut;
+        lut.update(CV_8U, RenderKernel::RenderRange());
+
+        for (cv::Point2f zoom : {cv::Point2f(2.0f, 3.0f), cv::Point2f(0.5f, 0.25f)})
+        {
+            cv::Mat scaled, expected;
+            cv::resize(src, scaled, cv::Size(), zoom.x, zoom.y, zoom.x < 1.0f ? cv::INTER_AREA : cv::INTER_NEAREST);
+            cv::cvtColor(scaled, expected, cv::COLOR_GRAY2RGB);
+
+            cv::Mat actual(scaled.size(), CV_8UC3);
+            RenderKernel::renderToRgb(src, zoom, scaled.size(), lut, 0, actual);
+            EXPECT_LE(cv::norm(actual, expected, cv::NORM_INF), 1) << "zoom " << zoom;
+        }
+    }
+
+    TEST(RenderKernelTests, testRange)
+    {
+        cv::Mat src = (cv::Mat_<float>(1, 5) << -50.0f, 0.0f, 50.0f, 200.0f, NAN);
+        cv::Mat dst(2, 6, CV_8UC3);
+        RenderKernel::renderToRgb(src, 1.0f, cv::Size(100, 100), RenderKernel::RenderRange::fromLowHigh(0.0f, 100.0f), 7, dst);
+
+        // saturates at both ends, NaN to 0, and background outside the image
+        EXPECT_EQ(dst.at<cv::Vec3b>(0, 0), cv::Vec3b(0, 0, 0));
+        EXPECT_EQ(dst.at<cv::Vec3b>(0, 1), cv::Vec3b(0, 0, 0));
+        EXPECT_EQ(dst.at<cv::Vec3b>(0, 2), cv::Vec3b(128, 128, 128));
+        EXPECT_EQ(dst.at<cv::Vec3b>(0, 3), cv::Vec3b(255, 255, 255));
+        EXPECT_EQ(dst.at<cv::Vec3b>(0, 4), cv::Vec3b(0, 0, 0));
+        EXPECT_EQ(dst.at<cv::Vec3b>(0, 5), cv::Vec3b(7, 7, 7));
+        EXPECT_EQ(dst.at<cv::Vec3b>(1, 0), cv::Vec3b(7, 7, 7));
+
+        // color is swapped to RGB and not ranged
+        cv::Mat bgr(1, 1, CV_8UC3, cv::Scalar(1, 2, 3));
+        RenderKernel::renderToRgb(bgr, 1.0f, cv::Size(1, 1), RenderKernel::RenderRange::fromLowHigh(0.0f, 100.0f), 7, dst);
+        EXPECT_EQ(dst.at<cv::Vec3b>(0, 0), cv::Vec3b(3, 2, 1));
+    }
+
+    TEST(RenderKernelTests, testLut)
+    {
+        RenderKernel::RenderLut lut;
+        RenderKernel::RenderRange range = RenderKernel::RenderRange::fromLowHigh(100.0f, 3000.0f);
+        EXPECT_TRUE(lut.update(CV_16U, range));
+        EXPECT_FALSE(lut.update(CV_16U, range));
+        EXPECT_TRUE(lut.update(CV_16U, RenderKernel::RenderRange::fromLowHigh(100.0f, 3001.0f)));
+        EXPECT_TRUE(lut.update(CV_16S, range));
+        EXPECT_EQ(lut.getBuildCount(), 3);
+
+        // the table gives the same pixels as ranging each value
+        cv::Mat src(40, 50, CV_16S);
+        cv::randu(src, -1000, 4000);
+        cv::Mat src32f;
+        src.convertTo(src32f, CV_32F);
+        cv::Mat fromTable(100, 100, CV_8UC3);
+        cv::Mat fromValues(100, 100, CV_8UC3);
+        RenderKernel::renderToRgb(src, 2.0f, fromTable.size(), lut, 50, fromTable);
+        RenderKernel::renderToRgb(src32f, 2.0f, fromValues.size(), range, 50, fromValues);
+        EXPECT_EQ(cv::norm(fromTable, fromValues, cv::NORM_INF), 0);
+
+        // and has to be for the image depth
+        EXPECT_THROW(RenderKernel::renderToRgb(src32f, 2.0f, fromValues.size(), lut, 50, fromValues), std::runtime_error);
+    }
+
+    TEST(RenderKernelTests, testGammaAndColormap)
+    {
+        cv::Mat ramp(1, 256, CV_8U);
+
+        for (int i = 0; i < 256; i++)
+        {
+            ramp.at<uint8_t>(0, i) = (uint8_t)i;
+        }
+
+        cv::Mat dst(1, 256, CV_8UC3);
+        RenderKernel::RenderLut lut;
+        lut.update(CV_8U, RenderKernel::RenderRange(), 0.5f);
+        RenderKernel::renderToRgb(ramp, 1.0f, dst.size(), lut, 0, dst);
+        EXPECT_EQ(dst.at<cv::Vec3b>(0, 64), cv::Vec3b(128, 128, 128));
+        EXPECT_EQ(dst.at<cv::Vec3b>(0, 255), cv::Vec3b(255, 255, 255));
+
+        // only the colors are rebuilt, and zoomed out the colormap is applied after averaging
+        EXPECT_TRUE(lut.update(CV_8U, RenderKernel::RenderRange(), 1.0f, cv::COLORMAP_JET));
+        RenderKernel::renderToRgb(ramp, 1.0f, dst.size(), lut, 0, dst);
+        cv::Mat expected;
+        cv::applyColorMap(ramp, expected, cv::COLORMAP_JET);
+        cv::cvtColor(expected, expected, cv::COLOR_BGR2RGB);
+        EXPECT_EQ(cv::norm(dst, expected, cv::NORM_INF), 0);
+
+        cv::Mat flat(4, 4, CV_8U, cv::Scalar(100));
+        RenderKernel::renderToRgb(flat, 0.5f, dst.size(), lut, 0, dst);
+        EXPECT_EQ(dst.at<cv::Vec3b>(0, 1), expected.at<cv::Vec3b>(0, 100));
+    }
+
+    /**
+     * @brief Time the staged pipeline against the kernel for a 16-bit image on a big view, zoomed in, 1:1, and out.
+     * Not a pass/fail on the times, they're just printed. Disabled because it's slow in debug builds, run with
+     * --gtest_also_run_disabled_tests.
+     */
+    TEST(RenderKernelTests, DISABLED_testBenchmark)
+    {
+        const int iterations = 10;
+        cv::Mat src(2048, 2048, CV_16U);
+        cv::randu(src, 0, 40000);
+        cv::Mat staged(1000, 1600, CV_8UC3);
+        cv::Mat fused(1000, 1600, CV_8UC3);
+
+        for (float zoom : {4.0f, 1.0f, 0.6f})
+        {
+            // the sub-image that covers the view at this zoom
+            cv::Rect2i roi(0, 0, std::min(src.cols, (int)ceilf(staged.cols / zoom)), std::min(src.rows, (int)ceilf(staged.rows / zoom)));
+            cv::Mat sub = src(roi);
+
+            auto start = std::chrono::steady_clock::now();
+
+            for (int i = 0; i < iterations; i++)
+            {
+                renderStaged(sub, zoom, staged.size(), 100.0f, 30000.0f, 50, staged);
+            }
+
+            auto mid = std::chrono::steady_clock::now();
+
+            for (int i = 0; i < iterations; i++)
+            {
+                RenderKernel::renderToRgb(sub, zoom, fused.size(), RenderKernel::RenderRange::fromLowHigh(100.0f, 30000.0f), 50, fused);
+            }
+
+            auto end = std::chrono::steady_clock::now();
+            double stagedMs = std::chrono::duration<double, std::milli>(mid - start).count() / iterations;
+            double fusedMs = std::chrono::duration<double, std::milli>(end - mid).count() / iterations;
+            cout << "render 16U to 1600x1000 at zoom " << zoom << ": staged " << stagedMs << " ms, fused " << fusedMs << " ms" << endl;
+
+            EXPECT_LE(cv::norm(fused, staged, cv::NORM_INF), 1);
+        }
+    }
+
+    /**
+     * @brief Time just ranging a 16-bit image, by multiply-add against the table of every value. Disabled like the one
+     * above.
+     */
+    TEST(RenderKernelTests, DISABLED_testBenchmarkLevelTable)
+    {
+        const int iterations = 10;
+        cv::Mat src(2048, 2048, CV_16U);
+        cv::randu(src, 0, 40000);
+        cv::Mat ranged;
+        RenderKernel::RenderRange range = RenderKernel::RenderRange::fromLowHigh(100.0f, 30000.0f);
+        std::vector<uint8_t> table;
+        RenderKernel::buildLevelTable(CV_16U, range, table);
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; i++)
+        {
+            cv::convertScaleAbs(src, ranged, range.alpha, range.beta);
+        }
+
+        auto mid = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; i++)
+        {
+            RenderKernel::applyLevelTable(src, table, ranged);
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        double scaleMs = std::chrono::duration<double, std::milli>(mid - start).count() / iterations;
+        double tableMs = std::chrono::duration<double, std::milli>(end - mid).count() / iterations;
+        cout << "range 16U 2048x2048: convertScaleAbs " << scaleMs << " ms, table " << tableMs << " ms" << endl;
+    }
+}
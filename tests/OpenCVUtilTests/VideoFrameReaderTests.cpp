@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <fmt/core.h>
+
+#include <opencv2/opencv.hpp>
+
+#include "VideoFrameReader.h"
+
+using namespace std;
+using namespace Wxiv;
+namespace fs = std::filesystem;
+
+namespace WxivTests
+{
+    static const int TestFrameCount = 30;
+    static const cv::Size TestFrameSize(64, 48);
+
+    /**
+     * @brief Write an MJPEG avi (which OpenCV can write with no extra codecs) where each frame is filled with 8 * its index.
+     */
+    static bool writeTestVideo(const fs::path& path)
+    {
+        cv::VideoWriter writer(path.string(), cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), 30, TestFrameSize);
+
+        if (!writer.isOpened())
+        {
+            return false;
+        }
+
+        for (int i = 0; i < TestFrameCount; i++)
+        {
+            writer.write(cv::Mat(TestFrameSize, CV_8UC3, cv::Scalar::all(i * 8)));
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Unique per run, so concurrent runs don't write each other's video.
+     */
+    static fs::path makeTestVideoPath(const std::string& name)
+    {
+        return fs::temp_directory_path() / fmt::format("VideoFrameReaderTests-{}-{}.avi", name, std::random_device()());
+    }
+
+    static double getFrameValue(const cv::Mat& frame)
+    {
+        return cv::mean(frame)[0];
+    }
+
+    TEST(VideoFrameReaderTests, testStepAndSeek)
+    {
+        fs::path path = makeTestVideoPath("step");
+
+        if (!writeTestVideo(path))
+        {
+            GTEST_SKIP() << "Can't write a test video with this OpenCV.";
+        }
+
+        {
+            VideoFrameReader reader(path, 256 * 1024 * 1024);
+            ASSERT_EQ(reader.getFrameCount(), TestFrameCount);
+            EXPECT_TRUE(VideoFrameReader::checkIsVideoExtension(".AVI"));
+            EXPECT_FALSE(VideoFrameReader::checkIsVideoExtension("tif"));
+
+            // stepping forward decodes one frame each, no seeks
+            for (int i = 0; i < 10; i++)
+            {
+                cv::Mat frame = reader.readFrame(i);
+                EXPECT_EQ(frame.size(), TestFrameSize);
+                EXPECT_NEAR(getFrameValue(frame), i * 8, 3);
+            }
+
+            EXPECT_EQ(reader.getDecodeCount(), 10);
+            EXPECT_EQ(reader.getSeekCount(), 0);
+
+            // stepping back is cached
+            EXPECT_NEAR(getFrameValue(reader.readFrame(5)), 40, 3);
+            EXPECT_EQ(reader.getDecodeCount(), 10);
+
+            // jumping ahead seeks, then stepping on from there doesn't
+            EXPECT_NEAR(getFrameValue(reader.readFrame(25)), 200, 3);
+            EXPECT_EQ(reader.getSeekCount(), 1);
+            EXPECT_NEAR(getFrameValue(reader.readFrame(26)), 208, 3);
+            EXPECT_EQ(reader.getSeekCount(), 1);
+
+            // and back to one not cached seeks again
+            reader.setCacheBudgetBytes(0);
+            EXPECT_NEAR(getFrameValue(reader.readFrame(2)), 16, 3);
+            EXPECT_EQ(reader.getSeekCount(), 2);
+
+            EXPECT_THROW(reader.readFrame(TestFrameCount), std::runtime_error);
+        }
+
+        fs::remove(path);
+    }
+
+    TEST(VideoFrameReaderTests, testCacheBudget)
+    {
+        fs::path path = makeTestVideoPath("budget");
+
+        if (!writeTestVideo(path))
+        {
+            GTEST_SKIP() << "Can't write a test video with this OpenCV.";
+        }
+
+        {
+            size_t frameBytes = (size_t)TestFrameSize.area() * 3;
+            VideoFrameReader reader(path, frameBytes * 3);
+
+            for (int i = 0; i < 10; i++)
+            {
+                reader.readFrame(i);
+            }
+
+            EXPECT_EQ(reader.getCacheBytes(), frameBytes * 3);
+
+            // the newest are kept
+            int decodeCount = reader.getDecodeCount();
+            reader.readFrame(8);
+            EXPECT_EQ(reader.getDecodeCount(), decodeCount);
+            reader.readFrame(0);
+            EXPECT_GT(reader.getDecodeCount(), decodeCount);
+        }
+
+        fs::remove(path);
+    }
+
+    TEST(VideoFrameReaderTests, testKeyframeIndex)
+    {
+        fs::path path = makeTestVideoPath("index");
+
+        if (!writeTestVideo(path))
+        {
+            GTEST_SKIP() << "Can't write a test video with this OpenCV.";
+        }
+
+        {
+            // frames can be read while the index is built
+            VideoFrameReader reader(path, 256 * 1024 * 1024);
+            EXPECT_NEAR(getFrameValue(reader.readFrame(20)), 160, 3);
+
+            for (int i = 0; (i < 500) && reader.checkIsIndexing(); i++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            ASSERT_FALSE(reader.checkIsIndexing());
+
+            // every MJPEG frame is a keyframe, if the backend can tell us
+            if (reader.checkHasKeyframeIndex())
+            {
+                EXPECT_EQ((int)reader.getKeyframes().size(), TestFrameCount);
+            }
+
+            EXPECT_NEAR(getFrameValue(reader.readFrame(3)), 24, 3);
+        }
+
+        fs::remove(path);
+    }
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+
+#include "WxWidgetsUtil.h"
+#include <wx/mstream.h>
+#include <wx/zstream.h>
+
+namespace WxivTests
+{
+    /**
+     * @brief Builds small zip and tar files in memory, for archive tests.
+     */
+    class TestArchive
+    {
+      public:
+        struct Member
+        {
+            std::string name;
+            std::vector<uint8_t> data;
+        };
+
+      private:
+        static void putU16(std::vector<uint8_t>& v, uint16_t x)
+        {
+            v.push_back(x & 0xff);
+            v.push_back(x >> 8);
+        }
+
+        static void putU32(std::vector<uint8_t>& v, uint32_t x)
+        {
+            putU16(v, x & 0xffff);
+            putU16(v, x >> 16);
+        }
+
+        static void putBytes(std::vector<uint8_t>& v, const void* p, size_t n)
+        {
+            v.insert(v.end(), (const uint8_t*)p, (const uint8_t*)p + n);
+        }
+
+        static uint32_t crc32(const std::vector<uint8_t>& data)
+        {
+            uint32_t crc = 0xffffffff;
+
+            for (uint8_t b : data)
+            {
+                crc ^= b;
+
+                for (int k = 0; k < 8; k++)
+                {
+                    crc = (crc >> 1) ^ (0xedb88320 & (0 - (crc & 1)));
+                }
+            }
+
+            return ~crc;
+        }
+
+        static std::vector<uint8_t> deflate(const std::vector<uint8_t>& data)
+        {
+            wxMemoryOutputStream mem;
+
+            {
+                wxZlibOutputStream zlib(mem, -1, wxZLIB_NO_HEADER);
+                zlib.Write(data.data(), data.size());
+                zlib.Close();
+            }
+
+            std::vector<uint8_t> compressed(mem.GetSize());
+            mem.CopyTo(compressed.data(), compressed.size());
+            return compressed;
+        }
+
+        static void putTarHeader(std::vector<uint8_t>& v, const std::string& name, size_t size, char type, const std::string& prefix = "")
+        {
+            uint8_t h[512] = {};
+            memcpy(h, name.data(), std::min<size_t>(name.size(), 100));
+            snprintf((char*)h + 100, 8, "%07o", 0644);
+            snprintf((char*)h + 124, 12, "%011llo", (unsigned long long)size);
+            h[156] = (uint8_t)type;
+            memcpy(h + 257, "ustar", 6);
+            memcpy(h + 263, "00", 2);
+            memcpy(h + 345, prefix.data(), std::min<size_t>(prefix.size(), 155));
+
+            unsigned sum = 0;
+            memset(h + 148, ' ', 8);
+
+            for (uint8_t b : h)
+            {
+                sum += b;
+            }
+
+            snprintf((char*)h + 148, 8, "%06o", sum);
+            putBytes(v, h, sizeof(h));
+        }
+
+        static void putTarData(std::vector<uint8_t>& v, const std::vector<uint8_t>& data)
+        {
+            v.insert(v.end(), data.begin(), data.end());
+            v.resize((v.size() + 511) / 512 * 512, 0);
+        }
+
+      public:
+        /**
+         * @brief Names longer than 100 chars get a GNU long name header.
+         */
+        static std::vector<uint8_t> makeTar(const std::vector<Member>& members)
+        {
+            std::vector<uint8_t> v;
+
+            for (const Member& m : members)
+            {
+                if (m.name.size() > 100)
+                {
+                    std::vector<uint8_t> longName(m.name.begin(), m.name.end());
+                    longName.push_back(0);
+                    putTarHeader(v, "././@LongLink", longName.size(), 'L');
+                    putTarData(v, longName);
+                }
+
+                putTarHeader(v, m.name, m.data.size(), '0');
+                putTarData(v, m.data);
+            }
+
+            v.resize(v.size() + 1024, 0);
+            return v;
+        }
+
+        static std::vector<uint8_t> makeZip(const std::vector<Member>& members, bool doDeflate)
+        {
+            std::vector<uint8_t> v;
+            std::vector<uint8_t> dir;
+
+            for (const Member& m : members)
+            {
+                std::vector<uint8_t> stored = doDeflate ? deflate(m.data) : m.data;
+                uint32_t crc = crc32(m.data);
+                uint32_t localOffset = (uint32_t)v.size();
+
+                putU32(v, 0x04034b50);
+                putU16(v, 20);
+                putU16(v, 0);
+                putU16(v, doDeflate ? 8 : 0);
+                putU32(v, 0); // time, date
+                putU32(v, crc);
+                putU32(v, (uint32_t)stored.size());
+                putU32(v, (uint32_t)m.data.size());
+                putU16(v, (uint16_t)m.name.size());
+                putU16(v, 4); // an extra field, which the central header doesn't have
+                putBytes(v, m.name.data(), m.name.size());
+                putU32(v, 0xcafe);
+                putBytes(v, stored.data(), stored.size());
+
+                putU32(dir, 0x02014b50);
+                putU16(dir, 20);
+                putU16(dir, 20);
+                putU16(dir, 0);
+                putU16(dir, doDeflate ? 8 : 0);
+                putU32(dir, 0);
+                putU32(dir, crc);
+                putU32(dir, (uint32_t)stored.size());
+                putU32(dir, (uint32_t)m.data.size());
+                putU16(dir, (uint16_t)m.name.size());
+                putU16(dir, 0);
+                putU16(dir, 0);
+                putU16(dir, 0);
+                putU16(dir, 0);
+                putU32(dir, 0);
+                putU32(dir, localOffset);
+                putBytes(dir, m.name.data(), m.name.size());
+            }
+
+            uint32_t dirOffset = (uint32_t)v.size();
+            putBytes(v, dir.data(), dir.size());
+
+            putU32(v, 0x06054b50);
+            putU16(v, 0);
+            putU16(v, 0);
+            putU16(v, (uint16_t)members.size());
+            putU16(v, (uint16_t)members.size());
+            putU32(v, (uint32_t)dir.size());
+            putU32(v, dirOffset);
+            putU16(v, 0);
+            return v;
+        }
+
+        static void write(const wxString& path, const std::vector<uint8_t>& bytes)
+        {
+            std::ofstream f(path.ToStdString(), std::ios::binary);
+            f.write((const char*)bytes.data(), bytes.size());
+        }
+    };
+}
@@ -1,5 +1,7 @@
 ﻿#include <string>
 #include <vector>
+#include <chrono>
+#include <iostream>
 #include <gtest/gtest.h>
 
 #include <opencv2/opencv.hpp>
@@ -53,4 +55,89 @@ namespace WxivTests
         EXPECT_EQ(img.rows, rtImages[0].rows);
         EXPECT_EQ(img.cols, rtImages[0].cols);
     }
+
+    /**
+     * @brief Test the reduced decode picks the smallest jpg scale that is still at least the min dim.
+     */
+    TEST(WxivUtilTests, testLoadImageReduced)
+    {
+        cv::Mat img(1024, 2048, CV_8UC3, cv::Scalar(30, 60, 90));
+        TempFile tempFile("WxivUtilTests", "jpg");
+        ASSERT_TRUE(wxSaveImage(tempFile.GetFullPath(), img));
+
+        cv::Mat reduced;
+        cv::Size fullSize;
+        EXPECT_TRUE(wxLoadImageReduced(tempFile.GetFullPath(), 0, 512, reduced, fullSize));
+        EXPECT_EQ(cv::Size(2048, 1024), fullSize);
+        EXPECT_EQ(cv::Size(512, 256), reduced.size());
+        EXPECT_EQ(CV_8UC3, reduced.type());
+
+        // same read into memory instead of mapped
+        cv::Mat copied;
+        EXPECT_TRUE(wxLoadImageReduced(tempFile.GetFullPath(), 0, 512, copied, fullSize, true));
+        EXPECT_EQ(cv::norm(reduced, copied, cv::NORM_INF), 0);
+
+        // no reduction would do, so no preview
+        EXPECT_FALSE(wxLoadImageReduced(tempFile.GetFullPath(), 0, 2048, reduced, fullSize));
+
+        // png has no reduced decode
+        TempFile pngFile("WxivUtilTests", "png");
+        ASSERT_TRUE(wxSaveImage(pngFile.GetFullPath(), img));
+        EXPECT_FALSE(wxLoadImageReduced(pngFile.GetFullPath(), 0, 512, reduced, fullSize));
+    }
+
+    /**
+     * @brief Test the mapped decode matches the file decode, when used for ASCII paths too.
+     */
+    TEST(WxivUtilTests, testLoadImageMapped)
+    {
+        cv::Mat img(64, 48, CV_16U);
+        cv::randu(img, 0, 60000);
+        TempFile tempFile("WxivUtilTests", "tif");
+        ASSERT_TRUE(wxSaveImage(tempFile.GetFullPath(), img));
+
+        vector<cv::Mat> fileImages;
+        ASSERT_TRUE(wxLoadImage(tempFile.GetFullPath(), fileImages, 0));
+
+        setDoLoadImageMapped(true);
+        vector<cv::Mat> mappedImages;
+        bool isLoaded = wxLoadImage(tempFile.GetFullPath(), mappedImages, 0);
+        setDoLoadImageMapped(false);
+
+        ASSERT_TRUE(isLoaded);
+        ASSERT_EQ(1, mappedImages.size());
+        EXPECT_EQ(CV_16U, mappedImages[0].type());
+        EXPECT_EQ(0, cv::norm(fileImages[0], mappedImages[0], cv::NORM_INF));
+    }
+
+    /**
+     * @brief Compare decode time of a big tif read by OpenCV vs decoded from a mapping.
+     * Disabled because it writes a 512 MB file, run with --gtest_also_run_disabled_tests.
+     */
+    TEST(WxivUtilTests, DISABLED_benchmarkLoadImageMapped)
+    {
+        cv::Mat img(16384, 16384, CV_16U);
+        cv::randu(img, 0, 60000);
+        TempFile tempFile("WxivUtilTests", "tif");
+        ASSERT_TRUE(wxSaveImage(tempFile.GetFullPath(), img));
+
+        for (int doMap = 0; doMap < 2; doMap++)
+        {
+            setDoLoadImageMapped(doMap != 0);
+            double bestMs = 0.0;
+
+            for (int i = 0; i < 3; i++)
+            {
+                vector<cv::Mat> images;
+                auto t0 = std::chrono::steady_clock::now();
+                ASSERT_TRUE(wxLoadImage(tempFile.GetFullPath(), images, 0));
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                bestMs = (i == 0) ? ms : std::min(bestMs, ms);
+            }
+
+            std::cout << (doMap ? "mapped: " : "file: ") << bestMs << " ms" << std::endl;
+        }
+
+        setDoLoadImageMapped(false);
+    }
 }